@@ -23,5 +23,7 @@
 + (NSString *)recipient;
 + (void)setRecipient:(NSString *)recipient;
 
++ (CGFloat)rowHeightForText:(NSString *)text;
+
 
 @end
@@ -150,4 +150,16 @@
 	[userDefaults setObject:recipient forKey:@"recipient"];
 }
 
+#pragma mark -
+#pragma mark Rows
+
++ (CGFloat)rowHeightForText:(NSString *)text
+{
+	UIFont *cellFont = [UIFont fontWithName:@"Helvetica" size:17.0];
+	CGSize constraintSize = CGSizeMake(280.0f, MAXFLOAT);
+	CGSize labelSize = [text sizeWithFont:cellFont constrainedToSize:constraintSize lineBreakMode:UILineBreakModeWordWrap];
+	
+	return labelSize.height + 25;
+}
+
 @end
@@ -0,0 +1,35 @@
+//
+//  FetchedChangeBatch.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/21/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+// Collects the object and section changes a fetched results controller reports during one
+// change cycle, collapses redundant ones (e.g. an insert followed by a delete of the same
+// object) and applies them to a table view as a single batch.
+@interface FetchedChangeBatch : NSObject {
+	NSMutableArray *objectChanges;
+	CFMutableDictionaryRef changesByObject;
+	NSMutableIndexSet *insertedSections;
+	NSMutableIndexSet *deletedSections;
+}
+
+- (void)addSectionChange:(NSFetchedResultsChangeType)type atIndex:(NSUInteger)sectionIndex;
+- (void)addObjectChange:(id)anObject type:(NSFetchedResultsChangeType)type 
+			atIndexPath:(NSIndexPath *)indexPath newIndexPath:(NSIndexPath *)newIndexPath;
+
+- (BOOL)isEmpty;
+- (BOOL)changesRowCount;
+
+// Applies all structural changes inside one beginUpdates/endUpdates pair and returns the
+// objects whose rows were updated in place, so the caller can reconfigure their cells.
+- (NSArray *)applyToTableView:(UITableView *)tableView withRowAnimation:(UITableViewRowAnimation)animation;
+
+- (void)reset;
+
+@end
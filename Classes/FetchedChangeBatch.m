@@ -0,0 +1,200 @@
+//
+//  FetchedChangeBatch.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/21/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "FetchedChangeBatch.h"
+
+
+// A single pending object change. indexPath is expressed in the coordinates before the
+// change cycle, newIndexPath in the coordinates after it.
+@interface FetchedObjectChange : NSObject {
+@public
+	id object;
+	NSFetchedResultsChangeType type;
+	NSIndexPath *indexPath;
+	NSIndexPath *newIndexPath;
+	BOOL cancelled;
+}
+@end
+
+@implementation FetchedObjectChange
+
+- (void)dealloc
+{
+	[object release];
+	[indexPath release];
+	[newIndexPath release];
+	[super dealloc];
+}
+
+@end
+
+
+@implementation FetchedChangeBatch
+
+- (id)init
+{
+	if ((self = [super init])) {
+		objectChanges = [[NSMutableArray alloc] init];
+		// Managed objects don't support NSCopying, so key them by identity
+		changesByObject = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+		insertedSections = [[NSMutableIndexSet alloc] init];
+		deletedSections = [[NSMutableIndexSet alloc] init];
+	}
+	
+	return self;
+}
+
+- (void)addSectionChange:(NSFetchedResultsChangeType)type atIndex:(NSUInteger)sectionIndex
+{
+	switch (type) {
+		case NSFetchedResultsChangeInsert:
+			[insertedSections addIndex:sectionIndex];
+			break;
+			
+		case NSFetchedResultsChangeDelete:
+			[deletedSections addIndex:sectionIndex];
+			break;
+	}
+}
+
+- (void)addObjectChange:(id)anObject type:(NSFetchedResultsChangeType)type 
+			atIndexPath:(NSIndexPath *)indexPath newIndexPath:(NSIndexPath *)newIndexPath
+{
+	FetchedObjectChange *change = (FetchedObjectChange *)CFDictionaryGetValue(changesByObject, anObject);
+	
+	if (change == nil) {
+		change = [[FetchedObjectChange alloc] init];
+		change->object = [anObject retain];
+		change->type = type;
+		change->indexPath = [indexPath retain];
+		change->newIndexPath = [newIndexPath retain];
+		
+		[objectChanges addObject:change];
+		CFDictionarySetValue(changesByObject, anObject, change);
+		[change release];
+		return;
+	}
+	
+	// Collapse the new change into the pending one for the same object
+	switch (type) {
+		case NSFetchedResultsChangeDelete:
+			if (change->type == NSFetchedResultsChangeInsert) {
+				// The row never made it to the table view
+				change->cancelled = YES;
+				CFDictionaryRemoveValue(changesByObject, anObject);
+			} else {
+				change->type = NSFetchedResultsChangeDelete;
+				[change->newIndexPath release];
+				change->newIndexPath = nil;
+			}
+			break;
+			
+		case NSFetchedResultsChangeInsert:
+			if (change->type == NSFetchedResultsChangeDelete) {
+				// Deleted and inserted again: the row just ends up somewhere else
+				change->type = NSFetchedResultsChangeMove;
+			}
+			[change->newIndexPath release];
+			change->newIndexPath = [newIndexPath retain];
+			break;
+			
+		case NSFetchedResultsChangeMove:
+			if (change->type == NSFetchedResultsChangeUpdate) {
+				change->type = NSFetchedResultsChangeMove;
+			}
+			[change->newIndexPath release];
+			change->newIndexPath = [newIndexPath retain];
+			break;
+			
+		case NSFetchedResultsChangeUpdate:
+			// Inserted and moved rows get a freshly configured cell anyway
+			break;
+	}
+}
+
+- (BOOL)isEmpty
+{
+	return CFDictionaryGetCount(changesByObject) == 0 && 
+		[insertedSections count] == 0 && [deletedSections count] == 0;
+}
+
+- (BOOL)changesRowCount
+{
+	for (FetchedObjectChange *change in objectChanges) {
+		if (!change->cancelled && 
+			(change->type == NSFetchedResultsChangeInsert || change->type == NSFetchedResultsChangeDelete)) {
+			return YES;
+		}
+	}
+	
+	return [insertedSections count] > 0 || [deletedSections count] > 0;
+}
+
+- (NSArray *)applyToTableView:(UITableView *)tableView withRowAnimation:(UITableViewRowAnimation)animation
+{
+	NSMutableArray *deletedRows = [NSMutableArray array];
+	NSMutableArray *insertedRows = [NSMutableArray array];
+	NSMutableArray *updatedObjects = [NSMutableArray array];
+	
+	for (FetchedObjectChange *change in objectChanges) {
+		if (change->cancelled) {
+			continue;
+		}
+		
+		switch (change->type) {
+			case NSFetchedResultsChangeInsert:
+				[insertedRows addObject:change->newIndexPath];
+				break;
+				
+			case NSFetchedResultsChangeDelete:
+				[deletedRows addObject:change->indexPath];
+				break;
+				
+			case NSFetchedResultsChangeMove:
+				[deletedRows addObject:change->indexPath];
+				[insertedRows addObject:change->newIndexPath];
+				break;
+				
+			case NSFetchedResultsChangeUpdate:
+				[updatedObjects addObject:change->object];
+				break;
+		}
+	}
+	
+	if ([deletedRows count] || [insertedRows count] || [insertedSections count] || [deletedSections count]) {
+		[tableView beginUpdates];
+		
+		[tableView deleteSections:deletedSections withRowAnimation:animation];
+		[tableView insertSections:insertedSections withRowAnimation:animation];
+		[tableView deleteRowsAtIndexPaths:deletedRows withRowAnimation:animation];
+		[tableView insertRowsAtIndexPaths:insertedRows withRowAnimation:animation];
+		
+		[tableView endUpdates];
+	}
+	
+	return updatedObjects;
+}
+
+- (void)reset
+{
+	[objectChanges removeAllObjects];
+	CFDictionaryRemoveAllValues(changesByObject);
+	[insertedSections removeAllIndexes];
+	[deletedSections removeAllIndexes];
+}
+
+- (void)dealloc
+{
+	[objectChanges release];
+	CFRelease(changesByObject);
+	[insertedSections release];
+	[deletedSections release];
+	[super dealloc];
+}
+
+@end
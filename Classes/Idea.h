@@ -21,6 +21,19 @@
 - (NSString *)dump;
 - (NSString *)subject;
 
+// Siblings are ordered by timeStamp, which doubles as a fractional order key: a moved idea gets
+// a timeStamp between the ones of its new neighbours, so no other idea is touched unless they're
+// too close together, in which case the siblings are spaced out again first. Moving an idea under
+// a new parent only changes its own parent, its subtree comes along. siblings are the children of
+// newParent in order, with or without the idea itself. Returns NO if newParent is the idea itself
+// or one of its descendants.
+- (BOOL)moveToParent:(Idea *)newParent atIndex:(NSUInteger)index amongSiblings:(NSArray *)siblings;
+- (NSArray *)orderedChildren;
+
+// The children of parent in order, or the top level ideas if parent is nil. Returns nil if they
+// couldn't be fetched.
++ (NSArray *)orderedChildrenOfParent:(Idea *)parent inManagedObjectContext:(NSManagedObjectContext *)context;
+
 @end
 
 
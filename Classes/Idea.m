@@ -9,6 +9,11 @@
 #import "Idea.h"
 
 
+@interface Idea ()
++ (NSDate *)orderKeyAtIndex:(NSUInteger)index amongSiblings:(NSArray *)siblings;
++ (void)respaceSiblings:(NSArray *)siblings;
+@end
+
 @implementation Idea 
 
 @dynamic timeStamp;
@@ -30,6 +35,111 @@
 	return [children sortedArrayUsingDescriptors:sortDescriptors];
 }
 
++ (NSArray *)orderedChildrenOfParent:(Idea *)parent inManagedObjectContext:(NSManagedObjectContext *)context
+{
+	if (parent != nil) {
+		return [parent orderedChildren];
+	}
+	
+	NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
+	[fetchRequest setEntity:[NSEntityDescription entityForName:@"Idea" inManagedObjectContext:context]];
+	[fetchRequest setPredicate:[NSPredicate predicateWithFormat:@"parent == nil"]];
+	
+	NSSortDescriptor *sortDescriptor = [[NSSortDescriptor alloc] initWithKey:@"timeStamp" ascending:YES];
+	[fetchRequest setSortDescriptors:[NSArray arrayWithObject:sortDescriptor]];
+	[sortDescriptor release];
+	
+	NSError *error = nil;
+	NSArray *ideas = [context executeFetchRequest:fetchRequest error:&error];
+	[fetchRequest release];
+	
+	if (ideas == nil) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+	}
+	
+	return ideas;
+}
+
+- (BOOL)moveToParent:(Idea *)newParent atIndex:(NSUInteger)index amongSiblings:(NSArray *)siblings
+{
+	// Only the path up from the new parent needs to be checked, not the subtree being moved
+	for (Idea *ancestor = newParent; ancestor != nil; ancestor = ancestor.parent) {
+		if (ancestor == self) {
+			return NO;
+		}
+	}
+	
+	NSMutableArray *others = [NSMutableArray arrayWithArray:siblings];
+	[others removeObject:self];
+	
+	index = MIN(index, [others count]);
+	
+	NSDate *orderKey = [Idea orderKeyAtIndex:index amongSiblings:others];
+	if (orderKey == nil) {
+		[Idea respaceSiblings:others];
+		orderKey = [Idea orderKeyAtIndex:index amongSiblings:others];
+	}
+	
+	if (self.parent != newParent) {
+		self.parent = newParent;
+	}
+	self.timeStamp = orderKey;
+	
+	return YES;
+}
+
+// Returns nil when the neighbours' keys are too close together to fit another one in between
++ (NSDate *)orderKeyAtIndex:(NSUInteger)index amongSiblings:(NSArray *)siblings
+{
+	NSDate *previous = index > 0 ? [[siblings objectAtIndex:index - 1] timeStamp] : nil;
+	NSDate *next = index < [siblings count] ? [[siblings objectAtIndex:index] timeStamp] : nil;
+	
+	if (next == nil) {
+		// Same as a new idea, unless that wouldn't come last
+		NSDate *now = [NSDate date];
+		return previous ? [now laterDate:[NSDate dateWithTimeInterval:1 sinceDate:previous]] : now;
+	}
+	
+	if (previous == nil) {
+		return [NSDate dateWithTimeInterval:-1 sinceDate:next];
+	}
+	
+	NSTimeInterval lower = [previous timeIntervalSinceReferenceDate];
+	NSTimeInterval upper = [next timeIntervalSinceReferenceDate];
+	NSTimeInterval middle = lower + (upper - lower) / 2;
+	
+	if (middle <= lower || middle >= upper) {
+		return nil;
+	}
+	
+	return [NSDate dateWithTimeIntervalSinceReferenceDate:middle];
+}
+
+// Spreads the keys evenly between the first and last one, at least a second apart, without
+// moving the last one so that new ideas still come after all of them.
++ (void)respaceSiblings:(NSArray *)siblings
+{
+	NSUInteger count = [siblings count];
+	
+	if (count < 2) {
+		return;
+	}
+	
+	NSTimeInterval first = [[[siblings objectAtIndex:0] timeStamp] timeIntervalSinceReferenceDate];
+	NSTimeInterval last = [[[siblings lastObject] timeStamp] timeIntervalSinceReferenceDate];
+	NSTimeInterval step = (last - first) / (count - 1);
+	
+	if (step < 1) {
+		step = 1;
+		first = last - step * (count - 1);
+	}
+	
+	for (NSUInteger i = 0; i < count; i++) {
+		Idea *sibling = [siblings objectAtIndex:i];
+		sibling.timeStamp = [NSDate dateWithTimeIntervalSinceReferenceDate:first + step * i];
+	}
+}
+
 - (NSString *)dumpIter:(BOOL)firstTime indentation:(int)indentation
 {
 	NSMutableString *result = [NSMutableString string];
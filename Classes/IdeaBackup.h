@@ -0,0 +1,80 @@
+//
+//  IdeaBackup.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/28/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+@class IdeaSnapshot;
+
+// Keys of a generation
+extern NSString * const IdeaBackupDateKey;
+extern NSString * const IdeaBackupIdeaCountKey;
+
+// Incremental backups of the board. Every idea is kept as a chunk named after the SHA-1 of its
+// contents, its name and the names of its children's chunks, so an idea that didn't change
+// since the last backup, along with its whole subtree, is found under the same name and isn't
+// written again: a backup only writes the chunks of the ideas that changed and of their
+// ancestors. A generation is a small property list naming the chunk of the top level, written
+// last so that it only exists once all of its chunks do. Chunks are checked against their name
+// when they're read back.
+//
+// The chunks and generations naming every chunk are counted in a single index (see
+// IdeaBackupIndex.h), read once and written once by a backup or a prune, so that removing a
+// generation only reads the chunks that were its own. An interruption can leave a chunk behind
+// but never removes one that's still named.
+@interface IdeaBackup : NSObject {
+	NSString *directory;
+}
+
+// Backups in Documents/Backups
++ (IdeaBackup *)defaultBackup;
+
+- (id)initWithDirectory:(NSString *)path;
+
+// Newest first, each as it was read from its file
+- (NSArray *)generations;
+- (NSDate *)dateOfLatestGeneration;
+
+// This and the methods below block on the file system, so call them from a background thread
+- (NSDictionary *)backUpSnapshot:(IdeaSnapshot *)snapshot error:(NSError **)error;
+
+// Adds a copy of the generation to the top level of the board, under an idea named after its
+// date, reading one chunk at a time. Returns the number of chunks that were missing or damaged,
+// each losing an idea and its subtree, or NSNotFound if the generation couldn't be read.
+- (NSUInteger)restoreGeneration:(NSDictionary *)generation intoContext:(NSManagedObjectContext *)context;
+
+// Removes the oldest generations beyond count, then the chunks no longer named by anything
+- (void)removeGenerationsBeyondCount:(NSUInteger)count;
+
+@end
+
+
+// Backs the board up from a snapshot on the reader queue, unless the latest generation is less
+// than a day old.
+@interface IdeaBackupOperation : NSOperation {
+	IdeaBackup *backup;
+	NSPersistentStoreCoordinator *persistentStoreCoordinator;
+}
+
+- (id)initWithBackup:(IdeaBackup *)aBackup persistentStoreCoordinator:(NSPersistentStoreCoordinator *)coordinator;
+
+@end
+
+
+// Restores a generation on the reader queue in a context of its own, and merges the restored
+// ideas into the given context on the main thread. A backup that can't be read or saved, or that
+// had damaged chunks, is reported with an alert.
+@interface IdeaRestoreOperation : NSOperation {
+	IdeaBackup *backup;
+	NSDictionary *generation;
+	NSManagedObjectContext *mainContext;
+}
+
+- (id)initWithBackup:(IdeaBackup *)aBackup generation:(NSDictionary *)aGeneration managedObjectContext:(NSManagedObjectContext *)context;
+
+@end
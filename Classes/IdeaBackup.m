@@ -0,0 +1,623 @@
+//
+//  IdeaBackup.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/28/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <CommonCrypto/CommonDigest.h>
+#import <UIKit/UIKit.h>
+#import "IdeaBackup.h"
+#import "IdeaSnapshot.h"
+#include "IdeaBackupIndex.h"
+#include <errno.h>
+
+
+NSString * const IdeaBackupDateKey = @"date";
+NSString * const IdeaBackupIdeaCountKey = @"ideaCount";
+
+static NSString * const kRootChunkKey = @"root";
+
+// Not written, the name of the file a generation was read from
+static NSString * const kFileKey = @"file";
+
+// The reference counts of all chunks
+static NSString * const kIndexFile = @"Chunks.index";
+
+// A new generation at most once a day, and a month of them kept
+static const NSTimeInterval kBackupInterval = 24 * 60 * 60;
+static const NSUInteger kGenerationLimit = 30;
+
+
+@interface IdeaBackup ()
+- (NSString *)chunksDirectory;
+- (NSString *)generationsDirectory;
+- (NSString *)pathForChunk:(NSString *)name;
+- (NSString *)writeChunkOfIdeaWithID:(NSManagedObjectID *)objectID inSnapshot:(IdeaSnapshot *)snapshot
+							   index:(IdeaBackupIndex *)index error:(NSError **)error;
+- (NSString *)writeChunkWithName:(NSString *)ideaName childChunks:(NSArray *)childChunks
+						   index:(IdeaBackupIndex *)index error:(NSError **)error;
+- (NSArray *)readChunk:(NSString *)name;
+- (NSUInteger)restoreChildChunks:(NSArray *)childChunks underIdea:(NSManagedObject *)parent context:(NSManagedObjectContext *)context;
+- (BOOL)readIndex:(IdeaBackupIndex *)index generations:(NSArray *)generations error:(NSError **)error;
+- (BOOL)writeIndex:(IdeaBackupIndex *)index removingChunks:(IdeaBackupChunkList *)removedChunks error:(NSError **)error;
+@end
+
+
+static NSError *IdeaBackupPOSIXError(void)
+{
+	return [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+}
+
+// For IdeaBackupIndex, which reads a chunk's children when counting them from scratch and when
+// releasing it for the last time
+static int IdeaBackupReadChildChunks(void *info, const char *name, IdeaBackupChunkList *children)
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	NSArray *childChunks = [[(IdeaBackup *)info readChunk:[NSString stringWithUTF8String:name]] objectAtIndex:1];
+	int succeeded = [childChunks isKindOfClass:[NSArray class]];
+	
+	for (NSString *childChunk in succeeded ? childChunks : nil) {
+		if (![childChunk isKindOfClass:[NSString class]] || !IdeaBackupChunkListAppend(children, [childChunk UTF8String])) {
+			succeeded = 0;
+			break;
+		}
+	}
+	
+	[pool drain];
+	
+	return succeeded;
+}
+
+
+@implementation IdeaBackup
+
++ (IdeaBackup *)defaultBackup
+{
+	static IdeaBackup *defaultBackup = nil;
+	
+	@synchronized(self) {
+		if (defaultBackup == nil) {
+			NSString *documents = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+			defaultBackup = [[IdeaBackup alloc] initWithDirectory:[documents stringByAppendingPathComponent:@"Backups"]];
+		}
+	}
+	
+	return defaultBackup;
+}
+
+- (id)initWithDirectory:(NSString *)path
+{
+	if ((self = [super init])) {
+		directory = [path copy];
+	}
+	
+	return self;
+}
+
+- (NSString *)chunksDirectory
+{
+	return [directory stringByAppendingPathComponent:@"Chunks"];
+}
+
+- (NSString *)generationsDirectory
+{
+	return [directory stringByAppendingPathComponent:@"Generations"];
+}
+
+// Spread over 256 directories by the first two digits of the name
+- (NSString *)pathForChunk:(NSString *)name
+{
+	return [[[self chunksDirectory] stringByAppendingPathComponent:[name substringToIndex:2]] stringByAppendingPathComponent:name];
+}
+
+
+#pragma mark -
+#pragma mark Generations
+
+- (NSArray *)generations
+{
+	NSString *generationsDirectory = [self generationsDirectory];
+	NSMutableArray *generations = [NSMutableArray array];
+	
+	for (NSString *file in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:generationsDirectory error:NULL]) {
+		if (![[file pathExtension] isEqualToString:@"plist"]) {
+			continue;
+		}
+		
+		NSMutableDictionary *generation = [NSMutableDictionary dictionaryWithContentsOfFile:[generationsDirectory stringByAppendingPathComponent:file]];
+		
+		if ([generation objectForKey:kRootChunkKey] && [generation objectForKey:IdeaBackupDateKey]) {
+			[generation setObject:file forKey:kFileKey];
+			[generations addObject:generation];
+		}
+	}
+	
+	NSSortDescriptor *sortDescriptor = [[NSSortDescriptor alloc] initWithKey:IdeaBackupDateKey ascending:NO];
+	[generations sortUsingDescriptors:[NSArray arrayWithObject:sortDescriptor]];
+	[sortDescriptor release];
+	
+	return generations;
+}
+
+- (NSDate *)dateOfLatestGeneration
+{
+	NSArray *generations = [self generations];
+	
+	return [generations count] > 0 ? [[generations objectAtIndex:0] objectForKey:IdeaBackupDateKey] : nil;
+}
+
+- (NSDictionary *)backUpSnapshot:(IdeaSnapshot *)snapshot error:(NSError **)error
+{
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+	
+	if (![fileManager createDirectoryAtPath:[self generationsDirectory] withIntermediateDirectories:YES attributes:nil error:error]) {
+		return nil;
+	}
+	
+	IdeaBackupIndex index;
+	IdeaBackupIndexInit(&index);
+	
+	if (![self readIndex:&index generations:[self generations] error:error]) {
+		return nil;
+	}
+	
+	// The top level is stored like an idea without a name
+	NSString *rootChunk = [self writeChunkOfIdeaWithID:nil inSnapshot:snapshot index:&index error:error];
+	
+	if (rootChunk == nil) {
+		IdeaBackupIndexDestroy(&index);
+		return nil;
+	}
+	
+	NSDate *date = [NSDate date];
+	NSMutableDictionary *generation = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+									   rootChunk, kRootChunkKey,
+									   date, IdeaBackupDateKey,
+									   [NSNumber numberWithUnsignedInteger:[snapshot count]], IdeaBackupIdeaCountKey,
+									   nil];
+	
+	// Never over another generation, whose chunks would stay counted
+	NSString *file = [NSString stringWithFormat:@"%.0f.plist", [date timeIntervalSinceReferenceDate]];
+	
+	for (NSUInteger number = 2; [fileManager fileExistsAtPath:[[self generationsDirectory] stringByAppendingPathComponent:file]]; number++) {
+		file = [NSString stringWithFormat:@"%.0f-%d.plist", [date timeIntervalSinceReferenceDate], number];
+	}
+	
+	// The new chunks are all written by now, and are counted along with the generation
+	if (!IdeaBackupIndexRetain(&index, [rootChunk UTF8String]) || ![self writeIndex:&index removingChunks:NULL error:error]) {
+		IdeaBackupIndexDestroy(&index);
+		return nil;
+	}
+	
+	if (![generation writeToFile:[[self generationsDirectory] stringByAppendingPathComponent:file] atomically:YES]) {
+		IdeaBackupChunkList removedChunks;
+		IdeaBackupChunkListInit(&removedChunks);
+		
+		if (IdeaBackupIndexRelease(&index, [rootChunk UTF8String], IdeaBackupReadChildChunks, self, &removedChunks)) {
+			[self writeIndex:&index removingChunks:&removedChunks error:NULL];
+		}
+		
+		IdeaBackupChunkListDestroy(&removedChunks);
+		IdeaBackupIndexDestroy(&index);
+		return nil;
+	}
+	
+	IdeaBackupIndexDestroy(&index);
+	[generation setObject:file forKey:kFileKey];
+	
+	return generation;
+}
+
+// Children first, since an idea's chunk is named after theirs
+- (NSString *)writeChunkOfIdeaWithID:(NSManagedObjectID *)objectID inSnapshot:(IdeaSnapshot *)snapshot
+							   index:(IdeaBackupIndex *)index error:(NSError **)error
+{
+	NSArray *childIDs = [snapshot childIDsOfIdeaWithID:objectID];
+	NSMutableArray *childChunks = [NSMutableArray arrayWithCapacity:[childIDs count]];
+	
+	for (NSManagedObjectID *childID in childIDs) {
+		NSString *childChunk = [self writeChunkOfIdeaWithID:childID inSnapshot:snapshot index:index error:error];
+		
+		if (childChunk == nil) {
+			return nil;
+		}
+		
+		[childChunks addObject:childChunk];
+	}
+	
+	NSString *ideaName = objectID ? [snapshot nameOfIdeaWithID:objectID] : @"";
+	
+	return [self writeChunkWithName:ideaName childChunks:childChunks index:index error:error];
+}
+
+// A chunk the index has is left alone, along with the counts of its children. One that isn't in
+// the index can still be on disk, left behind by an interrupted backup; chunks are written
+// atomically, so it's whole and has the same contents.
+- (NSString *)writeChunkWithName:(NSString *)ideaName childChunks:(NSArray *)childChunks
+						   index:(IdeaBackupIndex *)index error:(NSError **)error
+{
+	NSString *errorDescription = nil;
+	NSData *data = [NSPropertyListSerialization dataFromPropertyList:[NSArray arrayWithObjects:ideaName, childChunks, nil]
+															  format:NSPropertyListBinaryFormat_v1_0
+													errorDescription:&errorDescription];
+	
+	if (data == nil) {
+		NSLog(@"Couldn't serialize chunk: %@", errorDescription);
+		[errorDescription release];
+		return nil;
+	}
+	
+	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+	CC_SHA1([data bytes], [data length], digest);
+	
+	NSMutableString *name = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+	for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+		[name appendFormat:@"%02x", digest[i]];
+	}
+	
+	const char **childNames = malloc(([childChunks count] + 1) * sizeof(const char *));
+	NSUInteger childCount = 0;
+	
+	if (childNames == NULL) {
+		return nil;
+	}
+	
+	for (NSString *childChunk in childChunks) {
+		childNames[childCount++] = [childChunk UTF8String];
+	}
+	
+	int added = IdeaBackupIndexAddChunk(index, [name UTF8String], childNames, childCount);
+	free(childNames);
+	
+	if (added < 0) {
+		NSLog(@"Couldn't count chunk %@", name);
+		return nil;
+	}
+	
+	NSString *path = [self pathForChunk:name];
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+	
+	if (added == 0 || [fileManager fileExistsAtPath:path]) {
+		return name;
+	}
+	
+	if (![fileManager createDirectoryAtPath:[path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:error]) {
+		return nil;
+	}
+	
+	if (![data writeToFile:path options:NSAtomicWrite error:error]) {
+		return nil;
+	}
+	
+	return name;
+}
+
+// Returns the name and child chunks of an idea, or nil if the chunk is missing or its contents
+// don't match its name
+- (NSArray *)readChunk:(NSString *)name
+{
+	if ([name length] != CC_SHA1_DIGEST_LENGTH * 2) {
+		return nil;
+	}
+	
+	NSData *data = [NSData dataWithContentsOfFile:[self pathForChunk:name]];
+	
+	if (data == nil) {
+		return nil;
+	}
+	
+	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+	CC_SHA1([data bytes], [data length], digest);
+	
+	for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+		if (![[name substringWithRange:NSMakeRange(i * 2, 2)] isEqualToString:[NSString stringWithFormat:@"%02x", digest[i]]]) {
+			NSLog(@"Damaged chunk %@", name);
+			return nil;
+		}
+	}
+	
+	NSArray *chunk = [NSPropertyListSerialization propertyListFromData:data
+													  mutabilityOption:NSPropertyListImmutable
+																format:NULL
+													  errorDescription:NULL];
+	
+	if (![chunk isKindOfClass:[NSArray class]] || [chunk count] != 2) {
+		return nil;
+	}
+	
+	return chunk;
+}
+
+
+#pragma mark -
+#pragma mark Restoring
+
+- (NSUInteger)restoreGeneration:(NSDictionary *)generation intoContext:(NSManagedObjectContext *)context
+{
+	NSArray *rootChunk = [self readChunk:[generation objectForKey:kRootChunkKey]];
+	
+	if (rootChunk == nil) {
+		return NSNotFound;
+	}
+	
+	NSDateFormatter *dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+	[dateFormatter setDateStyle:NSDateFormatterMediumStyle];
+	[dateFormatter setTimeStyle:NSDateFormatterShortStyle];
+	
+	NSManagedObject *container = [NSEntityDescription insertNewObjectForEntityForName:@"Idea" inManagedObjectContext:context];
+	[container setValue:[NSDate date] forKey:@"timeStamp"];
+	[container setValue:[NSString stringWithFormat:@"Backup of %@", [dateFormatter stringFromDate:[generation objectForKey:IdeaBackupDateKey]]]
+				 forKey:@"name"];
+	
+	return [self restoreChildChunks:[rootChunk objectAtIndex:1] underIdea:container context:context];
+}
+
+// Siblings get increasing order keys in the order they were backed up in, the last one now, so
+// that none of them is later than an idea added after the restore
+- (NSUInteger)restoreChildChunks:(NSArray *)childChunks underIdea:(NSManagedObject *)parent context:(NSManagedObjectContext *)context
+{
+	NSUInteger lostCount = 0;
+	NSDate *baseDate = [NSDate date];
+	NSUInteger count = [childChunks count];
+	NSUInteger index = 0;
+	
+	for (NSString *name in childChunks) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		NSArray *chunk = [self readChunk:name];
+		
+		if (chunk == nil) {
+			lostCount++;
+		} else {
+			NSManagedObject *idea = [NSEntityDescription insertNewObjectForEntityForName:@"Idea" inManagedObjectContext:context];
+			[idea setValue:[chunk objectAtIndex:0] forKey:@"name"];
+			index++;
+			[idea setValue:[NSDate dateWithTimeInterval:-(NSTimeInterval)(count - index) sinceDate:baseDate] forKey:@"timeStamp"];
+			[idea setValue:parent forKey:@"parent"];
+			
+			lostCount += [self restoreChildChunks:[chunk objectAtIndex:1] underIdea:idea context:context];
+		}
+		
+		[pool drain];
+	}
+	
+	return lostCount;
+}
+
+
+#pragma mark -
+#pragma mark Removing old generations
+
+- (void)removeGenerationsBeyondCount:(NSUInteger)count
+{
+	NSArray *generations = [self generations];
+	
+	if ([generations count] <= count) {
+		return;
+	}
+	
+	IdeaBackupIndex index;
+	IdeaBackupIndexInit(&index);
+	
+	NSError *error = nil;
+	
+	if (![self readIndex:&index generations:generations error:&error]) {
+		NSLog(@"Couldn't read the chunk index %@, %@", error, [error userInfo]);
+		return;
+	}
+	
+	IdeaBackupChunkList removedChunks;
+	IdeaBackupChunkListInit(&removedChunks);
+	
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+	BOOL released = YES;
+	
+	// The generation goes first, so its chunks are never uncounted for a generation that's still there
+	for (NSDictionary *generation in [generations subarrayWithRange:NSMakeRange(count, [generations count] - count)]) {
+		NSString *path = [[self generationsDirectory] stringByAppendingPathComponent:[generation objectForKey:kFileKey]];
+		
+		if (released && [fileManager removeItemAtPath:path error:NULL]) {
+			released = IdeaBackupIndexRelease(&index, [[generation objectForKey:kRootChunkKey] UTF8String],
+											  IdeaBackupReadChildChunks, self, &removedChunks);
+		}
+	}
+	
+	if (![self writeIndex:&index removingChunks:&removedChunks error:&error]) {
+		NSLog(@"Couldn't write the chunk index %@, %@", error, [error userInfo]);
+	}
+	
+	IdeaBackupChunkListDestroy(&removedChunks);
+	IdeaBackupIndexDestroy(&index);
+}
+
+
+#pragma mark -
+#pragma mark Chunk index
+
+// A missing or damaged index is counted again from the generations, which reads all of their chunks
+- (BOOL)readIndex:(IdeaBackupIndex *)index generations:(NSArray *)generations error:(NSError **)error
+{
+	NSString *path = [directory stringByAppendingPathComponent:kIndexFile];
+	
+	if (IdeaBackupIndexRead(index, [path fileSystemRepresentation])) {
+		return YES;
+	}
+	
+	if (errno != ENOENT) {
+		NSLog(@"Counting chunks again, the chunk index couldn't be read %@", IdeaBackupPOSIXError());
+	}
+	
+	NSUInteger rootCount = [generations count];
+	const char **rootNames = malloc((rootCount + 1) * sizeof(const char *));
+	BOOL rebuilt = NO;
+	
+	if (rootNames) {
+		for (NSUInteger i = 0; i < rootCount; i++) {
+			rootNames[i] = [[[generations objectAtIndex:i] objectForKey:kRootChunkKey] UTF8String];
+		}
+		
+		rebuilt = IdeaBackupIndexRebuild(index, rootNames, rootCount, IdeaBackupReadChildChunks, self);
+		free(rootNames);
+	}
+	
+	if (!rebuilt && error) {
+		*error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+	}
+	
+	return rebuilt;
+}
+
+// Chunks are only removed once the index no longer counts them
+- (BOOL)writeIndex:(IdeaBackupIndex *)index removingChunks:(IdeaBackupChunkList *)removedChunks error:(NSError **)error
+{
+	NSString *path = [directory stringByAppendingPathComponent:kIndexFile];
+	
+	if (!IdeaBackupIndexWrite(index, [path fileSystemRepresentation])) {
+		if (error) {
+			*error = IdeaBackupPOSIXError();
+		}
+		return NO;
+	}
+	
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+	
+	for (size_t i = 0; removedChunks && i < removedChunks->count; i++) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		[fileManager removeItemAtPath:[self pathForChunk:[NSString stringWithUTF8String:removedChunks->names[i]]] error:NULL];
+		[pool drain];
+	}
+	
+	return YES;
+}
+
+- (void)dealloc
+{
+	[directory release];
+	[super dealloc];
+}
+
+@end
+
+
+@implementation IdeaBackupOperation
+
+- (id)initWithBackup:(IdeaBackup *)aBackup persistentStoreCoordinator:(NSPersistentStoreCoordinator *)coordinator
+{
+	if ((self = [super init])) {
+		backup = [aBackup retain];
+		persistentStoreCoordinator = [coordinator retain];
+	}
+	
+	return self;
+}
+
+- (void)main
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	NSDate *latestDate = [backup dateOfLatestGeneration];
+	
+	if (latestDate == nil || -[latestDate timeIntervalSinceNow] >= kBackupInterval) {
+		NSError *error = nil;
+		IdeaSnapshot *snapshot = [IdeaSnapshot currentSnapshotWithPersistentStoreCoordinator:persistentStoreCoordinator error:&error];
+		
+		if (snapshot == nil || [backup backUpSnapshot:snapshot error:&error] == nil) {
+			NSLog(@"Backup failed %@, %@", error, [error userInfo]);
+		} else {
+			[backup removeGenerationsBeyondCount:kGenerationLimit];
+		}
+	}
+	
+	[pool drain];
+}
+
+- (void)dealloc
+{
+	[backup release];
+	[persistentStoreCoordinator release];
+	[super dealloc];
+}
+
+@end
+
+
+@implementation IdeaRestoreOperation
+
+- (id)initWithBackup:(IdeaBackup *)aBackup generation:(NSDictionary *)aGeneration managedObjectContext:(NSManagedObjectContext *)context
+{
+	if ((self = [super init])) {
+		backup = [aBackup retain];
+		generation = [aGeneration retain];
+		mainContext = [context retain];
+	}
+	
+	return self;
+}
+
+- (void)main
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	NSManagedObjectContext *context = [[NSManagedObjectContext alloc] init];
+	[context setPersistentStoreCoordinator:[mainContext persistentStoreCoordinator]];
+	[context setUndoManager:nil];
+	
+	NSUInteger lostCount = [backup restoreGeneration:generation intoContext:context];
+	NSString *report = nil;
+	
+	if (lostCount == NSNotFound) {
+		report = @"The backup couldn't be read, so nothing was added to your board.";
+	} else {
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(contextDidSave:)
+													 name:NSManagedObjectContextDidSaveNotification
+												   object:context];
+		
+		NSError *error = nil;
+		if (![context save:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+			
+			report = @"The backup couldn't be added to your board.";
+		} else if (lostCount > 0) {
+			report = [NSString stringWithFormat:@"The backup was added to your board, but %d of its entries were damaged and were left out along with their children.", lostCount];
+		}
+		
+		[[NSNotificationCenter defaultCenter] removeObserver:self name:NSManagedObjectContextDidSaveNotification object:context];
+	}
+	
+	// Settings is gone by now, so the alert is the only place to tell
+	if (report) {
+		[self performSelectorOnMainThread:@selector(showReport:) withObject:report waitUntilDone:NO];
+	}
+	
+	[context release];
+	[pool drain];
+}
+
+- (void)showReport:(NSString *)report
+{
+	UIAlertView *alert = [[UIAlertView alloc] initWithTitle:@"Restore Backup"
+													message:report
+												   delegate:nil
+										  cancelButtonTitle:@"Ok"
+										  otherButtonTitles:nil];
+	[alert show];
+	[alert release];
+}
+
+// The main context only learns about the restored ideas by merging them in
+- (void)contextDidSave:(NSNotification *)notification
+{
+	[mainContext performSelectorOnMainThread:@selector(mergeChangesFromContextDidSaveNotification:) withObject:notification waitUntilDone:YES];
+}
+
+- (void)dealloc
+{
+	[backup release];
+	[generation release];
+	[mainContext release];
+	[super dealloc];
+}
+
+@end
@@ -0,0 +1,420 @@
+//
+//  IdeaBackupIndex.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/28/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "IdeaBackupIndex.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// An empty slot has an empty name
+struct IdeaBackupIndexEntry {
+	IdeaBackupChunkName name;
+	long count;
+};
+
+static const char kNewIndexSuffix[] = ".new";
+
+// The first line of the file, followed by the number of chunks, then a line per chunk
+static const char kIndexHeader[] = "GreenBoardPro chunk index 1";
+
+
+#pragma mark -
+#pragma mark Chunk lists
+
+void IdeaBackupChunkListInit(IdeaBackupChunkList *list)
+{
+	list->names = NULL;
+	list->count = 0;
+	list->capacity = 0;
+}
+
+void IdeaBackupChunkListDestroy(IdeaBackupChunkList *list)
+{
+	free(list->names);
+	IdeaBackupChunkListInit(list);
+}
+
+static int IdeaBackupIsChunkName(const char *name)
+{
+	size_t length = 0;
+	
+	for (; name[length]; length++) {
+		char c = name[length];
+		if (length == IDEA_BACKUP_CHUNK_NAME_LENGTH || !((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+			return 0;
+		}
+	}
+	
+	return length == IDEA_BACKUP_CHUNK_NAME_LENGTH;
+}
+
+int IdeaBackupChunkListAppend(IdeaBackupChunkList *list, const char *name)
+{
+	if (!IdeaBackupIsChunkName(name)) {
+		return 0;
+	}
+	
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity ? 2 * list->capacity : 16;
+		IdeaBackupChunkName *names = realloc(list->names, capacity * sizeof(IdeaBackupChunkName));
+		
+		if (names == NULL) {
+			return 0;
+		}
+		
+		list->names = names;
+		list->capacity = capacity;
+	}
+	
+	memcpy(list->names[list->count++], name, sizeof(IdeaBackupChunkName));
+	return 1;
+}
+
+
+#pragma mark -
+#pragma mark Hash table
+
+// Names are already hashes, so their first digits do
+static size_t IdeaBackupIndexHome(const IdeaBackupIndex *index, const char *name)
+{
+	size_t hash = 0;
+	
+	for (int i = 0; i < 16; i++) {
+		char c = name[i];
+		hash = (hash << 4) | (size_t)(c <= '9' ? c - '0' : c - 'a' + 10);
+	}
+	
+	return hash & (index->capacity - 1);
+}
+
+// The slot holding name, or the empty slot it would go in
+static size_t IdeaBackupIndexSlot(const IdeaBackupIndex *index, const char *name)
+{
+	size_t slot = IdeaBackupIndexHome(index, name);
+	
+	while (index->entries[slot].name[0] && strcmp(index->entries[slot].name, name) != 0) {
+		slot = (slot + 1) & (index->capacity - 1);
+	}
+	
+	return slot;
+}
+
+static IdeaBackupIndexEntry *IdeaBackupIndexFind(const IdeaBackupIndex *index, const char *name)
+{
+	if (index->count == 0 || !IdeaBackupIsChunkName(name)) {
+		return NULL;
+	}
+	
+	IdeaBackupIndexEntry *entry = &index->entries[IdeaBackupIndexSlot(index, name)];
+	
+	return entry->name[0] ? entry : NULL;
+}
+
+// Kept at most half full. Returns NULL if there isn't enough memory.
+static IdeaBackupIndexEntry *IdeaBackupIndexInsert(IdeaBackupIndex *index, const char *name, long count)
+{
+	if (2 * (index->count + 1) > index->capacity) {
+		IdeaBackupIndex larger;
+		
+		larger.capacity = index->capacity ? 2 * index->capacity : 256;
+		larger.count = index->count;
+		larger.entries = calloc(larger.capacity, sizeof(IdeaBackupIndexEntry));
+		
+		if (larger.entries == NULL) {
+			return NULL;
+		}
+		
+		for (size_t i = 0; i < index->capacity; i++) {
+			if (index->entries[i].name[0]) {
+				larger.entries[IdeaBackupIndexSlot(&larger, index->entries[i].name)] = index->entries[i];
+			}
+		}
+		
+		free(index->entries);
+		*index = larger;
+	}
+	
+	IdeaBackupIndexEntry *entry = &index->entries[IdeaBackupIndexSlot(index, name)];
+	
+	memcpy(entry->name, name, sizeof(IdeaBackupChunkName));
+	entry->count = count;
+	index->count++;
+	
+	return entry;
+}
+
+// Moves the entries after the hole back into it where their probe allows, so that no lookup
+// stops short at it
+static void IdeaBackupIndexRemove(IdeaBackupIndex *index, IdeaBackupIndexEntry *entry)
+{
+	size_t mask = index->capacity - 1;
+	size_t hole = (size_t)(entry - index->entries);
+	
+	for (size_t next = (hole + 1) & mask; index->entries[next].name[0]; next = (next + 1) & mask) {
+		size_t home = IdeaBackupIndexHome(index, index->entries[next].name);
+		
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			index->entries[hole] = index->entries[next];
+			hole = next;
+		}
+	}
+	
+	index->entries[hole].name[0] = 0;
+	index->count--;
+}
+
+
+#pragma mark -
+#pragma mark Index
+
+void IdeaBackupIndexInit(IdeaBackupIndex *index)
+{
+	index->entries = NULL;
+	index->count = 0;
+	index->capacity = 0;
+}
+
+void IdeaBackupIndexDestroy(IdeaBackupIndex *index)
+{
+	free(index->entries);
+	IdeaBackupIndexInit(index);
+}
+
+int IdeaBackupIndexRead(IdeaBackupIndex *index, const char *path)
+{
+	IdeaBackupIndexDestroy(index);
+	
+	FILE *file = fopen(path, "r");
+	
+	if (file == NULL) {
+		return 0;
+	}
+	
+	char header[sizeof(kIndexHeader) + 1];
+	unsigned long count;
+	int valid = fgets(header, sizeof(header), file) && strncmp(header, kIndexHeader, sizeof(kIndexHeader) - 1) == 0 &&
+				header[sizeof(kIndexHeader) - 1] == '\n' && fscanf(file, "%lu\n", &count) == 1;
+	
+	for (unsigned long i = 0; valid && i < count; i++) {
+		IdeaBackupChunkName name;
+		long references;
+		
+		// A chunk in the index twice would be released too early
+		valid = fscanf(file, "%40s %ld\n", name, &references) == 2 && IdeaBackupIsChunkName(name) &&
+				references > 0 && IdeaBackupIndexFind(index, name) == NULL;
+		
+		if (valid && IdeaBackupIndexInsert(index, name, references) == NULL) {
+			IdeaBackupIndexDestroy(index);
+			fclose(file);
+			errno = ENOMEM;
+			return 0;
+		}
+	}
+	
+	valid = valid && fgetc(file) == EOF && !ferror(file);
+	fclose(file);
+	
+	if (!valid) {
+		IdeaBackupIndexDestroy(index);
+		errno = EINVAL;
+		return 0;
+	}
+	
+	return 1;
+}
+
+int IdeaBackupIndexWrite(const IdeaBackupIndex *index, const char *path)
+{
+	char newPath[PATH_MAX];
+	int length = snprintf(newPath, sizeof(newPath), "%s%s", path, kNewIndexSuffix);
+	
+	if (length < 0 || (size_t)length >= sizeof(newPath)) {
+		errno = ENAMETOOLONG;
+		return 0;
+	}
+	
+	FILE *file = fopen(newPath, "w");
+	
+	if (file == NULL) {
+		return 0;
+	}
+	
+	int written = fprintf(file, "%s\n%lu\n", kIndexHeader, (unsigned long)index->count) > 0;
+	
+	for (size_t i = 0; written && i < index->capacity; i++) {
+		if (index->entries[i].name[0]) {
+			written = fprintf(file, "%s %ld\n", index->entries[i].name, index->entries[i].count) > 0;
+		}
+	}
+	
+	// On disk before it replaces the old index, which the rename alone doesn't promise
+	written = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+	
+	if (fclose(file) != 0 || !written || rename(newPath, path) != 0) {
+		int writeError = errno;
+		unlink(newPath);
+		errno = writeError;
+		return 0;
+	}
+	
+	return 1;
+}
+
+int IdeaBackupIndexRebuild(IdeaBackupIndex *index, const char * const *rootNames, size_t rootCount,
+						   IdeaBackupReadChildChunks readChildChunks, void *info)
+{
+	IdeaBackupChunkList pending;
+	IdeaBackupChunkList children;
+	IdeaBackupChunkList unreadable;
+	int succeeded = 1;
+	
+	IdeaBackupIndexDestroy(index);
+	IdeaBackupChunkListInit(&pending);
+	IdeaBackupChunkListInit(&children);
+	IdeaBackupChunkListInit(&unreadable);
+	
+	// Every chunk is read once, when it's first reached
+	for (size_t i = 0; succeeded && i < rootCount; i++) {
+		if (IdeaBackupIndexRetain(index, rootNames[i])) {
+			continue;
+		}
+		succeeded = !IdeaBackupIsChunkName(rootNames[i]) ||
+					(IdeaBackupIndexInsert(index, rootNames[i], 1) && IdeaBackupChunkListAppend(&pending, rootNames[i]));
+	}
+	
+	while (succeeded && pending.count > 0) {
+		IdeaBackupChunkName name;
+		memcpy(name, pending.names[--pending.count], sizeof(name));
+		
+		children.count = 0;
+		if (!readChildChunks(info, name, &children)) {
+			succeeded = IdeaBackupChunkListAppend(&unreadable, name);
+			continue;
+		}
+		
+		for (size_t i = 0; succeeded && i < children.count; i++) {
+			if (!IdeaBackupIndexRetain(index, children.names[i])) {
+				succeeded = IdeaBackupIndexInsert(index, children.names[i], 1) && IdeaBackupChunkListAppend(&pending, children.names[i]);
+			}
+		}
+	}
+	
+	// Left out so that a backup that has them writes them again
+	for (size_t i = 0; succeeded && i < unreadable.count; i++) {
+		IdeaBackupIndexRemove(index, IdeaBackupIndexFind(index, unreadable.names[i]));
+	}
+	
+	IdeaBackupChunkListDestroy(&pending);
+	IdeaBackupChunkListDestroy(&children);
+	IdeaBackupChunkListDestroy(&unreadable);
+	
+	if (!succeeded) {
+		IdeaBackupIndexDestroy(index);
+	}
+	
+	return succeeded;
+}
+
+long IdeaBackupIndexCount(const IdeaBackupIndex *index, const char *name)
+{
+	IdeaBackupIndexEntry *entry = IdeaBackupIndexFind(index, name);
+	
+	return entry ? entry->count : 0;
+}
+
+int IdeaBackupIndexAddChunk(IdeaBackupIndex *index, const char *name, const char * const *childNames, size_t childCount)
+{
+	if (!IdeaBackupIsChunkName(name)) {
+		return -1;
+	}
+	if (IdeaBackupIndexFind(index, name)) {
+		return 0;
+	}
+	
+	// Children are written before their parents, so they're all in the index by now
+	for (size_t i = 0; i < childCount; i++) {
+		if (IdeaBackupIndexFind(index, childNames[i]) == NULL) {
+			return -1;
+		}
+	}
+	
+	if (IdeaBackupIndexInsert(index, name, 0) == NULL) {
+		return -1;
+	}
+	
+	for (size_t i = 0; i < childCount; i++) {
+		IdeaBackupIndexRetain(index, childNames[i]);
+	}
+	
+	return 1;
+}
+
+int IdeaBackupIndexRetain(IdeaBackupIndex *index, const char *name)
+{
+	IdeaBackupIndexEntry *entry = IdeaBackupIndexFind(index, name);
+	
+	if (entry == NULL) {
+		return 0;
+	}
+	
+	entry->count++;
+	return 1;
+}
+
+int IdeaBackupIndexRelease(IdeaBackupIndex *index, const char *name,
+						   IdeaBackupReadChildChunks readChildChunks, void *info, IdeaBackupChunkList *removed)
+{
+	IdeaBackupIndexEntry *entry = IdeaBackupIndexFind(index, name);
+	
+	if (entry == NULL) {
+		return 1;
+	}
+	if (--entry->count > 0) {
+		return 1;
+	}
+	
+	// removed doubles as the list of chunks whose children are still to be released
+	size_t next = removed->count;
+	
+	IdeaBackupIndexRemove(index, entry);
+	if (!IdeaBackupChunkListAppend(removed, name)) {
+		return 0;
+	}
+	
+	IdeaBackupChunkList children;
+	int succeeded = 1;
+	
+	IdeaBackupChunkListInit(&children);
+	
+	for (; succeeded && next < removed->count; next++) {
+		children.count = 0;
+		
+		// A damaged chunk can't name its children anymore, which are then left behind
+		if (!readChildChunks(info, removed->names[next], &children)) {
+			continue;
+		}
+		
+		for (size_t i = 0; succeeded && i < children.count; i++) {
+			entry = IdeaBackupIndexFind(index, children.names[i]);
+			
+			if (entry && --entry->count == 0) {
+				IdeaBackupIndexRemove(index, entry);
+				succeeded = IdeaBackupChunkListAppend(removed, children.names[i]);
+			}
+		}
+	}
+	
+	IdeaBackupChunkListDestroy(&children);
+	
+	return succeeded;
+}
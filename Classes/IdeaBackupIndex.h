@@ -0,0 +1,88 @@
+//
+//  IdeaBackupIndex.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/28/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef IDEA_BACKUP_INDEX_H
+#define IDEA_BACKUP_INDEX_H
+
+#include <stddef.h>
+
+// The reference counts of IdeaBackup's chunks, in plain C so that they can be tested on their own
+// (see Tests/BackupTests.c). Every chunk in the index is counted once for each generation naming
+// it as its root and once for each time a chunk in the index names it as a child. The counts of
+// all chunks are kept in a single file, read once before a backup or a prune and written once
+// after, so that a backup only costs the chunks it writes.
+//
+// A chunk is only ever counted after it's written and only removed after the index no longer
+// counts it, and a generation is only written after the index counting it and only removed before
+// the index that stops counting it. An interruption can then leave a chunk behind, but never
+// removes one that's still named.
+
+// Chunks are named by the 40 hex digits of the SHA-1 of their contents
+#define IDEA_BACKUP_CHUNK_NAME_LENGTH 40
+
+typedef char IdeaBackupChunkName[IDEA_BACKUP_CHUNK_NAME_LENGTH + 1];
+
+typedef struct {
+	IdeaBackupChunkName *names;
+	size_t count;
+	size_t capacity;
+} IdeaBackupChunkList;
+
+void IdeaBackupChunkListInit(IdeaBackupChunkList *list);
+void IdeaBackupChunkListDestroy(IdeaBackupChunkList *list);
+
+// Returns 0 if name isn't a chunk name or there isn't enough memory
+int IdeaBackupChunkListAppend(IdeaBackupChunkList *list, const char *name);
+
+// Appends the names of the children of the chunk, in the order the chunk has them. Returns 0 if
+// the chunk is missing or damaged, in which case its children are neither counted nor released.
+typedef int (*IdeaBackupReadChildChunks)(void *info, const char *name, IdeaBackupChunkList *children);
+
+typedef struct IdeaBackupIndexEntry IdeaBackupIndexEntry;
+
+typedef struct {
+	IdeaBackupIndexEntry *entries;
+	size_t count;
+	size_t capacity;
+} IdeaBackupIndex;
+
+void IdeaBackupIndexInit(IdeaBackupIndex *index);
+void IdeaBackupIndexDestroy(IdeaBackupIndex *index);
+
+// Replaces what index holds with the index at path. Returns 0 with errno set if the file can't
+// be read, ENOENT if there's none, or EINVAL if it isn't an index, leaving index empty.
+int IdeaBackupIndexRead(IdeaBackupIndex *index, const char *path);
+
+// Writes a copy next to path and renames it over path, so that an interruption leaves either the
+// old index or the new one. Returns 0 with errno set if the index couldn't be written.
+int IdeaBackupIndexWrite(const IdeaBackupIndex *index, const char *path);
+
+// Counts every chunk reachable from the roots from scratch, for when the index is missing or
+// damaged. Chunks that can't be read are left out. Returns 0 if there isn't enough memory.
+int IdeaBackupIndexRebuild(IdeaBackupIndex *index, const char * const *rootNames, size_t rootCount,
+						   IdeaBackupReadChildChunks readChildChunks, void *info);
+
+// 0 for a chunk that isn't in the index
+long IdeaBackupIndexCount(const IdeaBackupIndex *index, const char *name);
+
+// Puts a chunk in the index, uncounted, and counts its children for it. Returns 1 if the chunk was
+// added, in which case it still has to be written, 0 if it was already there, or -1 if there isn't
+// enough memory.
+int IdeaBackupIndexAddChunk(IdeaBackupIndex *index, const char *name, const char * const *childNames, size_t childCount);
+
+// Counts a reference to a chunk in the index. Returns 0 if it isn't in the index.
+int IdeaBackupIndexRetain(IdeaBackupIndex *index, const char *name);
+
+// Uncounts a reference to a chunk. A chunk no longer named is taken out of the index and appended
+// to removed, and its children are released in turn. The chunks in removed are only to be
+// removed once the index is written. Releasing a chunk that isn't in the index does nothing.
+// Returns 0 if there isn't enough memory, in which case some chunks may be left behind.
+int IdeaBackupIndexRelease(IdeaBackupIndex *index, const char *name,
+						   IdeaBackupReadChildChunks readChildChunks, void *info, IdeaBackupChunkList *removed);
+
+#endif
@@ -13,11 +13,13 @@
 
 @class RootViewController;
 @class Idea;
+@class IdeaOperationLog;
 
 @interface IdeaDetailViewController : UIViewController <UITextFieldDelegate> {
 	IBOutlet UITextField *name;
 	Idea *idea;
 	BOOL newIdea;
+	IdeaOperationLog *operationLog;
 	
 	id <IdeaDetailDelegate> delegate;
 }
@@ -25,6 +27,7 @@
 @property (nonatomic, retain) IBOutlet UITextField *name;
 @property (nonatomic, retain) Idea *idea;
 @property (nonatomic, assign) BOOL newIdea;
+@property (nonatomic, retain) IdeaOperationLog *operationLog;
 
 @property (nonatomic, retain) id <IdeaDetailDelegate> delegate;
 
@@ -10,6 +10,7 @@
 #import "RootViewController.h"
 #import "Idea.h"
 #import "ApplicationHelper.h"
+#import "IdeaOperationLog.h"
 
 
 @implementation IdeaDetailViewController
@@ -17,6 +18,7 @@
 @synthesize name;
 @synthesize idea;
 @synthesize newIdea;
+@synthesize operationLog;
 @synthesize delegate;
 
 // The designated initializer.  Override if you create the controller programmatically and want to perform customization that is not appropriate for viewDidLoad.
@@ -91,10 +93,15 @@
 - (void)save
 {
 	if (name.text.length == 0) {
+		if (!newIdea) {
+			[operationLog recordDeleteOfIdea:idea];
+		}
+		
 		[idea.managedObjectContext deleteObject:idea];
 		[delegate ideaDetailViewControllerDidForceDelete:self];
 		return;
 	}
+	NSString *oldName = [[[idea valueForKey:@"name"] copy] autorelease];
 	[idea setValue:name.text forKey:@"name"];
 	
 	NSError *error = nil;
@@ -102,6 +109,10 @@
 		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
         
 		[ApplicationHelper showApplicationError];
+	} else if (newIdea) {
+		[operationLog recordInsertOfIdea:idea];
+	} else if (![oldName isEqualToString:name.text]) {
+		[operationLog recordRenameOfIdea:idea fromName:oldName];
 	}
 	
 	[name resignFirstResponder];
@@ -146,6 +157,7 @@
 - (void)dealloc {
 	[name release];
 	[idea release];
+	[operationLog release];
 	[delegate release];
     [super dealloc];
 }
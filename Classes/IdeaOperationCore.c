@@ -0,0 +1,189 @@
+//
+//  IdeaOperationCore.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/25/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "IdeaOperationCore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#pragma mark -
+#pragma mark Ring buffer
+
+int OperationRingInit(OperationRing *ring, size_t capacity, size_t byteLimit,
+					  void (*dropSlot)(void *info, size_t slot), void *info)
+{
+	memset(ring, 0, sizeof(*ring));
+	
+	ring->slotByteCounts = calloc(capacity, sizeof(size_t));
+	if (ring->slotByteCounts == NULL) {
+		return 0;
+	}
+	
+	ring->capacity = capacity;
+	ring->byteLimit = byteLimit;
+	ring->dropSlot = dropSlot;
+	ring->info = info;
+	
+	return 1;
+}
+
+void OperationRingDestroy(OperationRing *ring)
+{
+	free(ring->slotByteCounts);
+	ring->slotByteCounts = NULL;
+}
+
+size_t OperationRingSlotAtIndex(const OperationRing *ring, size_t index)
+{
+	return (ring->start + index) % ring->capacity;
+}
+
+static void OperationRingDrop(OperationRing *ring, size_t slot)
+{
+	ring->byteCount -= ring->slotByteCounts[slot];
+	ring->slotByteCounts[slot] = 0;
+	
+	if (ring->dropSlot) {
+		ring->dropSlot(ring->info, slot);
+	}
+}
+
+static void OperationRingRemoveOldest(OperationRing *ring)
+{
+	OperationRingDrop(ring, ring->start);
+	
+	ring->start = (ring->start + 1) % ring->capacity;
+	ring->count--;
+	
+	if (ring->undoCount > 0) {
+		ring->undoCount--;
+	}
+}
+
+static void OperationRingRemoveNewest(OperationRing *ring)
+{
+	OperationRingDrop(ring, OperationRingSlotAtIndex(ring, ring->count - 1));
+	
+	ring->count--;
+	
+	if (ring->undoCount > ring->count) {
+		ring->undoCount = ring->count;
+	}
+}
+
+size_t OperationRingAdd(OperationRing *ring, size_t byteCount)
+{
+	while (ring->count > ring->undoCount) {
+		OperationRingRemoveNewest(ring);
+	}
+	
+	if (ring->count == ring->capacity) {
+		OperationRingRemoveOldest(ring);
+	}
+	
+	size_t slot = OperationRingSlotAtIndex(ring, ring->count);
+	
+	ring->slotByteCounts[slot] = byteCount;
+	ring->count++;
+	ring->undoCount++;
+	ring->byteCount += byteCount;
+	
+	while (ring->byteCount > ring->byteLimit && ring->count > 1) {
+		OperationRingRemoveOldest(ring);
+	}
+	
+	return slot;
+}
+
+void OperationRingRemoveAll(OperationRing *ring)
+{
+	while (ring->count > 0) {
+		OperationRingRemoveNewest(ring);
+	}
+	
+	ring->start = 0;
+}
+
+int OperationRingCanUndo(const OperationRing *ring)
+{
+	return ring->undoCount > 0;
+}
+
+int OperationRingCanRedo(const OperationRing *ring)
+{
+	return ring->undoCount < ring->count;
+}
+
+size_t OperationRingUndoSlot(const OperationRing *ring)
+{
+	return OperationRingSlotAtIndex(ring, ring->undoCount - 1);
+}
+
+size_t OperationRingRedoSlot(const OperationRing *ring)
+{
+	return OperationRingSlotAtIndex(ring, ring->undoCount);
+}
+
+void OperationRingDidUndo(OperationRing *ring)
+{
+	ring->undoCount--;
+}
+
+void OperationRingDidRedo(OperationRing *ring)
+{
+	ring->undoCount++;
+}
+
+
+#pragma mark -
+#pragma mark Name delta
+
+void NameDeltaCompute(const NameDeltaChar *oldName, size_t oldLength,
+					  const NameDeltaChar *newName, size_t newLength,
+					  size_t *prefixLength, size_t *suffixLength)
+{
+	size_t shortestLength = oldLength < newLength ? oldLength : newLength;
+	size_t prefix = 0;
+	size_t suffix = 0;
+	
+	while (prefix < shortestLength && oldName[prefix] == newName[prefix]) {
+		prefix++;
+	}
+	
+	// The suffix can't overlap the prefix in either name
+	while (suffix < shortestLength - prefix && oldName[oldLength - suffix - 1] == newName[newLength - suffix - 1]) {
+		suffix++;
+	}
+	
+	*prefixLength = prefix;
+	*suffixLength = suffix;
+}
+
+int NameDeltaApply(const NameDeltaChar *name, size_t length,
+				   size_t prefixLength, size_t currentLength, size_t suffixLength,
+				   const NameDeltaChar *replacement, size_t replacementLength,
+				   NameDeltaChar *result)
+{
+	if (length != prefixLength + currentLength + suffixLength) {
+		return 0;
+	}
+	
+	// Empty names and replacements may come as NULL, which memcpy doesn't take even for 0 bytes
+	if (prefixLength > 0) {
+		memcpy(result, name, prefixLength * sizeof(NameDeltaChar));
+	}
+	if (replacementLength > 0) {
+		memcpy(result + prefixLength, replacement, replacementLength * sizeof(NameDeltaChar));
+	}
+	if (suffixLength > 0) {
+		memcpy(result + prefixLength + replacementLength, name + prefixLength + currentLength, suffixLength * sizeof(NameDeltaChar));
+	}
+	
+	return 1;
+}
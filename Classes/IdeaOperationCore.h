@@ -0,0 +1,78 @@
+//
+//  IdeaOperationCore.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/25/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef IDEA_OPERATION_CORE_H
+#define IDEA_OPERATION_CORE_H
+
+#include <stddef.h>
+
+// The parts of IdeaOperationLog that don't need Foundation, so that they can be tested on their
+// own (see Tests/OperationLogTests.c).
+
+
+// Bookkeeping of the ring buffer of operations. The ring only hands out slots: the caller keeps
+// the operation of each slot and is told to let go of it through dropSlot, which is called once
+// for every slot whose operation leaves the ring.
+typedef struct {
+	size_t capacity;
+	size_t byteLimit;
+	size_t start;
+	size_t count;
+	size_t undoCount;
+	size_t byteCount;
+	size_t *slotByteCounts;
+
+	void (*dropSlot)(void *info, size_t slot);
+	void *info;
+} OperationRing;
+
+// Returns 0 if there isn't enough memory
+int OperationRingInit(OperationRing *ring, size_t capacity, size_t byteLimit,
+					  void (*dropSlot)(void *info, size_t slot), void *info);
+void OperationRingDestroy(OperationRing *ring);
+
+// Slot of the operation at index, the oldest one being at 0
+size_t OperationRingSlotAtIndex(const OperationRing *ring, size_t index);
+
+// Drops the operations that were undone, since they can't be redone on top of a new one, and the
+// oldest ones beyond the capacity or the byte limit, though the new operation is always kept.
+// Returns the slot the new operation goes into.
+size_t OperationRingAdd(OperationRing *ring, size_t byteCount);
+
+void OperationRingRemoveAll(OperationRing *ring);
+
+int OperationRingCanUndo(const OperationRing *ring);
+int OperationRingCanRedo(const OperationRing *ring);
+
+// Slots of the operation the next undo or redo applies, only valid when it can be undone or redone
+size_t OperationRingUndoSlot(const OperationRing *ring);
+size_t OperationRingRedoSlot(const OperationRing *ring);
+
+// To be called once the operation of the undo or redo slot has been applied
+void OperationRingDidUndo(OperationRing *ring);
+void OperationRingDidRedo(OperationRing *ring);
+
+
+// The difference between two names, in UTF-16 units like unichar: both share prefixLength
+// leading and suffixLength trailing characters, which never overlap in either name.
+typedef unsigned short NameDeltaChar;
+
+void NameDeltaCompute(const NameDeltaChar *oldName, size_t oldLength,
+					  const NameDeltaChar *newName, size_t newLength,
+					  size_t *prefixLength, size_t *suffixLength);
+
+// Replaces the currentLength characters after the prefix of name with replacement, writing
+// prefixLength + replacementLength + suffixLength characters to result. Returns 0 and writes
+// nothing if name isn't prefixLength + currentLength + suffixLength long, which means it was
+// changed some other way since the delta was taken.
+int NameDeltaApply(const NameDeltaChar *name, size_t length,
+				   size_t prefixLength, size_t currentLength, size_t suffixLength,
+				   const NameDeltaChar *replacement, size_t replacementLength,
+				   NameDeltaChar *result);
+
+#endif
@@ -0,0 +1,55 @@
+//
+//  IdeaOperationLog.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/25/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+#import "IdeaOperationCore.h"
+
+@class Idea;
+
+// Records edits to the board as small, self-contained operations so they can be undone and
+// redone. Every operation only stores what it changed: a rename keeps the part of the name that
+// changed, a delete keeps its subtree serialized as a binary property list, and undoing or redoing
+// an operation only touches the ideas it's about, besides spacing out the order keys of a moved
+// idea's siblings when there's no room left between them. Operations live in a ring buffer which
+// drops the oldest ones beyond a number of operations or bytes. Each call records an edit that has
+// already been saved, and undo and redo save the context themselves.
+@interface IdeaOperationLog : NSObject {
+	NSManagedObjectContext *managedObjectContext;
+
+	// One operation per slot of the ring, NSNull for the free ones
+	NSMutableArray *operations;
+	OperationRing ring;
+
+	// Ideas brought back by undoing a delete or redoing an insert get new object ids
+	NSMutableDictionary *replacedObjectIDs;
+}
+
+- (id)initWithManagedObjectContext:(NSManagedObjectContext *)context;
+
+- (void)recordInsertOfIdea:(Idea *)idea;
+- (void)recordRenameOfIdea:(Idea *)idea fromName:(NSString *)oldName;
+// oldIndex is where the idea was among oldParent's children, itself included, or NSNotFound to
+// put it back at the end
+- (void)recordMoveOfIdea:(Idea *)idea fromParent:(Idea *)oldParent index:(NSUInteger)oldIndex;
+
+// Has to be called before the idea is deleted
+- (void)recordDeleteOfIdea:(Idea *)idea;
+
+- (BOOL)canUndo;
+- (BOOL)canRedo;
+- (NSString *)undoActionName;
+- (NSString *)redoActionName;
+
+// Return NO if the operation couldn't be applied, in which case it's dropped from the log
+- (BOOL)undo;
+- (BOOL)redo;
+
+- (void)removeAllOperations;
+
+@end
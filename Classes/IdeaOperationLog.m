@@ -0,0 +1,575 @@
+//
+//  IdeaOperationLog.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/25/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "IdeaOperationLog.h"
+#import "Idea.h"
+
+
+// The ring buffer holds at most this many operations, and drops the oldest ones once they take
+// more than kByteLimit, though the latest operation is always kept
+static const NSUInteger kOperationLimit = 256;
+static const NSUInteger kByteLimit = 256 * 1024;
+
+// Rough cost of an operation besides its strings and data
+static const NSUInteger kOperationOverhead = 64;
+
+
+typedef enum {
+	IdeaOperationInsert,
+	IdeaOperationRename,
+	IdeaOperationDelete,
+	IdeaOperationMove
+} IdeaOperationType;
+
+
+// One edit. Ideas are referred to by object id, a nil parent id stands for the top level.
+@interface IdeaOperation : NSObject {
+@public
+	IdeaOperationType type;
+	NSManagedObjectID *ideaID;
+
+	// Insert: where the idea was added and its name. Delete: the parent of the deleted subtree.
+	// Move: where it was and where it went, as positions among the siblings rather than order
+	// keys, since moving it either way can space out the keys of all its siblings.
+	NSManagedObjectID *oldParentID;
+	NSManagedObjectID *newParentID;
+	NSDate *newTimeStamp;
+	NSUInteger oldIndex;
+	NSUInteger newIndex;
+	NSString *name;
+
+	// Rename: both names share prefixLength leading and suffixLength trailing characters,
+	// removedText was between them before and insertedText is after
+	NSUInteger prefixLength;
+	NSUInteger suffixLength;
+	NSString *removedText;
+	NSString *insertedText;
+
+	// Delete: the subtree as a binary property list
+	NSData *subtree;
+
+	NSUInteger byteCount;
+}
+@end
+
+@implementation IdeaOperation
+
+- (void)dealloc
+{
+	[ideaID release];
+	[oldParentID release];
+	[newParentID release];
+	[newTimeStamp release];
+	[name release];
+	[removedText release];
+	[insertedText release];
+	[subtree release];
+	[super dealloc];
+}
+
+@end
+
+
+@interface IdeaOperationLog ()
+- (IdeaOperation *)operationWithType:(IdeaOperationType)type idea:(Idea *)idea;
+- (void)addOperation:(IdeaOperation *)operation;
+- (NSString *)actionNameForOperation:(IdeaOperation *)operation;
+- (BOOL)applyOperation:(IdeaOperation *)operation reverse:(BOOL)reverse;
+- (BOOL)applyOperation:(IdeaOperation *)operation reverse:(BOOL)reverse restoredIdeas:(NSMutableDictionary *)restoredIdeas;
+- (Idea *)ideaWithID:(NSManagedObjectID *)objectID;
+- (BOOL)resolveParentID:(NSManagedObjectID *)parentID parent:(Idea **)parent;
+- (NSManagedObjectID *)permanentIDForIdea:(Idea *)idea;
+- (NSDictionary *)propertyListForIdea:(Idea *)idea;
+- (void)restoreIdeaFromPropertyList:(NSDictionary *)propertyList parent:(Idea *)parent restoredIdeas:(NSMutableDictionary *)restoredIdeas;
+@end
+
+
+static void IdeaOperationLogDropSlot(void *info, size_t slot)
+{
+	[(NSMutableArray *)info replaceObjectAtIndex:slot withObject:[NSNull null]];
+}
+
+
+@implementation IdeaOperationLog
+
+- (id)initWithManagedObjectContext:(NSManagedObjectContext *)context
+{
+	if ((self = [super init])) {
+		managedObjectContext = [context retain];
+		replacedObjectIDs = [[NSMutableDictionary alloc] init];
+		
+		operations = [[NSMutableArray alloc] initWithCapacity:kOperationLimit];
+		for (NSUInteger i = 0; i < kOperationLimit; i++) {
+			[operations addObject:[NSNull null]];
+		}
+		
+		if (!OperationRingInit(&ring, kOperationLimit, kByteLimit, IdeaOperationLogDropSlot, operations)) {
+			[self release];
+			return nil;
+		}
+	}
+	
+	return self;
+}
+
+
+#pragma mark -
+#pragma mark Recording
+
+- (void)recordInsertOfIdea:(Idea *)idea
+{
+	IdeaOperation *operation = [self operationWithType:IdeaOperationInsert idea:idea];
+	
+	operation->newParentID = [[self permanentIDForIdea:idea.parent] retain];
+	operation->newTimeStamp = [idea.timeStamp retain];
+	operation->name = [idea.name copy];
+	operation->byteCount += [operation->name length] * sizeof(unichar);
+	
+	[self addOperation:operation];
+}
+
+- (void)recordRenameOfIdea:(Idea *)idea fromName:(NSString *)oldName
+{
+	NSString *newName = idea.name;
+	
+	if (oldName == nil) {
+		oldName = @"";
+	}
+	if (newName == nil) {
+		newName = @"";
+	}
+	
+	NSUInteger oldLength = [oldName length];
+	NSUInteger newLength = [newName length];
+	unichar *oldCharacters = malloc((oldLength + newLength + 1) * sizeof(unichar));
+	unichar *newCharacters = oldCharacters + oldLength;
+	size_t prefix = 0;
+	size_t suffix = 0;
+	
+	[oldName getCharacters:oldCharacters range:NSMakeRange(0, oldLength)];
+	[newName getCharacters:newCharacters range:NSMakeRange(0, newLength)];
+	NameDeltaCompute(oldCharacters, oldLength, newCharacters, newLength, &prefix, &suffix);
+	free(oldCharacters);
+	
+	if (prefix == oldLength && prefix == newLength) {
+		return;
+	}
+	
+	IdeaOperation *operation = [self operationWithType:IdeaOperationRename idea:idea];
+	
+	operation->prefixLength = prefix;
+	operation->suffixLength = suffix;
+	operation->removedText = [[oldName substringWithRange:NSMakeRange(prefix, oldLength - prefix - suffix)] retain];
+	operation->insertedText = [[newName substringWithRange:NSMakeRange(prefix, newLength - prefix - suffix)] retain];
+	operation->byteCount += ([operation->removedText length] + [operation->insertedText length]) * sizeof(unichar);
+	
+	[self addOperation:operation];
+}
+
+- (void)recordMoveOfIdea:(Idea *)idea fromParent:(Idea *)oldParent index:(NSUInteger)oldIndex
+{
+	NSArray *siblings = [Idea orderedChildrenOfParent:idea.parent inManagedObjectContext:managedObjectContext];
+	
+	if (siblings == nil) {
+		// Redoing it couldn't put the idea back in its place
+		[self removeAllOperations];
+		return;
+	}
+	
+	IdeaOperation *operation = [self operationWithType:IdeaOperationMove idea:idea];
+	
+	operation->oldParentID = [[self permanentIDForIdea:oldParent] retain];
+	operation->newParentID = [[self permanentIDForIdea:idea.parent] retain];
+	operation->oldIndex = oldIndex;
+	operation->newIndex = [siblings indexOfObject:idea];
+	
+	[self addOperation:operation];
+}
+
+- (void)recordDeleteOfIdea:(Idea *)idea
+{
+	NSString *errorDescription = nil;
+	NSData *subtree = [NSPropertyListSerialization dataFromPropertyList:[self propertyListForIdea:idea]
+																 format:NSPropertyListBinaryFormat_v1_0
+													   errorDescription:&errorDescription];
+	
+	if (subtree == nil) {
+		NSLog(@"Couldn't serialize deleted idea: %@", errorDescription);
+		[errorDescription release];
+		
+		// Older operations could refer to the subtree, which couldn't be brought back
+		[self removeAllOperations];
+		return;
+	}
+	
+	IdeaOperation *operation = [self operationWithType:IdeaOperationDelete idea:idea];
+	
+	operation->oldParentID = [[self permanentIDForIdea:idea.parent] retain];
+	operation->subtree = [subtree retain];
+	operation->byteCount += [subtree length];
+	
+	[self addOperation:operation];
+}
+
+- (IdeaOperation *)operationWithType:(IdeaOperationType)type idea:(Idea *)idea
+{
+	IdeaOperation *operation = [[[IdeaOperation alloc] init] autorelease];
+	
+	operation->type = type;
+	operation->ideaID = [[self permanentIDForIdea:idea] retain];
+	operation->byteCount = kOperationOverhead;
+	
+	return operation;
+}
+
+// Temporary ids change on save, so they can't be kept
+- (NSManagedObjectID *)permanentIDForIdea:(Idea *)idea
+{
+	if (idea == nil) {
+		return nil;
+	}
+	
+	if ([[idea objectID] isTemporaryID]) {
+		NSError *error = nil;
+		if (![managedObjectContext obtainPermanentIDsForObjects:[NSArray arrayWithObject:idea] error:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		}
+	}
+	
+	return [idea objectID];
+}
+
+// Children are stored in order, so restoring them in turn keeps their order keys in order too
+- (NSDictionary *)propertyListForIdea:(Idea *)idea
+{
+	NSMutableDictionary *propertyList = [NSMutableDictionary dictionaryWithCapacity:4];
+	
+	[propertyList setObject:[[[self permanentIDForIdea:idea] URIRepresentation] absoluteString] forKey:@"id"];
+	
+	if (idea.name) {
+		[propertyList setObject:idea.name forKey:@"name"];
+	}
+	if (idea.timeStamp) {
+		[propertyList setObject:idea.timeStamp forKey:@"timeStamp"];
+	}
+	
+	NSArray *orderedChildren = [idea orderedChildren];
+	
+	if ([orderedChildren count] > 0) {
+		NSMutableArray *children = [NSMutableArray arrayWithCapacity:[orderedChildren count]];
+		
+		for (Idea *child in orderedChildren) {
+			[children addObject:[self propertyListForIdea:child]];
+		}
+		
+		[propertyList setObject:children forKey:@"children"];
+	}
+	
+	return propertyList;
+}
+
+
+#pragma mark -
+#pragma mark Ring buffer
+
+// The ring only drops other slots than the one it returns, so the operation is safe to store last
+- (void)addOperation:(IdeaOperation *)operation
+{
+	size_t slot = OperationRingAdd(&ring, operation->byteCount);
+	
+	[operations replaceObjectAtIndex:slot withObject:operation];
+}
+
+- (void)removeAllOperations
+{
+	OperationRingRemoveAll(&ring);
+	[replacedObjectIDs removeAllObjects];
+}
+
+
+#pragma mark -
+#pragma mark Undo and redo
+
+- (BOOL)canUndo
+{
+	return OperationRingCanUndo(&ring);
+}
+
+- (BOOL)canRedo
+{
+	return OperationRingCanRedo(&ring);
+}
+
+- (NSString *)undoActionName
+{
+	if (![self canUndo]) {
+		return nil;
+	}
+	
+	return [NSString stringWithFormat:@"Undo %@", [self actionNameForOperation:[operations objectAtIndex:OperationRingUndoSlot(&ring)]]];
+}
+
+- (NSString *)redoActionName
+{
+	if (![self canRedo]) {
+		return nil;
+	}
+	
+	return [NSString stringWithFormat:@"Redo %@", [self actionNameForOperation:[operations objectAtIndex:OperationRingRedoSlot(&ring)]]];
+}
+
+- (NSString *)actionNameForOperation:(IdeaOperation *)operation
+{
+	switch (operation->type) {
+		case IdeaOperationInsert:
+			return @"Add";
+		case IdeaOperationRename:
+			return @"Rename";
+		case IdeaOperationDelete:
+			return @"Delete";
+		case IdeaOperationMove:
+			return @"Move";
+	}
+	
+	return nil;
+}
+
+- (BOOL)undo
+{
+	if (![self canUndo]) {
+		return NO;
+	}
+	
+	if (![self applyOperation:[operations objectAtIndex:OperationRingUndoSlot(&ring)] reverse:YES]) {
+		return NO;
+	}
+	
+	OperationRingDidUndo(&ring);
+	return YES;
+}
+
+- (BOOL)redo
+{
+	if (![self canRedo]) {
+		return NO;
+	}
+	
+	if (![self applyOperation:[operations objectAtIndex:OperationRingRedoSlot(&ring)] reverse:NO]) {
+		return NO;
+	}
+	
+	OperationRingDidRedo(&ring);
+	return YES;
+}
+
+// If the operation can't be applied, the ideas it refers to were changed some other way and
+// the rest of the log can't be trusted either, so it's cleared
+- (BOOL)applyOperation:(IdeaOperation *)operation reverse:(BOOL)reverse
+{
+	NSMutableDictionary *restoredIdeas = [NSMutableDictionary dictionary];
+	
+	if (![self applyOperation:operation reverse:reverse restoredIdeas:restoredIdeas]) {
+		[self removeAllOperations];
+		return NO;
+	}
+	
+	NSError *error = nil;
+	if (![managedObjectContext save:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		[managedObjectContext rollback];
+		[self removeAllOperations];
+		return NO;
+	}
+	
+	// Ideas brought back have new ids, which are permanent now that they're saved
+	for (NSManagedObjectID *objectID in restoredIdeas) {
+		[replacedObjectIDs setObject:[[restoredIdeas objectForKey:objectID] objectID] forKey:objectID];
+	}
+	
+	return YES;
+}
+
+// Everything the operation refers to is looked up before anything is changed
+- (BOOL)applyOperation:(IdeaOperation *)operation reverse:(BOOL)reverse restoredIdeas:(NSMutableDictionary *)restoredIdeas
+{
+	BOOL removesIdea = (operation->type == IdeaOperationInsert && reverse) || (operation->type == IdeaOperationDelete && !reverse);
+	BOOL restoresIdea = (operation->type == IdeaOperationInsert && !reverse) || (operation->type == IdeaOperationDelete && reverse);
+	Idea *idea = nil;
+	Idea *parent = nil;
+	
+	if (!restoresIdea) {
+		idea = [self ideaWithID:operation->ideaID];
+		
+		if (idea == nil) {
+			return NO;
+		}
+	}
+	
+	if (removesIdea) {
+		[managedObjectContext deleteObject:idea];
+		return YES;
+	}
+	
+	switch (operation->type) {
+		case IdeaOperationInsert:
+		{
+			if (![self resolveParentID:operation->newParentID parent:&parent]) {
+				return NO;
+			}
+			
+			Idea *newIdea = [NSEntityDescription insertNewObjectForEntityForName:@"Idea" inManagedObjectContext:managedObjectContext];
+			newIdea.name = operation->name;
+			newIdea.timeStamp = operation->newTimeStamp;
+			newIdea.parent = parent;
+			
+			[restoredIdeas setObject:newIdea forKey:operation->ideaID];
+			break;
+		}
+		
+		case IdeaOperationDelete:
+		{
+			if (![self resolveParentID:operation->oldParentID parent:&parent]) {
+				return NO;
+			}
+			
+			NSString *errorDescription = nil;
+			NSDictionary *propertyList = [NSPropertyListSerialization propertyListFromData:operation->subtree
+																		  mutabilityOption:NSPropertyListImmutable
+																					format:NULL
+																		  errorDescription:&errorDescription];
+			
+			if (![propertyList isKindOfClass:[NSDictionary class]]) {
+				NSLog(@"Couldn't read deleted idea: %@", errorDescription);
+				[errorDescription release];
+				return NO;
+			}
+			
+			[self restoreIdeaFromPropertyList:propertyList parent:parent restoredIdeas:restoredIdeas];
+			break;
+		}
+		
+		case IdeaOperationRename:
+		{
+			NSString *name = idea.name ? idea.name : @"";
+			NSString *currentText = reverse ? operation->insertedText : operation->removedText;
+			NSString *replacementText = reverse ? operation->removedText : operation->insertedText;
+			NSUInteger length = [name length];
+			NSUInteger replacementLength = [replacementText length];
+			NSUInteger newLength = operation->prefixLength + replacementLength + operation->suffixLength;
+			unichar *characters = malloc((length + replacementLength + newLength + 1) * sizeof(unichar));
+			unichar *replacementCharacters = characters + length;
+			unichar *newCharacters = replacementCharacters + replacementLength;
+			
+			[name getCharacters:characters range:NSMakeRange(0, length)];
+			[replacementText getCharacters:replacementCharacters range:NSMakeRange(0, replacementLength)];
+			
+			BOOL applied = NameDeltaApply(characters, length,
+										  operation->prefixLength, [currentText length], operation->suffixLength,
+										  replacementCharacters, replacementLength, newCharacters);
+			
+			if (applied) {
+				idea.name = [NSString stringWithCharacters:newCharacters length:newLength];
+			}
+			free(characters);
+			
+			if (!applied) {
+				return NO;
+			}
+			break;
+		}
+		
+		case IdeaOperationMove:
+		{
+			if (![self resolveParentID:reverse ? operation->oldParentID : operation->newParentID parent:&parent]) {
+				return NO;
+			}
+			
+			NSArray *siblings = [Idea orderedChildrenOfParent:parent inManagedObjectContext:managedObjectContext];
+			
+			if (siblings == nil) {
+				return NO;
+			}
+			
+			// Fails if the parent has been moved under the idea since. The index is clamped to
+			// the siblings there are now.
+			NSUInteger index = reverse ? operation->oldIndex : operation->newIndex;
+			if (![idea moveToParent:parent atIndex:index amongSiblings:siblings]) {
+				return NO;
+			}
+			break;
+		}
+	}
+	
+	return YES;
+}
+
+- (void)restoreIdeaFromPropertyList:(NSDictionary *)propertyList parent:(Idea *)parent restoredIdeas:(NSMutableDictionary *)restoredIdeas
+{
+	Idea *idea = [NSEntityDescription insertNewObjectForEntityForName:@"Idea" inManagedObjectContext:managedObjectContext];
+	idea.name = [propertyList objectForKey:@"name"];
+	idea.timeStamp = [propertyList objectForKey:@"timeStamp"];
+	idea.parent = parent;
+	
+	NSURL *URI = [NSURL URLWithString:[propertyList objectForKey:@"id"]];
+	NSManagedObjectID *objectID = URI ? [[managedObjectContext persistentStoreCoordinator] managedObjectIDForURIRepresentation:URI] : nil;
+	
+	if (objectID) {
+		[restoredIdeas setObject:idea forKey:objectID];
+	}
+	
+	for (NSDictionary *child in [propertyList objectForKey:@"children"]) {
+		[self restoreIdeaFromPropertyList:child parent:idea restoredIdeas:restoredIdeas];
+	}
+}
+
+- (Idea *)ideaWithID:(NSManagedObjectID *)objectID
+{
+	NSManagedObjectID *replacement;
+	
+	while ((replacement = [replacedObjectIDs objectForKey:objectID])) {
+		objectID = replacement;
+	}
+	
+	Idea *idea = (Idea *)[managedObjectContext existingObjectWithID:objectID error:NULL];
+	
+	if ([idea isDeleted]) {
+		return nil;
+	}
+	
+	return idea;
+}
+
+// A nil parent id is the top level, anything else has to still exist
+- (BOOL)resolveParentID:(NSManagedObjectID *)parentID parent:(Idea **)parent
+{
+	*parent = nil;
+	
+	if (parentID == nil) {
+		return YES;
+	}
+	
+	*parent = [self ideaWithID:parentID];
+	
+	return *parent != nil;
+}
+
+
+#pragma mark -
+#pragma mark Memory management
+
+- (void)dealloc
+{
+	OperationRingDestroy(&ring);
+	[managedObjectContext release];
+	[operations release];
+	[replacedObjectIDs release];
+	[super dealloc];
+}
+
+@end
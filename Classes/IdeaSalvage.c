@@ -0,0 +1,407 @@
+//
+//  IdeaSalvage.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "IdeaSalvage.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+int IdeaSalvageRowListAppend(IdeaSalvageRowList *list, long long key, long long parentKey, double timeStamp, const char *name)
+{
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity ? 2 * list->capacity : 64;
+		IdeaSalvageRow *rows = realloc(list->rows, capacity * sizeof(IdeaSalvageRow));
+		
+		if (rows == NULL) {
+			return 0;
+		}
+		
+		list->rows = rows;
+		list->capacity = capacity;
+	}
+	
+	IdeaSalvageRow *row = &list->rows[list->count];
+	
+	row->key = key;
+	row->parentKey = parentKey;
+	row->timeStamp = timeStamp;
+	row->name = NULL;
+	
+	if (name) {
+		size_t length = strlen(name);
+		
+		row->name = malloc(length + 1);
+		if (row->name == NULL) {
+			return 0;
+		}
+		memcpy(row->name, name, length + 1);
+	}
+	
+	list->count++;
+	return 1;
+}
+
+static void IdeaSalvageRowListEmpty(IdeaSalvageRowList *list)
+{
+	for (size_t i = 0; i < list->count; i++) {
+		free(list->rows[i].name);
+	}
+	list->count = 0;
+}
+
+static void IdeaSalvageRowListFree(IdeaSalvageRowList *list)
+{
+	IdeaSalvageRowListEmpty(list);
+	free(list->rows);
+	list->rows = NULL;
+	list->capacity = 0;
+}
+
+// Missing time stamps first, then by time stamp and key so the order is total
+static int IdeaSalvageCompareSiblings(const IdeaSalvageRow *row1, const IdeaSalvageRow *row2)
+{
+	int missing1 = row1->timeStamp != row1->timeStamp;
+	int missing2 = row2->timeStamp != row2->timeStamp;
+	
+	if (missing1 != missing2) {
+		return missing1 ? -1 : 1;
+	}
+	if (!missing1 && row1->timeStamp != row2->timeStamp) {
+		return row1->timeStamp < row2->timeStamp ? -1 : 1;
+	}
+	if (row1->key != row2->key) {
+		return row1->key < row2->key ? -1 : 1;
+	}
+	return 0;
+}
+
+static int IdeaSalvageCompareRows(const void *a, const void *b)
+{
+	const IdeaSalvageRow *row1 = a;
+	const IdeaSalvageRow *row2 = b;
+	
+	if (row1->parentKey != row2->parentKey) {
+		return row1->parentKey < row2->parentKey ? -1 : 1;
+	}
+	return IdeaSalvageCompareSiblings(row1, row2);
+}
+
+static int IdeaSalvageCompareLevelRows(const void *a, const void *b)
+{
+	return IdeaSalvageCompareSiblings(a, b);
+}
+
+static int IdeaSalvageCompareKeys(const void *a, const void *b)
+{
+	long long key1 = *(const long long *)a;
+	long long key2 = *(const long long *)b;
+	
+	return key1 < key2 ? -1 : (key1 > key2 ? 1 : 0);
+}
+
+// First row with parentKey in rows sorted by IdeaSalvageCompareRows, count if there's none
+static size_t IdeaSalvageFirstChild(const IdeaSalvageRow *rows, size_t count, long long parentKey)
+{
+	size_t low = 0;
+	size_t high = count;
+	
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		
+		if (rows[middle].parentKey < parentKey) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	
+	return (low < count && rows[low].parentKey == parentKey) ? low : count;
+}
+
+
+#pragma mark -
+#pragma mark Keys
+
+typedef struct {
+	long long *keys;
+	size_t capacity;
+	size_t count;
+} IdeaSalvageKeySet;
+
+static size_t IdeaSalvageKeySlot(const IdeaSalvageKeySet *set, long long key)
+{
+	unsigned long long hash = (unsigned long long)key * 0x9E3779B97F4A7C15ULL;
+	size_t slot = (size_t)(hash >> 16) & (set->capacity - 1);
+	
+	while (set->keys[slot] != 0 && set->keys[slot] != key) {
+		slot = (slot + 1) & (set->capacity - 1);
+	}
+	
+	return slot;
+}
+
+// Returns 1 if the key was added, 0 if it was already there, -1 if there isn't enough memory
+static int IdeaSalvageKeySetAdd(IdeaSalvageKeySet *set, long long key)
+{
+	if (2 * (set->count + 1) > set->capacity) {
+		IdeaSalvageKeySet larger;
+		
+		larger.capacity = set->capacity ? 2 * set->capacity : 256;
+		larger.count = 0;
+		larger.keys = calloc(larger.capacity, sizeof(long long));
+		if (larger.keys == NULL) {
+			return -1;
+		}
+		
+		for (size_t i = 0; i < set->capacity; i++) {
+			if (set->keys[i] != 0) {
+				larger.keys[IdeaSalvageKeySlot(&larger, set->keys[i])] = set->keys[i];
+				larger.count++;
+			}
+		}
+		
+		free(set->keys);
+		*set = larger;
+	}
+	
+	size_t slot = IdeaSalvageKeySlot(set, key);
+	if (set->keys[slot] == key) {
+		return 0;
+	}
+	
+	set->keys[slot] = key;
+	set->count++;
+	return 1;
+}
+
+
+#pragma mark -
+#pragma mark All rows at once
+
+typedef struct {
+	size_t index;
+	void *copy;
+} IdeaSalvageQueueEntry;
+
+// Copies the row at index under parentCopy, then its subtree breadth first. The subtree of a row
+// that can't be copied is passed over along with it. Returns -1 if there isn't enough memory.
+static long long IdeaSalvageCopySubtree(const IdeaSalvageSource *source, const IdeaSalvageRowList *list, size_t index,
+										void *parentCopy, char *visited, IdeaSalvageKeySet *copiedKeys, IdeaSalvageQueueEntry *queue)
+{
+	size_t head = 0;
+	size_t tail = 0;
+	long long copiedCount = 0;
+	
+	visited[index] = 1;
+	queue[tail].index = index;
+	queue[tail].copy = parentCopy;
+	tail++;
+	
+	while (head < tail) {
+		IdeaSalvageQueueEntry entry = queue[head++];
+		const IdeaSalvageRow *row = &list->rows[entry.index];
+		void *copy = NULL;
+		
+		// Entries carry their parent's copy until they're copied themselves
+		if (entry.copy || entry.index == index) {
+			int added = IdeaSalvageKeySetAdd(copiedKeys, row->key);
+			
+			if (added < 0) {
+				return -1;
+			}
+			if (added > 0) {
+				copy = source->copyRow(source->info, row, entry.copy);
+			}
+			if (copy) {
+				copiedCount++;
+			}
+		}
+		
+		for (size_t i = IdeaSalvageFirstChild(list->rows, list->count, row->key); i < list->count && list->rows[i].parentKey == row->key; i++) {
+			if (!visited[i]) {
+				visited[i] = 1;
+				queue[tail].index = i;
+				queue[tail].copy = copy;
+				tail++;
+			}
+		}
+	}
+	
+	return copiedCount;
+}
+
+static size_t IdeaSalvageAllRows(const IdeaSalvageSource *source, IdeaSalvageRowList *list, int *failed)
+{
+	size_t count = list->count;
+	char *visited = calloc(count + 1, 1);
+	IdeaSalvageQueueEntry *queue = malloc((count + 1) * sizeof(IdeaSalvageQueueEntry));
+	long long *keys = malloc((count + 1) * sizeof(long long));
+	IdeaSalvageKeySet copiedKeys = { NULL, 0, 0 };
+	size_t copiedCount = 0;
+	
+	// Nothing was copied yet, so the ideas can still be read level by level
+	*failed = visited == NULL || queue == NULL || keys == NULL;
+	
+	if (!*failed) {
+		qsort(list->rows, count, sizeof(IdeaSalvageRow), IdeaSalvageCompareRows);
+		
+		for (size_t i = 0; i < count; i++) {
+			keys[i] = list->rows[i].key;
+			
+			// Not a key a damaged store should have handed out
+			if (keys[i] <= 0) {
+				visited[i] = 1;
+			}
+		}
+		qsort(keys, count, sizeof(long long), IdeaSalvageCompareKeys);
+		
+		// The top level, then ideas whose parent is gone, in the order they'd have been at the top,
+		// then whatever is left, which is its own ancestor: the first idea of each cycle breaks it
+		for (int pass = 0; pass < 3; pass++) {
+			for (size_t i = 0; i < count; i++) {
+				const IdeaSalvageRow *row = &list->rows[i];
+				
+				if (visited[i]) {
+					continue;
+				}
+				
+				int isRoot = row->parentKey == 0;
+				int isOrphan = !isRoot && (row->parentKey == row->key ||
+										   bsearch(&row->parentKey, keys, count, sizeof(long long), IdeaSalvageCompareKeys) == NULL);
+				
+				if ((pass == 0 && isRoot) || (pass == 1 && isOrphan) || pass == 2) {
+					long long subtreeCount = IdeaSalvageCopySubtree(source, list, i, NULL, visited, &copiedKeys, queue);
+					
+					// Out of memory, what's copied is kept
+					if (subtreeCount < 0) {
+						pass = 3;
+						break;
+					}
+					copiedCount += (size_t)subtreeCount;
+				}
+			}
+		}
+	}
+	
+	free(visited);
+	free(queue);
+	free(keys);
+	free(copiedKeys.keys);
+	
+	return copiedCount;
+}
+
+
+#pragma mark -
+#pragma mark Level by level
+
+static size_t IdeaSalvageByLevel(const IdeaSalvageSource *source, size_t *lostLevelCount)
+{
+	IdeaSalvageRowList level = { NULL, 0, 0 };
+	IdeaSalvageKeySet visited = { NULL, 0, 0 };
+	IdeaSalvageQueueEntry *queue = NULL;
+	long long *queueKeys = NULL;
+	size_t head = 0;
+	size_t tail = 0;
+	size_t capacity = 0;
+	size_t copiedCount = 0;
+	
+	// The parents still to be read, starting with the top level
+	long long parentKey = 0;
+	void *parentCopy = NULL;
+	
+	for (;;) {
+		level.count = 0;
+		
+		if (!source->readChildRows(source->info, parentKey, &level)) {
+			(*lostLevelCount)++;
+		} else {
+			qsort(level.rows, level.count, sizeof(IdeaSalvageRow), IdeaSalvageCompareLevelRows);
+			
+			for (size_t i = 0; i < level.count; i++) {
+				const IdeaSalvageRow *row = &level.rows[i];
+				int added = row->key > 0 ? IdeaSalvageKeySetAdd(&visited, row->key) : 0;
+				
+				if (added < 0) {
+					goto done;
+				}
+				
+				// Seen under another parent already, or its own ancestor
+				if (added == 0) {
+					continue;
+				}
+				
+				void *copy = source->copyRow(source->info, row, parentCopy);
+				if (copy == NULL) {
+					continue;
+				}
+				copiedCount++;
+				
+				if (tail == capacity) {
+					size_t newCapacity = capacity ? 2 * capacity : 256;
+					IdeaSalvageQueueEntry *newQueue = realloc(queue, newCapacity * sizeof(IdeaSalvageQueueEntry));
+					if (newQueue == NULL) {
+						goto done;
+					}
+					queue = newQueue;
+					
+					long long *newKeys = realloc(queueKeys, newCapacity * sizeof(long long));
+					if (newKeys == NULL) {
+						goto done;
+					}
+					queueKeys = newKeys;
+					capacity = newCapacity;
+				}
+				
+				queue[tail].copy = copy;
+				queueKeys[tail] = row->key;
+				tail++;
+			}
+		}
+		
+		IdeaSalvageRowListEmpty(&level);
+		
+		if (head == tail) {
+			break;
+		}
+		
+		parentKey = queueKeys[head];
+		parentCopy = queue[head].copy;
+		head++;
+	}
+	
+done:
+	IdeaSalvageRowListFree(&level);
+	free(visited.keys);
+	free(queue);
+	free(queueKeys);
+	
+	return copiedCount;
+}
+
+
+size_t IdeaSalvage(const IdeaSalvageSource *source, size_t *lostLevelCount)
+{
+	IdeaSalvageRowList list = { NULL, 0, 0 };
+	size_t copiedCount = 0;
+	int failed = 1;
+	
+	*lostLevelCount = 0;
+	
+	if (source->readAllRows(source->info, &list)) {
+		copiedCount = IdeaSalvageAllRows(source, &list, &failed);
+	}
+	IdeaSalvageRowListFree(&list);
+	
+	if (failed) {
+		copiedCount = IdeaSalvageByLevel(source, lostLevelCount);
+	}
+	
+	return copiedCount;
+}
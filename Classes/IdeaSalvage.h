@@ -0,0 +1,59 @@
+//
+//  IdeaSalvage.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef IDEA_SALVAGE_H
+#define IDEA_SALVAGE_H
+
+#include <stddef.h>
+
+// The traversal IdeaStore uses to copy the ideas out of a damaged store, in plain C so that it can
+// be run against damaged SQLite files on its own (see Tests/StoreTests.c). Reading the damaged
+// store and writing the copies is left to the source's callbacks.
+
+// An idea as read from the damaged store. Keys are whatever the source uses to tell ideas apart,
+// as long as they're positive; a parent key of 0 stands for the top level.
+typedef struct {
+	long long key;
+	long long parentKey;
+	double timeStamp;		// NaN if there's none
+	char *name;				// UTF-8, NULL if there's none
+} IdeaSalvageRow;
+
+typedef struct {
+	IdeaSalvageRow *rows;
+	size_t count;
+	size_t capacity;
+} IdeaSalvageRowList;
+
+// Copies name. Returns 0 if there isn't enough memory.
+int IdeaSalvageRowListAppend(IdeaSalvageRowList *list, long long key, long long parentKey, double timeStamp, const char *name);
+
+typedef struct {
+	void *info;
+
+	// Appends every idea in the store to rows, in any order. Returns 0 if they can't all be read.
+	int (*readAllRows)(void *info, IdeaSalvageRowList *rows);
+
+	// Appends the children of the idea with parentKey to rows, in any order. Returns 0 if they
+	// can't be read.
+	int (*readChildRows)(void *info, long long parentKey, IdeaSalvageRowList *rows);
+
+	// Copies the idea under parentCopy, NULL for the top level. Returns the copy, or NULL if it
+	// couldn't be copied, in which case its subtree isn't either.
+	void *(*copyRow)(void *info, const IdeaSalvageRow *row, void *parentCopy);
+} IdeaSalvageSource;
+
+// Copies every idea that can be read, parents before their children and children in timeStamp
+// order. All rows are read at once first, which is a single query for a store that isn't too
+// damaged; ideas whose parent isn't there, or which are their own ancestors, are copied to the
+// top level. If that read fails, the ideas are read level by level from the top instead, so that
+// a level that can't be read only loses the subtrees under it; lostLevelCount is set to the
+// number of those. Returns the number of ideas copied.
+size_t IdeaSalvage(const IdeaSalvageSource *source, size_t *lostLevelCount);
+
+#endif
@@ -0,0 +1,73 @@
+//
+//  IdeaSalvageStore.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "IdeaSalvageStore.h"
+
+#include <math.h>
+
+
+#define IDEA_SALVAGE_STORE_SELECT "SELECT Z_PK, ZPARENT, ZTIMESTAMP, ZNAME FROM ZIDEA"
+
+
+sqlite3 *IdeaSalvageStoreOpen(const char *path)
+{
+	sqlite3 *db = NULL;
+	
+	if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+		sqlite3_close(db);
+		return NULL;
+	}
+	
+	return db;
+}
+
+// Finalizes statement. A row the table can't give back ends the read as a failure.
+static int IdeaSalvageStoreReadRows(sqlite3_stmt *statement, IdeaSalvageRowList *rows)
+{
+	int result;
+	
+	while ((result = sqlite3_step(statement)) == SQLITE_ROW) {
+		double timeStamp = sqlite3_column_type(statement, 2) == SQLITE_NULL ? NAN : sqlite3_column_double(statement, 2);
+		
+		if (!IdeaSalvageRowListAppend(rows, sqlite3_column_int64(statement, 0), sqlite3_column_int64(statement, 1),
+									  timeStamp, (const char *)sqlite3_column_text(statement, 3))) {
+			result = SQLITE_NOMEM;
+			break;
+		}
+	}
+	
+	sqlite3_finalize(statement);
+	return result == SQLITE_DONE;
+}
+
+int IdeaSalvageStoreReadAllRows(sqlite3 *db, IdeaSalvageRowList *rows)
+{
+	sqlite3_stmt *statement;
+	
+	if (sqlite3_prepare_v2(db, IDEA_SALVAGE_STORE_SELECT, -1, &statement, NULL) != SQLITE_OK) {
+		return 0;
+	}
+	
+	return IdeaSalvageStoreReadRows(statement, rows);
+}
+
+int IdeaSalvageStoreReadChildRows(sqlite3 *db, long long parentKey, IdeaSalvageRowList *rows)
+{
+	sqlite3_stmt *statement;
+	const char *sql = parentKey ? IDEA_SALVAGE_STORE_SELECT " WHERE ZPARENT = ?"
+								: IDEA_SALVAGE_STORE_SELECT " WHERE ZPARENT IS NULL";
+	
+	if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) != SQLITE_OK) {
+		return 0;
+	}
+	if (parentKey) {
+		sqlite3_bind_int64(statement, 1, parentKey);
+	}
+	
+	return IdeaSalvageStoreReadRows(statement, rows);
+}
@@ -0,0 +1,29 @@
+//
+//  IdeaSalvageStore.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef IDEA_SALVAGE_STORE_H
+#define IDEA_SALVAGE_STORE_H
+
+#include "IdeaSalvage.h"
+
+#include <sqlite3.h>
+
+// Reads the ideas of a damaged store for IdeaSalvage straight from the table Core Data keeps them
+// in, so that SQLite hands out whatever rows it can still find instead of Core Data giving up on
+// the whole store. Shared with Tests/StoreTests.c, which runs it against damaged files.
+//
+// Keys are the rows' primary keys, which Core Data also stores parents as.
+
+// Opens the store read-only. Returns NULL if SQLite can't open it at all.
+sqlite3 *IdeaSalvageStoreOpen(const char *path);
+
+// Both return 0 if the rows can't be read, as readAllRows and readChildRows do.
+int IdeaSalvageStoreReadAllRows(sqlite3 *db, IdeaSalvageRowList *rows);
+int IdeaSalvageStoreReadChildRows(sqlite3 *db, long long parentKey, IdeaSalvageRowList *rows);
+
+#endif
@@ -0,0 +1,58 @@
+//
+//  IdeaSnapshot.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/26/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+// An immutable copy of the names and order of every saved idea, read with a single fetch in a
+// managed object context of its own, so that it's consistent whatever the main thread saves
+// while it's being read and can be used from any thread without locking. Every save to the
+// store starts a new version; readers asking for a snapshot of the current version share the
+// same one, and an old version is freed as soon as the last reader holding it releases it.
+@interface IdeaSnapshot : NSObject {
+	NSUInteger version;
+	NSDictionary *namesByID;
+
+	// Ordered child ids by parent id, NSNull for the top level
+	NSDictionary *childIDsByParentID;
+}
+
+@property (nonatomic, readonly) NSUInteger version;
+
+// Blocks on the store, so call it from a background thread
++ (IdeaSnapshot *)currentSnapshotWithPersistentStoreCoordinator:(NSPersistentStoreCoordinator *)coordinator
+														  error:(NSError **)error;
+
+// Background readers are queued here one at a time, the store is shared with the main thread
++ (NSOperationQueue *)readerQueue;
+
+- (NSUInteger)count;
+- (NSString *)nameOfIdeaWithID:(NSManagedObjectID *)objectID;
+- (NSArray *)childIDsOfIdeaWithID:(NSManagedObjectID *)objectID;
+
+// Same text as -[Idea dump], nil if the idea wasn't saved yet when the snapshot was taken
+- (NSString *)dumpOfIdeaWithID:(NSManagedObjectID *)objectID;
+
+@end
+
+
+// Dumps an idea from the current snapshot on the reader queue and passes the text to the
+// target's action on the main thread, or nil if it couldn't be read.
+@interface IdeaDumpOperation : NSOperation {
+	NSPersistentStoreCoordinator *persistentStoreCoordinator;
+	NSManagedObjectID *ideaID;
+	NSString *dump;
+
+	// Not retained, only touched on the main thread and cleared when the operation is cancelled
+	id target;
+	SEL action;
+}
+
+- (id)initWithIdea:(NSManagedObject *)idea target:(id)aTarget action:(SEL)anAction;
+
+@end
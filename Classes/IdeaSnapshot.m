@@ -0,0 +1,275 @@
+//
+//  IdeaSnapshot.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/26/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "IdeaSnapshot.h"
+
+
+// Both only touched while synchronized on the class
+static NSUInteger storeVersion = 0;
+static IdeaSnapshot *latestSnapshot = nil;
+
+
+@interface IdeaSnapshot ()
++ (void)contextDidSave:(NSNotification *)notification;
+- (id)initWithVersion:(NSUInteger)aVersion rows:(NSArray *)rows;
+- (void)appendDumpOfIdeaWithID:(NSManagedObjectID *)objectID toString:(NSMutableString *)result indentation:(NSUInteger)indentation;
+@end
+
+
+@implementation IdeaSnapshot
+
+@synthesize version;
+
++ (void)initialize
+{
+	if (self == [IdeaSnapshot class]) {
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(contextDidSave:)
+													 name:NSManagedObjectContextDidSaveNotification
+												   object:nil];
+	}
+}
+
++ (void)contextDidSave:(NSNotification *)notification
+{
+	@synchronized(self) {
+		storeVersion++;
+	}
+}
+
++ (NSOperationQueue *)readerQueue
+{
+	static NSOperationQueue *readerQueue = nil;
+	
+	@synchronized(self) {
+		if (readerQueue == nil) {
+			readerQueue = [[NSOperationQueue alloc] init];
+			[readerQueue setMaxConcurrentOperationCount:1];
+		}
+	}
+	
+	return readerQueue;
+}
+
++ (IdeaSnapshot *)currentSnapshotWithPersistentStoreCoordinator:(NSPersistentStoreCoordinator *)coordinator
+														  error:(NSError **)error
+{
+	NSUInteger currentVersion;
+	
+	@synchronized(self) {
+		if (latestSnapshot && latestSnapshot->version == storeVersion) {
+			return [[latestSnapshot retain] autorelease];
+		}
+		
+		// Taken before fetching, so a save racing with the fetch makes the snapshot look older
+		// than it is rather than newer
+		currentVersion = storeVersion;
+	}
+	
+	NSManagedObjectContext *context = [[NSManagedObjectContext alloc] init];
+	[context setPersistentStoreCoordinator:coordinator];
+	[context setUndoManager:nil];
+	
+	NSEntityDescription *entity = [NSEntityDescription entityForName:@"Idea" inManagedObjectContext:context];
+	
+	NSExpressionDescription *objectIDDescription = [[NSExpressionDescription alloc] init];
+	[objectIDDescription setName:@"objectID"];
+	[objectIDDescription setExpression:[NSExpression expressionForEvaluatedObject]];
+	[objectIDDescription setExpressionResultType:NSObjectIDAttributeType];
+	
+	// One fetch of plain values rather than faulting the tree in, so every row comes from the
+	// same state of the store
+	NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
+	[fetchRequest setEntity:entity];
+	[fetchRequest setResultType:NSDictionaryResultType];
+	[fetchRequest setPropertiesToFetch:[NSArray arrayWithObjects:
+										objectIDDescription,
+										[[entity propertiesByName] objectForKey:@"name"],
+										[[entity propertiesByName] objectForKey:@"parent"],
+										nil]];
+	[objectIDDescription release];
+	
+	NSSortDescriptor *sortDescriptor = [[NSSortDescriptor alloc] initWithKey:@"timeStamp" ascending:YES];
+	[fetchRequest setSortDescriptors:[NSArray arrayWithObject:sortDescriptor]];
+	[sortDescriptor release];
+	
+	NSArray *rows = [context executeFetchRequest:fetchRequest error:error];
+	[fetchRequest release];
+	
+	IdeaSnapshot *snapshot = nil;
+	
+	if (rows) {
+		snapshot = [[[IdeaSnapshot alloc] initWithVersion:currentVersion rows:rows] autorelease];
+		
+		@synchronized(self) {
+			if (latestSnapshot == nil || latestSnapshot->version < currentVersion) {
+				[latestSnapshot release];
+				latestSnapshot = [snapshot retain];
+			}
+		}
+	}
+	
+	[context release];
+	
+	return snapshot;
+}
+
+// Rows come sorted by timeStamp, so children end up in the same order as -[Idea orderedChildren]
+- (id)initWithVersion:(NSUInteger)aVersion rows:(NSArray *)rows
+{
+	if ((self = [super init])) {
+		version = aVersion;
+		
+		NSMutableDictionary *names = [[NSMutableDictionary alloc] initWithCapacity:[rows count]];
+		NSMutableDictionary *children = [[NSMutableDictionary alloc] init];
+		
+		for (NSDictionary *row in rows) {
+			NSManagedObjectID *objectID = [row objectForKey:@"objectID"];
+			id parentID = [row objectForKey:@"parent"];
+			id name = [row objectForKey:@"name"];
+			
+			if (parentID == nil) {
+				parentID = [NSNull null];
+			}
+			
+			[names setObject:(name ? name : @"") forKey:objectID];
+			
+			NSMutableArray *siblings = [children objectForKey:parentID];
+			if (siblings == nil) {
+				siblings = [NSMutableArray array];
+				[children setObject:siblings forKey:parentID];
+			}
+			[siblings addObject:objectID];
+		}
+		
+		namesByID = names;
+		childIDsByParentID = children;
+	}
+	
+	return self;
+}
+
+- (NSUInteger)count
+{
+	return [namesByID count];
+}
+
+- (NSString *)nameOfIdeaWithID:(NSManagedObjectID *)objectID
+{
+	return [namesByID objectForKey:objectID];
+}
+
+- (NSArray *)childIDsOfIdeaWithID:(NSManagedObjectID *)objectID
+{
+	NSArray *childIDs = [childIDsByParentID objectForKey:(objectID ? (id)objectID : (id)[NSNull null])];
+	
+	return childIDs ? childIDs : [NSArray array];
+}
+
+- (NSString *)dumpOfIdeaWithID:(NSManagedObjectID *)objectID
+{
+	NSString *name = [namesByID objectForKey:objectID];
+	
+	if (name == nil) {
+		return nil;
+	}
+	
+	NSMutableString *result = [NSMutableString stringWithString:name];
+	
+	for (NSManagedObjectID *childID in [childIDsByParentID objectForKey:objectID]) {
+		[self appendDumpOfIdeaWithID:childID toString:result indentation:1];
+	}
+	
+	return result;
+}
+
+// Appends to one string instead of building one for every subtree like -[Idea dump]
+- (void)appendDumpOfIdeaWithID:(NSManagedObjectID *)objectID toString:(NSMutableString *)result indentation:(NSUInteger)indentation
+{
+	[result appendString:@"\n"];
+	
+	for (NSUInteger i = 0; i < indentation; i++) {
+		// two spaces for every indentation
+		[result appendString:@"  "];
+	}
+	
+	[result appendFormat:@"- %@", [namesByID objectForKey:objectID]];
+	
+	for (NSManagedObjectID *childID in [childIDsByParentID objectForKey:objectID]) {
+		[self appendDumpOfIdeaWithID:childID toString:result indentation:indentation + 1];
+	}
+}
+
+- (void)dealloc
+{
+	[namesByID release];
+	[childIDsByParentID release];
+	[super dealloc];
+}
+
+@end
+
+
+@implementation IdeaDumpOperation
+
+- (id)initWithIdea:(NSManagedObject *)idea target:(id)aTarget action:(SEL)anAction
+{
+	if ((self = [super init])) {
+		persistentStoreCoordinator = [[[idea managedObjectContext] persistentStoreCoordinator] retain];
+		ideaID = [[idea objectID] retain];
+		target = aTarget;
+		action = anAction;
+	}
+	
+	return self;
+}
+
+- (void)main
+{
+	if ([self isCancelled]) {
+		return;
+	}
+	
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	NSError *error = nil;
+	IdeaSnapshot *snapshot = [IdeaSnapshot currentSnapshotWithPersistentStoreCoordinator:persistentStoreCoordinator error:&error];
+	
+	if (snapshot == nil) {
+		NSLog(@"Snapshot failed %@, %@", error, [error userInfo]);
+	} else if (![self isCancelled]) {
+		dump = [[snapshot dumpOfIdeaWithID:ideaID] retain];
+	}
+	
+	if (![self isCancelled]) {
+		[self performSelectorOnMainThread:@selector(finish) withObject:nil waitUntilDone:NO];
+	}
+	
+	[pool drain];
+}
+
+- (void)finish
+{
+	[target performSelector:action withObject:dump];
+}
+
+- (void)cancel
+{
+	target = nil;
+	[super cancel];
+}
+
+- (void)dealloc
+{
+	[persistentStoreCoordinator release];
+	[ideaID release];
+	[dump release];
+	[super dealloc];
+}
+
+@end
@@ -0,0 +1,97 @@
+//
+//  IdeaStore.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+
+// The file the board is kept in. SQLite never gives back the pages freed by deleting ideas, it
+// only reuses them, so a board that had big subtrees deleted keeps its largest size on disk and
+// its remaining pages end up scattered through the file. Ideas of different subtrees share pages,
+// so most of that space isn't even in free pages but in pages left partly empty. Once either makes
+// up a large part of the file, the store is vacuumed and analyzed the next time the app goes to the
+// background (see IdeaStoreMeasurementOperation), which rewrites it compactly with the pages of
+// each table in order.
+@interface IdeaStore : NSObject {
+
+}
+
+// Options that compact the SQLite store when it's added
++ (NSDictionary *)compactionOptions;
+
+// Whether the store at storeURL, holding ideaCount ideas, is worth compacting. Besides the free
+// pages in its header, its size is compared to what the same number of ideas took when the
+// baseline was recorded; without a baseline only the free pages count.
++ (BOOL)storeAtURL:(NSURL *)storeURL needsCompactionWithIdeaCount:(NSUInteger)ideaCount;
+
+// Whether recordBaselineForStoreAtURL:ideaCount: was ever called
++ (BOOL)hasBaseline;
+
+// Remembers the size an idea takes in the store as it is now, for the next
+// storeAtURL:needsCompactionWithIdeaCount:. Recorded the first time the store is measured and
+// after every compaction.
++ (void)recordBaselineForStoreAtURL:(NSURL *)storeURL ideaCount:(NSUInteger)ideaCount;
+
+// Vacuums and analyzes the store through a coordinator of its own, then records the new baseline.
+// Vacuuming keeps the primary keys of Core Data's tables, so object ids held elsewhere stay valid,
+// but it rewrites the whole file: it's meant to be called where nothing else is using the store.
++ (BOOL)compactStoreAtURL:(NSURL *)storeURL model:(NSManagedObjectModel *)model;
+
+// Adds the store at storeURL to coordinator, migrating it to the current model if needed. Returns
+// NO, without touching the file, if the store can't be opened; it's then up to the caller to run
+// an IdeaStoreRecoveryOperation once the app has launched.
++ (BOOL)addStoreAtURL:(NSURL *)storeURL toCoordinator:(NSPersistentStoreCoordinator *)coordinator;
+
+// Bytes taken by free pages, 0 if there's no store yet or it can't be read
++ (unsigned long long)freeBytesInStoreAtURL:(NSURL *)storeURL fileSize:(unsigned long long *)fileSize;
+
+@end
+
+
+// Measures the store on the reader queue, through a coordinator of its own, and passes an NSNumber
+// to the target's action on the main thread: YES if the store is worth compacting with
+// compactStoreAtURL:model:. The first time it only records the baseline and passes NO, since
+// there's nothing yet to tell a store that was always this size from one that grew sparse.
+@interface IdeaStoreMeasurementOperation : NSOperation {
+	NSURL *storeURL;
+	NSManagedObjectModel *managedObjectModel;
+	BOOL needsCompaction;
+	
+	// Not retained, only touched on the main thread
+	id target;
+	SEL action;
+}
+
+- (id)initWithStoreAtURL:(NSURL *)aStoreURL model:(NSManagedObjectModel *)model target:(id)aTarget action:(SEL)anAction;
+
+@end
+
+
+// Rebuilds a store that can't be opened on the reader queue, then passes a description of what was
+// recovered and what was lost to the target's action on the main thread. The damaged store is
+// never deleted: every idea that can be read from it is copied into a new store, read with a
+// single fetch when the store allows it and level by level from the top when it doesn't. The
+// damaged file is then set aside under a name of its own and the new one takes its place, each
+// with a single rename so that an interruption leaves either file whole; a swap interrupted in
+// between is finished by the next addStoreAtURL:toCoordinator:. Once the action is performed the
+// store can be added again, unless the damaged file couldn't be moved out of the way.
+@interface IdeaStoreRecoveryOperation : NSOperation {
+	NSURL *storeURL;
+	NSManagedObjectModel *managedObjectModel;
+	NSString *report;
+	
+	// Not retained, only touched on the main thread
+	id target;
+	SEL action;
+}
+
+@property (nonatomic, readonly) NSString *report;
+
+- (id)initWithStoreAtURL:(NSURL *)aStoreURL model:(NSManagedObjectModel *)model target:(id)aTarget action:(SEL)anAction;
+
+@end
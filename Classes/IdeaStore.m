@@ -0,0 +1,421 @@
+//
+//  IdeaStore.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "IdeaStore.h"
+#include "IdeaStoreFile.h"
+#include "IdeaSalvageStore.h"
+#include <errno.h>
+#include <math.h>
+#include <sys/param.h>
+
+
+// Vacuuming rewrites the whole file, so it's only worth it once enough of it is wasted
+static const unsigned long long kVacuumMinimumFreeBytes = 256 * 1024;
+static const double kVacuumMinimumFreeFraction = 0.25;
+
+// Average size of an idea in the store when it was first measured or last compacted
+static NSString * const kBaselineBytesPerIdeaKey = @"compactedBytesPerIdea";
+
+// Kept next to the store while it's being recovered: the copy being written, then the finished
+// copy, then the damaged file, which keeps the time it was set aside in its name
+static NSString * const kRecoveringStoreSuffix = @"-recovering";
+static NSString * const kRecoveredStoreSuffix = @"-recovered";
+static NSString * const kDamagedStoreSuffix = @"-damaged";
+
+
+// What the salvage callbacks share. The damaged store is read with SQLite, Core Data only writes
+// the copies.
+typedef struct {
+	sqlite3 *damagedStore;
+	NSManagedObjectContext *recoveredContext;
+} IdeaStoreSalvageInfo;
+
+
+@interface IdeaStore ()
++ (NSURL *)URLForStoreAtURL:(NSURL *)storeURL suffix:(NSString *)suffix;
++ (NSUInteger)countIdeasInStoreAtURL:(NSURL *)storeURL coordinator:(NSPersistentStoreCoordinator *)coordinator
+							 options:(NSDictionary *)options;
++ (NSUInteger)salvageStoreAtURL:(NSURL *)damagedURL intoStoreAtURL:(NSURL *)recoveredURL
+						  model:(NSManagedObjectModel *)model lostLevelCount:(NSUInteger *)lostLevelCount;
+@end
+
+
+@implementation IdeaStore
+
++ (BOOL)storeAtURL:(NSURL *)storeURL needsCompactionWithIdeaCount:(NSUInteger)ideaCount
+{
+	unsigned long long fileSize = 0;
+	unsigned long long freeBytes = [self freeBytesInStoreAtURL:storeURL fileSize:&fileSize];
+	
+	if (fileSize < kVacuumMinimumFreeBytes) {
+		return NO;
+	}
+	
+	double bytesPerIdea = [[NSUserDefaults standardUserDefaults] doubleForKey:kBaselineBytesPerIdeaKey];
+	
+	if (bytesPerIdea > 0) {
+		double usedBytes = bytesPerIdea * ideaCount;
+		
+		if (usedBytes < fileSize - freeBytes) {
+			freeBytes = fileSize - (unsigned long long)usedBytes;
+		}
+	}
+	
+	return freeBytes >= kVacuumMinimumFreeBytes && freeBytes >= fileSize * kVacuumMinimumFreeFraction;
+}
+
++ (BOOL)hasBaseline
+{
+	return [[NSUserDefaults standardUserDefaults] doubleForKey:kBaselineBytesPerIdeaKey] > 0;
+}
+
++ (void)recordBaselineForStoreAtURL:(NSURL *)storeURL ideaCount:(NSUInteger)ideaCount
+{
+	unsigned long long fileSize = 0;
+	unsigned long long freeBytes = [self freeBytesInStoreAtURL:storeURL fileSize:&fileSize];
+	
+	if (ideaCount > 0 && fileSize > freeBytes) {
+		[[NSUserDefaults standardUserDefaults] setDouble:(double)(fileSize - freeBytes) / ideaCount
+												  forKey:kBaselineBytesPerIdeaKey];
+	}
+}
+
++ (BOOL)compactStoreAtURL:(NSURL *)storeURL model:(NSManagedObjectModel *)model
+{
+	NSPersistentStoreCoordinator *coordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:model];
+	
+	// Adding the store with these options is what compacts it
+	NSUInteger ideaCount = [self countIdeasInStoreAtURL:storeURL coordinator:coordinator options:[self compactionOptions]];
+	[coordinator release];
+	
+	if (ideaCount == NSNotFound) {
+		return NO;
+	}
+	
+	[self recordBaselineForStoreAtURL:storeURL ideaCount:ideaCount];
+	
+	return YES;
+}
+
+// Adds the store to coordinator with options just long enough to count its ideas. Returns
+// NSNotFound if it can't be added or counted.
++ (NSUInteger)countIdeasInStoreAtURL:(NSURL *)storeURL coordinator:(NSPersistentStoreCoordinator *)coordinator
+							 options:(NSDictionary *)options
+{
+	NSError *error = nil;
+	NSPersistentStore *store = [coordinator addPersistentStoreWithType:NSSQLiteStoreType configuration:nil
+																   URL:storeURL options:options error:&error];
+	NSUInteger ideaCount = NSNotFound;
+	
+	if (store) {
+		NSManagedObjectContext *context = [[NSManagedObjectContext alloc] init];
+		[context setPersistentStoreCoordinator:coordinator];
+		
+		NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
+		[fetchRequest setEntity:[NSEntityDescription entityForName:@"Idea" inManagedObjectContext:context]];
+		ideaCount = [context countForFetchRequest:fetchRequest error:&error];
+		[fetchRequest release];
+		[context release];
+		
+		[coordinator removePersistentStore:store error:NULL];
+	}
+	
+	if (ideaCount == NSNotFound) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+	}
+	
+	return ideaCount;
+}
+
++ (NSDictionary *)compactionOptions
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithBool:YES], NSSQLiteManualVacuumOption,
+			[NSNumber numberWithBool:YES], NSSQLiteAnalyzeOption,
+			nil];
+}
+
++ (unsigned long long)freeBytesInStoreAtURL:(NSURL *)storeURL fileSize:(unsigned long long *)fileSize
+{
+	unsigned long long freeBytes = 0;
+	
+	IdeaStoreFileReadFreeBytes([[storeURL path] fileSystemRepresentation], &freeBytes, fileSize);
+	
+	return freeBytes;
+}
+
+#pragma mark -
+#pragma mark Recovery
+
++ (BOOL)addStoreAtURL:(NSURL *)storeURL toCoordinator:(NSPersistentStoreCoordinator *)coordinator
+{
+	NSURL *recoveredURL = [self URLForStoreAtURL:storeURL suffix:kRecoveredStoreSuffix];
+	
+	// A recovery was interrupted after the damaged file was set aside, finish it
+	IdeaStoreFileFinishInterruptedSwap([[storeURL path] fileSystemRepresentation], [[recoveredURL path] fileSystemRepresentation]);
+	
+	NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
+							 [NSNumber numberWithBool:YES], NSMigratePersistentStoresAutomaticallyOption,
+							 [NSNumber numberWithBool:YES], NSInferMappingModelAutomaticallyOption,
+							 nil];
+	
+	NSError *error = nil;
+	if (![coordinator addPersistentStoreWithType:NSSQLiteStoreType configuration:nil URL:storeURL options:options error:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		return NO;
+	}
+	
+	return YES;
+}
+
+static int IdeaStoreSalvageReadAllRows(void *info, IdeaSalvageRowList *rows)
+{
+	return IdeaSalvageStoreReadAllRows(((IdeaStoreSalvageInfo *)info)->damagedStore, rows);
+}
+
+static int IdeaStoreSalvageReadChildRows(void *info, long long parentKey, IdeaSalvageRowList *rows)
+{
+	return IdeaSalvageStoreReadChildRows(((IdeaStoreSalvageInfo *)info)->damagedStore, parentKey, rows);
+}
+
+// The copies are retained by the recovered context until it's saved
+static void *IdeaStoreSalvageCopyRow(void *info, const IdeaSalvageRow *row, void *parentCopy)
+{
+	IdeaStoreSalvageInfo *salvageInfo = info;
+	NSManagedObject *idea = [NSEntityDescription insertNewObjectForEntityForName:@"Idea" inManagedObjectContext:salvageInfo->recoveredContext];
+	
+	if (row->name) {
+		[idea setValue:[NSString stringWithUTF8String:row->name] forKey:@"name"];
+	}
+	if (!isnan(row->timeStamp)) {
+		[idea setValue:[NSDate dateWithTimeIntervalSinceReferenceDate:row->timeStamp] forKey:@"timeStamp"];
+	}
+	if (parentCopy) {
+		[idea setValue:(NSManagedObject *)parentCopy forKey:@"parent"];
+	}
+	
+	return idea;
+}
+
+// Returns the number of ideas copied, or NSNotFound if the damaged store can't be opened at all
+// or the recovered store can't be written.
++ (NSUInteger)salvageStoreAtURL:(NSURL *)damagedURL intoStoreAtURL:(NSURL *)recoveredURL
+						  model:(NSManagedObjectModel *)model lostLevelCount:(NSUInteger *)lostLevelCount
+{
+	NSError *error = nil;
+	
+	sqlite3 *damagedStore = IdeaSalvageStoreOpen([[damagedURL path] fileSystemRepresentation]);
+	
+	if (damagedStore == NULL) {
+		NSLog(@"Unresolved error: the damaged store at %@ couldn't be opened", damagedURL);
+		return NSNotFound;
+	}
+	
+	IdeaStoreFileRemove([[recoveredURL path] fileSystemRepresentation]);
+	
+	NSPersistentStoreCoordinator *recoveredCoordinator = [[[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:model] autorelease];
+	
+	if (![recoveredCoordinator addPersistentStoreWithType:NSSQLiteStoreType configuration:nil URL:recoveredURL options:nil error:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		sqlite3_close(damagedStore);
+		return NSNotFound;
+	}
+	
+	IdeaStoreSalvageInfo info;
+	
+	info.damagedStore = damagedStore;
+	
+	info.recoveredContext = [[[NSManagedObjectContext alloc] init] autorelease];
+	[info.recoveredContext setPersistentStoreCoordinator:recoveredCoordinator];
+	[info.recoveredContext setUndoManager:nil];
+	
+	IdeaSalvageSource source = { &info, IdeaStoreSalvageReadAllRows, IdeaStoreSalvageReadChildRows, IdeaStoreSalvageCopyRow };
+	size_t lostCount = 0;
+	NSUInteger salvagedCount = IdeaSalvage(&source, &lostCount);
+	
+	*lostLevelCount = lostCount;
+	
+	// Closed before the damaged file is set aside
+	sqlite3_close(damagedStore);
+	
+	if (![info.recoveredContext save:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		IdeaStoreFileRemove([[recoveredURL path] fileSystemRepresentation]);
+		return NSNotFound;
+	}
+	
+	[recoveredCoordinator removePersistentStore:[[recoveredCoordinator persistentStores] lastObject] error:NULL];
+	
+	return salvagedCount;
+}
+
++ (NSURL *)URLForStoreAtURL:(NSURL *)storeURL suffix:(NSString *)suffix
+{
+	NSString *path = [storeURL path];
+	NSString *name = [[[path lastPathComponent] stringByDeletingPathExtension] stringByAppendingString:suffix];
+	
+	return [NSURL fileURLWithPath:[[[path stringByDeletingLastPathComponent] stringByAppendingPathComponent:name]
+								   stringByAppendingPathExtension:[path pathExtension]]];
+}
+
+@end
+
+
+@implementation IdeaStoreRecoveryOperation
+
+@synthesize report;
+
+- (id)initWithStoreAtURL:(NSURL *)aStoreURL model:(NSManagedObjectModel *)model target:(id)aTarget action:(SEL)anAction
+{
+	if ((self = [super init])) {
+		storeURL = [aStoreURL retain];
+		managedObjectModel = [model retain];
+		target = aTarget;
+		action = anAction;
+	}
+	
+	return self;
+}
+
+- (void)main
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	NSURL *recoveringURL = [IdeaStore URLForStoreAtURL:storeURL suffix:kRecoveringStoreSuffix];
+	NSURL *recoveredURL = [IdeaStore URLForStoreAtURL:storeURL suffix:kRecoveredStoreSuffix];
+	NSString *damagedPrefix = [[[storeURL path] stringByDeletingPathExtension] stringByAppendingString:kDamagedStoreSuffix];
+	
+	NSUInteger lostLevelCount = 0;
+	NSUInteger salvagedCount = [IdeaStore salvageStoreAtURL:storeURL intoStoreAtURL:recoveringURL
+													  model:managedObjectModel lostLevelCount:&lostLevelCount];
+	
+	// Only a finished copy is ever found under the recovered name
+	if (salvagedCount != NSNotFound &&
+		!IdeaStoreFileReplace([[recoveredURL path] fileSystemRepresentation], [[recoveringURL path] fileSystemRepresentation])) {
+		NSLog(@"Unresolved error %s", strerror(errno));
+		
+		IdeaStoreFileRemove([[recoveringURL path] fileSystemRepresentation]);
+		salvagedCount = NSNotFound;
+	}
+	
+	// Set the damaged file aside first, so that until the recovered one is in place there's never
+	// a store at storeURL that could be opened empty
+	char damagedPath[MAXPATHLEN];
+	
+	if (!IdeaStoreFileSetAside([[storeURL path] fileSystemRepresentation], [damagedPrefix fileSystemRepresentation],
+							   [[[storeURL path] pathExtension] fileSystemRepresentation], time(NULL), damagedPath, sizeof(damagedPath))) {
+		NSLog(@"Unresolved error %s", strerror(errno));
+		
+		IdeaStoreFileRemove([[recoveredURL path] fileSystemRepresentation]);
+		report = [@"Your ideas couldn't be opened, and the damaged file couldn't be moved out of the way to rebuild them. Changes won't be saved until the app is restarted." retain];
+	} else {
+		NSString *damagedName = [[NSString stringWithUTF8String:damagedPath] lastPathComponent];
+		
+		if (salvagedCount == NSNotFound) {
+			report = [[NSString alloc] initWithFormat:@"Your ideas couldn't be opened or read. A new board was started, and the damaged file was kept as %@.", damagedName];
+		} else {
+			if (!IdeaStoreFileReplace([[storeURL path] fileSystemRepresentation], [[recoveredURL path] fileSystemRepresentation])) {
+				// Left for the next launch to finish
+				NSLog(@"Unresolved error %s", strerror(errno));
+			}
+			
+			if (lostLevelCount > 0) {
+				report = [[NSString alloc] initWithFormat:@"Your ideas couldn't be opened and were rebuilt from the %d that could be read. The children of %d entries were lost, and the damaged file was kept as %@.", salvagedCount, lostLevelCount, damagedName];
+			} else {
+				report = [[NSString alloc] initWithFormat:@"Your ideas couldn't be opened and were rebuilt. All %d of them were recovered, and the damaged file was kept as %@.", salvagedCount, damagedName];
+			}
+		}
+	}
+	
+	// Finished even when cancelled, the store has to be added back either way
+	[self performSelectorOnMainThread:@selector(finish) withObject:nil waitUntilDone:NO];
+	
+	[pool drain];
+}
+
+- (void)finish
+{
+	[target performSelector:action withObject:report];
+}
+
+- (void)cancel
+{
+	target = nil;
+	[super cancel];
+}
+
+- (void)dealloc
+{
+	[storeURL release];
+	[managedObjectModel release];
+	[report release];
+	[super dealloc];
+}
+
+@end
+
+
+@implementation IdeaStoreMeasurementOperation
+
+- (id)initWithStoreAtURL:(NSURL *)aStoreURL model:(NSManagedObjectModel *)model target:(id)aTarget action:(SEL)anAction
+{
+	if ((self = [super init])) {
+		storeURL = [aStoreURL retain];
+		managedObjectModel = [model retain];
+		target = aTarget;
+		action = anAction;
+	}
+	
+	return self;
+}
+
+- (void)main
+{
+	if ([self isCancelled]) {
+		return;
+	}
+	
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	NSPersistentStoreCoordinator *coordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:managedObjectModel];
+	NSUInteger ideaCount = [IdeaStore countIdeasInStoreAtURL:storeURL coordinator:coordinator options:nil];
+	[coordinator release];
+	
+	if (ideaCount != NSNotFound) {
+		if (![IdeaStore hasBaseline]) {
+			[IdeaStore recordBaselineForStoreAtURL:storeURL ideaCount:ideaCount];
+		} else {
+			needsCompaction = [IdeaStore storeAtURL:storeURL needsCompactionWithIdeaCount:ideaCount];
+		}
+		
+		[self performSelectorOnMainThread:@selector(finish) withObject:nil waitUntilDone:NO];
+	}
+	
+	[pool drain];
+}
+
+- (void)finish
+{
+	[target performSelector:action withObject:[NSNumber numberWithBool:needsCompaction]];
+}
+
+- (void)cancel
+{
+	target = nil;
+	[super cancel];
+}
+
+- (void)dealloc
+{
+	[storeURL release];
+	[managedObjectModel release];
+	[super dealloc];
+}
+
+@end
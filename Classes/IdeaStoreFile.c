@@ -0,0 +1,184 @@
+//
+//  IdeaStoreFile.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "IdeaStoreFile.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define kHeaderLength 100
+static const char kHeaderMagic[16] = "SQLite format 3";
+static const char kJournalSuffix[] = "-journal";
+
+
+static int IdeaStoreFileJournalPath(const char *path, char *journalPath, size_t size)
+{
+	int length = snprintf(journalPath, size, "%s%s", path, kJournalSuffix);
+	
+	if (length < 0 || (size_t)length >= size) {
+		errno = ENAMETOOLONG;
+		return 0;
+	}
+	
+	return 1;
+}
+
+static int IdeaStoreFileExists(const char *path)
+{
+	struct stat status;
+	
+	return lstat(path, &status) == 0;
+}
+
+int IdeaStoreFileReadFreeBytes(const char *path, unsigned long long *freeBytes, unsigned long long *fileSize)
+{
+	unsigned char bytes[kHeaderLength];
+	struct stat status;
+	
+	*freeBytes = 0;
+	*fileSize = 0;
+	
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return 0;
+	}
+	
+	if (fstat(fileno(file), &status) != 0) {
+		fclose(file);
+		return 0;
+	}
+	*fileSize = (unsigned long long)status.st_size;
+	
+	size_t length = fread(bytes, 1, kHeaderLength, file);
+	fclose(file);
+	
+	if (length < kHeaderLength || memcmp(bytes, kHeaderMagic, sizeof(kHeaderMagic)) != 0) {
+		return 0;
+	}
+	
+	// Big endian, a page size of 1 stands for 65536
+	unsigned long long pageSize = ((unsigned long long)bytes[16] << 8) | bytes[17];
+	if (pageSize == 1) {
+		pageSize = 65536;
+	}
+	
+	unsigned long long freePageCount = ((unsigned long long)bytes[36] << 24) | ((unsigned long long)bytes[37] << 16) |
+									   ((unsigned long long)bytes[38] << 8) | bytes[39];
+	
+	// A damaged header can claim anything
+	*freeBytes = freePageCount * pageSize;
+	if (*freeBytes > *fileSize) {
+		*freeBytes = *fileSize;
+	}
+	
+	return 1;
+}
+
+int IdeaStoreFileReplace(const char *destination, const char *source)
+{
+	char sourceJournal[1024];
+	char destinationJournal[1024];
+	
+	if (!IdeaStoreFileJournalPath(source, sourceJournal, sizeof(sourceJournal)) ||
+		!IdeaStoreFileJournalPath(destination, destinationJournal, sizeof(destinationJournal))) {
+		return 0;
+	}
+	
+	// The destination is left alone, journal included, if there's nothing to replace it with
+	if (!IdeaStoreFileExists(source)) {
+		errno = ENOENT;
+		return 0;
+	}
+	
+	unlink(destinationJournal);
+	
+	if (rename(source, destination) != 0) {
+		return 0;
+	}
+	
+	rename(sourceJournal, destinationJournal);
+	
+	return 1;
+}
+
+int IdeaStoreFileSetAside(const char *path, const char *prefix, const char *extension, time_t time,
+						  char *result, size_t resultSize)
+{
+	char journal[1024];
+	char resultJournal[1024];
+	
+	if (!IdeaStoreFileJournalPath(path, journal, sizeof(journal))) {
+		return 0;
+	}
+	
+	for (unsigned number = 1; ; number++) {
+		int length;
+		
+		if (number == 1) {
+			length = snprintf(result, resultSize, "%s-%lld.%s", prefix, (long long)time, extension);
+		} else {
+			length = snprintf(result, resultSize, "%s-%lld-%u.%s", prefix, (long long)time, number, extension);
+		}
+		
+		if (length < 0 || (size_t)length >= resultSize || !IdeaStoreFileJournalPath(result, resultJournal, sizeof(resultJournal))) {
+			errno = ENAMETOOLONG;
+			return 0;
+		}
+		
+		// link() fails rather than replace a file, unlike rename()
+		if (link(path, result) != 0) {
+			if (errno == EEXIST) {
+				continue;
+			}
+			return 0;
+		}
+		
+		// A journal already under the new name had no store there, it's left over from something
+		// else and would be rolled back onto this one
+		unlink(resultJournal);
+		
+		if (IdeaStoreFileExists(journal)) {
+			if (link(journal, resultJournal) != 0) {
+				int linkError = errno;
+				unlink(result);
+				errno = linkError;
+				return 0;
+			}
+		}
+		
+		// The store goes first: a journal left without it is removed along with the next one set
+		// in its place, while a store left without its journal could be opened half written
+		unlink(path);
+		unlink(journal);
+		
+		return 1;
+	}
+}
+
+int IdeaStoreFileFinishInterruptedSwap(const char *path, const char *recoveredPath)
+{
+	if (IdeaStoreFileExists(path) || !IdeaStoreFileExists(recoveredPath)) {
+		return 0;
+	}
+	
+	return IdeaStoreFileReplace(path, recoveredPath);
+}
+
+void IdeaStoreFileRemove(const char *path)
+{
+	char journal[1024];
+	
+	if (IdeaStoreFileJournalPath(path, journal, sizeof(journal))) {
+		unlink(journal);
+	}
+	unlink(path);
+}
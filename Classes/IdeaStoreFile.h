@@ -0,0 +1,43 @@
+//
+//  IdeaStoreFile.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef IDEA_STORE_FILE_H
+#define IDEA_STORE_FILE_H
+
+#include <stddef.h>
+#include <time.h>
+
+// The file operations IdeaStore does on the store behind Core Data's back, in plain C so that they
+// can be tested on their own (see Tests/StoreTests.c). A store's journal is the store's path with
+// "-journal" appended, and always goes along with it.
+
+// Reads the page size and free page count from the header of the SQLite file at path, see
+// "Database File Format" in the SQLite documentation. Returns 0 if the file can't be read or
+// isn't an SQLite database, in which case *freeBytes is 0 and *fileSize whatever could be found.
+int IdeaStoreFileReadFreeBytes(const char *path, unsigned long long *freeBytes, unsigned long long *fileSize);
+
+// Moves the store at source to destination with a single rename, so that an interruption leaves
+// either file whole. The journal of destination is removed first, since rolling it back onto
+// another file would corrupt it; if there's no store at source, nothing is touched. Returns 0 with
+// errno set if the store couldn't be moved.
+int IdeaStoreFileReplace(const char *destination, const char *source);
+
+// Moves the store at path out of the way, to "<prefix>-<time>.<extension>", or
+// "<prefix>-<time>-<n>.<extension>" for the first n from 2 that's free. Never replaces a file,
+// so every store set aside is kept. Writes the path used to result, which must hold resultSize
+// bytes. Returns 0 with errno set if the store couldn't be moved.
+int IdeaStoreFileSetAside(const char *path, const char *prefix, const char *extension, time_t time,
+						  char *result, size_t resultSize);
+
+// Finishes a recovery that was interrupted after the damaged store was set aside: if there's no
+// store at path and a finished recovered store exists, it's moved into place. Returns 1 if it was.
+int IdeaStoreFileFinishInterruptedSwap(const char *path, const char *recoveredPath);
+
+void IdeaStoreFileRemove(const char *path);
+
+#endif
@@ -9,6 +9,9 @@
 #import <UIKit/UIKit.h>
 #import <CoreData/CoreData.h>
 
+@class LevelCache;
+@class IdeaOperationLog;
+
 @interface IdeasAppDelegate : NSObject <UIApplicationDelegate> {
     
     UIWindow *window;
@@ -18,6 +21,16 @@
     NSManagedObjectContext *managedObjectContext_;
     NSManagedObjectModel *managedObjectModel_;
     NSPersistentStoreCoordinator *persistentStoreCoordinator_;
+	
+	LevelCache *levelCache_;
+	IdeaOperationLog *operationLog_;
+	
+	// Set when the store couldn't be opened and the board is kept in memory until it's recovered
+	BOOL storeNeedsRecovery_;
+	UIAlertView *recoveryProgressAlert_;
+	
+	// Set when the store measured at launch is worth compacting once the app goes to the background
+	BOOL storeNeedsCompaction_;
 }
 
 @property (nonatomic, retain) IBOutlet UIWindow *window;
@@ -28,6 +41,7 @@
 @property (nonatomic, retain, readonly) NSPersistentStoreCoordinator *persistentStoreCoordinator;
 
 - (NSURL *)applicationDocumentsDirectory;
+- (NSURL *)storeURL;
 - (void)saveContext;
 
 @end
@@ -9,8 +9,23 @@
 #import "IdeasAppDelegate.h"
 #import "RootViewController.h"
 #import "ApplicationHelper.h"
+#import "LevelCache.h"
+#import "IdeaOperationLog.h"
+#import "IdeaStore.h"
+#import "IdeaSnapshot.h"
+#import "IdeaBackup.h"
 #import "FlurryAPI.h"
 
+
+@interface IdeasAppDelegate ()
+- (void)showRecoveryProgress;
+- (void)storeRecoveryDidFinish:(NSString *)report;
+- (void)startStoreMaintenance;
+- (void)storeMeasurementDidFinish:(NSNumber *)needsCompaction;
+- (void)compactStoreIfNeeded;
+@end
+
+
 @implementation IdeasAppDelegate
 
 @synthesize window;
@@ -27,6 +42,13 @@ void uncaughtExceptionHandler(NSException *exception) {
     
     RootViewController *rootViewController = (RootViewController *)[navigationController topViewController];
     rootViewController.managedObjectContext = self.managedObjectContext;
+	
+	// Shared by every level of the navigation stack
+	levelCache_ = [[LevelCache alloc] initWithManagedObjectContext:self.managedObjectContext];
+	rootViewController.levelCache = levelCache_;
+	
+	operationLog_ = [[IdeaOperationLog alloc] initWithManagedObjectContext:self.managedObjectContext];
+	rootViewController.operationLog = operationLog_;
 }
 
 
@@ -38,11 +60,131 @@ void uncaughtExceptionHandler(NSException *exception) {
     // Add the navigation controller's view to the window and display.
     [self.window addSubview:navigationController.view];
     [self.window makeKeyAndVisible];
+	
+	if (storeNeedsRecovery_) {
+		// Rebuilding a large store takes longer than launching is allowed to
+		[self showRecoveryProgress];
+		
+		IdeaStoreRecoveryOperation *recoveryOperation = [[IdeaStoreRecoveryOperation alloc] initWithStoreAtURL:[self storeURL]
+																										 model:self.managedObjectModel
+																										target:self
+																										action:@selector(storeRecoveryDidFinish:)];
+		[[IdeaSnapshot readerQueue] addOperation:recoveryOperation];
+		[recoveryOperation release];
+	} else {
+		[self startStoreMaintenance];
+	}
 
     return YES;
 }
 
 
+- (void)startStoreMaintenance {
+	// Both off the main thread. Only measuring, the store is compacted once the board is put away.
+	IdeaStoreMeasurementOperation *measurementOperation = [[IdeaStoreMeasurementOperation alloc] initWithStoreAtURL:[self storeURL]
+																											   model:self.managedObjectModel
+																											  target:self
+																											  action:@selector(storeMeasurementDidFinish:)];
+	[[IdeaSnapshot readerQueue] addOperation:measurementOperation];
+	[measurementOperation release];
+	
+	// At most one generation a day
+	IdeaBackupOperation *backupOperation = [[IdeaBackupOperation alloc] initWithBackup:[IdeaBackup defaultBackup]
+																persistentStoreCoordinator:self.persistentStoreCoordinator];
+	[[IdeaSnapshot readerQueue] addOperation:backupOperation];
+	[backupOperation release];
+}
+
+
+- (void)storeMeasurementDidFinish:(NSNumber *)needsCompaction {
+	storeNeedsCompaction_ = [needsCompaction boolValue];
+}
+
+
+// Vacuuming rewrites the whole file, so it waits until the app leaves the screen and the board
+// can't be used. It runs right here on the main thread, within the time the app gets before being
+// suspended, rather than on the reader queue, where it could still be queued behind a backup when
+// the app comes back. A vacuum cut short is rolled back by SQLite's journal.
+- (void)compactStoreIfNeeded {
+	if (!storeNeedsCompaction_ || storeNeedsRecovery_) {
+		return;
+	}
+	
+	if ([IdeaStore compactStoreAtURL:[self storeURL] model:self.managedObjectModel]) {
+		storeNeedsCompaction_ = NO;
+	}
+}
+
+
+#pragma mark -
+#pragma mark Store recovery
+
+// An alert without buttons, so the empty board can't be edited while it's being recovered
+- (void)showRecoveryProgress {
+	recoveryProgressAlert_ = [[UIAlertView alloc] initWithTitle:@"Recovering Ideas"
+														message:@"Your ideas couldn't be opened and are being rebuilt, this may take a while.\n\n\n"
+													   delegate:nil
+											  cancelButtonTitle:nil
+											  otherButtonTitles:nil];
+	[recoveryProgressAlert_ show];
+	
+	UIActivityIndicatorView *activityIndicator = [[UIActivityIndicatorView alloc] initWithActivityIndicatorStyle:UIActivityIndicatorViewStyleWhiteLarge];
+	activityIndicator.center = CGPointMake(recoveryProgressAlert_.bounds.size.width / 2, recoveryProgressAlert_.bounds.size.height - 50);
+	[activityIndicator startAnimating];
+	[recoveryProgressAlert_ addSubview:activityIndicator];
+	[activityIndicator release];
+}
+
+
+// The board was kept in memory meanwhile, swap the recovered store in for it
+- (void)storeRecoveryDidFinish:(NSString *)report {
+	NSPersistentStoreCoordinator *coordinator = self.persistentStoreCoordinator;
+	NSPersistentStore *memoryStore = [[coordinator persistentStores] lastObject];
+	NSString *message = report;
+	
+	[navigationController popToRootViewControllerAnimated:NO];
+	
+	NSError *error = nil;
+	if (memoryStore && ![coordinator removePersistentStore:memoryStore error:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+	}
+	
+	if ([IdeaStore addStoreAtURL:[self storeURL] toCoordinator:coordinator]) {
+		storeNeedsRecovery_ = NO;
+	} else {
+		message = [report stringByAppendingString:@" Your ideas couldn't be opened after that either, so changes won't be saved until the app is restarted."];
+		
+		if (![coordinator addPersistentStoreWithType:NSInMemoryStoreType configuration:nil URL:nil options:nil error:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		}
+	}
+	
+	// Nothing fetched from the store kept in memory is valid anymore
+	[self.managedObjectContext reset];
+	[operationLog_ removeAllOperations];
+	[levelCache_ removeAllLevels];
+	[(RootViewController *)[navigationController topViewController] reloadBoard];
+	
+	[recoveryProgressAlert_ dismissWithClickedButtonIndex:0 animated:YES];
+	[recoveryProgressAlert_ release];
+	recoveryProgressAlert_ = nil;
+	
+	[FlurryAPI logEvent:@"STORE_RECOVERED"];
+	
+	UIAlertView *alert = [[UIAlertView alloc] initWithTitle:@"Ideas Recovered"
+													message:message 
+												   delegate:nil 
+										  cancelButtonTitle:@"Ok" 
+										  otherButtonTitles:nil];
+	[alert show];
+	[alert release];
+	
+	if (!storeNeedsRecovery_) {
+		[self startStoreMaintenance];
+	}
+}
+
+
 - (void)applicationWillResignActive:(UIApplication *)application {
     /*
      Sent when the application is about to move from active to inactive state. This can occur for certain types of temporary interruptions (such as an incoming phone call or SMS message) or when the user quits the application and it begins the transition to the background state.
@@ -57,6 +199,7 @@ void uncaughtExceptionHandler(NSException *exception) {
      If your application supports background execution, called instead of applicationWillTerminate: when the user quits.
      */
     [self saveContext];
+	[self compactStoreIfNeeded];
 }
 
 
@@ -79,6 +222,7 @@ void uncaughtExceptionHandler(NSException *exception) {
  */
 - (void)applicationWillTerminate:(UIApplication *)application {
     [self saveContext];
+	[self compactStoreIfNeeded];
 }
 
 
@@ -88,13 +232,10 @@ void uncaughtExceptionHandler(NSException *exception) {
 	NSManagedObjectContext *managedObjectContext = self.managedObjectContext;
     if (managedObjectContext != nil) {
         if ([managedObjectContext hasChanges] && ![managedObjectContext save:&error]) {
-            /*
-             Replace this implementation with code to handle the error appropriately.
-             
-             abort() causes the application to generate a crash log and terminate. You should not use this function in a shipping application, although it may be useful during development. If it is not possible to recover from the error, display an alert panel that instructs the user to quit the application by pressing the Home button.
-             */
+            // A failed save leaves the store as it was, the changes stay in the context and are
+            // tried again with the next save
             NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
-            abort();
+            [FlurryAPI logError:@"SAVE_FAILED" message:[error localizedDescription] error:error];
         } 
     }
 }    
@@ -148,37 +289,20 @@ void uncaughtExceptionHandler(NSException *exception) {
         return persistentStoreCoordinator_;
     }
     
-    NSURL *storeURL = [[self applicationDocumentsDirectory] URLByAppendingPathComponent:@"Ideas.sqlite"];
+    NSURL *storeURL = [self storeURL];
     
-    NSError *error = nil;
+    // A store that can't be opened is rebuilt after launch from whatever can still be read from it,
+    // see IdeaStoreRecoveryOperation, and the board is kept in memory until then
     persistentStoreCoordinator_ = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:[self managedObjectModel]];
-    if (![persistentStoreCoordinator_ addPersistentStoreWithType:NSSQLiteStoreType configuration:nil URL:storeURL options:nil error:&error]) {
-        /*
-         Replace this implementation with code to handle the error appropriately.
-         
-         abort() causes the application to generate a crash log and terminate. You should not use this function in a shipping application, although it may be useful during development. If it is not possible to recover from the error, display an alert panel that instructs the user to quit the application by pressing the Home button.
-         
-         Typical reasons for an error here include:
-         * The persistent store is not accessible;
-         * The schema for the persistent store is incompatible with current managed object model.
-         Check the error message to determine what the actual problem was.
-         
-         
-         If the persistent store is not accessible, there is typically something wrong with the file path. Often, a file URL is pointing into the application's resources directory instead of a writeable directory.
-         
-         If you encounter schema incompatibility errors during development, you can reduce their frequency by:
-         * Simply deleting the existing store:
-         [[NSFileManager defaultManager] removeItemAtURL:storeURL error:nil]
-         
-         * Performing automatic lightweight migration by passing the following dictionary as the options parameter: 
-         [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:YES],NSMigratePersistentStoresAutomaticallyOption, [NSNumber numberWithBool:YES], NSInferMappingModelAutomaticallyOption, nil];
-         
-         Lightweight migration will only work for a limited set of schema changes; consult "Core Data Model Versioning and Data Migration Programming Guide" for details.
-         
-         */
-        NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
-        [ApplicationHelper showApplicationError];
-    }    
+    if (![IdeaStore addStoreAtURL:storeURL toCoordinator:persistentStoreCoordinator_]) {
+        storeNeedsRecovery_ = YES;
+        
+        NSError *error = nil;
+        if (![persistentStoreCoordinator_ addPersistentStoreWithType:NSInMemoryStoreType configuration:nil URL:nil options:nil error:&error]) {
+            NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+            [ApplicationHelper showApplicationError];
+        }
+    }
     
     return persistentStoreCoordinator_;
 }
@@ -195,6 +319,11 @@ void uncaughtExceptionHandler(NSException *exception) {
 }
 
 
+- (NSURL *)storeURL {
+    return [[self applicationDocumentsDirectory] URLByAppendingPathComponent:@"Ideas.sqlite"];
+}
+
+
 #pragma mark -
 #pragma mark Memory management
 
@@ -210,6 +339,9 @@ void uncaughtExceptionHandler(NSException *exception) {
     [managedObjectContext_ release];
     [managedObjectModel_ release];
     [persistentStoreCoordinator_ release];
+	[levelCache_ release];
+	[operationLog_ release];
+	[recoveryProgressAlert_ release];
     
     [navigationController release];
     [window release];
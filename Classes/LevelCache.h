@@ -0,0 +1,75 @@
+//
+//  LevelCache.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/22/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+@class Idea;
+
+// Posted whenever a change in the managed object context touches the children of one or more
+// ideas. The userInfo holds the keys (see keyForParent:) of the affected levels, whether or not
+// they were cached at the time.
+extern NSString * const LevelCacheDidInvalidateNotification;
+extern NSString * const LevelCacheInvalidatedParentsKey;
+
+// Remembers the ordered children of the levels the user has recently navigated to, keyed by
+// the object id of their parent idea (NSNull for the top level), together with their names,
+// row heights and scroll offset, so that showing a level again doesn't need to fetch or
+// measure it. A level's rows are dropped as soon as an idea under it is inserted, updated,
+// deleted or moved to another parent; its scroll offset is kept. Only the most recently
+// visited levels are remembered.
+@interface LevelCache : NSObject {
+	NSManagedObjectContext *managedObjectContext;
+	NSMutableDictionary *levels;
+	NSMutableDictionary *parentKeysByChild;
+
+	// Visited levels, least recently shown first, and where they were scrolled to
+	NSMutableArray *visitedKeys;
+	NSMutableDictionary *scrollOffsets;
+
+	// Prefetched levels that haven't been shown yet, oldest first
+	NSMutableArray *prefetchedKeys;
+	NSUInteger prefetchedRowCount;
+
+	NSUInteger changeCount;
+	NSUInteger hitCount;
+	NSUInteger missCount;
+	NSUInteger invalidationCount;
+}
+
+// Incremented whenever a change in the context invalidates any level, so that work started
+// from an earlier state of the context can tell it's stale.
+@property (nonatomic, readonly) NSUInteger changeCount;
+@property (nonatomic, readonly) NSUInteger hitCount;
+@property (nonatomic, readonly) NSUInteger missCount;
+@property (nonatomic, readonly) NSUInteger invalidationCount;
+
++ (id)keyForParent:(Idea *)parent;
+
+- (id)initWithManagedObjectContext:(NSManagedObjectContext *)context;
+
+// Returns NO on a miss. On a hit, rows holds the children of parent in display order and names
+// holds their names, which can be shown without firing the rows' faults. heights, if not NULL,
+// holds the heights of the rows measured so far, starting from the first one, or nil.
+- (BOOL)getRows:(NSArray **)rows names:(NSArray **)names heights:(NSArray **)heights forParent:(Idea *)parent;
+- (void)storeRows:(NSArray *)rows names:(NSArray *)names forParent:(Idea *)parent;
+
+// Records the state a level is left in. The heights are only kept while the level's rows are,
+// and only if they don't outnumber them.
+- (void)storeHeights:(NSArray *)heights scrollOffset:(CGFloat)scrollOffset forParent:(Idea *)parent;
+- (CGFloat)scrollOffsetForParent:(Idea *)parent;
+
+// Levels stored ahead of time only stay in the cache within a budget of rows; the ones stored
+// longest ago are dropped first. A prefetched level counts as visited once it's shown.
+- (BOOL)containsLevelForKey:(id)parentKey;
+- (void)storePrefetchedObjectIDs:(NSArray *)objectIDs names:(NSArray *)names heights:(NSArray *)heights 
+					forParentKey:(id)parentKey;
+
+- (void)removeAllLevels;
+
+@end
@@ -0,0 +1,367 @@
+//
+//  LevelCache.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/22/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import "LevelCache.h"
+#import "Idea.h"
+
+
+NSString * const LevelCacheDidInvalidateNotification = @"LevelCacheDidInvalidateNotification";
+NSString * const LevelCacheInvalidatedParentsKey = @"LevelCacheInvalidatedParentsKey";
+
+// Rows held by prefetched levels that haven't been shown yet
+static const NSUInteger kPrefetchedRowBudget = 2000;
+
+// Levels remembered once they've been shown
+static const NSUInteger kVisitedLevelLimit = 50;
+
+
+// The children of one parent idea, as object ids so that they don't keep the objects alive.
+@interface LevelCacheEntry : NSObject {
+@public
+	NSArray *objectIDs;
+	NSArray *names;
+	NSArray *heights;
+	BOOL prefetched;
+}
+@end
+
+@implementation LevelCacheEntry
+
+- (void)dealloc
+{
+	[objectIDs release];
+	[names release];
+	[heights release];
+	[super dealloc];
+}
+
+@end
+
+
+@interface LevelCache ()
+- (void)objectsDidChange:(NSNotification *)notification;
+- (BOOL)changesRowOfIdea:(Idea *)idea;
+- (void)removeLevelForKey:(id)parentKey;
+- (void)discardLevelForKey:(id)parentKey;
+- (void)touchVisitedKey:(id)parentKey;
+- (void)forgetVisitedKey:(id)parentKey;
+- (void)storeObjectIDs:(NSArray *)objectIDs names:(NSArray *)names heights:(NSArray *)heights 
+		  forParentKey:(id)parentKey prefetched:(BOOL)prefetched;
+@end
+
+
+@implementation LevelCache
+
+@synthesize changeCount, hitCount, missCount, invalidationCount;
+
++ (id)keyForParent:(Idea *)parent
+{
+	if (parent == nil) {
+		return [NSNull null];
+	}
+	
+	return [parent objectID];
+}
+
+- (id)initWithManagedObjectContext:(NSManagedObjectContext *)context
+{
+	if ((self = [super init])) {
+		managedObjectContext = [context retain];
+		levels = [[NSMutableDictionary alloc] init];
+		parentKeysByChild = [[NSMutableDictionary alloc] init];
+		prefetchedKeys = [[NSMutableArray alloc] init];
+		visitedKeys = [[NSMutableArray alloc] init];
+		scrollOffsets = [[NSMutableDictionary alloc] init];
+		
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(objectsDidChange:)
+													 name:NSManagedObjectContextObjectsDidChangeNotification
+												   object:managedObjectContext];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(removeAllLevels)
+													 name:UIApplicationDidReceiveMemoryWarningNotification
+												   object:nil];
+	}
+	
+	return self;
+}
+
+- (BOOL)getRows:(NSArray **)rows names:(NSArray **)names heights:(NSArray **)heights forParent:(Idea *)parent
+{
+	id parentKey = [LevelCache keyForParent:parent];
+	LevelCacheEntry *entry = [levels objectForKey:parentKey];
+	
+	if (entry == nil) {
+		missCount++;
+		return NO;
+	}
+	
+	hitCount++;
+	
+	if (entry->prefetched) {
+		entry->prefetched = NO;
+		prefetchedRowCount -= [entry->objectIDs count];
+		[prefetchedKeys removeObject:parentKey];
+	}
+	
+	[self touchVisitedKey:parentKey];
+	
+	// objectWithID: hands back registered objects or unfired faults, neither of which touches the store
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:[entry->objectIDs count]];
+	for (NSManagedObjectID *objectID in entry->objectIDs) {
+		[objects addObject:[managedObjectContext objectWithID:objectID]];
+	}
+	
+	*rows = objects;
+	*names = entry->names;
+	if (heights) {
+		*heights = entry->heights;
+	}
+	
+	return YES;
+}
+
+- (void)storeRows:(NSArray *)rows names:(NSArray *)names forParent:(Idea *)parent
+{
+	if ([[parent objectID] isTemporaryID]) {
+		return;
+	}
+	
+	NSArray *objectIDs = [rows valueForKey:@"objectID"];
+	
+	// Temporary ids change on save, unsaved levels are simply fetched again
+	for (NSManagedObjectID *objectID in objectIDs) {
+		if ([objectID isTemporaryID]) {
+			return;
+		}
+	}
+	
+	id parentKey = [LevelCache keyForParent:parent];
+	
+	[self storeObjectIDs:objectIDs names:names heights:nil forParentKey:parentKey prefetched:NO];
+	[self touchVisitedKey:parentKey];
+}
+
+- (void)storeHeights:(NSArray *)heights scrollOffset:(CGFloat)scrollOffset forParent:(Idea *)parent
+{
+	if ([[parent objectID] isTemporaryID]) {
+		return;
+	}
+	
+	id parentKey = [LevelCache keyForParent:parent];
+	LevelCacheEntry *entry = [levels objectForKey:parentKey];
+	
+	if (entry && [heights count] <= [entry->objectIDs count]) {
+		[entry->heights release];
+		entry->heights = [heights copy];
+	}
+	
+	[scrollOffsets setObject:[NSNumber numberWithFloat:scrollOffset] forKey:parentKey];
+	[self touchVisitedKey:parentKey];
+}
+
+- (CGFloat)scrollOffsetForParent:(Idea *)parent
+{
+	return [[scrollOffsets objectForKey:[LevelCache keyForParent:parent]] floatValue];
+}
+
+- (void)touchVisitedKey:(id)parentKey
+{
+	[parentKey retain];
+	[visitedKeys removeObject:parentKey];
+	[visitedKeys addObject:parentKey];
+	[parentKey release];
+	
+	while ([visitedKeys count] > kVisitedLevelLimit) {
+		[self forgetVisitedKey:[visitedKeys objectAtIndex:0]];
+	}
+}
+
+- (void)forgetVisitedKey:(id)parentKey
+{
+	LevelCacheEntry *entry = [levels objectForKey:parentKey];
+	
+	// A level prefetched again after it was visited is accounted for by the prefetch budget
+	if (entry && !entry->prefetched) {
+		[self discardLevelForKey:parentKey];
+	}
+	
+	[scrollOffsets removeObjectForKey:parentKey];
+	[visitedKeys removeObject:parentKey];
+}
+
+- (BOOL)containsLevelForKey:(id)parentKey
+{
+	return [levels objectForKey:parentKey] != nil;
+}
+
+- (void)storePrefetchedObjectIDs:(NSArray *)objectIDs names:(NSArray *)names heights:(NSArray *)heights 
+					forParentKey:(id)parentKey
+{
+	if ([objectIDs count] > kPrefetchedRowBudget) {
+		return;
+	}
+	
+	[self storeObjectIDs:objectIDs names:names heights:heights forParentKey:parentKey prefetched:YES];
+	
+	while (prefetchedRowCount > kPrefetchedRowBudget) {
+		[self discardLevelForKey:[prefetchedKeys objectAtIndex:0]];
+	}
+}
+
+- (void)storeObjectIDs:(NSArray *)objectIDs names:(NSArray *)names heights:(NSArray *)heights 
+		  forParentKey:(id)parentKey prefetched:(BOOL)prefetched
+{
+	[self discardLevelForKey:parentKey];
+	
+	LevelCacheEntry *entry = [[LevelCacheEntry alloc] init];
+	entry->objectIDs = [objectIDs copy];
+	entry->names = [names copy];
+	entry->heights = [heights copy];
+	entry->prefetched = prefetched;
+	[levels setObject:entry forKey:parentKey];
+	[entry release];
+	
+	for (NSManagedObjectID *objectID in objectIDs) {
+		[parentKeysByChild setObject:parentKey forKey:objectID];
+	}
+	
+	if (prefetched) {
+		[prefetchedKeys addObject:parentKey];
+		prefetchedRowCount += [objectIDs count];
+	}
+}
+
+- (void)removeLevelForKey:(id)parentKey
+{
+	if ([levels objectForKey:parentKey]) {
+		[self discardLevelForKey:parentKey];
+		invalidationCount++;
+	}
+}
+
+// Drops a level without counting it as an invalidation
+- (void)discardLevelForKey:(id)parentKey
+{
+	LevelCacheEntry *entry = [levels objectForKey:parentKey];
+	
+	if (entry == nil) {
+		return;
+	}
+	
+	if (entry->prefetched) {
+		prefetchedRowCount -= [entry->objectIDs count];
+		[prefetchedKeys removeObject:parentKey];
+	}
+	
+	[parentKeysByChild removeObjectsForKeys:entry->objectIDs];
+	[levels removeObjectForKey:parentKey];
+}
+
+- (void)removeAllLevels
+{
+	invalidationCount += [levels count];
+	
+	[levels removeAllObjects];
+	[parentKeysByChild removeAllObjects];
+	[prefetchedKeys removeAllObjects];
+	prefetchedRowCount = 0;
+}
+
+// Changing an idea's children only updates the idea's own inverse relationship, which isn't
+// shown in the level it belongs to.
+- (BOOL)changesRowOfIdea:(Idea *)idea
+{
+	for (NSString *key in [idea changedValues]) {
+		if (![key isEqualToString:@"children"]) {
+			return YES;
+		}
+	}
+	
+	return NO;
+}
+
+- (void)objectsDidChange:(NSNotification *)notification
+{
+	NSDictionary *userInfo = [notification userInfo];
+	NSMutableSet *parentKeys = [NSMutableSet set];
+	
+	if ([userInfo objectForKey:NSInvalidatedAllObjectsKey]) {
+		[parentKeys addObjectsFromArray:[levels allKeys]];
+		[self removeAllLevels];
+	}
+	
+	NSArray *changeKeys = [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey,
+						   NSRefreshedObjectsKey, NSInvalidatedObjectsKey, nil];
+	
+	for (NSString *changeKey in changeKeys) {
+		// Refreshed and invalidated objects can't be asked for their parent
+		BOOL knowsParent = ![changeKey isEqualToString:NSRefreshedObjectsKey] && ![changeKey isEqualToString:NSInvalidatedObjectsKey];
+		
+		for (NSManagedObject *object in [userInfo objectForKey:changeKey]) {
+			if (![object isKindOfClass:[Idea class]]) {
+				continue;
+			}
+			
+			Idea *idea = (Idea *)object;
+			
+			if ([changeKey isEqualToString:NSDeletedObjectsKey]) {
+				[parentKeys addObject:[idea objectID]];
+				[self forgetVisitedKey:[idea objectID]];
+			} else if ([changeKey isEqualToString:NSUpdatedObjectsKey] && ![self changesRowOfIdea:idea]) {
+				continue;
+			}
+			
+			// The level the idea was cached in, which differs from its current parent once it's moved
+			id cachedParentKey = [parentKeysByChild objectForKey:[idea objectID]];
+			if (cachedParentKey) {
+				[parentKeys addObject:cachedParentKey];
+			}
+			
+			if (knowsParent) {
+				[parentKeys addObject:[LevelCache keyForParent:idea.parent]];
+			}
+		}
+	}
+	
+	if ([parentKeys count] == 0) {
+		return;
+	}
+	
+	changeCount++;
+	
+	for (id parentKey in parentKeys) {
+		[self removeLevelForKey:parentKey];
+	}
+	
+	[[NSNotificationCenter defaultCenter] postNotificationName:LevelCacheDidInvalidateNotification
+														object:self
+													  userInfo:[NSDictionary dictionaryWithObject:parentKeys forKey:LevelCacheInvalidatedParentsKey]];
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@: %u levels, %u hits, %u misses, %u invalidations>",
+			[self class], [levels count], hitCount, missCount, invalidationCount];
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	
+	[managedObjectContext release];
+	[levels release];
+	[parentKeysByChild release];
+	[prefetchedKeys release];
+	[visitedKeys release];
+	[scrollOffsets release];
+	[super dealloc];
+}
+
+@end
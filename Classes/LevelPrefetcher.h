@@ -0,0 +1,44 @@
+//
+//  LevelPrefetcher.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/23/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <CoreData/CoreData.h>
+
+@class LevelCache;
+
+// Loads the children of the ideas on screen into the level cache before they're tapped, one
+// level at a time on a background queue with its own managed object context. Nothing is
+// started while the table view is scrolling fast, and levels whose rows left the screen are
+// cancelled before they're fetched.
+@interface LevelPrefetcher : NSObject {
+	LevelCache *levelCache;
+	NSManagedObjectContext *managedObjectContext;
+	NSOperationQueue *queue;
+	NSMutableDictionary *operationsByParentKey;
+
+	CGFloat scrollSpeed;
+	CGFloat lastContentOffset;
+	NSTimeInterval lastScrollTime;
+}
+
+// Points per second, as of the last call to trackScrollView:. It drops to 0 once the scroll
+// view is neither dragged nor decelerating.
+@property (nonatomic, readonly) CGFloat scrollSpeed;
+@property (nonatomic, readonly, getter=isScrollingFast) BOOL scrollingFast;
+
+- (id)initWithLevelCache:(LevelCache *)cache managedObjectContext:(NSManagedObjectContext *)context;
+
+- (void)trackScrollView:(UIScrollView *)scrollView;
+
+// Starts prefetching the levels under the given ideas that aren't cached or being fetched
+// already, and cancels the ones under any other idea. Row heights are measured for as many
+// rows as fit in the given height.
+- (void)prefetchChildrenOfIdeas:(NSArray *)ideas measuringRowsInHeight:(CGFloat)height;
+- (void)cancelAllPrefetches;
+
+@end
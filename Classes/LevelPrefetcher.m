@@ -0,0 +1,239 @@
+//
+//  LevelPrefetcher.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/23/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "LevelPrefetcher.h"
+#import "LevelCache.h"
+#import "ApplicationHelper.h"
+
+
+// Above this speed, in points per second, rows fly by too fast to be tapped
+static const CGFloat kFastScrollSpeed = 1500.0;
+
+
+@class LevelPrefetchOperation;
+
+@interface LevelPrefetcher ()
+- (void)operationDidFinish:(LevelPrefetchOperation *)operation;
+- (void)cancelOperationForParentKey:(id)parentKey;
+@end
+
+
+// Fetches the children of one idea in a context of its own, and hands them back to the
+// prefetcher on the main thread.
+@interface LevelPrefetchOperation : NSOperation {
+@public
+	NSPersistentStoreCoordinator *persistentStoreCoordinator;
+	NSManagedObjectID *parentID;
+	NSUInteger changeCount;
+	CGFloat measuredHeight;
+	
+	NSArray *objectIDs;
+	NSArray *names;
+	
+	// Not retained, only touched on the main thread and cleared when the operation is cancelled
+	LevelPrefetcher *prefetcher;
+}
+@end
+
+@implementation LevelPrefetchOperation
+
+- (void)main
+{
+	if ([self isCancelled]) {
+		return;
+	}
+	
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	NSManagedObjectContext *context = [[NSManagedObjectContext alloc] init];
+	[context setPersistentStoreCoordinator:persistentStoreCoordinator];
+	[context setUndoManager:nil];
+	
+	NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
+	[fetchRequest setEntity:[NSEntityDescription entityForName:@"Idea" inManagedObjectContext:context]];
+	[fetchRequest setPredicate:[NSPredicate predicateWithFormat:@"parent == %@", parentID]];
+	[fetchRequest setReturnsObjectsAsFaults:NO];
+	
+	// Same order as the fetched results controller of a RootViewController
+	NSSortDescriptor *sortDescriptor = [[NSSortDescriptor alloc] initWithKey:@"timeStamp" ascending:YES];
+	[fetchRequest setSortDescriptors:[NSArray arrayWithObject:sortDescriptor]];
+	[sortDescriptor release];
+	
+	NSError *error = nil;
+	NSArray *results = [context executeFetchRequest:fetchRequest error:&error];
+	
+	if (results == nil) {
+		NSLog(@"Prefetch failed %@, %@", error, [error userInfo]);
+	} else if (![self isCancelled]) {
+		objectIDs = [[results valueForKey:@"objectID"] retain];
+		names = [[results valueForKey:@"name"] retain];
+		
+		[self performSelectorOnMainThread:@selector(finish) withObject:nil waitUntilDone:NO];
+	}
+	
+	[fetchRequest release];
+	[context release];
+	[pool drain];
+}
+
+- (void)finish
+{
+	[prefetcher operationDidFinish:self];
+}
+
+- (void)dealloc
+{
+	[persistentStoreCoordinator release];
+	[parentID release];
+	[objectIDs release];
+	[names release];
+	[super dealloc];
+}
+
+@end
+
+
+@implementation LevelPrefetcher
+
+@synthesize scrollSpeed;
+
+- (id)initWithLevelCache:(LevelCache *)cache managedObjectContext:(NSManagedObjectContext *)context
+{
+	if ((self = [super init])) {
+		levelCache = [cache retain];
+		managedObjectContext = [context retain];
+		operationsByParentKey = [[NSMutableDictionary alloc] init];
+		
+		// One level at a time, the store is shared with the main thread
+		queue = [[NSOperationQueue alloc] init];
+		[queue setMaxConcurrentOperationCount:1];
+	}
+	
+	return self;
+}
+
+- (void)trackScrollView:(UIScrollView *)scrollView
+{
+	NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+	CGFloat contentOffset = scrollView.contentOffset.y;
+	
+	if (!scrollView.dragging && !scrollView.decelerating) {
+		scrollSpeed = 0;
+	} else if (lastScrollTime > 0 && now > lastScrollTime) {
+		scrollSpeed = fabsf(contentOffset - lastContentOffset) / (now - lastScrollTime);
+	}
+	
+	lastContentOffset = contentOffset;
+	lastScrollTime = now;
+}
+
+- (BOOL)isScrollingFast
+{
+	return scrollSpeed > kFastScrollSpeed;
+}
+
+- (void)prefetchChildrenOfIdeas:(NSArray *)ideas measuringRowsInHeight:(CGFloat)height
+{
+	NSMutableSet *wantedKeys = [NSMutableSet setWithCapacity:[ideas count]];
+	
+	// The background context only sees what's saved, so wait for pending changes to be saved
+	BOOL canFetch = ![managedObjectContext hasChanges];
+	
+	for (NSManagedObject *idea in ideas) {
+		NSManagedObjectID *parentID = [idea objectID];
+		
+		if ([parentID isTemporaryID]) {
+			continue;
+		}
+		
+		[wantedKeys addObject:parentID];
+		
+		if (!canFetch || [levelCache containsLevelForKey:parentID] || [operationsByParentKey objectForKey:parentID]) {
+			continue;
+		}
+		
+		LevelPrefetchOperation *operation = [[LevelPrefetchOperation alloc] init];
+		operation->persistentStoreCoordinator = [[managedObjectContext persistentStoreCoordinator] retain];
+		operation->parentID = [parentID retain];
+		operation->changeCount = levelCache.changeCount;
+		operation->measuredHeight = height;
+		operation->prefetcher = self;
+		
+		[operationsByParentKey setObject:operation forKey:parentID];
+		[queue addOperation:operation];
+		[operation release];
+	}
+	
+	for (id parentKey in [operationsByParentKey allKeys]) {
+		if (![wantedKeys containsObject:parentKey]) {
+			[self cancelOperationForParentKey:parentKey];
+		}
+	}
+}
+
+- (void)operationDidFinish:(LevelPrefetchOperation *)operation
+{
+	[[operation retain] autorelease];
+	[operationsByParentKey removeObjectForKey:operation->parentID];
+	
+	// Anything that changed since the fetch started may not be in its results
+	if (operation->changeCount != levelCache.changeCount || [managedObjectContext hasChanges]) {
+		return;
+	}
+	
+	// The level was shown in the meantime
+	if ([levelCache containsLevelForKey:operation->parentID]) {
+		return;
+	}
+	
+	NSMutableArray *heights = [NSMutableArray array];
+	CGFloat totalHeight = 0;
+	
+	for (id name in operation->names) {
+		if (totalHeight >= operation->measuredHeight) {
+			break;
+		}
+		
+		CGFloat rowHeight = [ApplicationHelper rowHeightForText:(name == [NSNull null] ? nil : name)];
+		[heights addObject:[NSNumber numberWithFloat:rowHeight]];
+		totalHeight += rowHeight;
+	}
+	
+	[levelCache storePrefetchedObjectIDs:operation->objectIDs names:operation->names heights:heights
+							forParentKey:operation->parentID];
+}
+
+- (void)cancelOperationForParentKey:(id)parentKey
+{
+	LevelPrefetchOperation *operation = [operationsByParentKey objectForKey:parentKey];
+	
+	operation->prefetcher = nil;
+	[operation cancel];
+	
+	[operationsByParentKey removeObjectForKey:parentKey];
+}
+
+- (void)cancelAllPrefetches
+{
+	for (id parentKey in [operationsByParentKey allKeys]) {
+		[self cancelOperationForParentKey:parentKey];
+	}
+}
+
+- (void)dealloc
+{
+	[self cancelAllPrefetches];
+	
+	[levelCache release];
+	[managedObjectContext release];
+	[queue release];
+	[operationsByParentKey release];
+	[super dealloc];
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+//  OutlineTree.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#include "OutlineTreeCore.h"
+
+@class OutlineTree;
+
+@protocol OutlineTreeDataSource <NSObject>
+// Asked the first time an item is expanded, the children are remembered afterwards
+- (NSArray *)outlineTree:(OutlineTree *)outlineTree childrenOfItem:(id)item;
+@end
+
+// The rows of a flattened outline, kept in an implicit treap (see OutlineTreeCore.h): finding the
+// item of a row is O(log n), and so are collapsing and expanding an item however many descendants
+// it has. Items are retained for as long as they have a row, visible or hidden.
+@interface OutlineTree : NSObject {
+	OutlineRows rows;
+	id <OutlineTreeDataSource> dataSource;
+}
+
+@property (nonatomic, assign) id <OutlineTreeDataSource> dataSource;
+@property (nonatomic, readonly) NSUInteger count;
+
+// Replaces all rows with the given items, collapsed at the top level
+- (void)setRootItems:(NSArray *)items;
+
+- (id)itemAtIndex:(NSUInteger)index;
+- (NSUInteger)depthAtIndex:(NSUInteger)index;
+- (BOOL)isExpandedAtIndex:(NSUInteger)index;
+
+// Both return the number of rows inserted or removed right after index
+- (NSUInteger)expandItemAtIndex:(NSUInteger)index;
+- (NSUInteger)collapseItemAtIndex:(NSUInteger)index;
+
+@end
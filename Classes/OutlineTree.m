@@ -0,0 +1,103 @@
+//
+//  OutlineTree.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "OutlineTree.h"
+#include <stdlib.h>
+
+
+static void OutlineTreeRetainItem(void *info, const void *item)
+{
+	[(id)item retain];
+}
+
+static void OutlineTreeReleaseItem(void *info, const void *item)
+{
+	[(id)item release];
+}
+
+
+@implementation OutlineTree
+
+@synthesize dataSource;
+
+- (id)init
+{
+	if ((self = [super init])) {
+		OutlineRowsInit(&rows, arc4random(), OutlineTreeRetainItem, OutlineTreeReleaseItem, NULL);
+	}
+	
+	return self;
+}
+
+- (NSUInteger)count
+{
+	return OutlineRowsCount(&rows);
+}
+
+- (void)setRootItems:(NSArray *)items
+{
+	OutlineRowsRemoveAll(&rows);
+	
+	for (id item in items) {
+		OutlineRowsAppendItem(&rows, item);
+	}
+}
+
+- (id)itemAtIndex:(NSUInteger)index
+{
+	return (id)OutlineRowsItemAtIndex(&rows, index);
+}
+
+- (NSUInteger)depthAtIndex:(NSUInteger)index
+{
+	return OutlineRowsDepthAtIndex(&rows, index);
+}
+
+- (BOOL)isExpandedAtIndex:(NSUInteger)index
+{
+	return OutlineRowsIsExpandedAtIndex(&rows, index) ? YES : NO;
+}
+
+- (NSUInteger)expandItemAtIndex:(NSUInteger)index
+{
+	if (index >= OutlineRowsCount(&rows)) {
+		return 0;
+	}
+	
+	if (!OutlineRowsNeedsChildrenAtIndex(&rows, index)) {
+		return OutlineRowsExpandItemAtIndex(&rows, index, NULL, 0);
+	}
+	
+	NSArray *children = [dataSource outlineTree:self childrenOfItem:[self itemAtIndex:index]];
+	NSUInteger childCount = [children count];
+	id *childItems = malloc(childCount * sizeof(id));
+	
+	if (childItems == NULL) {
+		childCount = 0;
+	} else {
+		[children getObjects:childItems];
+	}
+	
+	NSUInteger count = OutlineRowsExpandItemAtIndex(&rows, index, (const void * const *)childItems, childCount);
+	free(childItems);
+	
+	return count;
+}
+
+- (NSUInteger)collapseItemAtIndex:(NSUInteger)index
+{
+	return OutlineRowsCollapseItemAtIndex(&rows, index);
+}
+
+- (void)dealloc
+{
+	OutlineRowsDestroy(&rows);
+	[super dealloc];
+}
+
+@end
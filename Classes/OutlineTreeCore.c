@@ -0,0 +1,295 @@
+//
+//  OutlineTreeCore.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "OutlineTreeCore.h"
+
+#include <stdlib.h>
+
+
+struct OutlineNode {
+	OutlineNode *left;
+	OutlineNode *right;
+	uint32_t priority;
+	
+	// Rows in this subtree, and the smallest depth among them
+	size_t size;
+	size_t minDepth;
+	
+	const void *item;
+	size_t depth;
+	int expanded;
+	
+	// The rows below a collapsed item, as they were when it was collapsed
+	OutlineNode *hidden;
+};
+
+
+static inline size_t OutlineNodeSize(const OutlineNode *node)
+{
+	return node ? node->size : 0;
+}
+
+static void OutlineNodeUpdate(OutlineNode *node)
+{
+	node->size = 1 + OutlineNodeSize(node->left) + OutlineNodeSize(node->right);
+	node->minDepth = node->depth;
+	
+	if (node->left && node->left->minDepth < node->minDepth) {
+		node->minDepth = node->left->minDepth;
+	}
+	if (node->right && node->right->minDepth < node->minDepth) {
+		node->minDepth = node->right->minDepth;
+	}
+}
+
+// xorshift32, the priorities only need to be spread out
+static uint32_t OutlineRowsNextPriority(OutlineRows *rows)
+{
+	uint32_t x = rows->seed;
+	
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rows->seed = x;
+	
+	return x;
+}
+
+static OutlineNode *OutlineNodeCreate(OutlineRows *rows, const void *item, size_t depth)
+{
+	OutlineNode *node = calloc(1, sizeof(OutlineNode));
+	
+	if (node == NULL) {
+		return NULL;
+	}
+	
+	node->priority = OutlineRowsNextPriority(rows);
+	node->item = item;
+	node->depth = depth;
+	OutlineNodeUpdate(node);
+	
+	if (rows->retainItem) {
+		rows->retainItem(rows->info, item);
+	}
+	
+	return node;
+}
+
+static void OutlineNodeFree(OutlineRows *rows, OutlineNode *node)
+{
+	if (node == NULL) {
+		return;
+	}
+	
+	OutlineNodeFree(rows, node->left);
+	OutlineNodeFree(rows, node->right);
+	OutlineNodeFree(rows, node->hidden);
+	
+	if (rows->releaseItem) {
+		rows->releaseItem(rows->info, node->item);
+	}
+	free(node);
+}
+
+// Appends the rows of b after the rows of a
+static OutlineNode *OutlineNodeMerge(OutlineNode *a, OutlineNode *b)
+{
+	if (a == NULL) {
+		return b;
+	}
+	if (b == NULL) {
+		return a;
+	}
+	
+	if (a->priority > b->priority) {
+		a->right = OutlineNodeMerge(a->right, b);
+		OutlineNodeUpdate(a);
+		return a;
+	}
+	
+	b->left = OutlineNodeMerge(a, b->left);
+	OutlineNodeUpdate(b);
+	return b;
+}
+
+// Splits the rows of node into the first count rows and the rest
+static void OutlineNodeSplit(OutlineNode *node, size_t count, OutlineNode **first, OutlineNode **rest)
+{
+	if (node == NULL) {
+		*first = NULL;
+		*rest = NULL;
+		return;
+	}
+	
+	size_t leftSize = OutlineNodeSize(node->left);
+	
+	if (count <= leftSize) {
+		OutlineNodeSplit(node->left, count, first, &node->left);
+		OutlineNodeUpdate(node);
+		*rest = node;
+	} else {
+		OutlineNodeSplit(node->right, count - leftSize - 1, &node->right, rest);
+		OutlineNodeUpdate(node);
+		*first = node;
+	}
+}
+
+static OutlineNode *OutlineNodeAtIndex(OutlineNode *node, size_t index)
+{
+	while (node) {
+		size_t leftSize = OutlineNodeSize(node->left);
+		
+		if (index < leftSize) {
+			node = node->left;
+		} else if (index == leftSize) {
+			return node;
+		} else {
+			index -= leftSize + 1;
+			node = node->right;
+		}
+	}
+	
+	return NULL;
+}
+
+// Counts the leading rows that are deeper than depth, i.e. the descendants of an item at that
+// depth when node holds the rows following it. minDepth leads straight to the first row that
+// isn't one.
+static size_t OutlineNodeDeeperPrefixCount(OutlineNode *node, size_t depth)
+{
+	size_t count = 0;
+	
+	while (node) {
+		if (node->left && node->left->minDepth <= depth) {
+			node = node->left;
+		} else if (node->depth <= depth) {
+			return count + OutlineNodeSize(node->left);
+		} else {
+			count += OutlineNodeSize(node->left) + 1;
+			node = node->right;
+		}
+	}
+	
+	return count;
+}
+
+
+void OutlineRowsInit(OutlineRows *rows, uint32_t seed,
+					 void (*retainItem)(void *info, const void *item),
+					 void (*releaseItem)(void *info, const void *item), void *info)
+{
+	rows->root = NULL;
+	rows->seed = seed ? seed : 1;  // xorshift never leaves 0
+	rows->retainItem = retainItem;
+	rows->releaseItem = releaseItem;
+	rows->info = info;
+}
+
+void OutlineRowsDestroy(OutlineRows *rows)
+{
+	OutlineRowsRemoveAll(rows);
+}
+
+void OutlineRowsRemoveAll(OutlineRows *rows)
+{
+	OutlineNodeFree(rows, rows->root);
+	rows->root = NULL;
+}
+
+int OutlineRowsAppendItem(OutlineRows *rows, const void *item)
+{
+	OutlineNode *node = OutlineNodeCreate(rows, item, 0);
+	
+	if (node == NULL) {
+		return 0;
+	}
+	
+	rows->root = OutlineNodeMerge(rows->root, node);
+	
+	return 1;
+}
+
+size_t OutlineRowsCount(const OutlineRows *rows)
+{
+	return OutlineNodeSize(rows->root);
+}
+
+const void *OutlineRowsItemAtIndex(const OutlineRows *rows, size_t index)
+{
+	return OutlineNodeAtIndex(rows->root, index)->item;
+}
+
+size_t OutlineRowsDepthAtIndex(const OutlineRows *rows, size_t index)
+{
+	return OutlineNodeAtIndex(rows->root, index)->depth;
+}
+
+int OutlineRowsIsExpandedAtIndex(const OutlineRows *rows, size_t index)
+{
+	return OutlineNodeAtIndex(rows->root, index)->expanded;
+}
+
+int OutlineRowsNeedsChildrenAtIndex(const OutlineRows *rows, size_t index)
+{
+	OutlineNode *node = OutlineNodeAtIndex(rows->root, index);
+	
+	return node && !node->expanded && node->hidden == NULL;
+}
+
+size_t OutlineRowsExpandItemAtIndex(OutlineRows *rows, size_t index, const void * const *children, size_t childCount)
+{
+	OutlineNode *node = OutlineNodeAtIndex(rows->root, index);
+	
+	if (node == NULL || node->expanded) {
+		return 0;
+	}
+	
+	OutlineNode *descendants = node->hidden;
+	
+	if (descendants == NULL) {
+		for (size_t i = 0; i < childCount; i++) {
+			OutlineNode *child = OutlineNodeCreate(rows, children[i], node->depth + 1);
+			if (child) {
+				descendants = OutlineNodeMerge(descendants, child);
+			}
+		}
+	}
+	
+	size_t count = OutlineNodeSize(descendants);
+	
+	node->hidden = NULL;
+	node->expanded = 1;
+	
+	OutlineNode *first, *rest;
+	OutlineNodeSplit(rows->root, index + 1, &first, &rest);
+	rows->root = OutlineNodeMerge(OutlineNodeMerge(first, descendants), rest);
+	
+	return count;
+}
+
+size_t OutlineRowsCollapseItemAtIndex(OutlineRows *rows, size_t index)
+{
+	OutlineNode *node = OutlineNodeAtIndex(rows->root, index);
+	
+	if (node == NULL || !node->expanded) {
+		return 0;
+	}
+	
+	OutlineNode *first, *descendants, *rest;
+	OutlineNodeSplit(rows->root, index + 1, &first, &rest);
+	
+	size_t count = OutlineNodeDeeperPrefixCount(rest, node->depth);
+	OutlineNodeSplit(rest, count, &descendants, &rest);
+	
+	node->hidden = descendants;
+	node->expanded = 0;
+	
+	rows->root = OutlineNodeMerge(first, rest);
+	
+	return count;
+}
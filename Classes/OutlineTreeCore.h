@@ -0,0 +1,64 @@
+//
+//  OutlineTreeCore.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef OUTLINE_TREE_CORE_H
+#define OUTLINE_TREE_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The parts of OutlineTree that don't need Foundation, so that they can be tested on their own
+// (see Tests/OutlineTreeTests.c).
+
+typedef struct OutlineNode OutlineNode;
+
+// The rows of a flattened outline, kept in an implicit treap: every node knows the size of its
+// subtree, so finding the item of a row is O(log n). Collapsing an item cuts its visible
+// descendants out of the treap as one piece and hangs them off the item, and expanding it splices
+// them back in, both O(log n) however many descendants there are.
+//
+// Items are opaque to the rows. retainItem is called once for every row an item is put in and
+// releaseItem once for every row that goes away, hidden rows included; either may be NULL.
+typedef struct {
+	OutlineNode *root;
+	uint32_t seed;
+
+	void (*retainItem)(void *info, const void *item);
+	void (*releaseItem)(void *info, const void *item);
+	void *info;
+} OutlineRows;
+
+// seed picks the treap's priorities, any value will do
+void OutlineRowsInit(OutlineRows *rows, uint32_t seed,
+					 void (*retainItem)(void *info, const void *item),
+					 void (*releaseItem)(void *info, const void *item), void *info);
+void OutlineRowsDestroy(OutlineRows *rows);
+
+void OutlineRowsRemoveAll(OutlineRows *rows);
+
+// Adds a collapsed row at the top level after the last row. Returns 0 if there isn't enough memory.
+int OutlineRowsAppendItem(OutlineRows *rows, const void *item);
+
+size_t OutlineRowsCount(const OutlineRows *rows);
+
+// index has to be less than the count
+const void *OutlineRowsItemAtIndex(const OutlineRows *rows, size_t index);
+size_t OutlineRowsDepthAtIndex(const OutlineRows *rows, size_t index);
+int OutlineRowsIsExpandedAtIndex(const OutlineRows *rows, size_t index);
+
+// Whether expanding the item at index needs its children, which is the case the first time it's
+// expanded. After that the rows below it are kept while it's collapsed, as they were.
+int OutlineRowsNeedsChildrenAtIndex(const OutlineRows *rows, size_t index);
+
+// Both return the number of rows inserted or removed right after index, and do nothing if the
+// item is already expanded or collapsed. children are only used when the item needs them, and
+// any that there isn't enough memory for are left out.
+size_t OutlineRowsExpandItemAtIndex(OutlineRows *rows, size_t index, const void * const *children, size_t childCount);
+size_t OutlineRowsCollapseItemAtIndex(OutlineRows *rows, size_t index);
+
+#endif
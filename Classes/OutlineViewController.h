@@ -0,0 +1,29 @@
+//
+//  OutlineViewController.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+#import <CoreData/CoreData.h>
+#import "OutlineTree.h"
+
+// Shows the whole board as one flattened outline, where tapping an idea expands or collapses
+// its children in place.
+@interface OutlineViewController : UITableViewController <OutlineTreeDataSource> {
+	OutlineTree *outlineTree;
+
+	// Expanded ideas, so the outline can be rebuilt the same way after the board changes
+	NSMutableSet *expandedIdeas;
+
+@private
+	NSManagedObjectContext *managedObjectContext_;
+}
+
+@property (nonatomic, retain) NSManagedObjectContext *managedObjectContext;
+
+- (void)reloadOutline;
+
+@end
@@ -0,0 +1,231 @@
+//
+//  OutlineViewController.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "OutlineViewController.h"
+#import "Idea.h"
+#import "ApplicationHelper.h"
+
+
+// Expanding or collapsing more rows than this reloads the table instead of animating each row
+static const NSUInteger kMaxAnimatedRowChanges = 100;
+
+
+@interface OutlineViewController ()
+- (NSArray *)topLevelIdeas;
+- (NSArray *)indexPathsForRowsAfterIndex:(NSUInteger)index count:(NSUInteger)count;
+- (void)objectsDidChange:(NSNotification *)notification;
+@end
+
+
+@implementation OutlineViewController
+
+@synthesize managedObjectContext=managedObjectContext_;
+
+
+#pragma mark -
+#pragma mark View lifecycle
+
+- (void)viewDidLoad {
+	[super viewDidLoad];
+	
+	self.navigationItem.title = @"Outline";
+	
+	self.tableView.backgroundColor = [UIColor clearColor];
+	self.tableView.separatorStyle = UITableViewCellSeparatorStyleNone;
+	
+	// Single line rows, so that reloading doesn't need to measure every row of the outline
+	self.tableView.rowHeight = 44;
+	
+	outlineTree = [[OutlineTree alloc] init];
+	outlineTree.dataSource = self;
+	expandedIdeas = [[NSMutableSet alloc] init];
+	
+	[self reloadOutline];
+	
+	[[NSNotificationCenter defaultCenter] addObserver:self
+											 selector:@selector(objectsDidChange:)
+												 name:NSManagedObjectContextObjectsDidChangeNotification
+											   object:self.managedObjectContext];
+}
+
+- (void)viewWillAppear:(BOOL)animated {
+	[super viewWillAppear:animated];
+	
+	[self.navigationController setToolbarHidden:YES animated:YES];
+}
+
+- (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)interfaceOrientation {
+	return YES;
+}
+
+
+#pragma mark -
+#pragma mark Helper methods
+
+// Rebuilding only expands the ideas that are visible, the others are expanded when reached
+- (void)reloadOutline
+{
+	[outlineTree setRootItems:[self topLevelIdeas]];
+	
+	for (NSUInteger i = 0; i < outlineTree.count; i++) {
+		if ([expandedIdeas containsObject:[outlineTree itemAtIndex:i]]) {
+			[outlineTree expandItemAtIndex:i];
+		}
+	}
+	
+	[self.tableView reloadData];
+}
+
+- (NSArray *)topLevelIdeas
+{
+	NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
+	[fetchRequest setEntity:[NSEntityDescription entityForName:@"Idea" inManagedObjectContext:self.managedObjectContext]];
+	[fetchRequest setPredicate:[NSPredicate predicateWithFormat:@"parent == %@", [NSNull null]]];
+	
+	NSSortDescriptor *sortDescriptor = [[NSSortDescriptor alloc] initWithKey:@"timeStamp" ascending:YES];
+	[fetchRequest setSortDescriptors:[NSArray arrayWithObject:sortDescriptor]];
+	[sortDescriptor release];
+	
+	NSError *error = nil;
+	NSArray *ideas = [self.managedObjectContext executeFetchRequest:fetchRequest error:&error];
+	[fetchRequest release];
+	
+	if (ideas == nil) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		[ApplicationHelper showApplicationError];
+	}
+	
+	return ideas;
+}
+
+- (NSArray *)indexPathsForRowsAfterIndex:(NSUInteger)index count:(NSUInteger)count
+{
+	NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:count];
+	
+	for (NSUInteger i = 1; i <= count; i++) {
+		[indexPaths addObject:[NSIndexPath indexPathForRow:index + i inSection:0]];
+	}
+	
+	return indexPaths;
+}
+
+- (void)objectsDidChange:(NSNotification *)notification
+{
+	for (Idea *idea in [[notification userInfo] objectForKey:NSDeletedObjectsKey]) {
+		[expandedIdeas removeObject:idea];
+	}
+	
+	[self reloadOutline];
+}
+
+
+#pragma mark -
+#pragma mark OutlineTreeDataSource methods
+
+- (NSArray *)outlineTree:(OutlineTree *)tree childrenOfItem:(id)item
+{
+	return [(Idea *)item orderedChildren];
+}
+
+
+#pragma mark -
+#pragma mark Table view data source
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
+	return outlineTree.count;
+}
+
+- (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
+
+	static NSString *CellIdentifier = @"OutlineCell";
+	
+	UITableViewCell *cell = [tableView dequeueReusableCellWithIdentifier:CellIdentifier];
+	
+	if (cell == nil) {
+		cell = [[[UITableViewCell alloc] initWithStyle:UITableViewCellStyleValue1 reuseIdentifier:CellIdentifier] autorelease];
+		cell.textLabel.font = [UIFont fontWithName:@"Helvetica" size:17.0];
+		cell.indentationWidth = 20;
+	}
+	
+	NSDictionary *theme = [ApplicationHelper theme];
+	
+	Idea *idea = [outlineTree itemAtIndex:indexPath.row];
+	NSUInteger childCount = [idea.children count];
+	
+	cell.textLabel.text = [idea valueForKey:@"name"];
+	cell.indentationLevel = [outlineTree depthAtIndex:indexPath.row];
+	cell.backgroundColor = [UIColor colorWithPatternImage:[UIImage imageNamed:[theme objectForKey:@"foreground"]]];
+	
+	if (childCount > 0) {
+		cell.detailTextLabel.text = [NSString stringWithFormat:@"%d", childCount];
+		cell.accessoryType = [outlineTree isExpandedAtIndex:indexPath.row] ? UITableViewCellAccessoryNone : UITableViewCellAccessoryDisclosureIndicator;
+	} else {
+		cell.detailTextLabel.text = nil;
+		cell.accessoryType = UITableViewCellAccessoryNone;
+	}
+	
+	return cell;
+}
+
+
+#pragma mark -
+#pragma mark Table view delegate
+
+- (void)tableView:(UITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath
+{
+	[tableView deselectRowAtIndexPath:indexPath animated:YES];
+	
+	NSUInteger row = indexPath.row;
+	Idea *idea = [outlineTree itemAtIndex:row];
+	BOOL expanding = ![outlineTree isExpandedAtIndex:row];
+	NSUInteger count;
+	
+	if (expanding) {
+		count = [outlineTree expandItemAtIndex:row];
+		[expandedIdeas addObject:idea];
+	} else {
+		count = [outlineTree collapseItemAtIndex:row];
+		[expandedIdeas removeObject:idea];
+	}
+	
+	if (count > kMaxAnimatedRowChanges) {
+		[tableView reloadData];
+		return;
+	}
+	
+	NSArray *indexPaths = [self indexPathsForRowsAfterIndex:row count:count];
+	
+	[tableView beginUpdates];
+	
+	if (expanding) {
+		[tableView insertRowsAtIndexPaths:indexPaths withRowAnimation:UITableViewRowAnimationTop];
+	} else {
+		[tableView deleteRowsAtIndexPaths:indexPaths withRowAnimation:UITableViewRowAnimationTop];
+	}
+	
+	[tableView reloadRowsAtIndexPaths:[NSArray arrayWithObject:indexPath] withRowAnimation:UITableViewRowAnimationNone];
+	
+	[tableView endUpdates];
+}
+
+
+#pragma mark -
+#pragma mark Memory management
+
+- (void)dealloc {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	
+	[outlineTree release];
+	[expandedIdeas release];
+	[managedObjectContext_ release];
+	[super dealloc];
+}
+
+
+@end
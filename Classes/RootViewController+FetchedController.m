@@ -8,6 +8,7 @@
 
 #import "RootViewController+FetchedController.h"
 #import "ApplicationHelper.h"
+#import "FetchedChangeBatch.h"
 
 @implementation RootViewController (FetchedController)
 
@@ -54,7 +55,7 @@
     // Edit the section name key path and cache name if appropriate.
     // nil for section name key path means "no sections".
 	
-	// For now I'm setting cacheName to nil as I don't think it will impact performances
+	// No cacheName: levels that were already shown are served by the LevelCache without fetching at all
     NSFetchedResultsController *aFetchedResultsController = [[NSFetchedResultsController alloc] 
 															 initWithFetchRequest:fetchRequest 
 															 managedObjectContext:self.managedObjectContext 
@@ -85,22 +86,28 @@
 
 
 - (void)controllerWillChangeContent:(NSFetchedResultsController *)controller {
-    [self.tableView beginUpdates];
+	if (userDrivenChange) {
+		return;
+	}
+	
+	// Changes are only collected here and applied as one batch in controllerDidChangeContent:
+	if (pendingChanges == nil) {
+		pendingChanges = [[FetchedChangeBatch alloc] init];
+	}
+	
+	// The batch is measured again against the new rows
+	[self forgetRowHeights];
 }
 
 
 - (void)controller:(NSFetchedResultsController *)controller didChangeSection:(id <NSFetchedResultsSectionInfo>)sectionInfo
            atIndex:(NSUInteger)sectionIndex forChangeType:(NSFetchedResultsChangeType)type {
 	
-    switch(type) {
-        case NSFetchedResultsChangeInsert:
-            [self.tableView insertSections:[NSIndexSet indexSetWithIndex:sectionIndex] withRowAnimation:UITableViewRowAnimationFade];
-            break;
-            
-        case NSFetchedResultsChangeDelete:
-            [self.tableView deleteSections:[NSIndexSet indexSetWithIndex:sectionIndex] withRowAnimation:UITableViewRowAnimationFade];
-            break;
-    }
+	if (userDrivenChange) {
+		return;
+	}
+	
+	[pendingChanges addSectionChange:type atIndex:sectionIndex];
 }
 
 
@@ -108,33 +115,45 @@
        atIndexPath:(NSIndexPath *)indexPath forChangeType:(NSFetchedResultsChangeType)type
       newIndexPath:(NSIndexPath *)newIndexPath {
 	
-    UITableView *tableView = self.tableView;
-    
-    switch(type) {
-            
-        case NSFetchedResultsChangeInsert:
-            [tableView insertRowsAtIndexPaths:[NSArray arrayWithObject:newIndexPath] withRowAnimation:UITableViewRowAnimationFade];
-            break;
-            
-        case NSFetchedResultsChangeDelete:
-            [tableView deleteRowsAtIndexPaths:[NSArray arrayWithObject:indexPath] withRowAnimation:UITableViewRowAnimationFade];
-			[self updateTitle]; // reload title after deletion
-            break;
-            
-        case NSFetchedResultsChangeUpdate:
-            [self configureCell:[tableView cellForRowAtIndexPath:indexPath] atIndexPath:indexPath];
-            break;
-            
-        case NSFetchedResultsChangeMove:
-            [tableView deleteRowsAtIndexPaths:[NSArray arrayWithObject:indexPath] withRowAnimation:UITableViewRowAnimationFade];
-            [tableView insertRowsAtIndexPaths:[NSArray arrayWithObject:newIndexPath]withRowAnimation:UITableViewRowAnimationFade];
-            break;
-    }
+	if (userDrivenChange) {
+		return;
+	}
+	
+	[pendingChanges addObjectChange:anObject type:type atIndexPath:indexPath newIndexPath:newIndexPath];
 }
 
 
 - (void)controllerDidChangeContent:(NSFetchedResultsController *)controller {
-    [self.tableView endUpdates];
+	// The table view already shows the moved row, only the snapshot needs to follow
+	if (userDrivenChange) {
+		[self takeRowSnapshot];
+		return;
+	}
+	
+	if ([pendingChanges isEmpty]) {
+		[pendingChanges reset];
+		return;
+	}
+	
+	BOOL countChanged = [pendingChanges changesRowCount];
+	
+	NSArray *updatedObjects = [pendingChanges applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationFade];
+	[pendingChanges reset];
+	
+	for (id object in updatedObjects) {
+		NSIndexPath *indexPath = [controller indexPathForObject:object];
+		UITableViewCell *cell = [self.tableView cellForRowAtIndexPath:indexPath];
+		
+		if (cell) {
+			[self configureCell:cell atIndexPath:indexPath];
+		}
+	}
+	
+	[self takeRowSnapshot];
+	
+	if (countChanged) {
+		[self updateTitle]; // reload title once for the whole batch
+	}
 }
 
 
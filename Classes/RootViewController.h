@@ -11,26 +11,58 @@
 #import "IdeaDetailViewController.h"
 
 @class MailComposerViewController;
+@class FetchedChangeBatch;
+@class LevelCache;
+@class LevelPrefetcher;
+@class IdeaOperationLog;
+@class IdeaDumpOperation;
 @class Idea;
 
 @interface RootViewController : UITableViewController <NSFetchedResultsControllerDelegate, UITextFieldDelegate, UIActionSheetDelegate, IdeaDetailDelegate> {	
 	Idea *selectedIdea;
 	MailComposerViewController *mailComposerViewController;
+	LevelCache *levelCache;
+	LevelPrefetcher *levelPrefetcher;
+	IdeaOperationLog *operationLog;
+	IdeaDumpOperation *mailDumpOperation;
 
 @private
     NSFetchedResultsController *fetchedResultsController_;
     NSManagedObjectContext *managedObjectContext_;
+	
+	// Rows as last shown by the table view, used to diff against the fetched objects. Until the
+	// fetched results controller is created, these are the rows of the level cache.
+	NSArray *displayedRows;
+	NSArray *displayedNames;
+	
+	// Heights of the first rows, in the order the table view measured them
+	NSMutableArray *displayedHeights;
+	CGFloat scrollOffsetToRestore;
+	
+	FetchedChangeBatch *pendingChanges;
+	
+	// Set while the table view already shows a change the user made by moving a row
+	BOOL userDrivenChange;
 }
 
 @property (nonatomic, retain) NSManagedObjectContext *managedObjectContext;
 @property (nonatomic, retain) NSFetchedResultsController *fetchedResultsController;
 
 @property (nonatomic, retain) Idea *selectedIdea;
+@property (nonatomic, retain) LevelCache *levelCache;
+@property (nonatomic, retain) IdeaOperationLog *operationLog;
 
 
 - (void)showDeleteConfirmation:(id)sender;
 - (void)deleteCurrentObject;
+- (void)showUndoOptions;
+- (BOOL)moveIdea:(Idea *)idea toParent:(Idea *)newParent;
 - (void)updateTitle;
 - (void)reloadTheme;
+- (void)loadRows;
+- (void)takeRowSnapshot;
+- (void)forgetRowHeights;
+- (void)applyRowChanges;
+- (void)reloadBoard;
 
 @end
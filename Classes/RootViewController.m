@@ -9,19 +9,45 @@
 #import "RootViewController.h"
 #import "IdeaDetailViewController.h"
 #import "SettingsViewController.h"
+#import "OutlineViewController.h"
 #import "MailComposerViewController.h"
 #import "Idea.h"
 #import "ApplicationHelper.h"
+#import "RowDiff.h"
+#import "FetchedChangeBatch.h"
+#import "LevelCache.h"
+#import "LevelPrefetcher.h"
+#import "IdeaOperationLog.h"
+#import "IdeaSnapshot.h"
 #import "FlurryAPI.h"
 
 
+enum {
+	kDeleteActionSheetTag = 1,
+	kUndoActionSheetTag
+};
+
+
 @interface RootViewController ()
 - (void)configureCell:(UITableViewCell *)cell atIndexPath:(NSIndexPath *)indexPath;
+- (BOOL)showsCachedRows;
+- (NSUInteger)rowCount;
+- (Idea *)ideaAtIndexPath:(NSIndexPath *)indexPath;
+- (NSString *)nameAtIndexPath:(NSIndexPath *)indexPath;
+- (void)levelCacheDidInvalidate:(NSNotification *)notification;
+- (void)reloadRowsFromStore;
+- (void)prefetchVisibleLevels;
 - (void)editCurrentObject:(id)sender;
+- (void)moveCurrentObjectUp:(id)sender;
 - (void)showDetailView:(Idea *)aObject newIdea:(BOOL)newIdea;
 - (void)showMailView;
+- (void)mailDumpDidFinish:(NSString *)dump;
+- (void)cancelMailDump;
 - (void)showSettingsView;
+- (void)showOutlineView;
+- (void)popDeletedLevels;
 - (void)configureTheme;
+- (void)reconfigureVisibleCells;
 - (void)configureNavigationBar;
 - (void)configureToolbar;
 @end
@@ -32,6 +58,8 @@
 @synthesize fetchedResultsController=fetchedResultsController_, managedObjectContext=managedObjectContext_;
 
 @synthesize selectedIdea;
+@synthesize levelCache;
+@synthesize operationLog;
 
 
 #pragma mark -
@@ -41,8 +69,13 @@
 - (void)viewDidLoad {
     [super viewDidLoad];
 	
+	[self loadRows];
 	[self updateTitle];
 	
+	if (levelCache && levelPrefetcher == nil) {
+		levelPrefetcher = [[LevelPrefetcher alloc] initWithLevelCache:levelCache managedObjectContext:self.managedObjectContext];
+	}
+	
 	if (mailComposerViewController == nil) {
 		mailComposerViewController = [[MailComposerViewController alloc] init];
 	}
@@ -66,10 +99,41 @@
 - (void)viewWillAppear:(BOOL)animated {
     [super viewWillAppear:animated];
 
-	if (selectedIdea) {
-		[self.navigationController setToolbarHidden:NO animated:NO];
-	} else {
-		[self.navigationController setToolbarHidden:YES animated:YES];
+	[self.navigationController setToolbarHidden:NO animated:NO];
+	
+	// Rows are loaded by now, so the offset the level was left at can be clamped to them
+	if (scrollOffsetToRestore > 0) {
+		CGFloat maxOffset = MAX(self.tableView.contentSize.height - self.tableView.bounds.size.height, 0);
+		self.tableView.contentOffset = CGPointMake(0, MIN(scrollOffsetToRestore, maxOffset));
+		scrollOffsetToRestore = 0;
+	}
+}
+
+- (void)viewWillDisappear:(BOOL)animated {
+	[super viewWillDisappear:animated];
+	
+	[levelCache storeHeights:displayedHeights scrollOffset:self.tableView.contentOffset.y forParent:selectedIdea];
+	
+	[self resignFirstResponder];
+	[self cancelMailDump];
+}
+
+- (void)viewDidAppear:(BOOL)animated {
+	[super viewDidAppear:animated];
+	
+	[self prefetchVisibleLevels];
+	
+	// Shaking the device offers to undo or redo the last edit
+	[self becomeFirstResponder];
+}
+
+- (BOOL)canBecomeFirstResponder {
+	return YES;
+}
+
+- (void)motionEnded:(UIEventSubtype)motion withEvent:(UIEvent *)event {
+	if (motion == UIEventSubtypeMotionShake) {
+		[self showUndoOptions];
 	}
 }
 
@@ -92,8 +156,8 @@
 {
 	
 	NSString *countText;
-	if ([[self.fetchedResultsController fetchedObjects] count] > 0) {
-		countText = [NSString stringWithFormat:@" (%d)", [[self.fetchedResultsController fetchedObjects] count]];
+	if ([self rowCount] > 0) {
+		countText = [NSString stringWithFormat:@" (%d)", [self rowCount]];
 	} else {
 		countText = @"";
 	}
@@ -126,17 +190,169 @@
 	
 	self.navigationController.view.backgroundColor = [UIColor colorWithPatternImage:[UIImage imageNamed:[theme objectForKey:@"background"]]];
 		
-	// This should be done only when the theme changed
+	// A theme only changes colors, so there's no need to reload rows or measure them again
+	[self reconfigureVisibleCells];
+}
+
+- (void)reconfigureVisibleCells
+{
+	for (NSIndexPath *indexPath in [self.tableView indexPathsForVisibleRows]) {
+		[self configureCell:[self.tableView cellForRowAtIndexPath:indexPath] atIndexPath:indexPath];
+	}
+}
+
+// A level that was shown before is taken from the level cache, and the fetched results
+// controller is only created once something under it changes.
+- (void)loadRows
+{
+	NSArray *rows = nil;
+	NSArray *names = nil;
+	NSArray *heights = nil;
+	
+	if (fetchedResultsController_ == nil && [levelCache getRows:&rows names:&names heights:&heights forParent:selectedIdea]) {
+		[displayedRows release];
+		displayedRows = [rows copy];
+		
+		[displayedNames release];
+		displayedNames = [names copy];
+		
+		[displayedHeights release];
+		displayedHeights = [[NSMutableArray alloc] initWithArray:heights];
+		
+		[[NSNotificationCenter defaultCenter] addObserver:self 
+												 selector:@selector(levelCacheDidInvalidate:) 
+													 name:LevelCacheDidInvalidateNotification 
+												   object:levelCache];
+	} else {
+		[self takeRowSnapshot];
+	}
+	
+	scrollOffsetToRestore = [levelCache scrollOffsetForParent:selectedIdea];
+}
+
+- (void)takeRowSnapshot
+{
+	NSArray *rows = [self.fetchedResultsController fetchedObjects];
+	
+	[displayedRows release];
+	displayedRows = [rows copy];
+	
+	[displayedNames release];
+	displayedNames = [[rows valueForKey:@"name"] copy];
+	
+	[self forgetRowHeights];
+	
+	[levelCache storeRows:displayedRows names:displayedNames forParent:selectedIdea];
+}
+
+// Heights are kept by row index, so they're dropped whenever rows may have moved
+- (void)forgetRowHeights
+{
+	[displayedHeights release];
+	displayedHeights = [[NSMutableArray alloc] init];
+}
+
+- (void)levelCacheDidInvalidate:(NSNotification *)notification
+{
+	NSSet *parentKeys = [[notification userInfo] objectForKey:LevelCacheInvalidatedParentsKey];
+	
+	if (![parentKeys containsObject:[LevelCache keyForParent:selectedIdea]]) {
+		return;
+	}
+	
+	[[NSNotificationCenter defaultCenter] removeObserver:self name:LevelCacheDidInvalidateNotification object:levelCache];
+	
+	// The context is still in the middle of processing its changes, fetch once it's done
+	[self performSelector:@selector(reloadRowsFromStore) withObject:nil afterDelay:0];
+}
+
+// Everything fetched before is dropped, for when the store was swapped under the context
+- (void)reloadBoard
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self name:LevelCacheDidInvalidateNotification object:levelCache];
+	[levelPrefetcher cancelAllPrefetches];
+	
+	fetchedResultsController_.delegate = nil;
+	self.fetchedResultsController = nil;
+	
+	[pendingChanges reset];
+	
+	[self takeRowSnapshot];
 	[self.tableView reloadData];
+	[self updateTitle];
+}
+
+- (void)reloadRowsFromStore
+{
+	[self applyRowChanges];
+	[self updateTitle];
+}
+
+- (void)prefetchVisibleLevels
+{
+	NSArray *indexPaths = [self.tableView indexPathsForVisibleRows];
+	NSMutableArray *ideas = [NSMutableArray arrayWithCapacity:[indexPaths count]];
+	
+	for (NSIndexPath *indexPath in indexPaths) {
+		[ideas addObject:[self ideaAtIndexPath:indexPath]];
+	}
+	
+	[levelPrefetcher prefetchChildrenOfIdeas:ideas measuringRowsInHeight:self.tableView.bounds.size.height];
+}
+
+- (BOOL)showsCachedRows
+{
+	return fetchedResultsController_ == nil && displayedRows != nil;
+}
+
+- (NSUInteger)rowCount
+{
+	if ([self showsCachedRows]) {
+		return [displayedRows count];
+	}
+	
+	return [[self.fetchedResultsController fetchedObjects] count];
+}
+
+- (Idea *)ideaAtIndexPath:(NSIndexPath *)indexPath
+{
+	if ([self showsCachedRows]) {
+		return [displayedRows objectAtIndex:indexPath.row];
+	}
+	
+	return [self.fetchedResultsController objectAtIndexPath:indexPath];
+}
+
+// Cached rows come with their names, so showing them doesn't fire their faults
+- (NSString *)nameAtIndexPath:(NSIndexPath *)indexPath
+{
+	if ([self showsCachedRows]) {
+		id name = [displayedNames objectAtIndex:indexPath.row];
+		return name == [NSNull null] ? nil : name;
+	}
+	
+	return [[self.fetchedResultsController objectAtIndexPath:indexPath] valueForKey:@"name"];
+}
+
+// Brings the table view in sync with the fetched objects by animating only the rows that
+// were inserted, deleted, moved or renamed since the last snapshot.
+- (void)applyRowChanges
+{
+	NSArray *rows = [self.fetchedResultsController fetchedObjects];
+	
+	RowDiff *diff = [RowDiff diffFromKeys:displayedRows values:displayedNames 
+								   toKeys:rows values:[rows valueForKey:@"name"] 
+								inSection:0];
+	
+	[self takeRowSnapshot];
+	[diff applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationFade];
 }
 
 - (void)configureCell:(UITableViewCell *)cell atIndexPath:(NSIndexPath *)indexPath {
     
 	NSDictionary *theme = [ApplicationHelper theme];
 	
-    Idea *idea = [self.fetchedResultsController objectAtIndexPath:indexPath];
-
-	cell.textLabel.text = [idea valueForKey:@"name"];
+	cell.textLabel.text = [self nameAtIndexPath:indexPath];
 	cell.textLabel.font = [UIFont fontWithName:@"Helvetica" size:17.0];
 	
 	cell.accessoryType = UIButtonTypeRoundedRect;
@@ -162,12 +378,60 @@
 								  cancelButtonTitle:@"Cancel" 
 								  destructiveButtonTitle:@"Confirm" 
 								  otherButtonTitles:nil];
+	actionSheet.tag = kDeleteActionSheetTag;
 	
 	[actionSheet showFromToolbar:self.navigationController.toolbar];
 	
 	[actionSheet release];
 }
 
+- (void)showUndoOptions
+{
+	NSString *undoActionName = [operationLog undoActionName];
+	NSString *redoActionName = [operationLog redoActionName];
+	
+	if (undoActionName == nil && redoActionName == nil) {
+		return;
+	}
+	
+	UIActionSheet *actionSheet = [[UIActionSheet alloc]
+								  initWithTitle:nil 
+								  delegate:self 
+								  cancelButtonTitle:nil 
+								  destructiveButtonTitle:nil 
+								  otherButtonTitles:nil];
+	actionSheet.tag = kUndoActionSheetTag;
+	
+	if (undoActionName) {
+		[actionSheet addButtonWithTitle:undoActionName];
+	}
+	if (redoActionName) {
+		[actionSheet addButtonWithTitle:redoActionName];
+	}
+	
+	actionSheet.cancelButtonIndex = [actionSheet addButtonWithTitle:@"Cancel"];
+	
+	[actionSheet showFromToolbar:self.navigationController.toolbar];
+	
+	[actionSheet release];
+}
+
+// Undoing can delete the ideas that levels further up the navigation stack are showing, in
+// which case those levels are popped
+- (void)popDeletedLevels
+{
+	NSArray *viewControllers = self.navigationController.viewControllers;
+	
+	for (NSUInteger i = 1; i < [viewControllers count]; i++) {
+		RootViewController *controller = [viewControllers objectAtIndex:i];
+		
+		if ([controller isKindOfClass:[RootViewController class]] && controller.selectedIdea.managedObjectContext == nil) {
+			[self.navigationController popToViewController:[viewControllers objectAtIndex:i - 1] animated:YES];
+			return;
+		}
+	}
+}
+
 - (void)editCurrentObject:(id)sender
 {
 	[self showDetailView:selectedIdea newIdea:FALSE];
@@ -179,6 +443,7 @@
 	detailViewController.idea = aObject;
 	detailViewController.delegate = self;
 	detailViewController.newIdea = newIdea;
+	detailViewController.operationLog = operationLog;
 	
 	UINavigationController *navigationController = [[UINavigationController alloc] initWithRootViewController:detailViewController];
 	
@@ -188,20 +453,64 @@
 	[navigationController release];
 }
 
+// The subtree is dumped on the reader queue from a snapshot of the store, so a big one doesn't
+// hold up the main thread
 - (void)showMailView
 {
+	if (mailDumpOperation) {
+		return;
+	}
+	
+	// The snapshot only sees what's saved
+	NSError *error = nil;
+	if ([self.managedObjectContext hasChanges] && ![self.managedObjectContext save:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		[ApplicationHelper showApplicationError];
+		return;
+	}
+	
+	mailDumpOperation = [[IdeaDumpOperation alloc] initWithIdea:selectedIdea target:self action:@selector(mailDumpDidFinish:)];
+	[[IdeaSnapshot readerQueue] addOperation:mailDumpOperation];
+	
+	[UIApplication sharedApplication].networkActivityIndicatorVisible = YES;
+}
+
+- (void)mailDumpDidFinish:(NSString *)dump
+{
+	[self cancelMailDump];
+	
+	if (dump == nil) {
+		[ApplicationHelper showApplicationError];
+		return;
+	}
+	
 	mailComposerViewController.delegate = self;
 	mailComposerViewController.recipient = [ApplicationHelper recipient];
 	mailComposerViewController.subject = [selectedIdea subject];
-	mailComposerViewController.content = [selectedIdea dump];
+	mailComposerViewController.content = dump;
 	
 	[mailComposerViewController showPicker];
 }
 
+- (void)cancelMailDump
+{
+	if (mailDumpOperation == nil) {
+		return;
+	}
+	
+	[mailDumpOperation cancel];
+	[mailDumpOperation release];
+	mailDumpOperation = nil;
+	
+	[UIApplication sharedApplication].networkActivityIndicatorVisible = NO;
+}
+
 - (void)showSettingsView
 {
 	SettingsViewController *settingsViewController = [[SettingsViewController alloc] initWithNibName:@"SettingsViewController" bundle:nil];
 	settingsViewController.delegate = self;
+	settingsViewController.managedObjectContext = self.managedObjectContext;
 	
 	UINavigationController *navigationController = [[UINavigationController alloc] initWithRootViewController:settingsViewController];
 	
@@ -211,6 +520,16 @@
 	[navigationController release];
 }
 
+- (void)showOutlineView
+{
+	OutlineViewController *outlineViewController = [[OutlineViewController alloc] initWithStyle:UITableViewStylePlain];
+	outlineViewController.managedObjectContext = self.managedObjectContext;
+	
+	[self.navigationController pushViewController:outlineViewController animated:YES];
+	
+	[outlineViewController release];
+}
+
 - (void)configureNavigationBar
 {
 	UIBarButtonItem *addButton = [[UIBarButtonItem alloc] 
@@ -258,6 +577,12 @@
 									 style:UIBarButtonSystemItemReply
 									 target:self 
 									 action:@selector(showMailView)];
+		UIBarButtonItem *moveUpItem = [[UIBarButtonItem alloc] 
+									   initWithTitle:@"Move Up"
+									   style:UIBarButtonItemStyleBordered
+									   target:self 
+									   action:@selector(moveCurrentObjectUp:)];
+		moveUpItem.enabled = (selectedIdea.parent != nil);
 		
 		self.toolbarItems = [NSArray arrayWithObjects:
 							 flexibleSPace, 
@@ -267,14 +592,32 @@
 							 flexibleSPace, 
 							 deleteItem, 
 							 flexibleSPace, 
+							 moveUpItem,
+							 self.editButtonItem,
 							 nil];
 		
 		[flexibleSPace release];
 		[editItem release];
 		[mailItem release];
+		[moveUpItem release];
 		[deleteItem release];
 	} else {
-		self.navigationController.toolbarHidden = YES;
+		self.navigationController.toolbarHidden = NO;
+		
+		UIBarButtonItem *flexibleSPace = [[UIBarButtonItem alloc]
+										  initWithBarButtonSystemItem:UIBarButtonSystemItemFlexibleSpace 
+										  target:nil 
+										  action:nil];
+		UIBarButtonItem *outlineItem = [[UIBarButtonItem alloc] 
+										initWithTitle:@"Outline"
+										style:UIBarButtonItemStyleBordered
+										target:self 
+										action:@selector(showOutlineView)];
+		
+		self.toolbarItems = [NSArray arrayWithObjects:outlineItem, flexibleSPace, self.editButtonItem, nil];
+		
+		[flexibleSPace release];
+		[outlineItem release];
 	}
 }
 
@@ -290,14 +633,14 @@
 
 - (void)ideaDetailViewController:(IdeaDetailViewController *)ideaDetailViewController didSaveIdea:(Idea *)idea
 {
-	[self.tableView reloadData];
+	[self applyRowChanges];
 	[self updateTitle];
 	[self dismissModalViewControllerAnimated:YES];
 }
 
 - (void)ideaDetailViewControllerDidForceDelete:(IdeaDetailViewController *)ideaDetailViewController
 {
-	[self.tableView reloadData];
+	[self applyRowChanges];
 	[self updateTitle];
 	[self dismissModalViewControllerAnimated:YES];
 	
@@ -309,9 +652,32 @@
 
 - (void)actionSheet:(UIActionSheet *)actionSheet clickedButtonAtIndex:(NSInteger)buttonIndex
 {
-	if (buttonIndex == 0) {
-		[self deleteCurrentObject];
+	if (actionSheet.tag == kDeleteActionSheetTag) {
+		if (buttonIndex == 0) {
+			[self deleteCurrentObject];
+		}
+		return;
 	}
+	
+	if (buttonIndex == actionSheet.cancelButtonIndex) {
+		return;
+	}
+	
+	BOOL undo = [[actionSheet buttonTitleAtIndex:buttonIndex] isEqualToString:[operationLog undoActionName]];
+	BOOL applied = undo ? [operationLog undo] : [operationLog redo];
+	
+	if (!applied) {
+		UIAlertView *alert = [[UIAlertView alloc] initWithTitle:undo ? @"Can't Undo" : @"Can't Redo" 
+														message:@"The entry was changed in the meantime." 
+													   delegate:nil 
+											  cancelButtonTitle:@"OK" 
+											  otherButtonTitles:nil];
+		[alert show];
+		[alert release];
+	}
+	
+	[self updateTitle];
+	[self popDeletedLevels];
 }
 
 
@@ -339,8 +705,9 @@
 - (void)deleteCurrentObject
 {
 	
-	NSManagedObjectContext *context = [self.fetchedResultsController managedObjectContext];
+	NSManagedObjectContext *context = self.managedObjectContext;
 	
+	[operationLog recordDeleteOfIdea:selectedIdea];
 	[context deleteObject:selectedIdea];
 	
 	NSError *error = nil;
@@ -353,6 +720,68 @@
 	[self.navigationController popViewControllerAnimated:YES];
 }
 
+// Moves an idea and its whole subtree to the end of another idea's children, or to the top
+// level if newParent is nil. Returns NO if newParent is inside the idea's subtree.
+- (BOOL)moveIdea:(Idea *)idea toParent:(Idea *)newParent
+{
+	// Appending only needs to know the last sibling
+	NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
+	[fetchRequest setEntity:[NSEntityDescription entityForName:@"Idea" inManagedObjectContext:self.managedObjectContext]];
+	[fetchRequest setPredicate:[NSPredicate predicateWithFormat:@"parent == %@", newParent ? (id)newParent : (id)[NSNull null]]];
+	[fetchRequest setFetchLimit:1];
+	
+	NSSortDescriptor *sortDescriptor = [[NSSortDescriptor alloc] initWithKey:@"timeStamp" ascending:NO];
+	[fetchRequest setSortDescriptors:[NSArray arrayWithObject:sortDescriptor]];
+	[sortDescriptor release];
+	
+	NSError *error = nil;
+	NSArray *lastSibling = [self.managedObjectContext executeFetchRequest:fetchRequest error:&error];
+	[fetchRequest release];
+	
+	if (lastSibling == nil) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		[ApplicationHelper showApplicationError];
+		return NO;
+	}
+	
+	Idea *oldParent = idea.parent;
+	NSArray *oldSiblings = [Idea orderedChildrenOfParent:oldParent inManagedObjectContext:self.managedObjectContext];
+	NSUInteger oldIndex = oldSiblings ? [oldSiblings indexOfObject:idea] : NSNotFound;
+	
+	if (![idea moveToParent:newParent atIndex:[lastSibling count] amongSiblings:lastSibling]) {
+		return NO;
+	}
+	
+	if (![self.managedObjectContext save:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		[ApplicationHelper showApplicationError];
+		return NO;
+	}
+	
+	[operationLog recordMoveOfIdea:idea fromParent:oldParent index:oldIndex];
+	
+	return YES;
+}
+
+- (void)moveCurrentObjectUp:(id)sender
+{
+	Idea *parent = selectedIdea.parent;
+	
+	if (parent == nil || ![self moveIdea:selectedIdea toParent:parent.parent]) {
+		return;
+	}
+	
+	// Show the idea where it ended up, one level above the one it was listed in
+	NSArray *viewControllers = self.navigationController.viewControllers;
+	NSUInteger index = [viewControllers indexOfObject:self];
+	
+	if (index != NSNotFound && index >= 2) {
+		[self.navigationController popToViewController:[viewControllers objectAtIndex:index - 2] animated:YES];
+	}
+}
+
 - (void)setEditing:(BOOL)editing animated:(BOOL)animated {
 
     // Prevent new objects being added when in editing mode.
@@ -370,7 +799,7 @@
 
 
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
-	return [[self.fetchedResultsController fetchedObjects] count];
+	return [self rowCount];
 }
 
 
@@ -397,8 +826,11 @@
     
     if (editingStyle == UITableViewCellEditingStyleDelete) {
         // Delete the managed object for the given index path
-        NSManagedObjectContext *context = [self.fetchedResultsController managedObjectContext];
-        [context deleteObject:[self.fetchedResultsController objectAtIndexPath:indexPath]];
+        NSManagedObjectContext *context = self.managedObjectContext;
+        Idea *idea = [self ideaAtIndexPath:indexPath];
+        
+        [operationLog recordDeleteOfIdea:idea];
+        [context deleteObject:idea];
         
         // Save the context.
         NSError *error = nil;
@@ -412,20 +844,89 @@
 
 
 - (BOOL)tableView:(UITableView *)tableView canMoveRowAtIndexPath:(NSIndexPath *)indexPath {
-    // The table view should not be re-orderable.
-    return NO;
+    return YES;
+}
+
+// Only the moved idea gets a new order key, see -[Idea moveToParent:atIndex:amongSiblings:]
+- (void)tableView:(UITableView *)tableView moveRowAtIndexPath:(NSIndexPath *)fromIndexPath toIndexPath:(NSIndexPath *)toIndexPath {
+	if (fromIndexPath.row == toIndexPath.row) {
+		return;
+	}
+	
+	NSMutableArray *rows = [NSMutableArray arrayWithArray:[self showsCachedRows] ? displayedRows : [self.fetchedResultsController fetchedObjects]];
+	Idea *idea = [[rows objectAtIndex:fromIndexPath.row] retain];
+	
+	[idea moveToParent:selectedIdea atIndex:toIndexPath.row amongSiblings:rows];
+	
+	// The table view already shows the row at its new place
+	[rows removeObjectAtIndex:fromIndexPath.row];
+	[rows insertObject:idea atIndex:toIndexPath.row];
+	[idea release];
+	
+	[displayedRows release];
+	displayedRows = [rows copy];
+	
+	[displayedNames release];
+	displayedNames = [[rows valueForKey:@"name"] copy];
+	
+	[self forgetRowHeights];
+	
+	userDrivenChange = YES;
+	
+	NSError *error = nil;
+	if (![self.managedObjectContext save:&error]) {
+		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		
+		[ApplicationHelper showApplicationError];
+	} else {
+		[operationLog recordMoveOfIdea:idea fromParent:selectedIdea index:fromIndexPath.row];
+	}
+	
+	userDrivenChange = NO;
 }
 
 - (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath
 {
-	Idea *idea = [self.fetchedResultsController objectAtIndexPath:indexPath];
-	NSString *cellText = [idea valueForKey:@"name"];
+	if (indexPath.row < [displayedHeights count]) {
+		return [[displayedHeights objectAtIndex:indexPath.row] floatValue];
+	}
 	
-	UIFont *cellFont = [UIFont fontWithName:@"Helvetica" size:17.0];
-    CGSize constraintSize = CGSizeMake(280.0f, MAXFLOAT);
-    CGSize labelSize = [cellText sizeWithFont:cellFont constrainedToSize:constraintSize lineBreakMode:UILineBreakModeWordWrap];
+	CGFloat height = [ApplicationHelper rowHeightForText:[self nameAtIndexPath:indexPath]];
 	
-    return labelSize.height + 25;
+	// The table view measures rows in order, so only the first rows are ever recorded
+	if (indexPath.row == [displayedHeights count]) {
+		[displayedHeights addObject:[NSNumber numberWithFloat:height]];
+	}
+	
+	return height;
+}
+
+#pragma mark -
+#pragma mark Scroll view delegate
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView
+{
+	[levelPrefetcher trackScrollView:scrollView];
+	
+	if ([levelPrefetcher isScrollingFast]) {
+		[levelPrefetcher cancelAllPrefetches];
+	} else {
+		[self prefetchVisibleLevels];
+	}
+}
+
+- (void)scrollViewDidEndDragging:(UIScrollView *)scrollView willDecelerate:(BOOL)decelerate
+{
+	if (!decelerate) {
+		[levelPrefetcher trackScrollView:scrollView];
+		[self prefetchVisibleLevels];
+	}
+}
+
+- (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView
+{
+	[levelPrefetcher trackScrollView:scrollView];
+	[self prefetchVisibleLevels];
 }
 
 #pragma mark -
@@ -435,8 +936,10 @@
 {	
 	RootViewController *rootViewController = [[RootViewController alloc] initWithNibName:@"RootViewController" bundle:nil];
 	rootViewController.managedObjectContext = self.managedObjectContext;
+	rootViewController.levelCache = self.levelCache;
+	rootViewController.operationLog = self.operationLog;
 	
-	Idea *idea = [self.fetchedResultsController objectAtIndexPath:indexPath];
+	Idea *idea = [self ideaAtIndexPath:indexPath];
 	rootViewController.selectedIdea = idea;
 	
 	[self.navigationController pushViewController:rootViewController animated:YES];
@@ -462,9 +965,19 @@
 
 
 - (void)dealloc {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[self cancelMailDump];
+	
     [fetchedResultsController_ release];
     [managedObjectContext_ release];
 	[selectedIdea release];
+	[levelCache release];
+	[levelPrefetcher release];
+	[operationLog release];
+	[displayedRows release];
+	[displayedNames release];
+	[displayedHeights release];
+	[pendingChanges release];
     [super dealloc];
 }
 
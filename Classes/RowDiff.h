@@ -0,0 +1,35 @@
+//
+//  RowDiff.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/20/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// Computes the minimal set of row changes needed to turn one list of rows into another.
+// Rows are matched by a stable key (any object with pointer or value equality, e.g. an
+// NSManagedObject) and compared by a content value to detect updates.
+@interface RowDiff : NSObject {
+	NSMutableArray *deletedIndexPaths;
+	NSMutableArray *insertedIndexPaths;
+	NSMutableArray *updatedIndexPaths;
+	NSMutableArray *movedFromIndexPaths;
+	NSMutableArray *movedToIndexPaths;
+}
+
+@property (nonatomic, readonly) NSArray *deletedIndexPaths;
+@property (nonatomic, readonly) NSArray *insertedIndexPaths;
+@property (nonatomic, readonly) NSArray *updatedIndexPaths;
+@property (nonatomic, readonly) NSArray *movedFromIndexPaths;
+@property (nonatomic, readonly) NSArray *movedToIndexPaths;
+
++ (RowDiff *)diffFromKeys:(NSArray *)oldKeys values:(NSArray *)oldValues 
+				   toKeys:(NSArray *)newKeys values:(NSArray *)newValues 
+				inSection:(NSInteger)section;
+
+- (BOOL)hasChanges;
+- (void)applyToTableView:(UITableView *)tableView withRowAnimation:(UITableViewRowAnimation)animation;
+
+@end
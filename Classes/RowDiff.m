@@ -0,0 +1,169 @@
+//
+//  RowDiff.m
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/20/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#import "RowDiff.h"
+#include "RowDiffCore.h"
+
+
+@interface RowDiff ()
+- (void)computeFromKeys:(NSArray *)oldKeys values:(NSArray *)oldValues 
+				 toKeys:(NSArray *)newKeys values:(NSArray *)newValues 
+			  inSection:(NSInteger)section;
+@end
+
+
+@implementation RowDiff
+
+@synthesize deletedIndexPaths, insertedIndexPaths, updatedIndexPaths, movedFromIndexPaths, movedToIndexPaths;
+
++ (RowDiff *)diffFromKeys:(NSArray *)oldKeys values:(NSArray *)oldValues 
+				   toKeys:(NSArray *)newKeys values:(NSArray *)newValues 
+				inSection:(NSInteger)section
+{
+	RowDiff *diff = [[[RowDiff alloc] init] autorelease];
+	[diff computeFromKeys:oldKeys values:oldValues toKeys:newKeys values:newValues inSection:section];
+	
+	return diff;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		deletedIndexPaths = [[NSMutableArray alloc] init];
+		insertedIndexPaths = [[NSMutableArray alloc] init];
+		updatedIndexPaths = [[NSMutableArray alloc] init];
+		movedFromIndexPaths = [[NSMutableArray alloc] init];
+		movedToIndexPaths = [[NSMutableArray alloc] init];
+	}
+	
+	return self;
+}
+
+// Contents of the rows being diffed, for RowDiffValuesDiffer
+typedef struct {
+	NSArray *oldValues;
+	NSArray *newValues;
+} RowDiffValues;
+
+static int RowDiffValuesDiffer(void *info, size_t oldIndex, size_t newIndex)
+{
+	RowDiffValues *values = info;
+	
+	return ![[values->oldValues objectAtIndex:oldIndex] isEqual:[values->newValues objectAtIndex:newIndex]];
+}
+
+// Keys become ids for RowDiffCompute, which does the matching (see RowDiffCore.h)
+- (void)computeFromKeys:(NSArray *)oldKeys values:(NSArray *)oldValues 
+				 toKeys:(NSArray *)newKeys values:(NSArray *)newValues 
+			  inSection:(NSInteger)section
+{
+	NSUInteger oldCount = [oldKeys count];
+	NSUInteger newCount = [newKeys count];
+	
+	// Keys are not required to support NSCopying, so use a CFDictionary that only retains them
+	CFMutableDictionaryRef ids = CFDictionaryCreateMutable(NULL, oldCount + newCount, &kCFTypeDictionaryKeyCallBacks, NULL);
+	uintptr_t *oldIds = malloc((oldCount + 1) * sizeof(uintptr_t));
+	uintptr_t *newIds = malloc((newCount + 1) * sizeof(uintptr_t));
+	uintptr_t nextID = 1;
+	
+	for (NSUInteger j = 0; j < newCount + oldCount; j++) {
+		id key = j < newCount ? [newKeys objectAtIndex:j] : [oldKeys objectAtIndex:j - newCount];
+		uintptr_t keyID = (uintptr_t)CFDictionaryGetValue(ids, key);
+		
+		if (keyID == 0) {
+			keyID = nextID++;
+			CFDictionarySetValue(ids, key, (const void *)keyID);
+		}
+		
+		if (j < newCount) {
+			newIds[j] = keyID;
+		} else {
+			oldIds[j - newCount] = keyID;
+		}
+	}
+	
+	CFRelease(ids);
+	
+	RowDiffValues values = { oldValues, newValues };
+	RowDiffChanges changes;
+	
+	if (RowDiffCompute(oldIds, oldCount, newIds, newCount, RowDiffValuesDiffer, &values, &changes)) {
+		for (size_t k = 0; k < changes.deletedCount; k++) {
+			[deletedIndexPaths addObject:[NSIndexPath indexPathForRow:changes.deleted[k] inSection:section]];
+		}
+		for (size_t k = 0; k < changes.insertedCount; k++) {
+			[insertedIndexPaths addObject:[NSIndexPath indexPathForRow:changes.inserted[k] inSection:section]];
+		}
+		for (size_t k = 0; k < changes.updatedCount; k++) {
+			[updatedIndexPaths addObject:[NSIndexPath indexPathForRow:changes.updated[k] inSection:section]];
+		}
+		for (size_t k = 0; k < changes.movedCount; k++) {
+			[movedFromIndexPaths addObject:[NSIndexPath indexPathForRow:changes.movedFrom[k] inSection:section]];
+			[movedToIndexPaths addObject:[NSIndexPath indexPathForRow:changes.movedTo[k] inSection:section]];
+		}
+		
+		RowDiffChangesFree(&changes);
+	} else {
+		// Still a valid batch, just not a minimal one
+		for (NSUInteger i = 0; i < oldCount; i++) {
+			[deletedIndexPaths addObject:[NSIndexPath indexPathForRow:i inSection:section]];
+		}
+		for (NSUInteger j = 0; j < newCount; j++) {
+			[insertedIndexPaths addObject:[NSIndexPath indexPathForRow:j inSection:section]];
+		}
+	}
+	
+	free(oldIds);
+	free(newIds);
+}
+
+- (BOOL)hasChanges
+{
+	return [deletedIndexPaths count] > 0 || [insertedIndexPaths count] > 0 || 
+		[updatedIndexPaths count] > 0 || [movedFromIndexPaths count] > 0;
+}
+
+- (void)applyToTableView:(UITableView *)tableView withRowAnimation:(UITableViewRowAnimation)animation
+{
+	if (![self hasChanges]) {
+		return;
+	}
+	
+	// moveRowAtIndexPath:toIndexPath: is only available from iOS 5
+	BOOL canMove = [tableView respondsToSelector:@selector(moveRowAtIndexPath:toIndexPath:)];
+	
+	[tableView beginUpdates];
+	
+	[tableView deleteRowsAtIndexPaths:deletedIndexPaths withRowAnimation:animation];
+	[tableView insertRowsAtIndexPaths:insertedIndexPaths withRowAnimation:animation];
+	[tableView reloadRowsAtIndexPaths:updatedIndexPaths withRowAnimation:UITableViewRowAnimationNone];
+	
+	if (canMove) {
+		for (NSUInteger i = 0; i < [movedFromIndexPaths count]; i++) {
+			[tableView moveRowAtIndexPath:[movedFromIndexPaths objectAtIndex:i] 
+							  toIndexPath:[movedToIndexPaths objectAtIndex:i]];
+		}
+	} else {
+		[tableView deleteRowsAtIndexPaths:movedFromIndexPaths withRowAnimation:animation];
+		[tableView insertRowsAtIndexPaths:movedToIndexPaths withRowAnimation:animation];
+	}
+	
+	[tableView endUpdates];
+}
+
+- (void)dealloc
+{
+	[deletedIndexPaths release];
+	[insertedIndexPaths release];
+	[updatedIndexPaths release];
+	[movedFromIndexPaths release];
+	[movedToIndexPaths release];
+	[super dealloc];
+}
+
+@end
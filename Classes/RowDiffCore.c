@@ -0,0 +1,164 @@
+//
+//  RowDiffCore.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/20/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#include "RowDiffCore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Open addressing, an index of 0 marks a free slot and the others are new indexes plus one
+typedef struct {
+	uintptr_t *ids;
+	size_t *indexes;
+	size_t mask;
+} RowDiffIndexTable;
+
+static size_t RowDiffIndexTableSlot(const RowDiffIndexTable *table, uintptr_t identifier)
+{
+	size_t slot = (size_t)(((unsigned long long)identifier * 0x9E3779B97F4A7C15ULL) >> 20) & table->mask;
+	
+	while (table->indexes[slot] != 0 && table->ids[slot] != identifier) {
+		slot = (slot + 1) & table->mask;
+	}
+	
+	return slot;
+}
+
+void RowDiffChangesFree(RowDiffChanges *changes)
+{
+	free(changes->deleted);
+	free(changes->inserted);
+	free(changes->updated);
+	free(changes->movedFrom);
+	free(changes->movedTo);
+	memset(changes, 0, sizeof(RowDiffChanges));
+}
+
+int RowDiffCompute(const uintptr_t *oldIds, size_t oldCount, const uintptr_t *newIds, size_t newCount,
+				   RowDiffValuesDifferFunction valuesDiffer, void *info, RowDiffChanges *changes)
+{
+	RowDiffIndexTable table;
+	size_t capacity = 16;
+	
+	while (capacity < 2 * newCount) {
+		capacity *= 2;
+	}
+	table.mask = capacity - 1;
+	table.ids = malloc(capacity * sizeof(uintptr_t));
+	table.indexes = calloc(capacity, sizeof(size_t));
+	
+	// Every row ends up in at most one of the lists, deleted and inserted ones in two
+	memset(changes, 0, sizeof(RowDiffChanges));
+	changes->deleted = malloc((oldCount + 1) * sizeof(size_t));
+	changes->inserted = malloc((newCount + 1) * sizeof(size_t));
+	changes->updated = malloc((oldCount + 1) * sizeof(size_t));
+	changes->movedFrom = malloc((oldCount + 1) * sizeof(size_t));
+	changes->movedTo = malloc((oldCount + 1) * sizeof(size_t));
+	
+	char *matchedNew = calloc(newCount + 1, 1);
+	size_t *pairOld = malloc((oldCount + 1) * sizeof(size_t));
+	size_t *pairNew = malloc((oldCount + 1) * sizeof(size_t));
+	size_t *tails = malloc((oldCount + 1) * sizeof(size_t));
+	size_t *previous = malloc((oldCount + 1) * sizeof(size_t));
+	char *stays = calloc(oldCount + 1, 1);
+	
+	int succeeded = table.ids && table.indexes && changes->deleted && changes->inserted && changes->updated &&
+					changes->movedFrom && changes->movedTo && matchedNew && pairOld && pairNew && tails && previous && stays;
+	
+	if (succeeded) {
+		// The last row with an id is the one old rows pair with
+		for (size_t j = 0; j < newCount; j++) {
+			size_t slot = RowDiffIndexTableSlot(&table, newIds[j]);
+			
+			table.ids[slot] = newIds[j];
+			table.indexes[slot] = j + 1;
+		}
+		
+		size_t pairs = 0;
+		
+		for (size_t i = 0; i < oldCount; i++) {
+			size_t j = table.indexes[RowDiffIndexTableSlot(&table, oldIds[i])];
+			
+			if (j == 0 || matchedNew[j - 1]) {
+				changes->deleted[changes->deletedCount++] = i;
+			} else {
+				matchedNew[j - 1] = 1;
+				pairOld[pairs] = i;
+				pairNew[pairs] = j - 1;
+				pairs++;
+			}
+		}
+		
+		for (size_t j = 0; j < newCount; j++) {
+			if (!matchedNew[j]) {
+				changes->inserted[changes->insertedCount++] = j;
+			}
+		}
+		
+		// Longest increasing subsequence of pairNew (patience sorting, O(p log p))
+		size_t length = 0;
+		
+		for (size_t p = 0; p < pairs; p++) {
+			size_t low = 0, high = length;
+			
+			while (low < high) {
+				size_t mid = (low + high) / 2;
+				
+				if (pairNew[tails[mid]] < pairNew[p]) {
+					low = mid + 1;
+				} else {
+					high = mid;
+				}
+			}
+			
+			previous[p] = low > 0 ? tails[low - 1] : (size_t)-1;
+			tails[low] = p;
+			if (low == length) {
+				length++;
+			}
+		}
+		
+		if (length > 0) {
+			for (size_t p = tails[length - 1]; p != (size_t)-1; p = previous[p]) {
+				stays[p] = 1;
+			}
+		}
+		
+		for (size_t p = 0; p < pairs; p++) {
+			int changed = valuesDiffer(info, pairOld[p], pairNew[p]);
+			
+			if (stays[p]) {
+				if (changed) {
+					// Reloads are expressed in terms of the old indexes
+					changes->updated[changes->updatedCount++] = pairOld[p];
+				}
+			} else if (changed) {
+				changes->deleted[changes->deletedCount++] = pairOld[p];
+				changes->inserted[changes->insertedCount++] = pairNew[p];
+			} else {
+				changes->movedFrom[changes->movedCount] = pairOld[p];
+				changes->movedTo[changes->movedCount] = pairNew[p];
+				changes->movedCount++;
+			}
+		}
+	} else {
+		RowDiffChangesFree(changes);
+	}
+	
+	free(table.ids);
+	free(table.indexes);
+	free(matchedNew);
+	free(pairOld);
+	free(pairNew);
+	free(tails);
+	free(previous);
+	free(stays);
+	
+	return succeeded;
+}
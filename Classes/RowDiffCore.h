@@ -0,0 +1,48 @@
+//
+//  RowDiffCore.h
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/20/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+#ifndef ROW_DIFF_CORE_H
+#define ROW_DIFF_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The matching of RowDiff over integer ids instead of objects, so that it can be tested on its
+// own (see Tests/RowDiffTests.c). RowDiff gives every distinct key an id of its own.
+
+// Indexes of the rows that changed. Deleted and updated rows are indexes in the old list,
+// inserted rows in the new one, moves go from an old index to a new one; the same as
+// -[UITableView beginUpdates] expects them.
+typedef struct {
+	size_t *deleted;
+	size_t deletedCount;
+	size_t *inserted;
+	size_t insertedCount;
+	size_t *updated;
+	size_t updatedCount;
+	size_t *movedFrom;
+	size_t *movedTo;
+	size_t movedCount;
+} RowDiffChanges;
+
+// Whether the contents of the old row at oldIndex differ from the new row at newIndex with the
+// same id, in which case it's reloaded
+typedef int (*RowDiffValuesDifferFunction)(void *info, size_t oldIndex, size_t newIndex);
+
+// Rows are paired by id through a hash table in one pass over each list; an id found more than
+// once is paired once, the other rows with it are deleted or inserted. Paired rows that keep
+// their relative order form the longest increasing subsequence of their new positions, every
+// other paired row is a move, which keeps moves minimal. A moved row whose contents changed is
+// deleted and inserted instead, since a row can't be moved and reloaded in the same batch.
+// Returns 0 if there isn't enough memory, with changes left empty.
+int RowDiffCompute(const uintptr_t *oldIds, size_t oldCount, const uintptr_t *newIds, size_t newCount,
+				   RowDiffValuesDifferFunction valuesDiffer, void *info, RowDiffChanges *changes);
+
+void RowDiffChangesFree(RowDiffChanges *changes);
+
+#endif
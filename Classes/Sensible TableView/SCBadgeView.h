@@ -34,6 +34,10 @@
 	UIColor *color;
 	NSString *text;
 	UIFont *font;
+	BOOL highlighted;
+	
+	CGSize textSize; //used internally
+	BOOL textSizeValid; //used internally
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -49,4 +53,27 @@
 /*! The font of the text. */
 @property (nonatomic, retain) UIFont *font;
 
+/*! Set to TRUE to render the badge in its highlighted (white) state. The owner cell sets this
+ *	property whenever it gets highlighted or selected. Default: FALSE. */
+@property (nonatomic, assign) BOOL highlighted;
+
+/*! The size of text when rendered with font. The size is measured once and cached until
+ *	either the text or the font changes. */
+@property (nonatomic, readonly) CGSize textSize;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @name Badge Image Cache
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/*! 
+ *	Returns a pre-rasterized badge image for the given parameters. Images are rendered once and
+ *	shared by all badge views, so that displaying a badge with a previously seen 
+ *	(text, font, color, size, highlighted) combination requires no drawing at all.
+ */
++ (UIImage *)badgeImageWithText:(NSString *)_text font:(UIFont *)_font color:(UIColor *)_color
+						   size:(CGSize)size highlighted:(BOOL)_highlighted;
+
+/*! Removes all cached badge images. Called automatically on memory warnings. */
++ (void)purgeBadgeImageCache;
+
 @end
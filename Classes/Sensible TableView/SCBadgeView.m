@@ -20,6 +20,22 @@
  */
 
 #import "SCBadgeView.h"
+#import <QuartzCore/QuartzCore.h>
+#import "SCGlobals.h"
+
+
+static NSMutableDictionary *badgeImageCache = nil;
+
+
+@interface SCBadgeView (PRIVATE)
+
++ (NSString *)cacheKeyForText:(NSString *)_text font:(UIFont *)_font color:(UIColor *)_color
+						 size:(CGSize)size highlighted:(BOOL)_highlighted;
++ (UIImage *)renderBadgeImageWithText:(NSString *)_text font:(UIFont *)_font color:(UIColor *)_color
+								 size:(CGSize)size highlighted:(BOOL)_highlighted;
+
+@end
+
 
 
 @implementation SCBadgeView
@@ -27,6 +43,92 @@
 @synthesize text;
 @synthesize font;
 @synthesize color;
+@synthesize highlighted;
+
++ (void)initialize
+{
+	if(self != [SCBadgeView class])
+		return;
+	
+	badgeImageCache = [[NSMutableDictionary alloc] init];
+	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(purgeBadgeImageCache)
+												 name:UIApplicationDidReceiveMemoryWarningNotification
+											   object:nil];
+}
+
++ (void)purgeBadgeImageCache
+{
+	[badgeImageCache removeAllObjects];
+}
+
++ (NSString *)cacheKeyForText:(NSString *)_text font:(UIFont *)_font color:(UIColor *)_color
+						 size:(CGSize)size highlighted:(BOOL)_highlighted
+{
+	// Highlighted badges are always white, so the color is not part of their key
+	NSString *colorKey = _highlighted ? @"-" : [_color description];
+	
+	return [NSString stringWithFormat:@"%@|%@|%.1f|%@|%.0fx%.0f|%i", 
+			_text, _font.fontName, _font.pointSize, colorKey, size.width, size.height, _highlighted];
+}
+
++ (UIImage *)renderBadgeImageWithText:(NSString *)_text font:(UIFont *)_font color:(UIColor *)_color
+								 size:(CGSize)size highlighted:(BOOL)_highlighted
+{
+	UIColor *badgeColor = _highlighted ? [UIColor whiteColor] : _color;
+	
+#ifdef __IPHONE_4_0
+	if(UIGraphicsBeginImageContextWithOptions != NULL)
+		UIGraphicsBeginImageContextWithOptions(size, NO, 0);
+	else
+#endif
+		UIGraphicsBeginImageContext(size);
+	
+	CGContextRef context = UIGraphicsGetCurrentContext();
+	CGContextSaveGState(context);
+	CGContextSetFillColorWithColor(context, [badgeColor CGColor]);
+	CGContextBeginPath(context);
+	CGFloat radius = size.height / 2.0;
+	CGContextAddArc(context, radius, radius, radius, M_PI/2 , 3*M_PI/2, NO);
+	CGContextAddArc(context, size.width - radius, radius, radius, 3*M_PI/2, M_PI/2, NO);
+	CGContextClosePath(context);
+	CGContextFillPath(context);
+	CGContextRestoreGState(context);
+	
+	CGContextSetBlendMode(context, kCGBlendModeClear);
+	
+	CGSize _textSize = [_text sizeWithFont:_font];
+	CGRect textBounds = CGRectMake(round((size.width-_textSize.width)/2), 
+								   round((size.height-_textSize.height)/2), 
+								   _textSize.width, _textSize.height);
+	[_text drawInRect:textBounds withFont:_font];
+	
+	UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+	UIGraphicsEndImageContext();
+	
+	return image;
+}
+
++ (UIImage *)badgeImageWithText:(NSString *)_text font:(UIFont *)_font color:(UIColor *)_color
+						   size:(CGSize)size highlighted:(BOOL)_highlighted
+{
+	if(!_text || size.width<=0 || size.height<=0)
+		return nil;
+	
+	NSString *key = [self cacheKeyForText:_text font:_font color:_color size:size highlighted:_highlighted];
+	UIImage *image = [badgeImageCache objectForKey:key];
+	if(!image)
+	{
+		image = [self renderBadgeImageWithText:_text font:_font color:_color size:size highlighted:_highlighted];
+		if(image)
+		{
+			if([badgeImageCache count] >= SC_DefaultBadgeImageCacheLimit)
+				[badgeImageCache removeAllObjects];
+			[badgeImageCache setObject:image forKey:key];
+		}
+	}
+	
+	return image;
+}
 
 - (id)initWithFrame:(CGRect)aRect
 {
@@ -35,6 +137,8 @@
 		text = nil;
 		font = [[UIFont boldSystemFontOfSize: 16] retain];
 		color = [[UIColor colorWithRed:140.0f/255 green:153.0f/255 blue:180.0f/255 alpha:1] retain];
+		highlighted = FALSE;
+		textSizeValid = FALSE;
 		
 		self.backgroundColor = [UIColor clearColor];
 	}
@@ -52,49 +156,39 @@
 }
 
 // overrides superclass
-- (void)drawRect:(CGRect)rect
+- (void)displayLayer:(CALayer *)layer
 {
-	if(!self.text)
-		return;
+	// The badge is never drawn through drawRect:, instead its layer is handed a shared
+	// pre-rasterized image so that scrolling through badged cells performs no CPU drawing.
+	UIImage *image = [SCBadgeView badgeImageWithText:self.text font:self.font color:self.color
+												size:self.bounds.size highlighted:self.highlighted];
+#ifdef __IPHONE_4_0
+	if(image && [layer respondsToSelector:@selector(setContentsScale:)])
+		layer.contentsScale = image.scale;
+#endif
+	layer.contents = (id)[image CGImage];
+}
+
+// overrides superclass
+- (void)layoutSubviews
+{
+	[super layoutSubviews];
 	
-	UIColor *badgeColor = self.color;
-	UIView *spview = self.superview;
-	while (spview)
+	[self setNeedsDisplay];
+}
+
+- (CGSize)textSize
+{
+	if(!textSizeValid)
 	{
-		if([spview isKindOfClass:[UITableViewCell class]])
-		{
-			UITableViewCell *ownerCell = (UITableViewCell *)spview;
-			
-			if(ownerCell.highlighted || ownerCell.selected)
-				badgeColor = [UIColor whiteColor];
-			
-			break;
-		}
-		
-		spview = spview.superview;
+		if(self.text)
+			textSize = [self.text sizeWithFont:self.font];
+		else
+			textSize = CGSizeMake(0, 0);
+		textSizeValid = TRUE;
 	}
 	
-	
-	CGContextRef context = UIGraphicsGetCurrentContext();
-	CGContextSaveGState(context);
-	CGContextSetFillColorWithColor(context, [badgeColor CGColor]);
-	CGContextBeginPath(context);
-	CGFloat radius = self.bounds.size.height / 2.0;
-	CGContextAddArc(context, radius, radius, radius, M_PI/2 , 3*M_PI/2, NO);
-	CGContextAddArc(context, self.bounds.size.width - radius, radius, radius, 3*M_PI/2, M_PI/2, NO);
-	CGContextClosePath(context);
-	CGContextFillPath(context);
-	CGContextRestoreGState(context);
-	
-	CGContextSetBlendMode(context, kCGBlendModeClear);
-	
-	CGSize textSize = CGSizeMake(0, 0);
-	if(self.text)
-		textSize = [self.text sizeWithFont:self.font];
-	CGRect textBounds = CGRectMake(round((self.bounds.size.width-textSize.width)/2), 
-								   round((self.bounds.size.height-textSize.height)/2), 
-								   textSize.width, textSize.height);
-	[self.text drawInRect:textBounds withFont:self.font];
+	return textSize;
 }
 
 - (void)setColor:(UIColor *)_color
@@ -107,8 +201,12 @@
 
 - (void)setText:(NSString *)_text
 {
+	if(text == _text || [text isEqualToString:_text])
+		return;
+	
 	[text release];
 	text = [_text copy];
+	textSizeValid = FALSE;
 	
 	[self setNeedsDisplay];
 }
@@ -117,6 +215,17 @@
 {
 	[font release];
 	font = [_font retain];
+	textSizeValid = FALSE;
+	
+	[self setNeedsDisplay];
+}
+
+- (void)setHighlighted:(BOOL)_highlighted
+{
+	if(highlighted == _highlighted)
+		return;
+	
+	highlighted = _highlighted;
 	
 	[self setNeedsDisplay];
 }
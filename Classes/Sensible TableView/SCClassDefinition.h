@@ -25,6 +25,7 @@
 
 
 @class SCTableViewCell;
+@class SCKeyPathAccessor;
 
 
 typedef enum
@@ -336,6 +337,11 @@ withObjectBindings:(NSDictionary *)bindings;
 	NSString *titlePropertyNameDelimiter;
 	NSString *descriptionPropertyName;
 	id uiElementDelegate;
+	
+	//internal
+	NSArray *titleAccessors;
+	SCKeyPathAccessor *descriptionAccessor;
+	NSMutableString *titleBuffer;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -654,6 +660,11 @@ withObjectBindings:(NSDictionary *)bindings;
  *	of the same class or entity defined in the class definition. */
 - (NSString *)titleValueForObject:(NSObject *)object;
 
+/*! Returns the value of the description property for the given object, as determined by 
+ *	the descriptionPropertyName property. Note: object must be an instance of the same class 
+ *	or entity defined in the class definition. */
+- (id)descriptionValueForObject:(NSObject *)object;
+
 @end
 
 
@@ -731,3 +742,22 @@ withObjectBindings:(NSDictionary *)bindings;
 
 
 
+/* This class is used internally by the framework. It resolves a key path compiled once into a 
+ * chain of getter selectors. Each step keeps the class it last saw together with the getter's IMP,
+ * so repeated lookups on objects of the same class call the getter directly. Steps without an 
+ * object-returning getter use valueForKey:. From the first collection operator (a key starting 
+ * with "@", such as @count or @sum.price) on, the rest of the path goes to valueForKeyPath:. */
+@interface SCKeyPathAccessor : NSObject
+{
+	NSArray *keys;
+	NSUInteger keyCount;
+	NSString *operatorKeyPath;
+	SEL *selectors;
+	Class *cachedClasses;
+	IMP *cachedImps;
+}
+
+- (id)initWithKeyPath:(NSString *)keyPath;
+- (id)valueForObject:(id)object;
+
+@end
@@ -23,6 +23,185 @@
 #import "SCGlobals.h"
 #import <objc/runtime.h>
 
+
+// Compact description of a declared property, parsed once from its runtime attribute string
+typedef struct
+{
+	BOOL exists;
+	BOOL objectType;		// declared as an NSObject descendant (T@"ClassName")
+	BOOL readOnly;
+	SCPropertyDataType dataType;
+} SCPropertyMetadata;
+
+static SCPropertyMetadata SCParsePropertyAttributes(const char *attributes)
+{
+	SCPropertyMetadata metadata = { TRUE, FALSE, FALSE, SCPropertyDataTypeOther };
+	
+	// The first attribute is the type encoding, e.g. T@"NSString",&,N,V_name
+	const char *typeEnd = strchr(attributes, ',');
+	size_t typeLength = typeEnd ? (size_t)(typeEnd - attributes) : strlen(attributes);
+	if(typeLength>3 && strncmp(attributes, "T@\"", 3)==0)
+	{
+		metadata.objectType = TRUE;
+		
+		const char *className = attributes + 3;
+		size_t classNameLength = typeLength - 4;  // without T@" and the closing quote
+		if(classNameLength==8 && strncmp(className, "NSString", 8)==0)
+			metadata.dataType = SCPropertyDataTypeNSString;
+		else
+			if(classNameLength==8 && strncmp(className, "NSNumber", 8)==0)
+				metadata.dataType = SCPropertyDataTypeNSNumber;
+			else
+				if(classNameLength==6 && strncmp(className, "NSDate", 6)==0)
+					metadata.dataType = SCPropertyDataTypeNSDate;
+				else
+					if(classNameLength==12 && strncmp(className, "NSMutableSet", 12)==0)
+						metadata.dataType = SCPropertyDataTypeNSMutableSet;
+					else
+						if(classNameLength==14 && strncmp(className, "NSMutableArray", 14)==0)
+							metadata.dataType = SCPropertyDataTypeNSMutableArray;
+	}
+	
+	for(const char *attribute = typeEnd; attribute; attribute = strchr(attribute+1, ','))
+	{
+		if(attribute[1]=='R' && (attribute[2]==',' || attribute[2]=='\0'))
+		{
+			metadata.readOnly = TRUE;
+			break;
+		}
+	}
+	
+	return metadata;
+}
+
+// Returns the metadata of the given property, using a global cache keyed by (Class, property name)
+static SCPropertyMetadata SCPropertyMetadataForProperty(Class cls, NSString *propertyName)
+{
+	static CFMutableDictionaryRef metadataByClass = NULL;
+	
+	SCPropertyMetadata metadata = { FALSE, FALSE, FALSE, SCPropertyDataTypeOther };
+	if(!cls || !propertyName)
+		return metadata;
+	
+	@synchronized([SCPropertyDefinition class])
+	{
+		if(!metadataByClass)
+			metadataByClass = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, 
+														&kCFTypeDictionaryValueCallBacks);
+		
+		NSMutableDictionary *classMetadata = (NSMutableDictionary *)CFDictionaryGetValue(metadataByClass, cls);
+		if(!classMetadata)
+		{
+			classMetadata = [[NSMutableDictionary alloc] init];
+			CFDictionarySetValue(metadataByClass, cls, classMetadata);
+			[classMetadata release];
+		}
+		
+		NSValue *metadataValue = [classMetadata objectForKey:propertyName];
+		if(metadataValue)
+		{
+			[metadataValue getValue:&metadata];
+		}
+		else
+		{
+			objc_property_t property = class_getProperty(cls, [propertyName UTF8String]);
+			if(property)
+				metadata = SCParsePropertyAttributes(property_getAttributes(property));
+			[classMetadata setObject:[NSValue valueWithBytes:&metadata objCType:@encode(SCPropertyMetadata)]
+							  forKey:propertyName];
+		}
+	}
+	
+	return metadata;
+}
+
+
+
+
+@implementation SCKeyPathAccessor
+
+- (id)initWithKeyPath:(NSString *)keyPath
+{
+	if( (self=[super init]) )
+	{
+		keys = [[keyPath componentsSeparatedByString:@"."] retain];
+		keyCount = keys.count;
+		
+		// Collection operators apply to the collection rather than to a getter, so only
+		// KVC can resolve them and whatever follows them
+		for(NSUInteger i=0; i<keys.count; i++)
+			if([[keys objectAtIndex:i] hasPrefix:@"@"])
+			{
+				NSRange operatorRange = NSMakeRange(i, keys.count-i);
+				operatorKeyPath = [[[keys subarrayWithRange:operatorRange] componentsJoinedByString:@"."] retain];
+				keyCount = i;
+				break;
+			}
+		
+		selectors = malloc(keyCount * sizeof(SEL));
+		cachedClasses = calloc(keyCount, sizeof(Class));
+		cachedImps = calloc(keyCount, sizeof(IMP));
+		
+		for(NSUInteger i=0; i<keyCount; i++)
+			selectors[i] = NSSelectorFromString([keys objectAtIndex:i]);
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{
+	[keys release];
+	[operatorKeyPath release];
+	free(selectors);
+	free(cachedClasses);
+	free(cachedImps);
+	
+	[super dealloc];
+}
+
+- (id)valueForObject:(id)object
+{
+	id value = object;
+	for(NSUInteger i=0; i<keyCount && value; i++)
+	{
+		Class valueClass = object_getClass(value);
+		if(valueClass != cachedClasses[i])
+		{
+			cachedClasses[i] = valueClass;
+			cachedImps[i] = NULL;
+			
+			// Only getters that return an object can be called directly, KVC boxes everything else.
+			// Dictionaries map keys to entries rather than methods, so they always go through KVC.
+			Method method = NULL;
+			if(![valueClass isSubclassOfClass:[NSDictionary class]])
+				method = class_getInstanceMethod(valueClass, selectors[i]);
+			if(method && method_getNumberOfArguments(method)==2)
+			{
+				char returnType[2];
+				method_getReturnType(method, returnType, sizeof(returnType));
+				if(returnType[0] == '@')
+					cachedImps[i] = method_getImplementation(method);
+			}
+		}
+		
+		if(cachedImps[i])
+			value = cachedImps[i](value, selectors[i]);
+		else
+			value = [value valueForKey:[keys objectAtIndex:i]];
+	}
+	
+	if(operatorKeyPath && value)
+		value = [value valueForKeyPath:operatorKeyPath];
+	
+	return value;
+}
+
+@end
+
+
+
+
 @implementation SCPropertyDefinition
 
 @synthesize dataType;
@@ -284,32 +463,7 @@ withObjectBindings:(NSDictionary *)bindings
 	else
 	{
 #endif
-		objc_property_t property = class_getProperty([object class], [propertyName UTF8String]);
-		if(!property)
-			return SCPropertyDataTypeOther;
-		NSArray *attributesArray = [[NSString stringWithUTF8String: property_getAttributes(property)] 
-									componentsSeparatedByString:@","];
-		NSSet *attributesSet = [NSSet setWithArray:attributesArray];
-		
-		if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-										  [NSString stringWithUTF8String:class_getName([NSString class])]]])
-			dataType = SCPropertyDataTypeNSString;
-		else
-			if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-											  [NSString stringWithUTF8String:class_getName([NSNumber class])]]])
-				dataType = SCPropertyDataTypeNSNumber;
-			else
-				if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-												  [NSString stringWithUTF8String:class_getName([NSDate class])]]])
-					dataType = SCPropertyDataTypeNSDate;
-				else
-					if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-													  [NSString stringWithUTF8String:class_getName([NSMutableSet class])]]])
-						dataType = SCPropertyDataTypeNSMutableSet;
-					else
-						if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-														  [NSString stringWithUTF8String:class_getName([NSMutableArray class])]]])
-							dataType = SCPropertyDataTypeNSMutableArray;
+		dataType = SCPropertyMetadataForProperty([object class], propertyName).dataType;
 #ifdef _COREDATADEFINES_H
 	}
 #endif
@@ -333,6 +487,9 @@ withObjectBindings:(NSDictionary *)bindings
 		titlePropertyNameDelimiter = @" ";
 		descriptionPropertyName = nil;
 		uiElementDelegate = nil;
+		titleAccessors = nil;
+		descriptionAccessor = nil;
+		titleBuffer = nil;
 	}
 	return self;
 }
@@ -564,6 +721,9 @@ withManagedObjectContext:(NSManagedObjectContext *)context
 	[titlePropertyName release];
 	[titlePropertyNameDelimiter release];
 	[descriptionPropertyName release];
+	[titleAccessors release];
+	[descriptionAccessor release];
+	[titleBuffer release];
 	
 	[super dealloc];
 }
@@ -656,34 +816,13 @@ withManagedObjectContext:(NSManagedObjectContext *)context
 		if(!coreDataDefinition)
 		{
 			// Set property's dataType & dataReadOnly properties
-			objc_property_t property = class_getProperty(self.cls, [propertyDefinition.name UTF8String]);
-			if(!property)
+			SCPropertyMetadata metadata = SCPropertyMetadataForProperty(self.cls, propertyDefinition.name);
+			if(!metadata.exists)
 				return FALSE;
-			NSArray *attributesArray = [[NSString stringWithUTF8String: property_getAttributes(property)] 
-										componentsSeparatedByString:@","];
-			NSSet *attributesSet = [NSSet setWithArray:attributesArray];
-			
-			propertyDefinition.dataReadOnly = [attributesSet containsObject:@"R"];
 			
-			if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-											  [NSString stringWithUTF8String:class_getName([NSString class])]]])
-				propertyDefinition.dataType = SCPropertyDataTypeNSString;
-			else
-				if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-												  [NSString stringWithUTF8String:class_getName([NSNumber class])]]])
-					propertyDefinition.dataType = SCPropertyDataTypeNSNumber;
-				else
-					if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-													  [NSString stringWithUTF8String:class_getName([NSDate class])]]])
-						propertyDefinition.dataType = SCPropertyDataTypeNSDate;
-					else
-						if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-														  [NSString stringWithUTF8String:class_getName([NSMutableSet class])]]])
-							propertyDefinition.dataType = SCPropertyDataTypeNSMutableSet;
-						else
-							if([attributesSet containsObject:[NSString stringWithFormat:@"T@\"%@\"", 
-															  [NSString stringWithUTF8String:class_getName([NSMutableArray class])]]])
-								propertyDefinition.dataType = SCPropertyDataTypeNSMutableArray;
+			propertyDefinition.dataReadOnly = metadata.readOnly;
+			if(metadata.dataType != SCPropertyDataTypeOther)
+				propertyDefinition.dataType = metadata.dataType;
 		}
 		
 		[propertyDefinitions insertObject:propertyDefinition atIndex:index];
@@ -742,20 +881,8 @@ withManagedObjectContext:(NSManagedObjectContext *)context
 	else
 	{
 #endif		
-		objc_property_t property = class_getProperty(self.cls, [propertyName UTF8String]);
-		
-		if(property)
-		{
-			// Property must be an NSObject decendant to be allowed
-			NSArray *attributesArray = [[NSString stringWithUTF8String: property_getAttributes(property)] 
-										componentsSeparatedByString:@","];
-			NSString *classAttribute = [attributesArray objectAtIndex:0];
-			NSRange classStringRange = [classAttribute rangeOfString:@"T@\""];
-			if(classStringRange.location != NSNotFound)
-			{
-				propertyValid = TRUE;
-			}
-		}
+		// Property must be an NSObject decendant to be allowed
+		propertyValid = SCPropertyMetadataForProperty(self.cls, propertyName).objectType;
 #ifdef _COREDATADEFINES_H		
 	}
 #endif	
@@ -763,55 +890,74 @@ withManagedObjectContext:(NSManagedObjectContext *)context
 	return propertyValid;
 }
 
+- (void)setTitlePropertyName:(NSString *)propertyName
+{
+	[titlePropertyName release];
+	titlePropertyName = [propertyName copy];
+	
+	[titleAccessors release];
+	titleAccessors = nil;
+}
+
+- (void)setDescriptionPropertyName:(NSString *)propertyName
+{
+	[descriptionPropertyName release];
+	descriptionPropertyName = [propertyName copy];
+	
+	[descriptionAccessor release];
+	descriptionAccessor = nil;
+}
+
 - (NSString *)titleValueForObject:(NSObject *)object
 {
 	if(!self.titlePropertyName)
 		return nil;
-
-	NSMutableString *titleValue = [NSMutableString string];
 	
-	NSArray *titleNames = [self.titlePropertyName componentsSeparatedByString:@";"];
-#ifdef _COREDATADEFINES_H
-	if([object isKindOfClass:[NSManagedObject class]])
+	// Title key paths are compiled once, then reused for every object
+	if(!titleAccessors)
 	{
-		for(int i=0; i<titleNames.count; i++)
+		NSArray *titleNames = [self.titlePropertyName componentsSeparatedByString:@";"];
+		NSMutableArray *accessors = [NSMutableArray arrayWithCapacity:titleNames.count];
+		for(NSString *titleName in titleNames)
 		{
-			id value = [(NSManagedObject *)object valueForKeyPath:[titleNames objectAtIndex:i]];
-			if(value)
-			{
-				if(i!=0)
-					[titleValue appendString:self.titlePropertyNameDelimiter];
-				[titleValue appendString:[NSString stringWithFormat:@"%@", value]];
-			}
+			SCKeyPathAccessor *accessor = [[SCKeyPathAccessor alloc] initWithKeyPath:titleName];
+			[accessors addObject:accessor];
+			[accessor release];
 		}
+		titleAccessors = [accessors retain];
 	}
-	else
-	{
-		for(int i=0; i<titleNames.count; i++)
-		{
-			id value = [object valueForKey:[titleNames objectAtIndex:i]];
-			if(value)
-			{
-				if(i!=0)
-					[titleValue appendString:self.titlePropertyNameDelimiter];
-				[titleValue appendString:[NSString stringWithFormat:@"%@", value]];
-			}
-		}
-	}
-#else
-	for(int i=0; i<titleNames.count; i++)
+	
+	if(!titleBuffer)
+		titleBuffer = [[NSMutableString alloc] init];
+	[titleBuffer setString:@""];
+	
+	NSUInteger count = titleAccessors.count;
+	for(NSUInteger i=0; i<count; i++)
 	{
-		id value = [object valueForKey:[titleNames objectAtIndex:i]];
+		id value = [(SCKeyPathAccessor *)[titleAccessors objectAtIndex:i] valueForObject:object];
 		if(value)
 		{
 			if(i!=0)
-				[titleValue appendString:self.titlePropertyNameDelimiter];
-			[titleValue appendString:[NSString stringWithFormat:@"%@", value]];
+				[titleBuffer appendString:self.titlePropertyNameDelimiter];
+			if([value isKindOfClass:[NSString class]])
+				[titleBuffer appendString:value];
+			else
+				[titleBuffer appendString:[value description]];
 		}
 	}
-#endif
 	
-	return titleValue;
+	return [[titleBuffer copy] autorelease];
+}
+
+- (id)descriptionValueForObject:(NSObject *)object
+{
+	if(!self.descriptionPropertyName)
+		return nil;
+	
+	if(!descriptionAccessor)
+		descriptionAccessor = [[SCKeyPathAccessor alloc] initWithKeyPath:self.descriptionPropertyName];
+	
+	return [descriptionAccessor valueForObject:object];
 }
 
 @end
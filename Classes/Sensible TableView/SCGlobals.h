@@ -50,6 +50,10 @@
 #define		SC_DefaultTextViewFontSize			17		// Default font size of UITextView
 #define		SC_DefaultTextFieldHeight			31		// Default height of UITextField
 #define		SC_DefaultSegmentedControlHeight	29		// Default height of UISegmentedControl
+#define		SC_DefaultBadgeImageCacheLimit		256		// Maximum number of images cached by SCBadgeView
+#define		SC_DefaultParallelSortThreshold		4096	// Minimum number of items sorted on multiple cores
+#define		SC_DefaultCellPoolSize				24		// Maximum number of cells kept by a virtualized section
+#define		SC_DefaultLiveCommitDelay			0.3		// Seconds the active cell's live commits are deferred by
 /**********************************************************************************/
 
 
@@ -103,6 +107,25 @@ typedef enum
 
 + (NSObject *)getFirstNodeInNibWithName:(NSString *)nibName;
 
+/* Method compares two key values the same way NSSortDescriptor does (nil sorts first) */
++ (NSComparisonResult)compareValue:(id)value1 toValue:(id)value2;
+
+/* Method binary searches an array sorted by key for the index at which object should be inserted.
+ * The returned index is past any items with an equal key, so that insertions are stable. */
++ (NSUInteger)insertionIndexForObject:(NSObject *)object inArray:(NSArray *)array 
+						 sortedByKey:(NSString *)key ascending:(BOOL)ascending;
+
+/* Method stably sorts objects by key using decorate-sort-undecorate: each key value is extracted
+ * once, then (key, index) pairs are merge sorted, on multiple cores for large arrays. If sortKeys 
+ * is not NULL, it is set to an autoreleased array of the extracted keys (NSNull for nil) aligned 
+ * with the returned array. */
++ (NSMutableArray *)sortedArrayWithObjects:(NSArray *)objects byKey:(NSString *)key 
+								 ascending:(BOOL)ascending sortKeys:(NSMutableArray **)sortKeys;
+
+/* Method flips an array returned by sortedArrayWithObjects:byKey:ascending:sortKeys: to the opposite
+ * direction without re-extracting keys. Equal keys keep their relative order, as if resorted. */
++ (void)reverseSortedArray:(NSMutableArray *)array withSortKeys:(NSMutableArray *)sortKeys;
+
 @end
 
 
@@ -112,3 +135,39 @@ typedef enum
 @end
 
 
+
+/* This class implements a mutable set of selected item indexes backed by a bitset. It is a
+ * drop-in NSMutableSet: members that are non-negative integer NSNumbers are stored as bits, giving
+ * O(1) membership tests and toggles, while any other member is kept in a regular set. Enumeration
+ * returns indexes in ascending order, followed by any other members. */
+@interface SCSelectionSet : NSMutableSet
+{
+	uint32_t *words;
+	NSUInteger wordCount;
+	NSUInteger indexCount;
+	NSMutableSet *otherObjects;
+}
+
+/* Returns an array of the given set's members, with indexes in ascending order. Sets that are not
+ * an SCSelectionSet are sorted, an SCSelectionSet is already in order. */
++ (NSArray *)orderedObjectsOfSet:(NSSet *)set;
+
+- (BOOL)containsIndex:(NSUInteger)index;
+- (void)addIndex:(NSUInteger)index;
+- (void)removeIndex:(NSUInteger)index;
+
+/* Method flips the membership of index and returns TRUE if it is now selected */
+- (BOOL)toggleIndex:(NSUInteger)index;
+
+/* Methods return the first index or the next index after the given one, or NSNotFound */
+- (NSUInteger)firstIndex;
+- (NSUInteger)indexGreaterThanIndex:(NSUInteger)index;
+
+/* Method returns the indexes as a compact bitmap: bit (i % 8) of byte (i / 8) is set for each index i.
+ * Members that are not indexes are not included. */
+- (NSData *)dataRepresentation;
+
+/* Method replaces all members with the indexes in a bitmap returned by dataRepresentation */
+- (void)setIndexesWithData:(NSData *)data;
+
+@end
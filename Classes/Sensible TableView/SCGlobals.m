@@ -21,6 +21,199 @@
 
 #import "SCGlobals.h"
 
+#define SC_SortInsertionRunLength	16
+
+
+// Compares two key values the way NSSortDescriptor does, with nil sorting first
+static inline NSComparisonResult SCCompareKeys(id key1, id key2)
+{
+	if(key1 == key2)
+		return NSOrderedSame;
+	if(!key1)
+		return NSOrderedAscending;
+	if(!key2)
+		return NSOrderedDescending;
+	
+	return [key1 compare:key2];
+}
+
+// State shared by the merge sort functions. Only the extracted keys are compared, so sorting
+// never touches the original objects and can safely run off the calling thread.
+typedef struct
+{
+	id *keys;
+	NSUInteger *indices;
+	NSUInteger *buffer;
+	BOOL ascending;
+} SCSortContext;
+
+static inline BOOL SCSortKeyPrecedes(const SCSortContext *context, NSUInteger index1, NSUInteger index2)
+{
+	NSComparisonResult result = SCCompareKeys(context->keys[index1], context->keys[index2]);
+	return context->ascending ? (result == NSOrderedAscending) : (result == NSOrderedDescending);
+}
+
+// Merges the sorted runs [low, mid) and [mid, high)
+static void SCMergeSortRuns(const SCSortContext *context, NSUInteger low, NSUInteger mid, NSUInteger high)
+{
+	NSUInteger *indices = context->indices;
+	if(!SCSortKeyPrecedes(context, indices[mid], indices[mid-1]))
+		return;  // runs are already in order
+	
+	NSUInteger *buffer = context->buffer;
+	NSUInteger i = low, j = mid, k = low;
+	while(i<mid && j<high)
+	{
+		// take from the right run only when strictly smaller, which keeps the sort stable
+		if(SCSortKeyPrecedes(context, indices[j], indices[i]))
+			buffer[k++] = indices[j++];
+		else
+			buffer[k++] = indices[i++];
+	}
+	while(i < mid)
+		buffer[k++] = indices[i++];
+	while(j < high)
+		buffer[k++] = indices[j++];
+	
+	memcpy(indices+low, buffer+low, (high-low)*sizeof(NSUInteger));
+}
+
+// Stable bottom-up merge sort of [low, high), with insertion sorted short runs
+static void SCMergeSortRange(const SCSortContext *context, NSUInteger low, NSUInteger high)
+{
+	NSUInteger *indices = context->indices;
+	for(NSUInteger start=low; start<high; start+=SC_SortInsertionRunLength)
+	{
+		NSUInteger end = MIN(start+SC_SortInsertionRunLength, high);
+		for(NSUInteger i=start+1; i<end; i++)
+		{
+			NSUInteger index = indices[i];
+			NSUInteger j = i;
+			while(j>start && SCSortKeyPrecedes(context, index, indices[j-1]))
+			{
+				indices[j] = indices[j-1];
+				j--;
+			}
+			indices[j] = index;
+		}
+	}
+	
+	for(NSUInteger width=SC_SortInsertionRunLength; width<high-low; width*=2)
+		for(NSUInteger start=low; start+width<high; start+=2*width)
+			SCMergeSortRuns(context, start, start+width, MIN(start+2*width, high));
+}
+
+// Sorts [low, high) when mid is NSNotFound, otherwise merges [low, mid) with [mid, high).
+// NSOperationQueue is used rather than GCD so that sorting still loads and runs on OS
+// versions prior to 4.0.
+@interface SCMergeSortOperation : NSOperation
+{
+	const SCSortContext *context;
+	NSUInteger low;
+	NSUInteger mid;
+	NSUInteger high;
+}
+
+- (id)initWithContext:(const SCSortContext *)_context low:(NSUInteger)_low mid:(NSUInteger)_mid high:(NSUInteger)_high;
+
+@end
+
+@implementation SCMergeSortOperation
+
+- (id)initWithContext:(const SCSortContext *)_context low:(NSUInteger)_low mid:(NSUInteger)_mid high:(NSUInteger)_high
+{
+	if( (self=[super init]) )
+	{
+		context = _context;
+		low = _low;
+		mid = _mid;
+		high = _high;
+	}
+	return self;
+}
+
+- (void)main
+{
+	if(mid == NSNotFound)
+		SCMergeSortRange(context, low, high);
+	else
+		SCMergeSortRuns(context, low, mid, high);
+}
+
+@end
+
+static NSOperationQueue *SCMergeSortQueue(NSUInteger processorCount)
+{
+	static NSOperationQueue *queue = nil;
+	
+	@synchronized([SCMergeSortOperation class])
+	{
+		if(!queue)
+		{
+			queue = [[NSOperationQueue alloc] init];
+			[queue setMaxConcurrentOperationCount:processorCount];
+		}
+	}
+	return queue;
+}
+
+static void SCMergeSort(const SCSortContext *context, NSUInteger count)
+{
+	NSUInteger processorCount = [[NSProcessInfo processInfo] activeProcessorCount];
+	if(count>=SC_DefaultParallelSortThreshold && processorCount>1)
+	{
+		// Sort one chunk per core, then merge pairs of chunks level by level. Each merge
+		// at a given level writes a disjoint range of indices and buffer, and depends only on
+		// the two operations that produced its runs. The queue is shared by all sorts, so only
+		// this sort's final merge is waited on rather than everything on the queue.
+		NSOperationQueue *queue = SCMergeSortQueue(processorCount);
+		NSUInteger chunkSize = (count + processorCount - 1) / processorCount;
+		NSUInteger runCount = (count + chunkSize - 1) / chunkSize;
+		SCMergeSortOperation **runs = malloc(runCount * sizeof(SCMergeSortOperation *));
+		for(NSUInteger run=0; run<runCount; run++)
+		{
+			NSUInteger low = run*chunkSize;
+			runs[run] = [[SCMergeSortOperation alloc] initWithContext:context low:low mid:NSNotFound
+																  high:MIN(low+chunkSize, count)];
+			[queue addOperation:runs[run]];
+		}
+		
+		// runs[i] is the operation that leaves [i*width, (i+1)*width) sorted
+		for(NSUInteger width=chunkSize; width<count; width*=2)
+		{
+			NSUInteger mergedCount = 0;
+			for(NSUInteger run=0; run<runCount; run+=2)
+			{
+				if(run+1 == runCount)
+				{
+					runs[mergedCount++] = runs[run];  // no partner at this level
+					continue;
+				}
+				
+				NSUInteger low = run*width;
+				SCMergeSortOperation *operation = [[SCMergeSortOperation alloc] initWithContext:context low:low mid:low+width
+																						   high:MIN(low+2*width, count)];
+				[operation addDependency:runs[run]];
+				[operation addDependency:runs[run+1]];
+				[queue addOperation:operation];
+				[runs[run] release];
+				[runs[run+1] release];
+				runs[mergedCount++] = operation;
+			}
+			runCount = mergedCount;
+		}
+		
+		[runs[0] waitUntilFinished];
+		[runs[0] release];
+		free(runs);
+		return;
+	}
+	
+	SCMergeSortRange(context, 0, count);
+}
+
+
+
 
 @implementation SCHelper
 
@@ -63,6 +256,111 @@
 	return nil;
 }
 
++ (NSComparisonResult)compareValue:(id)value1 toValue:(id)value2
+{
+	return SCCompareKeys(value1, value2);
+}
+
++ (NSUInteger)insertionIndexForObject:(NSObject *)object inArray:(NSArray *)array 
+						 sortedByKey:(NSString *)key ascending:(BOOL)ascending
+{
+	id objectValue = [object valueForKey:key];
+	
+	NSUInteger low = 0;
+	NSUInteger high = [array count];
+	while(low < high)
+	{
+		NSUInteger mid = (low + high) / 2;
+		NSComparisonResult result = [self compareValue:[[array objectAtIndex:mid] valueForKey:key] 
+											   toValue:objectValue];
+		if(!ascending)
+			result = -result;
+		
+		if(result == NSOrderedDescending)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	
+	return low;
+}
+
++ (NSMutableArray *)sortedArrayWithObjects:(NSArray *)objects byKey:(NSString *)key 
+								 ascending:(BOOL)ascending sortKeys:(NSMutableArray **)sortKeys
+{
+	NSUInteger count = [objects count];
+	NSMutableArray *sortedArray = [NSMutableArray arrayWithCapacity:count];
+	NSMutableArray *sortedKeys = [NSMutableArray arrayWithCapacity:count];
+	
+	id *keys = malloc(count * sizeof(id));
+	NSUInteger *indices = malloc(count * sizeof(NSUInteger));
+	NSUInteger *buffer = malloc(count * sizeof(NSUInteger));
+	
+	// Decorate: key values are extracted once, on the calling thread
+	for(NSUInteger i=0; i<count; i++)
+	{
+		keys[i] = [[[objects objectAtIndex:i] valueForKey:key] retain];
+		indices[i] = i;
+	}
+	
+	SCSortContext context = { keys, indices, buffer, ascending };
+	SCMergeSort(&context, count);
+	
+	// Undecorate
+	NSNull *nullKey = [NSNull null];
+	for(NSUInteger i=0; i<count; i++)
+	{
+		NSUInteger index = indices[i];
+		[sortedArray addObject:[objects objectAtIndex:index]];
+		[sortedKeys addObject:keys[index] ? keys[index] : nullKey];
+	}
+	
+	for(NSUInteger i=0; i<count; i++)
+		[keys[i] release];
+	free(keys);
+	free(indices);
+	free(buffer);
+	
+	if(sortKeys)
+		*sortKeys = sortedKeys;
+	
+	return sortedArray;
+}
+
++ (void)reverseSortedArray:(NSMutableArray *)array withSortKeys:(NSMutableArray *)sortKeys
+{
+	NSUInteger count = [array count];
+	if(count < 2)
+		return;
+	
+	// Reversing also reverses runs of equal keys, so each run is flipped back afterwards
+	for(NSUInteger i=0, j=count-1; i<j; i++, j--)
+	{
+		[array exchangeObjectAtIndex:i withObjectAtIndex:j];
+		[sortKeys exchangeObjectAtIndex:i withObjectAtIndex:j];
+	}
+	
+	NSNull *nullKey = [NSNull null];
+	NSUInteger runStart = 0;
+	for(NSUInteger i=1; i<=count; i++)
+	{
+		if(i < count)
+		{
+			id key1 = [sortKeys objectAtIndex:runStart];
+			id key2 = [sortKeys objectAtIndex:i];
+			if(SCCompareKeys(key1==nullKey ? nil : key1, key2==nullKey ? nil : key2) == NSOrderedSame)
+				continue;
+		}
+		
+		for(NSUInteger low=runStart, high=i-1; low<high; low++, high--)
+		{
+			[array exchangeObjectAtIndex:low withObjectAtIndex:high];
+			[sortKeys exchangeObjectAtIndex:low withObjectAtIndex:high];
+		}
+		runStart = i;
+	}
+}
+
 @end
 
 
@@ -102,3 +400,302 @@
 
 @end
 
+
+
+
+
+#define SC_SelectionSetMaxIndex		(1 << 24)
+
+// Returns TRUE if object is an NSNumber holding an index that can be stored as a bit
+static inline BOOL SCSelectionIndexForObject(id object, NSUInteger *index)
+{
+	if(![object isKindOfClass:[NSNumber class]])
+		return FALSE;
+	
+	double value = [(NSNumber *)object doubleValue];
+	if(value<0 || value>=SC_SelectionSetMaxIndex || value!=floor(value))
+		return FALSE;
+	
+	*index = (NSUInteger)value;
+	return TRUE;
+}
+
+
+/* Enumerates the set bits in ascending order, then the set's other members */
+@interface SCSelectionSetEnumerator : NSEnumerator
+{
+	SCSelectionSet *selectionSet;
+	NSUInteger nextIndex;
+	NSEnumerator *otherObjectsEnumerator;
+}
+
+- (id)initWithSelectionSet:(SCSelectionSet *)set otherObjects:(NSSet *)objects;
+
+@end
+
+@implementation SCSelectionSetEnumerator
+
+- (id)initWithSelectionSet:(SCSelectionSet *)set otherObjects:(NSSet *)objects
+{
+	if( (self=[super init]) )
+	{
+		selectionSet = [set retain];
+		nextIndex = [set firstIndex];
+		otherObjectsEnumerator = [[objects objectEnumerator] retain];
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{
+	[selectionSet release];
+	[otherObjectsEnumerator release];
+	
+	[super dealloc];
+}
+
+- (id)nextObject
+{
+	if(nextIndex != NSNotFound)
+	{
+		NSNumber *object = [NSNumber numberWithUnsignedInteger:nextIndex];
+		nextIndex = [selectionSet indexGreaterThanIndex:nextIndex];
+		return object;
+	}
+	//else
+	return [otherObjectsEnumerator nextObject];
+}
+
+@end
+
+
+
+@implementation SCSelectionSet
+
++ (NSArray *)orderedObjectsOfSet:(NSSet *)set
+{
+	if([set isKindOfClass:[SCSelectionSet class]])
+		return [set allObjects];
+	
+	//else
+	NSMutableArray *indexes = [NSMutableArray arrayWithCapacity:[set count]];
+	NSMutableArray *objects = [NSMutableArray array];
+	NSUInteger index;
+	for(id object in set)
+	{
+		if(SCSelectionIndexForObject(object, &index))
+			[indexes addObject:object];
+		else
+			[objects addObject:object];
+	}
+	[indexes sortUsingSelector:@selector(compare:)];
+	[indexes addObjectsFromArray:objects];
+	
+	return indexes;
+}
+
+- (id)init
+{
+	return [self initWithCapacity:0];
+}
+
+- (id)initWithCapacity:(NSUInteger)numItems
+{
+	if( (self=[super init]) )
+	{
+		words = NULL;
+		wordCount = 0;
+		indexCount = 0;
+		otherObjects = nil;
+	}
+	
+	return self;
+}
+
+- (id)initWithObjects:(const id *)objects count:(NSUInteger)count
+{
+	if( (self=[self initWithCapacity:count]) )
+	{
+		for(NSUInteger i=0; i<count; i++)
+			[self addObject:objects[i]];
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{
+	free(words);
+	[otherObjects release];
+	
+	[super dealloc];
+}
+
+- (BOOL)containsIndex:(NSUInteger)index
+{
+	NSUInteger word = index / 32;
+	if(word >= wordCount)
+		return FALSE;
+	
+	return (words[word] & (1u << (index % 32))) != 0;
+}
+
+- (void)addIndex:(NSUInteger)index
+{
+	NSUInteger word = index / 32;
+	if(word >= wordCount)
+	{
+		NSUInteger newWordCount = MAX(word+1, wordCount*2);
+		words = realloc(words, newWordCount * sizeof(uint32_t));
+		memset(words+wordCount, 0, (newWordCount-wordCount) * sizeof(uint32_t));
+		wordCount = newWordCount;
+	}
+	
+	uint32_t bit = 1u << (index % 32);
+	if(!(words[word] & bit))
+	{
+		words[word] |= bit;
+		indexCount++;
+	}
+}
+
+- (void)removeIndex:(NSUInteger)index
+{
+	if(![self containsIndex:index])
+		return;
+	
+	words[index / 32] &= ~(1u << (index % 32));
+	indexCount--;
+}
+
+- (BOOL)toggleIndex:(NSUInteger)index
+{
+	if([self containsIndex:index])
+	{
+		[self removeIndex:index];
+		return FALSE;
+	}
+	//else
+	[self addIndex:index];
+	return TRUE;
+}
+
+- (NSUInteger)firstIndex
+{
+	if(!indexCount)
+		return NSNotFound;
+	
+	for(NSUInteger word=0; word<wordCount; word++)
+		if(words[word])
+			return word*32 + __builtin_ctz(words[word]);
+	
+	return NSNotFound;
+}
+
+- (NSUInteger)indexGreaterThanIndex:(NSUInteger)index
+{
+	NSUInteger start = index + 1;
+	NSUInteger word = start / 32;
+	if(word >= wordCount)
+		return NSNotFound;
+	
+	// mask out the bits at or below index in the first word
+	uint32_t bits = words[word] & (~0u << (start % 32));
+	while(!bits)
+	{
+		if(++word >= wordCount)
+			return NSNotFound;
+		bits = words[word];
+	}
+	
+	return word*32 + __builtin_ctz(bits);
+}
+
+- (NSData *)dataRepresentation
+{
+	// Trailing empty words are not stored
+	NSUInteger usedWordCount = wordCount;
+	while(usedWordCount && !words[usedWordCount-1])
+		usedWordCount--;
+	
+	NSMutableData *data = [NSMutableData dataWithLength:usedWordCount * sizeof(uint32_t)];
+	uint8_t *bytes = [data mutableBytes];
+	for(NSUInteger i=0; i<usedWordCount*sizeof(uint32_t); i++)
+		bytes[i] = (uint8_t)(words[i / 4] >> (8 * (i % 4)));
+	
+	return data;
+}
+
+- (void)setIndexesWithData:(NSData *)data
+{
+	[self removeAllObjects];
+	
+	NSUInteger length = [data length];
+	const uint8_t *bytes = [data bytes];
+	wordCount = (length + 3) / 4;
+	words = realloc(words, wordCount * sizeof(uint32_t));
+	memset(words, 0, wordCount * sizeof(uint32_t));
+	for(NSUInteger i=0; i<length; i++)
+		words[i / 4] |= (uint32_t)bytes[i] << (8 * (i % 4));
+	
+	indexCount = 0;
+	for(NSUInteger word=0; word<wordCount; word++)
+		indexCount += __builtin_popcount(words[word]);
+}
+
+
+#pragma mark -
+#pragma mark NSSet primitive methods
+
+- (NSUInteger)count
+{
+	return indexCount + [otherObjects count];
+}
+
+- (id)member:(id)object
+{
+	NSUInteger index;
+	if(SCSelectionIndexForObject(object, &index))
+		return [self containsIndex:index] ? object : nil;
+	//else
+	return [otherObjects member:object];
+}
+
+- (NSEnumerator *)objectEnumerator
+{
+	return [[[SCSelectionSetEnumerator alloc] initWithSelectionSet:self otherObjects:otherObjects] autorelease];
+}
+
+- (void)addObject:(id)object
+{
+	NSUInteger index;
+	if(SCSelectionIndexForObject(object, &index))
+	{
+		[self addIndex:index];
+		return;
+	}
+	
+	if(!otherObjects)
+		otherObjects = [[NSMutableSet alloc] init];
+	[otherObjects addObject:object];
+}
+
+- (void)removeObject:(id)object
+{
+	NSUInteger index;
+	if(SCSelectionIndexForObject(object, &index))
+		[self removeIndex:index];
+	else
+		[otherObjects removeObject:object];
+}
+
+- (void)removeAllObjects
+{
+	if(words)
+		memset(words, 0, wordCount * sizeof(uint32_t));
+	indexCount = 0;
+	[otherObjects removeAllObjects];
+}
+
+@end
@@ -80,6 +80,8 @@
 		
 	BOOL valueRequired;
 	BOOL autoValidateValue;
+	BOOL valueIsValidCached;	//internal
+	BOOL cachedValueIsValid;	//internal
 	
 	BOOL commitChangesLive;
 	BOOL needsCommit;
@@ -296,6 +298,11 @@
 /*!	Method gets called internally whenever the cell gets deselected. */
 - (void)willDeselectCell;
 
+/*!	When autoValidateValue is TRUE, the result of getValueIsValid is cached until the cell value changes. 
+ *	Subclasses should call this method whenever a change other than a cell value change (e.g. 
+ *	a configuration change) affects the cell's validity. */
+- (void)invalidateValueIsValid;
+
 /*! Method should be overridden by subclasses to support property attributes. The method should be 
  *	able to set the subclass' specific attributes to its corresponding SCPropertyAttributes subclass. */
 - (void) setAttributesTo:(SCPropertyAttributes *)attributes;
@@ -801,6 +808,8 @@
 	NSNumber *maximumValue;
 	BOOL allowFloatValue;
 	BOOL displayZeroAsBlank;
+	
+	NSNumberFormatter *numberFormatter;	//internal
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -1460,10 +1469,12 @@
 @property (nonatomic, copy) NSNumber *selectedItemIndex;
 
 /*! This property reflects the current cell's selection(s). You can add index(es) to the set
- *	to define the cell's selection.
+ *	to define the cell's selection. The set is an SCSelectionSet, which stores indexes as a bitset
+ *	and enumerates them in ascending order.
  *
  *	Note: If you have bound this cell to an object or a key, you can define the cell's selection
- *	using either the bound property value or the key value, respectively. */
+ *	using either the bound property value or the key value, respectively. If the bound property value
+ *	is an NSData, the selection is stored in the compact form returned by SCSelectionSet's dataRepresentation. */
 @property (nonatomic, readonly) NSMutableSet *selectedItemsIndexes;
 
 /*! If TRUE, the cell allows multiple selection. Default: FALSE. */
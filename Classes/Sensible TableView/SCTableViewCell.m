@@ -121,6 +121,8 @@
 	cellEditingStyle = UITableViewCellEditingStyleDelete;
 	valueRequired = FALSE;
 	autoValidateValue = TRUE;
+	valueIsValidCached = FALSE;
+	cachedValueIsValid = TRUE;
 	delegate = nil;
 	commitChangesLive = TRUE;
 	needsCommit = FALSE;
@@ -233,14 +235,14 @@
 - (void)setHighlighted:(BOOL)highlighted animated:(BOOL)animated
 {
 	[super setHighlighted:highlighted animated:animated];
-	[self.badgeView setNeedsDisplay];
+	self.badgeView.highlighted = self.highlighted || self.selected;
 }
 
 //overrides superclass
 - (void)setSelected:(BOOL)selected animated:(BOOL)animated
 {
 	[super setSelected:selected animated:animated];
-	[self.badgeView setNeedsDisplay];
+	self.badgeView.highlighted = self.highlighted || self.selected;
 }
 
 //overrides superclass
@@ -252,15 +254,12 @@
 	{
 		// Set the badgeView frame
 		CGFloat margin = 10;
-		CGSize badgeTextSize = CGSizeMake(0, 0);
-		if(self.badgeView.text)
-			badgeTextSize = [self.badgeView.text sizeWithFont:self.badgeView.font];
+		CGSize badgeTextSize = self.badgeView.textSize;
 		CGFloat badgeHeight = badgeTextSize.height - 2;
 		CGRect badgeFrame = CGRectMake(self.contentView.frame.size.width - (badgeTextSize.width+16) - margin, 
 									   round((self.contentView.frame.size.height - badgeHeight)/2), 
 									   badgeTextSize.width+16, badgeHeight); // must use "round" for badge to get correctly rendered
 		self.badgeView.frame = badgeFrame;
-		[self.badgeView setNeedsDisplay];
 		
 		// Resize textLabel
 		if((self.textLabel.frame.origin.x + self.textLabel.frame.size.width) >= badgeFrame.origin.x)
@@ -281,8 +280,7 @@
 		}
 	}
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -358,10 +356,39 @@
 	return nil;
 }
 
+- (void)setValueRequired:(BOOL)required
+{
+	valueRequired = required;
+	
+	[self invalidateValueIsValid];
+}
+
+- (void)setAutoValidateValue:(BOOL)autoValidate
+{
+	autoValidateValue = autoValidate;
+	
+	[self invalidateValueIsValid];
+}
+
+- (void)invalidateValueIsValid
+{
+	valueIsValidCached = FALSE;
+	
+	[self.ownerTableViewModel updateValidityForCell:self];
+}
+
 - (BOOL)valueIsValid
 {
 	if(self.autoValidateValue)
-		return [self getValueIsValid];
+	{
+		// getValueIsValid only depends on the cell itself, so its result is kept until the value changes
+		if(!valueIsValidCached)
+		{
+			cachedValueIsValid = [self getValueIsValid];
+			valueIsValidCached = TRUE;
+		}
+		return cachedValueIsValid;
+	}
 	
 	BOOL valid = TRUE;
 	
@@ -371,9 +398,7 @@
 		valid = [delegate valueIsValidForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:valueIsValidForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityValueIsValidForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [ownerTableViewModel indexPathForCell:self];
 			valid = [self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel 
@@ -392,9 +417,17 @@
 - (void)cellValueChanged
 {
 	needsCommit = TRUE;
+	valueIsValidCached = FALSE;
 	
+	// While the cell is being edited, the model buffers its live commits to the bound object,
+	// everything else below still happens right away (see SCTableViewModel liveCommitDelay)
 	if(self.commitChangesLive)
-		[self commitChanges];
+	{
+		if(self.ownerTableViewModel.liveCommitDelay > 0 && self.ownerTableViewModel.activeCell == self)
+			[self.ownerTableViewModel scheduleCommitForCell:self];
+		else
+			[self commitChanges];
+	}
 	
 	NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 	if(tempDetailModel) // a custom detail view is defined
@@ -419,7 +452,8 @@
 
 - (void)willDisplay
 {
-	// Does nothing, should be overridden by subclasses
+	// The displayed value might have been reloaded from the bound value
+	valueIsValidCached = FALSE;
 }
 
 - (void)didSelectCell
@@ -451,6 +485,8 @@
 
 - (void) setAttributesTo:(SCPropertyAttributes *)attributes
 {
+	valueIsValidCached = FALSE;
+	
 	self.imageView.image = attributes.imageView.image;
 	self.detailCellsImageViews = attributes.imageViewArray;
 }
@@ -626,8 +662,7 @@
 	self.control.frame = controlFrame;
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -653,6 +688,7 @@
 {
 	[self loadBoundValueIntoControl];
 	[self loadBindingsIntoCustomControls];
+	[self invalidateValueIsValid];
 }
 
 //override superclass
@@ -750,10 +786,13 @@
 																							inObject:self.boundObject];
 		if([controlValue isKindOfClass:[NSString class]] && propertyDataType==SCPropertyDataTypeNSNumber)
 		{
-			NSNumberFormatter *numberFormatter = [[NSNumberFormatter alloc] init];
-			[numberFormatter setNumberStyle:NSNumberFormatterDecimalStyle];
+			static NSNumberFormatter *numberFormatter = nil;
+			if(!numberFormatter)
+			{
+				numberFormatter = [[NSNumberFormatter alloc] init];
+				[numberFormatter setNumberStyle:NSNumberFormatterDecimalStyle];
+			}
 			controlValue = [numberFormatter numberFromString:(NSString *)controlValue];
-			[numberFormatter release];
 		}
 		
 		@try 
@@ -983,9 +1022,7 @@
 		return TRUE;
 	}
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:returnButtonTappedForRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityReturnButtonTappedForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel 
@@ -1199,8 +1236,7 @@
 	self.label.frame = labelFrame;
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -1394,8 +1430,7 @@
 	[self layoutTextView];
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -1616,8 +1651,7 @@
 	self.textField.frame = textFieldFrame;
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -1701,15 +1735,45 @@
 	maximumValue = nil;
 	allowFloatValue = TRUE;
 	displayZeroAsBlank = FALSE;
+	
+	numberFormatter = [[NSNumberFormatter alloc] init];
+	[numberFormatter setAllowsFloats:allowFloatValue];
 }
 
 - (void)dealloc
 {
 	[minimumValue release];
 	[maximumValue release];
+	[numberFormatter release];
 	[super dealloc];
 }
 
+- (void)setMinimumValue:(NSNumber *)value
+{
+	[minimumValue release];
+	minimumValue = [value copy];
+	
+	[numberFormatter setMinimum:minimumValue];
+	[self invalidateValueIsValid];
+}
+
+- (void)setMaximumValue:(NSNumber *)value
+{
+	[maximumValue release];
+	maximumValue = [value copy];
+	
+	[numberFormatter setMaximum:maximumValue];
+	[self invalidateValueIsValid];
+}
+
+- (void)setAllowFloatValue:(BOOL)allow
+{
+	allowFloatValue = allow;
+	
+	[numberFormatter setAllowsFloats:allowFloatValue];
+	[self invalidateValueIsValid];
+}
+
 //overrides superclass
 - (void)loadBoundValueIntoControl
 {
@@ -1777,18 +1841,10 @@
 		return TRUE;
 	}
 		
-	NSNumberFormatter *numFormatter = [[NSNumberFormatter alloc] init];
-	[numFormatter setMinimum:self.minimumValue];
-	[numFormatter setMaximum:self.maximumValue];
-	[numFormatter setAllowsFloats:self.allowFloatValue];
-	BOOL valid;
-	if([numFormatter numberFromString:self.textField.text])
-		valid = TRUE;
-	else
-		valid = FALSE;
-	[numFormatter release];
-	
-	return valid;
+	if([numberFormatter numberFromString:self.textField.text])
+		return TRUE;
+	//else
+	return FALSE;
 }
 
 
@@ -2031,8 +2087,7 @@
 	self.segmentedControl.frame = segmentedFrame;
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -2196,8 +2251,7 @@
 	self.switchControl.frame = switchFrame;
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidLayoutSubviewsForCell])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didLayoutSubviewsForCell:self
@@ -2384,9 +2438,7 @@
 - (UIViewController *)getCustomDetailViewForRowAtIndexPath:(NSIndexPath *)indexPath
 {
 	UIViewController *detailViewController = nil;
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:customDetailViewForRowAtIndexPath:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomDetailViewForRowAtIndexPath])
 	{
 		detailViewController = [self.ownerTableViewModel.dataSource 
 								tableViewModel:self.ownerTableViewModel
@@ -2451,9 +2503,7 @@
 	SCTableViewModel *detailModel = [[SCTableViewModel alloc] initWithTableView:nil withViewController:detailViewController];
 	detailViewController.tableViewModel = detailModel;
 	[detailModel release];
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 					  detailModelCreatedForRowAtIndexPath:indexPath
@@ -2526,9 +2576,7 @@
 		[self.delegate detailViewWillAppearForCell:self withDetailTableViewModel:viewController.tableViewModel];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -2555,9 +2603,7 @@
 		[self.delegate detailViewWillDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -2574,9 +2620,7 @@
 		[self.delegate detailViewDidDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewDidDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewDidDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -2859,9 +2903,7 @@
 - (void)displayImageInDetailView
 {
 	// Check for custom detail view controller
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:customDetailViewForRowAtIndexPath:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomDetailViewForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		UIViewController *detailViewController = [self.ownerTableViewModel.dataSource 
@@ -2905,9 +2947,7 @@
 	SCTableViewModel *detailModel = [[SCTableViewModel alloc] initWithTableView:nil withViewController:detailViewController];
 	detailViewController.tableViewModel = detailModel;
 	[detailModel release];
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -3075,8 +3115,7 @@
 			self.selectedImageName = [self.delegate newImageNameForCell:self];
 		}
 		else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-			&& [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:newImageNameForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityNewImageNameForRowAtIndexPath])
 		{
 			self.selectedImageName = 
 				[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -3114,9 +3153,7 @@
 		[self.delegate detailViewWillAppearForCell:self withDetailTableViewModel:nil];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -3225,7 +3262,7 @@
 	hideDetailViewNavigationBar = FALSE;
 	displaySelection = TRUE;
 	delimeter = @", ";
-	selectedItemsIndexes = [[NSMutableSet alloc] init];
+	selectedItemsIndexes = [[SCSelectionSet alloc] init];
 	
 	self.detailTableViewStyle = UITableViewStylePlain;
 	self.accessoryType = UITableViewCellAccessoryDisclosureIndicator;
@@ -3345,6 +3382,12 @@
 			{
 				[self buildSelectedItemsIndexesFromString:(NSString *)self.boundValue];
 			}
+			else
+				if([self.boundValue isKindOfClass:[NSData class]])
+				{
+					// compact bitmap form, see SCSelectionSet dataRepresentation
+					[(SCSelectionSet *)selectedItemsIndexes setIndexesWithData:(NSData *)self.boundValue];
+				}
 }
 
 - (void)buildSelectedItemsIndexesFromString:(NSString *)string
@@ -3363,7 +3406,7 @@
 - (NSString *)buildStringFromSelectedItemsIndexes
 {
 	NSMutableArray *selectionStrings = [NSMutableArray arrayWithCapacity:[self.selectedItemsIndexes count]];
-	for(NSNumber *index in self.selectedItemsIndexes)
+	for(NSNumber *index in [SCSelectionSet orderedObjectsOfSet:self.selectedItemsIndexes])
 	{
 		[selectionStrings addObject:[self.items objectAtIndex:[index intValue]]];
 	}
@@ -3389,9 +3432,10 @@
 {
 	// don't call superclass willDisplay, as the "label"'s text will be set manually
 	//[super willDisplay];
+	valueIsValidCached = FALSE;
 	
-	NSArray *indexesArray = [[self.selectedItemsIndexes allObjects] 
-							 sortedArrayUsingSelector:@selector(compare:)];
+	// SCSelectionSet enumerates in ascending order, so no sorting is needed
+	NSArray *indexesArray = [SCSelectionSet orderedObjectsOfSet:self.selectedItemsIndexes];
 	if(self.items && self.displaySelection && indexesArray.count)
 	{
 		NSMutableString *selectionString = [[NSMutableString alloc] init];
@@ -3418,6 +3462,7 @@
 {
 	[self buildSelectedItemsIndexesFromBoundValue];
 	[self willDisplay];
+	[self invalidateValueIsValid];
 }
 
 - (SCSelectionSection *)createSelectionSection
@@ -3468,9 +3513,7 @@
 		return;
 	
 	// Check for custom detail table view model
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:customDetailTableViewModelForRowAtIndexPath:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomDetailTableViewModelForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		SCTableViewModel *detailTableViewModel = [self.ownerTableViewModel.dataSource 
@@ -3511,9 +3554,7 @@
 			self.ownerTableViewModel.viewController.contentSizeForViewInPopover;
 #endif
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -3583,6 +3624,11 @@
 			for(NSNumber *index in self.selectedItemsIndexes)
 				[boundValueSet addObject:index];
 		}
+		else
+			if([self.boundValue isKindOfClass:[NSData class]])
+			{
+				self.boundValue = [(SCSelectionSet *)selectedItemsIndexes dataRepresentation];
+			}
 	}
 	
 	needsCommit = FALSE;
@@ -3661,9 +3707,7 @@
 		[self.delegate detailViewWillAppearForCell:self withDetailTableViewModel:tableViewController.tableViewModel];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -3691,9 +3735,7 @@
 		[self.delegate detailViewWillDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -3710,9 +3752,7 @@
 		[self.delegate detailViewDidDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewDidDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewDidDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4025,9 +4065,7 @@
 		return;
 	
 	// Check for custom detail table view model
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:customDetailTableViewModelForRowAtIndexPath:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomDetailTableViewModelForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		SCTableViewModel *detailTableViewModel = [self.ownerTableViewModel.dataSource 
@@ -4070,9 +4108,7 @@
 			self.ownerTableViewModel.viewController.contentSizeForViewInPopover;
 #endif
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4167,19 +4203,11 @@
 	
 	if(self.boundObject && self.objectClassDefinition.descriptionPropertyName)
 	{
-		NSString *detailText = nil;
-#ifdef _COREDATADEFINES_H
-		if([self.boundObject isKindOfClass:[NSManagedObject class]])
-			detailText = [NSString stringWithFormat:@"%@", [(NSManagedObject *)self.boundObject 
-														  valueForKeyPath:self.objectClassDefinition.descriptionPropertyName]];
+		id detailValue = [self.objectClassDefinition descriptionValueForObject:self.boundObject];
+		if([detailValue isKindOfClass:[NSString class]])
+			self.detailTextLabel.text = detailValue;
 		else
-			detailText = [NSString stringWithFormat:@"%@", [self.boundObject 
-														  valueForKey:self.objectClassDefinition.descriptionPropertyName]];
-#else
-		detailText = [NSString stringWithFormat:@"%@", [self.boundObject 
-													  valueForKey:self.objectClassDefinition.descriptionPropertyName]];
-#endif
-		self.detailTextLabel.text = detailText;
+			self.detailTextLabel.text = [NSString stringWithFormat:@"%@", detailValue];
 	}
 }
 
@@ -4194,9 +4222,7 @@
 		[self.delegate detailViewWillAppearForCell:self withDetailTableViewModel:tableViewController.tableViewModel];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4222,9 +4248,7 @@
 		[self.delegate detailViewWillDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4241,9 +4265,7 @@
 		[self.delegate detailViewDidDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewDidDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewDidDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4481,9 +4503,7 @@
 	}
 	
 	// Check for custom detail table view model
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:customDetailTableViewModelForRowAtIndexPath:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomDetailTableViewModelForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		SCTableViewModel *detailTableViewModel = [self.ownerTableViewModel.dataSource 
@@ -4533,9 +4553,7 @@
 			self.ownerTableViewModel.viewController.contentSizeForViewInPopover;
 #endif
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath])
 	{
 		NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4582,9 +4600,7 @@
 		[self.delegate detailViewWillAppearForCell:self withDetailTableViewModel:tableViewController.tableViewModel];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4618,9 +4634,7 @@
 		[self.delegate detailViewWillDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -4637,9 +4651,7 @@
 		[self.delegate detailViewDidDisappearForCell:self];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewDidDisappearForRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewDidDisappearForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [self.ownerTableViewModel indexPathForCell:self];
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
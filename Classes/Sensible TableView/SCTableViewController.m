@@ -183,6 +183,8 @@
 {
 	[super viewWillDisappear:animated];
 	
+	[self.tableViewModel commitPendingChanges];
+	
 	if([self.delegate conformsToProtocol:@protocol(SCTableViewControllerDelegate)]
 	   && [self.delegate respondsToSelector:
 		   @selector(tableViewControllerWillDisappear:cancelButtonTapped:doneButtonTapped:)])
@@ -314,6 +316,11 @@
 
 - (void)doneButtonAction
 {
+	// The button might have been tapped before the last deferred changes were committed
+	[self.tableViewModel commitPendingChanges];
+	if(!self.tableViewModel.valuesAreValid)
+		return;
+	
 	[self dismissWithCancelValue:FALSE doneValue:TRUE];
 }
 
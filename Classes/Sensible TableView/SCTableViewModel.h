@@ -24,6 +24,66 @@
 #import "SCTableViewSection.h"
 
 
+@class SCSearchFilter;
+
+/* The optional SCTableViewModelDataSource methods, used internally by the framework as bit
+ * positions in the model's cached data source capabilities. */
+typedef enum
+{
+	SCDataSourceCapabilityCustomCellForRowAtIndexPath,
+	SCDataSourceCapabilityCustomDetailTableViewModelForRowAtIndexPath,
+	SCDataSourceCapabilityCustomDetailViewForRowAtIndexPath,
+	SCDataSourceCapabilityCommitEditingStyle,
+	SCDataSourceCapabilityMoveRowAtIndexPath,
+	SCDataSourceCapabilitySectionHeaderTitleForItem,
+	SCDataSourceCapabilityCustomSearchResultForSearchText,
+	SCDataSourceCapabilityNewItemForArrayOfItemsSectionAtIndex,
+	SCDataSourceCapabilityCount
+} SCDataSourceCapability;
+
+/* The optional SCTableViewModelDelegate methods, used internally by the framework as bit
+ * positions in the model's cached delegate capabilities. */
+typedef enum
+{
+	SCDelegateCapabilityWillBeginEditing,
+	SCDelegateCapabilityDidBeginEditing,
+	SCDelegateCapabilityWillEndEditing,
+	SCDelegateCapabilityDidEndEditing,
+	SCDelegateCapabilityValueChangedForSectionAtIndex,
+	SCDelegateCapabilityDetailModelCreatedForSectionAtIndex,
+	SCDelegateCapabilityDetailViewWillAppearForSectionAtIndex,
+	SCDelegateCapabilityDetailViewWillDisappearForSectionAtIndex,
+	SCDelegateCapabilityDetailViewDidDisappearForSectionAtIndex,
+	SCDelegateCapabilityItemCreatedForSectionAtIndex,
+	SCDelegateCapabilityItemAddedForSectionAtIndexPath,
+	SCDelegateCapabilityItemEditedForSectionAtIndexPath,
+	SCDelegateCapabilityWillConfigureCell,
+	SCDelegateCapabilityDidLayoutSubviewsForCell,
+	SCDelegateCapabilityWillDisplayCell,
+	SCDelegateCapabilityWillSelectRowAtIndexPath,
+	SCDelegateCapabilityDidSelectRowAtIndexPath,
+	SCDelegateCapabilityDidDeselectRowAtIndexPath,
+	SCDelegateCapabilityAccessoryButtonTappedForRowWithIndexPath,
+	SCDelegateCapabilityValueChangedForRowAtIndexPath,
+	SCDelegateCapabilityValueIsValidForRowAtIndexPath,
+	SCDelegateCapabilityReturnButtonTappedForRowAtIndexPath,
+	SCDelegateCapabilityDidInsertRowAtIndexPath,
+	SCDelegateCapabilityWillRemoveRowAtIndexPath,
+	SCDelegateCapabilityDidRemoveRowAtIndexPath,
+	SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath,
+	SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath,
+	SCDelegateCapabilityDetailViewWillDisappearForRowAtIndexPath,
+	SCDelegateCapabilityDetailViewDidDisappearForRowAtIndexPath,
+	SCDelegateCapabilityNewImageNameForRowAtIndexPath,
+	SCDelegateCapabilitySectionGenerated,
+	SCDelegateCapabilitySearchBarSelectedScopeButtonIndexDidChange,
+	SCDelegateCapabilitySearchBarBookmarkButtonClicked,
+	SCDelegateCapabilitySearchBarCancelButtonClicked,
+	SCDelegateCapabilitySearchBarResultsListButtonClicked,
+	SCDelegateCapabilitySearchBarSearchButtonClicked,
+	SCDelegateCapabilityCount
+} SCDelegateCapability;
+
 /****************************************************************************************/
 /*	class SCTableViewModel	*/
 /****************************************************************************************/ 
@@ -62,6 +122,8 @@
 	UIViewController *viewController;
 	id dataSource;
 	id delegate;
+	uint32_t dataSourceCapabilities;	//internal
+	uint64_t delegateCapabilities;		//internal
 	UIBarButtonItem *editButtonItem;
 	BOOL autoResizeForKeyboard;
 	BOOL autoResizeStatus;
@@ -69,6 +131,7 @@
 	CGFloat keyboardOverlap;
 	NSMutableArray *sections;
 	NSArray *sectionIndexTitles;
+	NSArray *generatedSectionIndexTitles;	//internal
 	BOOL autoGenerateSectionIndexTitles;
 	BOOL autoSortSections;
 	BOOL hideSectionHeaderTitles;
@@ -78,6 +141,11 @@
 	SCTableViewCell *activeCell;
 	NSMutableDictionary *modelKeyValues;
 	UIBarButtonItem *commitButton;
+	NSTimeInterval liveCommitDelay;
+	NSMutableArray *cellsPendingCommit;		//internal
+	NSMutableSet *invalidCells;				//internal
+	NSMutableSet *customValidatedCells;		//internal
+	BOOL needsValidation;					//internal
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -238,6 +306,20 @@
  *	valuesAreValid property, where commitButton is enabled if valuesAreValid is TRUE. */
 @property (nonatomic, retain) UIBarButtonItem *commitButton;
 
+/*! The number of seconds the live commits of the active cell are deferred by. While the user types,
+ *	the active cell's changes are buffered and committed together once the user stops typing for
+ *	this period, or as soon as the active cell changes. Only writing to the bound object is deferred:
+ *	validity, commitButton and value changed notifications are still updated on every change, so
+ *	they see the cell's value ahead of its bound object. Set to 0 to commit every change immediately.
+ *
+ *	Default: 0.3 if the model's view controller is an SCTableViewController or an SCViewController, 
+ *	otherwise 0. Note: When set for any other view controller, commitPendingChanges must be called
+ *	before the view controller disappears. */
+@property (nonatomic, readwrite) NSTimeInterval liveCommitDelay;
+
+/*! Commits all deferred cell changes immediately. See liveCommitDelay. */
+- (void)commitPendingChanges;
+
 /*! Reload's the model's bound values in case the associated bound objects or keys valuea has changed
  *	by means other than the cells themselves (e.g. external custom code). */
 - (void)reloadBoundValues;
@@ -287,6 +369,29 @@
 	relationship. */
 @property (nonatomic, assign) SCTableViewModel *masterModel;
 
+/*! Method gets called internally by the active cell to defer its live commit. See liveCommitDelay. */
+- (void)scheduleCommitForCell:(SCTableViewCell *)cell;
+
+/*! Method gets called internally by the framework whenever the validity of a cell might have changed.
+ *	Used to keep valuesAreValid up to date without validating all of the model's cells. */
+- (void)updateValidityForCell:(SCTableViewCell *)cell;
+
+/*! Method gets called internally by the framework whenever sections are added, removed, or retitled, so
+ *	that automatically generated sectionIndexTitles are generated again the next time they're requested. */
+- (void)invalidateSectionIndexTitles;
+
+/*! Method gets called internally by the framework whenever cells are added to or removed from the model. 
+ *	All cells will be validated again the next time valuesAreValid is requested. */
+- (void)setNeedsValidation;
+
+/*! Returns TRUE if the dataSource implements the SCTableViewModelDataSource method represented by capability.
+ *	The answer is cached when the dataSource is set. */
+- (BOOL)dataSourceRespondsTo:(SCDataSourceCapability)capability;
+
+/*! Returns TRUE if the delegate implements the SCTableViewModelDelegate method represented by capability.
+ *	The answer is cached when the delegate is set. */
+- (BOOL)delegateRespondsTo:(SCDelegateCapability)capability;
+
 /*! Method gets called internally whenever the value of a section changes. This method 
  *	should only be used when subclassing %SCTableViewModel. If what you want is to get notified
  *	when a section value changes, consider using SCTableViewModelDelegate methods.
@@ -841,6 +946,10 @@
 {
 	SCArrayOfItemsSection *tempSection;		//internal
 	NSArray *filteredArray;					//internal
+	NSMutableDictionary *sectionsByHeaderTitle;	//internal
+	NSArray *collationSectionTitles;			//internal
+	NSDictionary *collationSectionIndexes;		//internal
+	BOOL groupItemsAlphabetically;
 	
 	NSMutableArray *items;
 	UITableViewCellAccessoryType itemsAccessoryType;
@@ -950,6 +1059,41 @@
  *	automatically filter its items based on the user's typed search term. */
 @property (nonatomic, retain) UISearchBar *searchBar;
 
+/*! If TRUE, and the dataSource does not provide section header titles, the model groups its items 
+ *	into one section per letter of the current locale's UILocalizedIndexedCollation, using the first
+ *	letter of each item's title (see titleForItem:). Sections are ordered as in the collation, and 
+ *	autoSortSections is ignored. Combine with autoGenerateSectionIndexTitles for an alphabetical 
+ *	index. Default: FALSE. */
+@property (nonatomic, readwrite) BOOL groupItemsAlphabetically;
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @name Incremental Item Operations
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/*!	Adds a single item to the items array and to its section without regenerating any of the
+ *	other sections. The corresponding row (and section, if a new one was needed) is inserted
+ *	into modeledTableView. If itemsAreSorted returns TRUE the item is placed using a binary search,
+ *	otherwise it is appended.
+ *	@return The index path of the inserted row, or nil if the item is hidden by an active search.
+ */
+- (NSIndexPath *)insertItem:(NSObject *)item;
+
+/*!	Removes a single item from the items array and from its section. The corresponding row (and
+ *	section, if it becomes empty) is deleted from modeledTableView.
+ *	@return The index path the removed row had, or nil if the item is not displayed.
+ */
+- (NSIndexPath *)removeItem:(NSObject *)item;
+
+/*!	Repositions a single item after a change to its sort key or section header title. Only the
+ *	item's old and new sections are touched. 
+ *	@return The new index path of the item's row.
+ */
+- (NSIndexPath *)moveItem:(NSObject *)item;
+
+/*! Returns the index path of the row displaying the given item, or nil if the item is not displayed. */
+- (NSIndexPath *)indexPathForItem:(NSObject *)item;
+
 
 //////////////////////////////////////////////////////////////////////////////////////////
 /// @name Internal Properties & Methods (should only be used when subclassing)
@@ -967,6 +1111,19 @@
 /*! Method called internally by framework when the model should add a new item. */
 - (void)addNewItem:(NSObject *)newItem;
 
+/*! Subclasses should override this method to return TRUE if items is kept sorted by sortKeyName. Default: FALSE. */
+- (BOOL)itemsAreSorted;
+
+/*! The key items are sorted by when itemsAreSorted returns TRUE. */
+- (NSString *)sortKeyName;
+
+/*! The direction items are sorted in when itemsAreSorted returns TRUE. */
+- (BOOL)sortAscending;
+
+/*! The title used to group the given item when groupItemsAlphabetically is TRUE. Default: the item 
+ *	itself if it's an NSString, otherwise its description. */
+- (NSString *)titleForItem:(NSObject *)item;
+
 @end
 
 
@@ -1023,6 +1180,11 @@
 	NSMutableSet *itemsSet;
 	BOOL sortItemsSetAscending;
 	NSString *searchPropertyName;
+	
+	NSArray *itemsSetSortedItems;		//internal
+	NSMutableArray *itemsSetSortKeys;	//internal
+	SCSearchFilter *searchFilter;		//internal
+	BOOL itemsSortedByModel;			//internal
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -59,6 +59,7 @@
 @synthesize activeCell;
 @synthesize modelKeyValues;
 @synthesize commitButton;
+@synthesize liveCommitDelay;
 
 
 + (id)tableViewModelWithTableView:(UITableView *)_modeledTableView
@@ -80,13 +81,14 @@
 		
 		modeledTableView = _modeledTableView;
 		viewController = _viewController;
-		dataSource = _viewController;
-		delegate = _viewController;
+		self.dataSource = _viewController;
+		self.delegate = _viewController;
 		modeledTableView.dataSource = self;
 		modeledTableView.delegate = self;
 		
 		editButtonItem = nil;
 		sectionIndexTitles = nil;
+		generatedSectionIndexTitles = nil;
 		autoGenerateSectionIndexTitles = FALSE;
 		autoSortSections = FALSE;
 		hideSectionHeaderTitles = FALSE;
@@ -100,6 +102,17 @@
 		
 		commitButton = nil;
 		
+		// SCTableViewController and SCViewController commit pending changes before disappearing
+		if([self.viewController isKindOfClass:[SCTableViewController class]]
+		   || [self.viewController isKindOfClass:[SCViewController class]])
+			liveCommitDelay = SC_DefaultLiveCommitDelay;
+		else
+			liveCommitDelay = 0;
+		cellsPendingCommit = [[NSMutableArray alloc] init];
+		invalidCells = [[NSMutableSet alloc] init];
+		customValidatedCells = [[NSMutableSet alloc] init];
+		needsValidation = TRUE;
+		
 		keyboardShown = FALSE;
 		keyboardOverlap = 0;
 		if([self.viewController isKindOfClass:[UITableViewController class]])
@@ -117,13 +130,109 @@
 	[self unregisterKeyboardNotifications];
 	[editButtonItem release];
 	[sectionIndexTitles release];
+	[generatedSectionIndexTitles release];
 	[sections release];
 	[modelKeyValues release];
 	[commitButton release];
+	[cellsPendingCommit release];
+	[invalidCells release];
+	[customValidatedCells release];
 
 	[super dealloc];
 }
 
+- (void)setDataSource:(id)_dataSource
+{
+	// Selectors ordered as SCDataSourceCapability
+	SEL selectors[SCDataSourceCapabilityCount] = 
+	{
+		@selector(tableViewModel:customCellForRowAtIndexPath:),
+		@selector(tableViewModel:customDetailTableViewModelForRowAtIndexPath:),
+		@selector(tableViewModel:customDetailViewForRowAtIndexPath:),
+		@selector(tableViewModel:commitEditingStyle:forRowAtIndexPath:),
+		@selector(tableViewModel:moveRowAtIndexPath:toIndexPath:),
+		@selector(tableViewModel:sectionHeaderTitleForItem:AtIndex:),
+		@selector(tableViewModel:customSearchResultForSearchText:autoSearchResults:),
+		@selector(tableViewModel:newItemForArrayOfItemsSectionAtIndex:),
+	};
+	
+	dataSource = _dataSource;
+	
+	dataSourceCapabilities = 0;
+	if([dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)])
+	{
+		for(int i=0; i<SCDataSourceCapabilityCount; i++)
+			if([dataSource respondsToSelector:selectors[i]])
+				dataSourceCapabilities |= (uint32_t)1 << i;
+	}
+}
+
+- (void)setDelegate:(id)_delegate
+{
+	// Selectors ordered as SCDelegateCapability
+	SEL selectors[SCDelegateCapabilityCount] = 
+	{
+		@selector(tableViewModelWillBeginEditing:),
+		@selector(tableViewModelDidBeginEditing:),
+		@selector(tableViewModelWillEndEditing:),
+		@selector(tableViewModelDidEndEditing:),
+		@selector(tableViewModel:valueChangedForSectionAtIndex:),
+		@selector(tableViewModel:detailModelCreatedForSectionAtIndex:detailTableViewModel:),
+		@selector(tableViewModel:detailViewWillAppearForSectionAtIndex:withDetailTableViewModel:),
+		@selector(tableViewModel:detailViewWillDisappearForSectionAtIndex:),
+		@selector(tableViewModel:detailViewDidDisappearForSectionAtIndex:),
+		@selector(tableViewModel:itemCreatedForSectionAtIndex:item:),
+		@selector(tableViewModel:itemAddedForSectionAtIndexPath:item:),
+		@selector(tableViewModel:itemEditedForSectionAtIndexPath:item:),
+		@selector(tableViewModel:willConfigureCell:forRowAtIndexPath:),
+		@selector(tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:),
+		@selector(tableViewModel:willDisplayCell:forRowAtIndexPath:),
+		@selector(tableViewModel:willSelectRowAtIndexPath:),
+		@selector(tableViewModel:didSelectRowAtIndexPath:),
+		@selector(tableViewModel:didDeselectRowAtIndexPath:),
+		@selector(tableViewModel:accessoryButtonTappedForRowWithIndexPath:),
+		@selector(tableViewModel:valueChangedForRowAtIndexPath:),
+		@selector(tableViewModel:valueIsValidForRowAtIndexPath:),
+		@selector(tableViewModel:returnButtonTappedForRowAtIndexPath:),
+		@selector(tableViewModel:didInsertRowAtIndexPath:),
+		@selector(tableViewModel:willRemoveRowAtIndexPath:),
+		@selector(tableViewModel:didRemoveRowAtIndexPath:),
+		@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:),
+		@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:),
+		@selector(tableViewModel:detailViewWillDisappearForRowAtIndexPath:),
+		@selector(tableViewModel:detailViewDidDisappearForRowAtIndexPath:),
+		@selector(tableViewModel:newImageNameForRowAtIndexPath:),
+		@selector(tableViewModel:sectionGenerated:atIndex:),
+		@selector(tableViewModel:searchBarSelectedScopeButtonIndexDidChange:),
+		@selector(tableViewModelSearchBarBookmarkButtonClicked:),
+		@selector(tableViewModelSearchBarCancelButtonClicked:),
+		@selector(tableViewModelSearchBarResultsListButtonClicked:),
+		@selector(tableViewModelSearchBarSearchButtonClicked:),
+	};
+	
+	delegate = _delegate;
+	
+	delegateCapabilities = 0;
+	if([delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)])
+	{
+		for(int i=0; i<SCDelegateCapabilityCount; i++)
+			if([delegate respondsToSelector:selectors[i]])
+				delegateCapabilities |= (uint64_t)1 << i;
+	}
+}
+
+// Tests/CapabilityBenchmark.c compares these checks with the conformsToProtocol:/respondsToSelector:
+// pairs they replace while scrolling.
+- (BOOL)dataSourceRespondsTo:(SCDataSourceCapability)capability
+{
+	return (dataSourceCapabilities & ((uint32_t)1 << capability)) != 0;
+}
+
+- (BOOL)delegateRespondsTo:(SCDelegateCapability)capability
+{
+	return (delegateCapabilities & ((uint64_t)1 << capability)) != 0;
+}
+
 - (void)disableViewControllerDelegate
 {
 	if([self.viewController isKindOfClass:[SCTableViewController class]])
@@ -173,15 +282,26 @@
 	if(!self.autoGenerateSectionIndexTitles)
 		return sectionIndexTitles;
 	
-	// Generate sectionIndexTitles
-	NSMutableArray *titles = [NSMutableArray arrayWithCapacity:self.sectionCount];
-	for(SCTableViewSection *section in sections)
-		if([section.headerTitle length])
-		{
-			// Add first letter of the header title to section titles
-			[titles addObject:[section.headerTitle substringToIndex:1]];
-		}
-	return titles;
+	// Generate sectionIndexTitles, only once for as long as the sections don't change
+	if(!generatedSectionIndexTitles)
+	{
+		NSMutableArray *titles = [[NSMutableArray alloc] initWithCapacity:self.sectionCount];
+		for(SCTableViewSection *section in sections)
+			if([section.headerTitle length])
+			{
+				// Add first letter of the header title to section titles
+				NSRange letterRange = [section.headerTitle rangeOfComposedCharacterSequenceAtIndex:0];
+				[titles addObject:[section.headerTitle substringWithRange:letterRange]];
+			}
+		generatedSectionIndexTitles = titles;
+	}
+	return generatedSectionIndexTitles;
+}
+
+- (void)invalidateSectionIndexTitles
+{
+	[generatedSectionIndexTitles release];
+	generatedSectionIndexTitles = nil;
 }
 
 - (void)setActiveCell:(SCTableViewCell *)cell
@@ -189,6 +309,9 @@
 	if(activeCell == cell)
 		return;
 	
+	// Changes deferred while the previous cell was active must be committed before it's deselected
+	[self commitPendingChanges];
+	
 	previousActiveCell = activeCell;
 	[previousActiveCell willDeselectCell];
 	if(previousActiveCell.selected)
@@ -243,8 +366,7 @@
 
 - (void)valueChangedForSectionAtIndex:(NSUInteger)index
 {
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModel:valueChangedForSectionAtIndex:)])
+	if([self delegateRespondsTo:SCDelegateCapabilityValueChangedForSectionAtIndex])
 	{
 		[self.delegate tableViewModel:self valueChangedForSectionAtIndex:index];
 	}
@@ -272,16 +394,44 @@
 	if(target)
 		[target performSelector:action];
 	
+	[self updateValidityForCell:cell];
 	if(self.commitButton)
 		self.commitButton.enabled = self.valuesAreValid;
 	
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModel:valueChangedForRowAtIndexPath:)])
+	if([self delegateRespondsTo:SCDelegateCapabilityValueChangedForRowAtIndexPath])
 	{
 		[self.delegate tableViewModel:self valueChangedForRowAtIndexPath:indexPath];
 	}
 }
 
+- (void)scheduleCommitForCell:(SCTableViewCell *)cell
+{
+	if([cellsPendingCommit indexOfObjectIdenticalTo:cell] == NSNotFound)
+		[cellsPendingCommit addObject:cell];
+	
+	// Restart the delay window
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(commitPendingChanges) object:nil];
+	[self performSelector:@selector(commitPendingChanges) withObject:nil afterDelay:self.liveCommitDelay];
+}
+
+- (void)commitPendingChanges
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(commitPendingChanges) object:nil];
+	
+	if(!cellsPendingCommit.count)
+		return;
+	
+	// Detach the pending cells first, as committing might defer new changes. Their value changed
+	// notifications were already sent by cellValueChanged.
+	NSArray *pendingCells = [[NSArray alloc] initWithArray:cellsPendingCommit];
+	[cellsPendingCommit removeAllObjects];
+	
+	for(SCTableViewCell *cell in pendingCells)
+		[cell commitChanges];
+	
+	[pendingCells release];
+}
+
 - (void)setTargetForModelModifiedEvent:(id)_target action:(SEL)_action
 {
 	target = _target;
@@ -294,16 +444,14 @@
 	
 	if(editing)
 	{
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModelWillBeginEditing:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityWillBeginEditing])
 		{
 			[self.delegate tableViewModelWillBeginEditing:self];
 		}
 	}
 	else
 	{
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModelWillEndEditing:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityWillEndEditing])
 		{
 			[self.delegate tableViewModelWillEndEditing:self];
 		}
@@ -314,16 +462,14 @@
 	
 	if(editing)
 	{
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModelDidBeginEditing:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityDidBeginEditing])
 		{
 			[self.delegate tableViewModelDidBeginEditing:self];
 		}
 	}
 	else
 	{
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModelDidEndEditing:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityDidEndEditing])
 		{
 			[self.delegate tableViewModelDidEndEditing:self];
 		}
@@ -344,13 +490,10 @@
 
 - (void)addSection:(SCTableViewSection *)section
 {
-	section.ownerTableViewModel = self;
-	if(![section isKindOfClass:[SCArrayOfItemsSection class]])
-	{
-		for(int i=0; i<section.cellCount; i++)
-			[section cellAtIndex:i].ownerTableViewModel = self;
-	}
+	section.ownerTableViewModel = self;	// also sets the owner of the section's cells
 	[sections addObject:section];
+	[self setNeedsValidation];
+	[self invalidateSectionIndexTitles];
 	
 	if(self.autoSortSections)
 		[sections sortUsingSelector:@selector(compare:)];
@@ -358,10 +501,10 @@
 
 - (void)insertSection:(SCTableViewSection *)section atIndex:(NSUInteger)index
 {
-	section.ownerTableViewModel = self;
-	for(int i=0; i<section.cellCount; i++)
-		[section cellAtIndex:i].ownerTableViewModel = self;
+	section.ownerTableViewModel = self;	// also sets the owner of the section's cells
 	[sections insertObject:section atIndex:index];
+	[self setNeedsValidation];
+	[self invalidateSectionIndexTitles];
 }
 
 - (SCTableViewSection *)sectionAtIndex:(NSUInteger)index
@@ -398,11 +541,15 @@
 - (void)removeSectionAtIndex:(NSUInteger)index
 {
 	[sections removeObjectAtIndex:index];
+	[self setNeedsValidation];
+	[self invalidateSectionIndexTitles];
 }
 
 - (void)removeAllSections
 {
 	[sections removeAllObjects];
+	[self setNeedsValidation];
+	[self invalidateSectionIndexTitles];
 }
 
 - (void)clear
@@ -448,10 +595,48 @@
 	return [[self sectionAtIndex:0] cellAtIndex:0];
 }
 
+- (void)setNeedsValidation
+{
+	needsValidation = TRUE;
+	[invalidCells removeAllObjects];
+	[customValidatedCells removeAllObjects];
+}
+
+- (void)updateValidityForCell:(SCTableViewCell *)cell
+{
+	if(needsValidation || !cell)
+		return;
+	
+	// Cells validated by a delegate are validated every time, as their validity might depend on other cells
+	if(cell.autoValidateValue)
+	{
+		[customValidatedCells removeObject:cell];
+		if(cell.valueIsValid)
+			[invalidCells removeObject:cell];
+		else
+			[invalidCells addObject:cell];
+	}
+	else
+	{
+		[invalidCells removeObject:cell];
+		[customValidatedCells addObject:cell];
+	}
+}
+
 - (BOOL)valuesAreValid
 {
-	for(SCTableViewSection *section in sections)
-		if(!section.valuesAreValid)
+	if(needsValidation)
+	{
+		needsValidation = FALSE;
+		for(SCTableViewSection *section in sections)
+			for(SCTableViewCell *cell in [section cellsForValidation])
+				[self updateValidityForCell:cell];
+	}
+	
+	if(invalidCells.count)
+		return FALSE;
+	for(SCTableViewCell *cell in customValidatedCells)
+		if(!cell.valueIsValid)
 			return FALSE;
 	
 	return TRUE;
@@ -461,6 +646,7 @@
 {
 	for(SCTableViewSection *section in sections)
 		[section reloadBoundValues];
+	[self setNeedsValidation];
 }
 
 - (void)pauseAutoResizeForKeyboard
@@ -537,8 +723,7 @@
 		[(SCArrayOfItemsSection *)section commitEditingStyle:editingStyle 
 											forCellAtIndexPath:indexPath];
 	
-	if([self.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.dataSource respondsToSelector:@selector(tableViewModel:commitEditingStyle:forRowAtIndexPath:)])
+	if([self dataSourceRespondsTo:SCDataSourceCapabilityCommitEditingStyle])
 	{
 		[self.dataSource tableViewModel:self commitEditingStyle:editingStyle forRowAtIndexPath:indexPath];
 	}
@@ -551,8 +736,7 @@
 	if([section isKindOfClass:[SCArrayOfItemsSection class]])
 		[(SCArrayOfItemsSection *)section moveCellAtIndexPath:fromIndexPath toIndexPath:toIndexPath];
 	
-	if([self.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.dataSource respondsToSelector:@selector(tableViewModel:moveRowAtIndexPath:toIndexPath:)])
+	if([self dataSourceRespondsTo:SCDataSourceCapabilityMoveRowAtIndexPath])
 	{
 		[self.dataSource tableViewModel:self moveRowAtIndexPath:fromIndexPath toIndexPath:toIndexPath];
 	}
@@ -564,23 +748,29 @@
 
 - (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath
 {
-	SCTableViewCell *cell = [self cellAtIndexPath:indexPath];
-	if([cell.delegate conformsToProtocol:@protocol(SCTableViewCellDelegate)]
-	   && [cell.delegate respondsToSelector:@selector(willConfigureCell:)])
+	SCTableViewSection *section = [self sectionAtIndex:indexPath.section];
+	
+	// Avoid generating the cell if the section already knows its height
+	CGFloat cellHeight = [section cachedHeightForCellAtIndex:indexPath.row];
+	if(!cellHeight)
 	{
-		[cell.delegate willConfigureCell:cell];
-	}
-	else
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate 
-			   respondsToSelector:@selector(tableViewModel:willConfigureCell:forRowAtIndexPath:)])
+		SCTableViewCell *cell = [section cellAtIndex:indexPath.row];
+		if([cell.delegate conformsToProtocol:@protocol(SCTableViewCellDelegate)]
+		   && [cell.delegate respondsToSelector:@selector(willConfigureCell:)])
 		{
-			[self.delegate tableViewModel:self willConfigureCell:cell forRowAtIndexPath:indexPath];
+			[cell.delegate willConfigureCell:cell];
 		}
+		else
+			if([self delegateRespondsTo:SCDelegateCapabilityWillConfigureCell])
+			{
+				[self.delegate tableViewModel:self willConfigureCell:cell forRowAtIndexPath:indexPath];
+			}
+		
+		cellHeight = cell.height;
+		[section didMeasureCell:cell withHeight:cellHeight atIndex:indexPath.row];
+	}
 	
-	CGFloat cellHeight = cell.height;
 	// Check if the cell has an image in its section and resize accordingly
-	SCTableViewSection *section = [self sectionAtIndex:indexPath.section];
 	if([section.cellsImageViews count] > indexPath.row)
 	{
 		UIImageView *imageView = [section.cellsImageViews objectAtIndex:indexPath.row];
@@ -714,9 +904,7 @@
 		[scCell.delegate willDisplayCell:scCell];
 	}
 	else
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate 
-			   respondsToSelector:@selector(tableViewModel:willDisplayCell:forRowAtIndexPath:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityWillDisplayCell])
 		{
 			[self.delegate tableViewModel:self willDisplayCell:scCell forRowAtIndexPath:indexPath];
 		}
@@ -738,8 +926,7 @@
 		[cell.delegate willSelectCell:cell];
 	}
 	else	
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModel:willSelectRowAtIndexPath:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityWillSelectRowAtIndexPath])
 		{
 			[self.delegate tableViewModel:self willSelectRowAtIndexPath:indexPath];
 		}
@@ -772,8 +959,7 @@
 		[cell.delegate didSelectCell:cell];
 	}
 	else	
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModel:didSelectRowAtIndexPath:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityDidSelectRowAtIndexPath])
 		{
 			[self.delegate tableViewModel:self didSelectRowAtIndexPath:indexPath];
 		}
@@ -797,8 +983,7 @@
 		[cell.delegate didDeselectCell:cell];
 	}
 	else	
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModel:didDeselectRowAtIndexPath:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityDidDeselectRowAtIndexPath])
 		{
 			[self.delegate tableViewModel:self didDeselectRowAtIndexPath:indexPath];
 		}
@@ -815,9 +1000,7 @@
 		[cell.delegate accessoryButtonTappedForCell:cell];
 	}
 	else
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate 
-			   respondsToSelector:@selector(tableViewModel:accessoryButtonTappedForRowWithIndexPath:)])
+		if([self delegateRespondsTo:SCDelegateCapabilityAccessoryButtonTappedForRowWithIndexPath])
 		{
 			[self.delegate tableViewModel:self accessoryButtonTappedForRowWithIndexPath:indexPath];
 		}
@@ -929,6 +1112,8 @@
 {
 	keyboardShown = NO;
 	
+	[self commitPendingChanges];
+	
 	if(keyboardOverlap == 0)
 		return;
 	
@@ -1003,7 +1188,10 @@
 @interface SCArrayOfItemsModel ()
 
 - (void)generateSections;
+- (void)generateAlphabeticalSectionsForItems:(NSArray *)itemsArray;
 - (NSString *)getHeaderTitleForItemAtIndex:(NSUInteger)index;
+- (NSString *)headerTitleForItem:(NSObject *)item atIndex:(NSUInteger)index;
+- (NSUInteger)collationSectionIndexForItem:(NSObject *)item;
 
 @end
 
@@ -1026,6 +1214,7 @@
 @synthesize detailViewHidesBottomBar;
 @synthesize addButtonItem;
 @synthesize searchBar;
+@synthesize groupItemsAlphabetically;
 
 
 - (id)init
@@ -1051,6 +1240,10 @@
 		
 		filteredArray = nil;
 		searchBar = nil;
+		sectionsByHeaderTitle = [[NSMutableDictionary alloc] init];
+		collationSectionTitles = nil;
+		collationSectionIndexes = nil;
+		groupItemsAlphabetically = FALSE;
 	}
 	
 	return self;
@@ -1074,6 +1267,9 @@
 	[addButtonItem release];
 	[filteredArray release];
 	[searchBar release];
+	[sectionsByHeaderTitle release];
+	[collationSectionTitles release];
+	[collationSectionIndexes release];
 	
 	[super dealloc];
 }
@@ -1089,29 +1285,165 @@
 		itemsArray = self.items;
 	
 	BOOL respondsToSectionGenerated = FALSE;
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModel:sectionGenerated:atIndex:)])
+	if([self delegateRespondsTo:SCDelegateCapabilitySectionGenerated])
 	{
 		respondsToSectionGenerated = TRUE;
 	}
 	
-	for(int i=0; i<itemsArray.count; i++)
+	BOOL respondsToSectionHeaderTitle = FALSE;
+	if([self dataSourceRespondsTo:SCDataSourceCapabilitySectionHeaderTitleForItem])
 	{
-		NSString *headerTitle = [self getHeaderTitleForItemAtIndex:i];
-		SCArrayOfItemsSection *section = (SCArrayOfItemsSection *)[self sectionWithHeaderTitle:headerTitle];
+		respondsToSectionHeaderTitle = TRUE;
+	}
+	
+	if(self.groupItemsAlphabetically && !respondsToSectionHeaderTitle)
+	{
+		[self generateAlphabeticalSectionsForItems:itemsArray];
+		return;
+	}
+	
+	// Sections are looked up by header title through a hash map instead of sectionWithHeaderTitle:,
+	// which makes grouping linear in the number of items rather than items x sections. The map
+	// is kept afterwards so that single items can be added and removed incrementally.
+	// Tests/SectionGroupingBenchmark.c times this pass against the old scan.
+	NSNull *noHeaderTitle = [NSNull null];
+	SCArrayOfItemsSection *lastSection = nil;
+	NSString *lastHeaderTitle = nil;
+	
+	NSUInteger count = itemsArray.count;
+	for(NSUInteger i=0; i<count; i++)
+	{
+		NSObject *item = [itemsArray objectAtIndex:i];
+		NSString *headerTitle = nil;
+		if(respondsToSectionHeaderTitle)
+			headerTitle = [self.dataSource tableViewModel:self sectionHeaderTitleForItem:item AtIndex:i];
+		
+		// Items are usually already grouped, so most lookups hit the previous section
+		SCArrayOfItemsSection *section;
+		if(lastSection && (headerTitle==lastHeaderTitle || [headerTitle isEqualToString:lastHeaderTitle]))
+			section = lastSection;
+		else
+			section = [sectionsByHeaderTitle objectForKey:headerTitle ? (id)headerTitle : (id)noHeaderTitle];
+		
 		if(!section)
 		{
 			section = [self createSectionWithHeaderTitle:headerTitle];
 			if(!section)
 				continue;
 			[self setPropertiesForSection:section];
-			[self addSection:section];
+			section.ownerTableViewModel = self;
+			[sections addObject:section];  // sorted once below rather than on every addSection:
+			[sectionsByHeaderTitle setObject:section forKey:headerTitle ? (id)headerTitle : (id)noHeaderTitle];
 			
 			if(respondsToSectionGenerated)
 				[self.delegate tableViewModel:self sectionGenerated:section atIndex:i];
 		}
-		[section.items addObject:[itemsArray objectAtIndex:i]];
+		[section.items addObject:item];
+		
+		lastSection = section;
+		lastHeaderTitle = headerTitle;
 	}
+	
+	if(self.autoSortSections)
+		[sections sortUsingSelector:@selector(compare:)];
+	[self invalidateSectionIndexTitles];
+}
+
+// Groups items into a fixed table of buckets, one per collation section, in a single pass.
+// Buckets are already in collation order, so no sorting of sections is needed.
+- (void)generateAlphabeticalSectionsForItems:(NSArray *)itemsArray
+{
+	NSUInteger bucketCount = [collationSectionTitles count];
+	NSMutableArray **buckets = calloc(bucketCount, sizeof(NSMutableArray *));
+	
+	for(NSObject *item in itemsArray)
+	{
+		NSUInteger bucketIndex = [self collationSectionIndexForItem:item];
+		if(!buckets[bucketIndex])
+			buckets[bucketIndex] = [[NSMutableArray alloc] init];
+		[buckets[bucketIndex] addObject:item];
+	}
+	
+	BOOL respondsToSectionGenerated = [self delegateRespondsTo:SCDelegateCapabilitySectionGenerated];
+	for(NSUInteger i=0; i<bucketCount; i++)
+	{
+		if(!buckets[i])
+			continue;
+		
+		NSString *headerTitle = [collationSectionTitles objectAtIndex:i];
+		SCArrayOfItemsSection *section = [self createSectionWithHeaderTitle:headerTitle];
+		if(section)
+		{
+			[self setPropertiesForSection:section];
+			section.ownerTableViewModel = self;
+			[section.items addObjectsFromArray:buckets[i]];
+			[sections addObject:section];
+			[sectionsByHeaderTitle setObject:section forKey:headerTitle];
+			
+			if(respondsToSectionGenerated)
+				[self.delegate tableViewModel:self sectionGenerated:section atIndex:sections.count-1];
+		}
+		[buckets[i] release];
+	}
+	free(buckets);
+	
+	[self invalidateSectionIndexTitles];
+}
+
+- (void)setGroupItemsAlphabetically:(BOOL)group
+{
+	groupItemsAlphabetically = group;
+	
+	[collationSectionTitles release];
+	collationSectionTitles = nil;
+	[collationSectionIndexes release];
+	collationSectionIndexes = nil;
+	if(groupItemsAlphabetically)
+	{
+		collationSectionTitles = [[[UILocalizedIndexedCollation currentCollation] sectionTitles] retain];
+		
+		NSMutableDictionary *indexes = [[NSMutableDictionary alloc] initWithCapacity:collationSectionTitles.count];
+		for(NSUInteger i=0; i<collationSectionTitles.count; i++)
+			[indexes setObject:[NSNumber numberWithUnsignedInteger:i] forKey:[collationSectionTitles objectAtIndex:i]];
+		collationSectionIndexes = indexes;
+	}
+	
+	if(self.items)
+		[self generateSections];
+}
+
+- (NSString *)titleForItem:(NSObject *)item
+{
+	if([item isKindOfClass:[NSString class]])
+		return (NSString *)item;
+	//else
+	return [item description];
+}
+
+- (NSUInteger)collationSectionIndexForItem:(NSObject *)item
+{
+	NSString *title = [self titleForItem:item];
+	if(![title length])
+		return collationSectionTitles.count-1;  // the collation's last section collects non-letters
+	
+	NSInteger index = [[UILocalizedIndexedCollation currentCollation] sectionForObject:title 
+																collationStringSelector:@selector(self)];
+	if(index < 0 || index >= collationSectionTitles.count)
+		return collationSectionTitles.count-1;
+	return index;
+}
+
+- (NSString *)headerTitleForItem:(NSObject *)item atIndex:(NSUInteger)index
+{
+	if([self dataSourceRespondsTo:SCDataSourceCapabilitySectionHeaderTitleForItem])
+	{
+		return [self.dataSource tableViewModel:self sectionHeaderTitleForItem:item AtIndex:index];
+	}
+	
+	if(self.groupItemsAlphabetically)
+		return [collationSectionTitles objectAtIndex:[self collationSectionIndexForItem:item]];
+	
+	return nil;
 }
 
 - (NSString *)getHeaderTitleForItemAtIndex:(NSUInteger)index
@@ -1122,20 +1454,233 @@
 	else
 		itemsArray = self.items;
 	
-	NSString *headerTitleName = nil;
-	if([self.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.dataSource respondsToSelector:@selector(tableViewModel:sectionHeaderTitleForItem:AtIndex:)])
+	return [self headerTitleForItem:[itemsArray objectAtIndex:index] atIndex:index];
+}
+
+- (SCArrayOfItemsSection *)createSectionWithHeaderTitle:(NSString *)title
+{
+	return nil;  // method must be overridden by subclasses
+}
+
+- (BOOL)itemsAreSorted
+{
+	return FALSE;  // subclasses that keep their items sorted should override
+}
+
+- (NSString *)sortKeyName
+{
+	return nil;
+}
+
+- (BOOL)sortAscending
+{
+	return TRUE;
+}
+
+- (id)sectionKeyForHeaderTitle:(NSString *)title
+{
+	if(title)
+		return title;
+	//else
+	return [NSNull null];
+}
+
+- (NSUInteger)insertionIndexForItem:(NSObject *)item inArray:(NSArray *)array
+{
+	if([self itemsAreSorted])
 	{
-		headerTitleName = [self.dataSource tableViewModel:self sectionHeaderTitleForItem:[itemsArray objectAtIndex:index]
-												  AtIndex:index];
+		@try 
+		{
+			return [SCHelper insertionIndexForObject:item inArray:array sortedByKey:[self sortKeyName]
+										   ascending:[self sortAscending]];
+		}
+		@catch (NSException * e) 
+		{
+			// key is not sortable, append instead
+		}
 	}
 	
-	return headerTitleName;
+	return array.count;
 }
 
-- (SCArrayOfItemsSection *)createSectionWithHeaderTitle:(NSString *)title
+// Creates a section, inserts it at its sorted position and registers it by header title.
+// The caller is responsible for updating modeledTableView.
+- (SCArrayOfItemsSection *)addGeneratedSectionWithHeaderTitle:(NSString *)headerTitle
 {
-	return nil;  // method must be overridden by subclasses
+	SCArrayOfItemsSection *section = [self createSectionWithHeaderTitle:headerTitle];
+	if(!section)
+		return nil;
+	[self setPropertiesForSection:section];
+	section.ownerTableViewModel = self;
+	
+	NSUInteger sectionIndex = sections.count;
+	if(self.groupItemsAlphabetically && [collationSectionIndexes objectForKey:headerTitle])
+	{
+		// Alphabetical sections are kept in collation order
+		NSUInteger bucketIndex = [[collationSectionIndexes objectForKey:headerTitle] unsignedIntegerValue];
+		NSUInteger low = 0;
+		while(low < sectionIndex)
+		{
+			NSUInteger mid = (low + sectionIndex) / 2;
+			NSString *midTitle = [(SCTableViewSection *)[sections objectAtIndex:mid] headerTitle];
+			NSNumber *midIndex = midTitle ? [collationSectionIndexes objectForKey:midTitle] : nil;
+			if(midIndex && [midIndex unsignedIntegerValue] > bucketIndex)
+				sectionIndex = mid;
+			else
+				low = mid + 1;
+		}
+	}
+	else
+	if(self.autoSortSections)
+	{
+		NSUInteger low = 0;
+		while(low < sectionIndex)
+		{
+			NSUInteger mid = (low + sectionIndex) / 2;
+			if([(SCTableViewSection *)[sections objectAtIndex:mid] compare:section] == NSOrderedDescending)
+				sectionIndex = mid;
+			else
+				low = mid + 1;
+		}
+	}
+	[sections insertObject:section atIndex:sectionIndex];
+	[sectionsByHeaderTitle setObject:section forKey:[self sectionKeyForHeaderTitle:headerTitle]];
+	[self invalidateSectionIndexTitles];
+	
+	if([self delegateRespondsTo:SCDelegateCapabilitySectionGenerated])
+	{
+		[self.delegate tableViewModel:self sectionGenerated:section atIndex:sectionIndex];
+	}
+	
+	return section;
+}
+
+// override superclass
+- (void)removeSectionAtIndex:(NSUInteger)index
+{
+	SCTableViewSection *section = [self sectionAtIndex:index];
+	if(section)
+	{
+		// Sections are keyed by the title they were generated for, which sectionGenerated or
+		// setHeaderTitle: may have changed since, so the entry is found by identity
+		[sectionsByHeaderTitle removeObjectsForKeys:[sectionsByHeaderTitle allKeysForObject:section]];
+	}
+	
+	[super removeSectionAtIndex:index];
+}
+
+// override superclass
+- (void)removeAllSections
+{
+	[sectionsByHeaderTitle removeAllObjects];
+	[super removeAllSections];
+}
+
+- (NSIndexPath *)indexPathForItem:(NSObject *)item
+{
+	for(NSUInteger i=0; i<sections.count; i++)
+	{
+		SCArrayOfItemsSection *section = (SCArrayOfItemsSection *)[sections objectAtIndex:i];
+		if(![section isKindOfClass:[SCArrayOfItemsSection class]])
+			continue;
+		
+		NSUInteger row = [section.items indexOfObjectIdenticalTo:item];
+		if(row != NSNotFound)
+			return [NSIndexPath indexPathForRow:row inSection:i];
+	}
+	
+	return nil;
+}
+
+- (NSIndexPath *)insertItem:(NSObject *)item
+{
+	NSUInteger itemIndex = [self insertionIndexForItem:item inArray:self.items];
+	[self.items insertObject:item atIndex:itemIndex];
+	
+	if(filteredArray)
+		return nil;  // item is not part of the current search results
+	
+	NSString *headerTitle = [self headerTitleForItem:item atIndex:itemIndex];
+	SCArrayOfItemsSection *section = [sectionsByHeaderTitle objectForKey:[self sectionKeyForHeaderTitle:headerTitle]];
+	BOOL newSection = FALSE;
+	if(!section)
+	{
+		section = [self addGeneratedSectionWithHeaderTitle:headerTitle];
+		if(!section)
+			return nil;
+		newSection = TRUE;
+	}
+	
+	NSUInteger rowIndex = [self insertionIndexForItem:item inArray:section.items];
+	[section.items insertObject:item atIndex:rowIndex];
+	
+	NSUInteger sectionIndex = [self indexForSection:section];
+	NSIndexPath *indexPath = [NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex];
+	if(newSection)
+	{
+		[self.modeledTableView insertSections:[NSIndexSet indexSetWithIndex:sectionIndex] 
+							 withRowAnimation:UITableViewRowAnimationLeft];
+		if(self.autoGenerateSectionIndexTitles)
+		{
+			[self.modeledTableView reloadData]; // reloadSectionIndexTitles not working!
+		}
+	}
+	else
+	{
+		[self.modeledTableView insertRowsAtIndexPaths:[NSArray arrayWithObject:indexPath]
+									 withRowAnimation:UITableViewRowAnimationBottom];
+	}
+	
+	return indexPath;
+}
+
+- (NSIndexPath *)removeItem:(NSObject *)item
+{
+	NSIndexPath *indexPath = [self indexPathForItem:item];
+	
+	[[item retain] autorelease];
+	[self.items removeObjectIdenticalTo:item];
+	if(filteredArray && indexPath)
+	{
+		NSMutableArray *newFilteredArray = [filteredArray mutableCopy];
+		[newFilteredArray removeObjectIdenticalTo:item];
+		[filteredArray release];
+		filteredArray = newFilteredArray;
+	}
+	
+	if(!indexPath)
+		return nil;
+	
+	SCArrayOfItemsSection *section = (SCArrayOfItemsSection *)[self sectionAtIndex:indexPath.section];
+	[section.items removeObjectAtIndex:indexPath.row];
+	if(!section.items.count)
+	{
+		[self removeSectionAtIndex:indexPath.section];
+		[self.modeledTableView deleteSections:[NSIndexSet indexSetWithIndex:indexPath.section]
+							 withRowAnimation:UITableViewRowAnimationRight];
+		if(self.autoGenerateSectionIndexTitles)
+		{
+			[self.modeledTableView reloadData]; // reloadSectionIndexTitles not working!
+		}
+	}
+	else
+	{
+		[self.modeledTableView deleteRowsAtIndexPaths:[NSArray arrayWithObject:indexPath]
+									 withRowAnimation:UITableViewRowAnimationRight];
+	}
+	
+	return indexPath;
+}
+
+- (NSIndexPath *)moveItem:(NSObject *)item
+{
+	// A move only touches the item's old and new sections
+	[item retain];
+	[self removeItem:item];
+	NSIndexPath *indexPath = [self insertItem:item];
+	[item release];
+	
+	return indexPath;
 }
 
 - (void)setSearchBar:(UISearchBar *)sbar
@@ -1298,25 +1843,17 @@
 
 - (void)addNewItem:(NSObject *)newItem
 {
-	[self.items addObject:newItem];
-	NSUInteger itemIndex = self.items.count-1;
+	NSUInteger itemIndex = [self insertionIndexForItem:newItem inArray:self.items];
+	[self.items insertObject:newItem atIndex:itemIndex];
 	
 	NSString *headerTitle = [self getHeaderTitleForItemAtIndex:itemIndex];
-	SCArrayOfItemsSection *section = (SCArrayOfItemsSection *)[self sectionWithHeaderTitle:headerTitle];
+	SCArrayOfItemsSection *section = [sectionsByHeaderTitle objectForKey:[self sectionKeyForHeaderTitle:headerTitle]];
 	if(!section)
 	{
 		// Add new section
-		section = [self createSectionWithHeaderTitle:headerTitle];
-		[self setPropertiesForSection:section];
-		[self addSection:section];
+		section = [self addGeneratedSectionWithHeaderTitle:headerTitle];
 		NSUInteger sectionIndex = [self indexForSection:section];
 		
-		if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.delegate respondsToSelector:@selector(tableViewModel:sectionGenerated:atIndex:)])
-		{
-			[self.delegate tableViewModel:self sectionGenerated:section atIndex:sectionIndex];
-		}
-		
 		[self.modeledTableView insertSections:[NSIndexSet indexSetWithIndex:sectionIndex] 
 							 withRowAnimation:UITableViewRowAnimationLeft];
 		if(self.autoGenerateSectionIndexTitles)
@@ -1354,8 +1891,7 @@
 
 - (void)searchBar:(UISearchBar *)sBar selectedScopeButtonIndexDidChange:(NSInteger)selectedScope
 {
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModel:searchBarSelectedScopeButtonIndexDidChange:)])
+	if([self delegateRespondsTo:SCDelegateCapabilitySearchBarSelectedScopeButtonIndexDidChange])
 	{
 		[self.delegate tableViewModel:self searchBarSelectedScopeButtonIndexDidChange:selectedScope];
 	}
@@ -1363,8 +1899,7 @@
 
 - (void)searchBarBookmarkButtonClicked:(UISearchBar *)sBar
 {
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModelSearchBarBookmarkButtonClicked:)])
+	if([self delegateRespondsTo:SCDelegateCapabilitySearchBarBookmarkButtonClicked])
 	{
 		[self.delegate tableViewModelSearchBarBookmarkButtonClicked:self];
 	}
@@ -1379,8 +1914,7 @@
 	filteredArray = nil;
 	[self generateSections];
 	
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModelSearchBarCancelButtonClicked:)])
+	if([self delegateRespondsTo:SCDelegateCapabilitySearchBarCancelButtonClicked])
 	{
 		[self.delegate tableViewModelSearchBarCancelButtonClicked:self];
 	}
@@ -1390,8 +1924,7 @@
 
 - (void)searchBarResultsListButtonClicked:(UISearchBar *)sBar
 {
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModelSearchBarResultsListButtonClicked:)])
+	if([self delegateRespondsTo:SCDelegateCapabilitySearchBarResultsListButtonClicked])
 	{
 		[self.delegate tableViewModelSearchBarResultsListButtonClicked:self];
 	}
@@ -1399,8 +1932,7 @@
 
 - (void)searchBarSearchButtonClicked:(UISearchBar *)sBar
 {
-	if([self.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.delegate respondsToSelector:@selector(tableViewModelSearchBarSearchButtonClicked:)])
+	if([self delegateRespondsTo:SCDelegateCapabilitySearchBarSearchButtonClicked])
 	{
 		[self.delegate tableViewModelSearchBarSearchButtonClicked:self];
 	}
@@ -1431,13 +1963,22 @@
 	
 	if([sbar.text length])
 	{
-		NSPredicate *predicate = [NSPredicate predicateWithFormat:@"SELF contains[c] %@", sbar.text];
-		resultsArray = [self.items filteredArrayUsingPredicate:predicate];
+		// Plain substring search, no predicate needs to be parsed on every keystroke
+		NSString *searchTerm = sbar.text;
+		NSMutableArray *matchingItems = [NSMutableArray array];
+		for(NSObject *item in self.items)
+		{
+			if([item isKindOfClass:[NSString class]]
+			   && [(NSString *)item rangeOfString:searchTerm options:NSCaseInsensitiveSearch].location != NSNotFound)
+			{
+				[matchingItems addObject:item];
+			}
+		}
+		resultsArray = matchingItems;
 		
 		// Check for custom results
 		NSArray *customResultsArray;
-		if([self.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-		   && [self.dataSource respondsToSelector:@selector(tableViewModel:customSearchResultForSearchText:autoSearchResults:)])
+		if([self dataSourceRespondsTo:SCDataSourceCapabilityCustomSearchResultForSearchText])
 		{
 			customResultsArray = [self.dataSource tableViewModel:self customSearchResultForSearchText:searchText
 											   autoSearchResults:resultsArray];
@@ -1462,6 +2003,141 @@
 
 
 
+/* Search filter compiled once from a list of property names. Matching calls the precompiled
+ * property accessors and does a plain case-insensitive substring search, so the search text
+ * is never parsed and may contain any characters. */
+@interface SCSearchFilter : NSObject
+{
+	NSString *propertyNamesKey;
+	NSArray *accessors;
+	NSStringCompareOptions options;
+}
+
+@property (nonatomic, readonly) NSString *propertyNamesKey;
+
+- (id)initWithPropertyNames:(NSArray *)propertyNames key:(NSString *)key 
+					options:(NSStringCompareOptions)compareOptions;
+- (BOOL)object:(NSObject *)object matchesSearchText:(NSString *)searchText;
+- (BOOL)object:(NSObject *)object safelyMatchesSearchText:(NSString *)searchText;
+- (NSArray *)filteredArrayFromArray:(NSArray *)array withSearchText:(NSString *)searchText;
+
+@end
+
+@implementation SCSearchFilter
+
+@synthesize propertyNamesKey;
+
+- (id)initWithPropertyNames:(NSArray *)propertyNames key:(NSString *)key 
+					options:(NSStringCompareOptions)compareOptions
+{
+	if( (self=[super init]) )
+	{
+		propertyNamesKey = [key copy];
+		options = compareOptions;
+		
+		NSMutableArray *propertyAccessors = [[NSMutableArray alloc] initWithCapacity:propertyNames.count];
+		for(NSString *propertyName in propertyNames)
+		{
+			if(![propertyName length])
+				continue;
+			SCKeyPathAccessor *accessor = [[SCKeyPathAccessor alloc] initWithKeyPath:propertyName];
+			[propertyAccessors addObject:accessor];
+			[accessor release];
+		}
+		accessors = propertyAccessors;
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{
+	[propertyNamesKey release];
+	[accessors release];
+	
+	[super dealloc];
+}
+
+// Exceptions aren't caught here, see filteredArrayFromArray:withSearchText:
+- (BOOL)object:(NSObject *)object matchesSearchText:(NSString *)searchText
+{
+	for(SCKeyPathAccessor *accessor in accessors)
+	{
+		id value = [accessor valueForObject:object];
+		
+		// only string values can contain the search text
+		if([value isKindOfClass:[NSString class]]
+		   && [(NSString *)value rangeOfString:searchText options:options].location != NSNotFound)
+		{
+			return TRUE;
+		}
+	}
+	
+	return FALSE;
+}
+
+// Same as object:matchesSearchText:, skipping any property that raises
+- (BOOL)object:(NSObject *)object safelyMatchesSearchText:(NSString *)searchText
+{
+	for(SCKeyPathAccessor *accessor in accessors)
+	{
+		id value = nil;
+		@try 
+		{
+			value = [accessor valueForObject:object];
+		}
+		@catch (NSException * e) 
+		{
+			// handle any unexpected property-name behavior gracefully
+			continue;
+		}
+		
+		if([value isKindOfClass:[NSString class]]
+		   && [(NSString *)value rangeOfString:searchText options:options].location != NSNotFound)
+		{
+			return TRUE;
+		}
+	}
+	
+	return FALSE;
+}
+
+- (NSArray *)filteredArrayFromArray:(NSArray *)array withSearchText:(NSString *)searchText
+{
+	NSMutableArray *resultsArray = [NSMutableArray array];
+	NSUInteger count = array.count;
+	
+	// A single exception handler for the whole pass instead of one per object and property, since
+	// setting one up costs a setjmp. Once a property raises, the object it raised on and the ones
+	// after it are matched the slow way. volatile keeps the index intact across the longjmp.
+	volatile NSUInteger i = 0;
+	@try 
+	{
+		for(; i<count; i++)
+		{
+			NSObject *object = [array objectAtIndex:i];
+			if([self object:object matchesSearchText:searchText])
+				[resultsArray addObject:object];
+		}
+	}
+	@catch (NSException * e) 
+	{
+		for(; i<count; i++)
+		{
+			NSObject *object = [array objectAtIndex:i];
+			if([self object:object safelyMatchesSearchText:searchText])
+				[resultsArray addObject:object];
+		}
+	}
+	
+	return resultsArray;
+}
+
+@end
+
+
+
+
 @interface SCArrayOfObjectsModel ()
 
 - (void)generateItemsArrayFromItemsSet;
@@ -1528,6 +2204,10 @@
 		itemsSet = nil;
 		sortItemsSetAscending = TRUE;
 		searchPropertyName = nil;
+		itemsSetSortedItems = nil;
+		itemsSetSortKeys = nil;
+		searchFilter = nil;
+		itemsSortedByModel = FALSE;
 	}
 	
 	return self;
@@ -1603,9 +2283,13 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 		[fetchRequest release];
 	}
 	
-	return [self initWithTableView:_modeledTableView withViewController:_viewController
-						 withItems:sectionItems
-			   withClassDefinition:classDefinition];
+	if( (self=[self initWithTableView:_modeledTableView withViewController:_viewController
+							withItems:sectionItems
+				  withClassDefinition:classDefinition]) )
+	{
+		itemsSortedByModel = (sectionItems != nil);  // fetched sorted by keyPropertyName
+	}
+	return self;
 }
 #endif
 
@@ -1614,6 +2298,9 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	[itemsClassDefinitions release];
 	[itemsSet release];
 	[searchPropertyName release];
+	[itemsSetSortedItems release];
+	[itemsSetSortKeys release];
+	[searchFilter release];
 		
 	[super dealloc];
 }
@@ -1647,26 +2334,58 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 
 -(void)setSortItemsSetAscending:(BOOL)ascending
 {
+	// If items still hold the last sort result, the opposite order is just its reverse
+	if(ascending!=sortItemsSetAscending && itemsSetSortKeys 
+	   && [itemsSetSortedItems count]==[self.itemsSet count] && [itemsSetSortedItems isEqualToArray:self.items])
+	{
+		sortItemsSetAscending = ascending;
+		
+		NSMutableArray *reversedArray = [NSMutableArray arrayWithArray:self.items];
+		[SCHelper reverseSortedArray:reversedArray withSortKeys:itemsSetSortKeys];
+		[itemsSetSortedItems release];
+		itemsSetSortedItems = [[NSArray alloc] initWithArray:reversedArray];
+		
+		self.items = reversedArray;
+		itemsSortedByModel = TRUE;
+		return;
+	}
+	
 	sortItemsSetAscending = ascending;
 	[self generateItemsArrayFromItemsSet];
 }
 
 - (void)generateItemsArrayFromItemsSet
 {
+	[itemsSetSortedItems release];
+	itemsSetSortedItems = nil;
+	[itemsSetSortKeys release];
+	itemsSetSortKeys = nil;
+	
 	if(!self.itemsSet)
 	{
 		self.items = nil;
 		return;
 	}
 	
-	NSMutableArray *sortedArray = [NSMutableArray arrayWithArray:[self.itemsSet allObjects]]; 
-	NSSortDescriptor *descriptor = [[NSSortDescriptor alloc] 
-									initWithKey:[self firstClassDefinition].keyPropertyName
-									ascending:self.sortItemsSetAscending];
-	[sortedArray sortUsingDescriptors:[NSArray arrayWithObject:descriptor]];
-	[descriptor release];
+	// Key values are extracted once and kept, so that toggling sortItemsSetAscending can reuse them
+	NSMutableArray *sortKeys = nil;
+	NSMutableArray *sortedArray = [SCHelper sortedArrayWithObjects:[self.itemsSet allObjects]
+															 byKey:[self firstClassDefinition].keyPropertyName
+														 ascending:self.sortItemsSetAscending
+														  sortKeys:&sortKeys];
+	itemsSetSortKeys = [sortKeys retain];
+	itemsSetSortedItems = [[NSArray alloc] initWithArray:sortedArray];
 	
 	self.items = sortedArray;
+	itemsSortedByModel = TRUE;
+}
+
+// override superclass method
+- (void)setItems:(NSMutableArray *)array
+{
+	// Items assigned from outside keep whatever order they were given in
+	itemsSortedByModel = FALSE;
+	[super setItems:array];
 }
 
 - (SCClassDefinition *)firstClassDefinition
@@ -1681,6 +2400,48 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	return classDef;
 }
 
+// override superclass method
+- (BOOL)itemsAreSorted
+{
+	if(![self sortKeyName])
+		return FALSE;
+	
+	// Only items the model sorted itself, from itemsSet or a fetch, and has kept sorted since
+	return itemsSortedByModel;
+}
+
+// override superclass method
+- (NSString *)sortKeyName
+{
+	return [self firstClassDefinition].keyPropertyName;
+}
+
+// override superclass method
+- (BOOL)sortAscending
+{
+	if(self.itemsSet)
+		return self.sortItemsSetAscending;
+	//else
+	return TRUE;
+}
+
+// override superclass method
+- (NSString *)titleForItem:(NSObject *)item
+{
+	SCClassDefinition *itemClassDef = nil;
+#ifdef _COREDATADEFINES_H
+	if([item isKindOfClass:[NSManagedObject class]])
+		itemClassDef = [self.itemsClassDefinitions valueForKey:[[(NSManagedObject *)item entity] name]];
+	else
+#endif
+		itemClassDef = [self.itemsClassDefinitions valueForKey:NSStringFromClass([item class])];
+	
+	if(itemClassDef.titlePropertyName)
+		return [itemClassDef titleValueForObject:item];
+	//else
+	return [super titleForItem:item];
+}
+
 #pragma mark -
 #pragma mark UISearchBarDelegate methods
 
@@ -1695,43 +2456,32 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 		if(!self.searchPropertyName)
 			self.searchPropertyName = objClassDef.titlePropertyName;
 		
-		NSArray *searchProperties;
-		if([self.searchPropertyName isEqualToString:@"*"])
-		{
-			searchProperties = [NSMutableArray arrayWithCapacity:objClassDef.propertyDefinitionCount];
-			for(int i=0; i<objClassDef.propertyDefinitionCount; i++)
-				[(NSMutableArray *)searchProperties addObject:[objClassDef propertyDefinitionAtIndex:i].name];
-		}
-		else
-		{
-			searchProperties = [self.searchPropertyName componentsSeparatedByString:@";"];
-		}
-
-		NSMutableString *predicateFormat = [NSMutableString string];
-		for(int i=0; i<searchProperties.count; i++)
+		// The filter is compiled once per set of search properties and reused on every keystroke
+		if(!searchFilter || ![searchFilter.propertyNamesKey isEqualToString:self.searchPropertyName])
 		{
-			NSString *property = [searchProperties objectAtIndex:i];
-			if(i==0)
-				[predicateFormat appendFormat:@"%@ contains[c] '%@'", property, sbar.text];
+			NSArray *searchProperties;
+			if([self.searchPropertyName isEqualToString:@"*"])
+			{
+				searchProperties = [NSMutableArray arrayWithCapacity:objClassDef.propertyDefinitionCount];
+				for(int i=0; i<objClassDef.propertyDefinitionCount; i++)
+					[(NSMutableArray *)searchProperties addObject:[objClassDef propertyDefinitionAtIndex:i].name];
+			}
 			else
-				[predicateFormat appendFormat:@" OR %@ contains[c] '%@'", property, sbar.text];
+			{
+				searchProperties = [self.searchPropertyName componentsSeparatedByString:@";"];
+			}
+			
+			[searchFilter release];
+			searchFilter = [[SCSearchFilter alloc] initWithPropertyNames:searchProperties 
+																	 key:self.searchPropertyName
+																 options:NSCaseInsensitiveSearch];
 		}
-		NSPredicate *predicate = [NSPredicate predicateWithFormat:predicateFormat];
 		
-		@try 
-		{
-			resultsArray = [self.items filteredArrayUsingPredicate:predicate];
-		}
-		@catch (NSException * e) 
-		{
-			// handle any unexpected property-name behavior gracefully
-			resultsArray = [NSArray array]; //empty array
-		}
+		resultsArray = [searchFilter filteredArrayFromArray:self.items withSearchText:sbar.text];
 		
 		// Check for custom results
 		NSArray *customResultsArray;
-		if([self.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-		   && [self.dataSource respondsToSelector:@selector(tableViewModel:customSearchResultForSearchText:autoSearchResults:)])
+		if([self dataSourceRespondsTo:SCDataSourceCapabilityCustomSearchResultForSearchText])
 		{
 			customResultsArray = [self.dataSource tableViewModel:self customSearchResultForSearchText:searchText
 											   autoSearchResults:resultsArray];
@@ -186,6 +186,18 @@
 /*! Provides subclasses with the framework to bind an SCTableViewSection to a value */
 @property (nonatomic, retain) NSObject *boundValue;
 
+/*! Method gets called internally by framework to get the height of the cell at the given index without
+ *	requesting the cell itself. Returns 0 if no height has been cached. */
+- (CGFloat)cachedHeightForCellAtIndex:(NSUInteger)index;
+
+/*! Method gets called internally by framework to get the cells whose values determine valuesAreValid.
+ *	Subclasses that override valuesAreValid should also override this method. */
+- (NSArray *)cellsForValidation;
+
+/*! Method gets called internally by framework after the cell at the given index has been measured
+ *	for its row height. */
+- (void)didMeasureCell:(SCTableViewCell *)cell withHeight:(CGFloat)height atIndex:(NSUInteger)index;
+
 
 @end
 
@@ -210,9 +222,27 @@
  *
  *	See also: SCArrayOfObjectsSection, SCObjectCell.
  */
+/* Lightweight row descriptor kept by a virtualized SCObjectSection for each of its rows. */
+typedef struct
+{
+	NSUInteger propertyIndex;	// index of the generating property definition, NSNotFound for added cells
+	CGFloat height;				// last measured row height, 0 if not measured yet
+	NSInteger validity;			// 1 if valid, 0 if invalid, -1 if unknown
+} SCCellDescriptor;
+
+
 @interface SCObjectSection : SCTableViewSection
 {
 	SCClassDefinition *boundObjectClassDefinition;
+	
+	BOOL virtualizesCells;
+	NSUInteger cellPoolSize;
+	
+	//internal
+	SCCellDescriptor *cellDescriptors;
+	NSUInteger cellDescriptorCount;
+	NSUInteger cellDescriptorCapacity;
+	NSMutableDictionary *pooledCells;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -257,6 +287,20 @@
 		  withBoundObject:(NSObject *)object
 	  withClassDefinition:(SCClassDefinition *)classDefinition;
 
+/*! Returns an initialized %SCObjectSection given a header title, a bound object,
+ *	its extended class definition, and whether the section should virtualize its cells.
+ *
+ *	@param sectionHeaderTitle A header title for the section.
+ *	@param object The object that %SCObjectSection will use to generate its cells.
+ *	@param classDefinition The extended class definition for the object.
+ *	@param virtualize Set to TRUE for the section to keep only a bounded number of cells in memory.
+ *	See virtualizesCells.
+ */
+- (id)initWithHeaderTitle:(NSString *)sectionHeaderTitle
+		  withBoundObject:(NSObject *)object
+	  withClassDefinition:(SCClassDefinition *)classDefinition
+		 virtualizesCells:(BOOL)virtualize;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 /// @name Cell Management
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -267,6 +311,18 @@
  *	if the property name does not exist within the bound object. */
 - (SCTableViewCell *)cellForPropertyName:(NSString *)propertyName;
 
+/*! TRUE if the section only keeps a lightweight descriptor for each of its rows, and generates
+ *	the actual cells on demand for the visible rows plus a small margin. Cells that go beyond
+ *	cellPoolSize are released, unless they are active, have uncommitted changes, have invalid
+ *	values, or are displayed. Use this mode for very large generated forms. Default: FALSE. 
+ *
+ *	Note: In this mode, cellAtIndex: might return a different cell instance each time it's called
+ *	for a row that is not displayed. */
+@property (nonatomic, readonly) BOOL virtualizesCells;
+
+/*! The maximum number of cells a virtualized section keeps in memory. Default: 24. */
+@property (nonatomic, readwrite) NSUInteger cellPoolSize;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 /// @name Other
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -325,6 +381,7 @@
 	NSIndexPath *selectedCellIndexPath;
 	UIBarButtonItem *addButtonItem;
 	NSObject *tempItem;		//used for temporarily storing newly added items
+	NSMutableArray *measuredCells;	//cells created only to measure row heights, reused by cellAtIndex:
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -545,6 +602,8 @@
 	
 	NSMutableSet *itemsSet;
 	BOOL sortItemsSetAscending;
+	NSArray *itemsSetSortedItems;
+	NSMutableArray *itemsSetSortKeys;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -896,7 +955,7 @@ withSelectedIndexPropertyName:(NSString *)propertyName
 @property (nonatomic, copy) NSNumber *selectedItemIndex;
 
 /*! This property reflects the current section's selection(s). You can add index(es) to the set
- *	to define the section's selection.
+ *	to define the section's selection. Unless bound to your own set, this is an SCSelectionSet.
  *
  *	Note: If you have bound this section to an object or a key, you can define the section's selection
  *	using either the bound property value or the key value, respectively. */
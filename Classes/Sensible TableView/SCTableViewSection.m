@@ -118,6 +118,22 @@
 	[super dealloc];
 }
 
+- (void)setHeaderTitle:(NSString *)title
+{
+	[headerTitle release];
+	headerTitle = [title copy];
+	
+	[self.ownerTableViewModel invalidateSectionIndexTitles];
+}
+
+- (void)setOwnerTableViewModel:(SCTableViewModel *)model
+{
+	ownerTableViewModel = model;
+	
+	for(SCTableViewCell *cell in cells)
+		cell.ownerTableViewModel = model;
+}
+
 - (NSComparisonResult)compare:(SCTableViewSection *)section
 {
 	if(!self.headerTitle)
@@ -197,6 +213,7 @@
 	cell.ownerTableViewModel = self.ownerTableViewModel;
 	cell.commitChangesLive = self.commitCellChangesLive;
 	[cells addObject:cell];
+	[self.ownerTableViewModel setNeedsValidation];
 }
 
 - (void)insertCell:(SCTableViewCell *)cell atIndex:(NSUInteger)index
@@ -204,6 +221,7 @@
 	cell.ownerTableViewModel = self.ownerTableViewModel;
 	cell.commitChangesLive = self.commitCellChangesLive;
 	[cells insertObject:cell atIndex:index];
+	[self.ownerTableViewModel setNeedsValidation];
 }
 
 - (SCTableViewCell *)cellAtIndex:(NSUInteger)index
@@ -224,6 +242,7 @@
     }
 	
 	[cells removeObjectAtIndex:index];
+	[self.ownerTableViewModel setNeedsValidation];
 }
 
 - (NSUInteger)indexForCell:(SCTableViewCell *)cell
@@ -252,6 +271,21 @@
 		[cell reloadBoundValue];
 }
 
+- (NSArray *)cellsForValidation
+{
+	return cells;
+}
+
+- (CGFloat)cachedHeightForCellAtIndex:(NSUInteger)index
+{
+	return 0;
+}
+
+- (void)didMeasureCell:(SCTableViewCell *)cell withHeight:(CGFloat)height atIndex:(NSUInteger)index
+{
+	// does nothing, cells are held by the section and measured directly
+}
+
 @end
 
 
@@ -263,12 +297,22 @@
 - (SCTableViewCell *)getCellForPropertyWithDefinition:(SCPropertyDefinition *)propertyDefinition
 								withUIElementDelegate:(id)uiElementDelegate;
 
+- (void)insertDescriptorAtIndex:(NSUInteger)index forPropertyAtIndex:(NSUInteger)propertyIndex;
+- (void)removeDescriptorAtIndex:(NSUInteger)index;
+- (void)shiftPooledCellsFromIndex:(NSUInteger)index by:(NSInteger)offset;
+- (SCTableViewCell *)materializeCellAtIndex:(NSUInteger)index;
+- (BOOL)canEvictCell:(SCTableViewCell *)cell atIndex:(NSUInteger)index;
+- (void)evictCellAtIndex:(NSUInteger)index;
+- (void)trimCellPoolKeepingIndex:(NSUInteger)index;
+
 @end
 
 
 @implementation SCObjectSection
 
 @synthesize boundObjectClassDefinition;
+@synthesize virtualizesCells;
+@synthesize cellPoolSize;
 
 + (id)sectionWithHeaderTitle:(NSString *)sectionHeaderTitle
 			 withBoundObject:(NSObject *)object
@@ -296,9 +340,27 @@
 - (id)initWithHeaderTitle:(NSString *)sectionHeaderTitle
 		  withBoundObject:(NSObject *)object
 	  withClassDefinition:(SCClassDefinition *)classDefinition
+{
+	return [self initWithHeaderTitle:sectionHeaderTitle withBoundObject:object 
+				 withClassDefinition:classDefinition virtualizesCells:FALSE];
+}
+
+- (id)initWithHeaderTitle:(NSString *)sectionHeaderTitle
+		  withBoundObject:(NSObject *)object
+	  withClassDefinition:(SCClassDefinition *)classDefinition
+		 virtualizesCells:(BOOL)virtualize
 {
 	[self initWithHeaderTitle:sectionHeaderTitle];
 	
+	virtualizesCells = virtualize;
+	cellPoolSize = SC_DefaultCellPoolSize;
+	cellDescriptors = NULL;
+	cellDescriptorCount = 0;
+	cellDescriptorCapacity = 0;
+	pooledCells = nil;
+	if(virtualizesCells)
+		pooledCells = [[NSMutableDictionary alloc] init];
+	
 	if(!object)
 		return self;
 	
@@ -333,15 +395,35 @@
 	// Generate cells based on classDefinition
 	for(int i=0; i<boundObjectClassDefinition.propertyDefinitionCount; i++)
 	{
+		// A virtualized section only keeps the first cellPoolSize cells, the rest are released
+		// right away after their descriptors have been recorded.
+		NSAutoreleasePool *pool = nil;
+		if(virtualizesCells)
+			pool = [[NSAutoreleasePool alloc] init];
+		
 		SCPropertyDefinition *propertyDefinition = [boundObjectClassDefinition propertyDefinitionAtIndex:i];
 		SCTableViewCell *cell = [self getCellForPropertyWithDefinition:propertyDefinition
 												 withUIElementDelegate:boundObjectClassDefinition.uiElementDelegate];
 		if(cell)
 		{
 			cell.tag = i;
-			[self addCell:cell];
+			if(virtualizesCells)
+			{
+				NSUInteger index = cellDescriptorCount;
+				[self insertDescriptorAtIndex:index forPropertyAtIndex:i];
+				cellDescriptors[index].height = cell.height;
+				cellDescriptors[index].validity = cell.valueIsValid ? 1 : 0;
+				if(pooledCells.count < cellPoolSize)
+				{
+					cell.commitChangesLive = self.commitCellChangesLive;
+					[pooledCells setObject:cell forKey:[NSNumber numberWithUnsignedInteger:index]];
+				}
+			}
+			else
+				[self addCell:cell];
 		}
 		
+		[pool drain];
 	}
 	
 	return self;
@@ -350,10 +432,338 @@
 - (void)dealloc
 {
 	[boundObjectClassDefinition release];
+	[pooledCells release];
+	free(cellDescriptors);
 	
 	[super dealloc];
 }
 
+- (void)insertDescriptorAtIndex:(NSUInteger)index forPropertyAtIndex:(NSUInteger)propertyIndex
+{
+	if(cellDescriptorCount == cellDescriptorCapacity)
+	{
+		cellDescriptorCapacity = cellDescriptorCapacity ? cellDescriptorCapacity*2 : 16;
+		cellDescriptors = realloc(cellDescriptors, cellDescriptorCapacity*sizeof(SCCellDescriptor));
+	}
+	if(index < cellDescriptorCount)
+	{
+		memmove(&cellDescriptors[index+1], &cellDescriptors[index], 
+				(cellDescriptorCount-index)*sizeof(SCCellDescriptor));
+		[self shiftPooledCellsFromIndex:index by:1];
+	}
+	cellDescriptorCount++;
+	
+	cellDescriptors[index].propertyIndex = propertyIndex;
+	cellDescriptors[index].height = 0;
+	cellDescriptors[index].validity = -1;
+}
+
+- (void)removeDescriptorAtIndex:(NSUInteger)index
+{
+	[pooledCells removeObjectForKey:[NSNumber numberWithUnsignedInteger:index]];
+	
+	memmove(&cellDescriptors[index], &cellDescriptors[index+1], 
+			(cellDescriptorCount-index-1)*sizeof(SCCellDescriptor));
+	cellDescriptorCount--;
+	[self shiftPooledCellsFromIndex:index+1 by:-1];
+}
+
+- (void)shiftPooledCellsFromIndex:(NSUInteger)index by:(NSInteger)offset
+{
+	NSMutableDictionary *shiftedCells = [[NSMutableDictionary alloc] initWithCapacity:pooledCells.count];
+	for(NSNumber *key in pooledCells)
+	{
+		NSUInteger cellIndex = [key unsignedIntegerValue];
+		if(cellIndex >= index)
+			cellIndex += offset;
+		[shiftedCells setObject:[pooledCells objectForKey:key] 
+						 forKey:[NSNumber numberWithUnsignedInteger:cellIndex]];
+	}
+	[pooledCells release];
+	pooledCells = shiftedCells;
+}
+
+- (SCTableViewCell *)materializeCellAtIndex:(NSUInteger)index
+{
+	NSNumber *key = [NSNumber numberWithUnsignedInteger:index];
+	SCTableViewCell *cell = [pooledCells objectForKey:key];
+	if(cell)
+		return cell;
+	
+	SCCellDescriptor *descriptor = &cellDescriptors[index];
+	SCPropertyDefinition *propertyDefinition = 
+		[boundObjectClassDefinition propertyDefinitionAtIndex:descriptor->propertyIndex];
+	cell = [self getCellForPropertyWithDefinition:propertyDefinition
+							withUIElementDelegate:boundObjectClassDefinition.uiElementDelegate];
+	if(!cell)
+		return nil;
+	
+	cell.tag = descriptor->propertyIndex;
+	cell.ownerTableViewModel = self.ownerTableViewModel;
+	cell.commitChangesLive = self.commitCellChangesLive;
+	[pooledCells setObject:cell forKey:key];
+	[self trimCellPoolKeepingIndex:index];
+	
+	return [[cell retain] autorelease];
+}
+
+- (BOOL)canEvictCell:(SCTableViewCell *)cell atIndex:(NSUInteger)index
+{
+	// Manually added cells have no property definition to be regenerated from
+	if(cellDescriptors[index].propertyIndex == NSNotFound)
+		return FALSE;
+	
+	// Cells validated by a delegate are kept, as their validity can change with other cells' values
+	return (cell != self.ownerTableViewModel.activeCell && !cell.superview 
+			&& !cell.needsCommit && cell.autoValidateValue && cell.valueIsValid);
+}
+
+- (void)evictCellAtIndex:(NSUInteger)index
+{
+	NSNumber *key = [NSNumber numberWithUnsignedInteger:index];
+	SCTableViewCell *cell = [pooledCells objectForKey:key];
+	
+	cellDescriptors[index].height = cell.height;
+	cellDescriptors[index].validity = 1;
+	[pooledCells removeObjectForKey:key];
+}
+
+- (void)trimCellPoolKeepingIndex:(NSUInteger)index
+{
+	if(pooledCells.count <= cellPoolSize)
+		return;
+	
+	// Determine the visible window of the section
+	NSUInteger firstVisibleIndex = index;
+	NSUInteger lastVisibleIndex = index;
+	NSUInteger sectionIndex = [self.ownerTableViewModel indexForSection:self];
+	for(NSIndexPath *indexPath in [self.ownerTableViewModel.modeledTableView indexPathsForVisibleRows])
+	{
+		if(indexPath.section != sectionIndex)
+			continue;
+		if(indexPath.row < firstVisibleIndex)
+			firstVisibleIndex = indexPath.row;
+		if(indexPath.row > lastVisibleIndex)
+			lastVisibleIndex = indexPath.row;
+	}
+	
+	// Evict the cells farthest away from the visible window first
+	while(pooledCells.count > cellPoolSize)
+	{
+		NSUInteger evictIndex = NSNotFound;
+		NSUInteger evictDistance = 0;
+		for(NSNumber *key in pooledCells)
+		{
+			NSUInteger cellIndex = [key unsignedIntegerValue];
+			NSUInteger distance;
+			if(cellIndex < firstVisibleIndex)
+				distance = firstVisibleIndex - cellIndex;
+			else
+				if(cellIndex > lastVisibleIndex)
+					distance = cellIndex - lastVisibleIndex;
+				else
+					continue;
+			
+			if(distance > evictDistance && [self canEvictCell:[pooledCells objectForKey:key] atIndex:cellIndex])
+			{
+				evictIndex = cellIndex;
+				evictDistance = distance;
+			}
+		}
+		
+		if(evictIndex == NSNotFound)
+			break;	// all pooled cells are in use
+		[self evictCellAtIndex:evictIndex];
+	}
+}
+
+// override superclass method
+- (void)setOwnerTableViewModel:(SCTableViewModel *)model
+{
+	[super setOwnerTableViewModel:model];
+	
+	for(SCTableViewCell *cell in [pooledCells allValues])
+		cell.ownerTableViewModel = model;
+}
+
+// override superclass method
+- (void)setCommitCellChangesLive:(BOOL)commit
+{
+	[super setCommitCellChangesLive:commit];
+	
+	for(SCTableViewCell *cell in [pooledCells allValues])
+		cell.commitChangesLive = commit;
+}
+
+// override superclass method
+- (NSUInteger)cellCount
+{
+	if(!virtualizesCells)
+		return [super cellCount];
+	
+	return cellDescriptorCount;
+}
+
+// override superclass method
+- (void)addCell:(SCTableViewCell *)cell
+{
+	if(!virtualizesCells)
+	{
+		[super addCell:cell];
+		return;
+	}
+	
+	[self insertCell:cell atIndex:cellDescriptorCount];
+}
+
+// override superclass method
+- (void)insertCell:(SCTableViewCell *)cell atIndex:(NSUInteger)index
+{
+	if(!virtualizesCells)
+	{
+		[super insertCell:cell atIndex:index];
+		return;
+	}
+	
+	cell.ownerTableViewModel = self.ownerTableViewModel;
+	cell.commitChangesLive = self.commitCellChangesLive;
+	[self insertDescriptorAtIndex:index forPropertyAtIndex:NSNotFound];
+	[pooledCells setObject:cell forKey:[NSNumber numberWithUnsignedInteger:index]];
+	[self.ownerTableViewModel setNeedsValidation];
+}
+
+// override superclass method
+- (SCTableViewCell *)cellAtIndex:(NSUInteger)index
+{
+	if(!virtualizesCells)
+		return [super cellAtIndex:index];
+	
+	if(index < cellDescriptorCount)
+		return [self materializeCellAtIndex:index];
+	//else
+	return nil;
+}
+
+// override superclass method
+- (void)removeCellAtIndex:(NSUInteger)index
+{
+	if(!virtualizesCells)
+	{
+		[super removeCellAtIndex:index];
+		return;
+	}
+	
+	SCTableViewCell *cell = [pooledCells objectForKey:[NSNumber numberWithUnsignedInteger:index]];
+	if(cell && self.ownerTableViewModel.activeCell == cell)
+	{
+		self.ownerTableViewModel.activeCell = nil;
+	}
+	
+	[self removeDescriptorAtIndex:index];
+	[self.ownerTableViewModel setNeedsValidation];
+}
+
+// override superclass method
+- (NSUInteger)indexForCell:(SCTableViewCell *)cell
+{
+	if(!virtualizesCells)
+		return [super indexForCell:cell];
+	
+	for(NSNumber *key in pooledCells)
+	{
+		if([pooledCells objectForKey:key] == cell)
+			return [key unsignedIntegerValue];
+	}
+	return NSNotFound;
+}
+
+// override superclass method
+- (BOOL)valuesAreValid
+{
+	if(!virtualizesCells)
+		return [super valuesAreValid];
+	
+	for(NSUInteger i=0; i<cellDescriptorCount; i++)
+	{
+		SCTableViewCell *cell = [pooledCells objectForKey:[NSNumber numberWithUnsignedInteger:i]];
+		if(!cell && cellDescriptors[i].validity == -1)
+			cell = [self materializeCellAtIndex:i];
+		
+		if(cell)
+		{
+			if(!cell.valueIsValid)
+				return FALSE;
+		}
+		else
+			if(!cellDescriptors[i].validity)
+				return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// override superclass method
+- (NSArray *)cellsForValidation
+{
+	if(!virtualizesCells)
+		return [super cellsForValidation];
+	
+	// Released cells were valid, only the remaining rows need their cells
+	for(NSUInteger i=0; i<cellDescriptorCount; i++)
+	{
+		if(cellDescriptors[i].validity != 1)
+			[self materializeCellAtIndex:i];
+	}
+	return [pooledCells allValues];
+}
+
+// override superclass method
+- (void)commitCellChanges
+{
+	if(!virtualizesCells)
+	{
+		[super commitCellChanges];
+		return;
+	}
+	
+	// Released cells never have uncommitted changes
+	for(SCTableViewCell *cell in [pooledCells allValues])
+		[cell commitChanges];
+}
+
+// override superclass method
+- (void)reloadBoundValues
+{
+	if(!virtualizesCells)
+	{
+		[super reloadBoundValues];
+		return;
+	}
+	
+	for(NSUInteger i=0; i<cellDescriptorCount; i++)
+		cellDescriptors[i].validity = -1;
+	for(SCTableViewCell *cell in [pooledCells allValues])
+		[cell reloadBoundValue];
+}
+
+// override superclass method
+- (CGFloat)cachedHeightForCellAtIndex:(NSUInteger)index
+{
+	// Generated cells are always measured directly, as their height can change while displayed
+	if(!virtualizesCells || index >= cellDescriptorCount
+	   || [pooledCells objectForKey:[NSNumber numberWithUnsignedInteger:index]])
+		return 0;
+	
+	return cellDescriptors[index].height;
+}
+
+// override superclass method
+- (void)didMeasureCell:(SCTableViewCell *)cell withHeight:(CGFloat)height atIndex:(NSUInteger)index
+{
+	if(virtualizesCells && index < cellDescriptorCount)
+		cellDescriptors[index].height = height;
+}
+
 - (SCTableViewCell *)getCellForPropertyWithDefinition:(SCPropertyDefinition *)propertyDefinition
 								withUIElementDelegate:(id)uiElementDelegate
 {
@@ -652,6 +1062,27 @@
 
 - (SCTableViewCell *)cellForPropertyName:(NSString *)propertyName
 {
+	if(virtualizesCells)
+	{
+		for(NSUInteger i=0; i<cellDescriptorCount; i++)
+		{
+			NSUInteger propertyIndex = cellDescriptors[i].propertyIndex;
+			if(propertyIndex == NSNotFound)
+			{
+				SCTableViewCell *cell = [pooledCells objectForKey:[NSNumber numberWithUnsignedInteger:i]];
+				if([cell.boundPropertyName isEqualToString:propertyName])
+					return cell;
+			}
+			else
+				if([[boundObjectClassDefinition propertyDefinitionAtIndex:propertyIndex].name 
+					isEqualToString:propertyName])
+				{
+					return [self materializeCellAtIndex:i];
+				}
+		}
+		return nil;
+	}
+	
 	for(SCTableViewCell *cell in cells)
 	{
 		if([cell.boundPropertyName isEqualToString:propertyName])
@@ -728,6 +1159,7 @@
 		selectedCellIndexPath = nil;
 		addButtonItem = nil;
 		tempItem = nil;
+		measuredCells = [[NSMutableArray alloc] init];
 	}
 	
 	return self;
@@ -751,6 +1183,7 @@
 	[addButtonItem release];
 	[tempItem release];
 	[cellIdentifier release];
+	[measuredCells release];
 	[super dealloc];
 }
 
@@ -778,11 +1211,17 @@
 	SCTableViewCell *cell = (SCTableViewCell *)[self.ownerTableViewModel.modeledTableView 
 							 dequeueReusableCellWithIdentifier:self.cellIdentifier];
 	
+	// Reuse a cell previously created only to measure a row height
+	if(cell == nil && measuredCells.count)
+	{
+		cell = [[[measuredCells lastObject] retain] autorelease];
+		[measuredCells removeLastObject];
+	}
+	
     if(cell == nil) 
 	{
 		// Check if the user provides their own custom cell
-		if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-		   && [self.ownerTableViewModel.dataSource respondsToSelector:@selector(tableViewModel:customCellForRowAtIndexPath:)])
+		if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomCellForRowAtIndexPath])
 		{
 			NSIndexPath *indexPath = [NSIndexPath indexPathForRow:index 
 														inSection:[self.ownerTableViewModel indexForSection:self]];
@@ -805,9 +1244,7 @@
 		[cell.delegate willConfigureCell:cell];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:willConfigureCell:forRowAtIndexPath:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityWillConfigureCell])
 		{
 			NSIndexPath *indexPath = [NSIndexPath indexPathForRow:index 
 														inSection:[self.ownerTableViewModel indexForSection:self]];
@@ -818,6 +1255,18 @@
     return cell;
 }
 
+// override superclass method
+- (void)didMeasureCell:(SCTableViewCell *)cell withHeight:(CGFloat)height atIndex:(NSUInteger)index
+{
+	// Cells that are not displayed can be recycled by the next cellAtIndex: call instead
+	// of creating a new cell for each measured row.
+	if(!cell.superview && measuredCells.count < SC_DefaultCellPoolSize 
+	   && [measuredCells indexOfObjectIdenticalTo:cell] == NSNotFound)
+	{
+		[measuredCells addObject:cell];
+	}
+}
+
 // override superclass method
 - (NSUInteger)indexForCell:(SCTableViewCell *)cell
 {
@@ -878,9 +1327,7 @@
 - (SCTableViewModel *)getCustomDetailModelForRowAtIndexPath:(NSIndexPath *)indexPath
 {
 	SCTableViewModel *detailModel = nil;
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:customDetailTableViewModelForRowAtIndexPath:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityCustomDetailTableViewModelForRowAtIndexPath])
 	{
 		detailModel = [self.ownerTableViewModel.dataSource tableViewModel:self.ownerTableViewModel
 							  customDetailTableViewModelForRowAtIndexPath:indexPath];
@@ -942,9 +1389,7 @@
 		self.ownerTableViewModel.viewController.contentSizeForViewInPopover;
 #endif	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForRowAtIndexPath:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForRowAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 					  detailModelCreatedForRowAtIndexPath:indexPath
@@ -961,9 +1406,7 @@
 		[cell.delegate detailViewWillAppearForCell:cell withDetailTableViewModel:detailViewController.tableViewModel];
 	}
 	else
-		if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-		   && [self.ownerTableViewModel.delegate 
-			   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForRowAtIndexPath:withDetailTableViewModel:)])
+		if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForRowAtIndexPath])
 		{
 			[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel 
 						detailViewWillAppearForRowAtIndexPath:indexPath 
@@ -1024,9 +1467,7 @@
 	
 	NSUInteger index = [ownerTableViewModel indexForSection:self];
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:itemCreatedForSectionAtIndex:item:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityItemCreatedForSectionAtIndex])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 							 itemCreatedForSectionAtIndex:index
@@ -1048,9 +1489,7 @@
 			self.ownerTableViewModel.viewController.contentSizeForViewInPopover;
 #endif	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailModelCreatedForSectionAtIndex:detailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailModelCreatedForSectionAtIndex])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 					  detailModelCreatedForSectionAtIndex:index
@@ -1060,9 +1499,7 @@
 	[self buildDetailTableModel:detailViewController.tableViewModel
 						forItem:tempItem];
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailViewWillAppearForSectionAtIndex:withDetailTableViewModel:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillAppearForSectionAtIndex])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 					detailViewWillAppearForSectionAtIndex:index
@@ -1111,8 +1548,7 @@
 		forCellAtIndexPath:(NSIndexPath *)indexPath
 {
 	BOOL shouldRemove = TRUE;
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:willRemoveRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityWillRemoveRowAtIndexPath])
 	{
 		shouldRemove = [self.ownerTableViewModel.delegate 
 						tableViewModel:self.ownerTableViewModel willRemoveRowAtIndexPath:indexPath];
@@ -1142,8 +1578,7 @@
 	[indexPaths release];
 	
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didRemoveRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidRemoveRowAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didRemoveRowAtIndexPath:indexPath];
 	}
@@ -1172,9 +1607,7 @@
 - (NSObject *)createNewItem
 {
 	// If supported, have datasource create the new item
-	if([self.ownerTableViewModel.dataSource conformsToProtocol:@protocol(SCTableViewModelDataSource)]
-	   && [self.ownerTableViewModel.dataSource 
-		   respondsToSelector:@selector(tableViewModel:newItemForArrayOfItemsSectionAtIndex:)])
+	if([self.ownerTableViewModel dataSourceRespondsTo:SCDataSourceCapabilityNewItemForArrayOfItemsSectionAtIndex])
 	{
 		return [self.ownerTableViewModel.dataSource tableViewModel:self.ownerTableViewModel
 							  newItemForArrayOfItemsSectionAtIndex:[self.ownerTableViewModel indexForSection:self]];
@@ -1207,9 +1640,7 @@
 {
 	[self.ownerTableViewModel prepareModelForCustomDetailViewDisappearing];
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailViewWillDisappearForSectionAtIndex:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewWillDisappearForSectionAtIndex])
 	{
 		NSUInteger index = [ownerTableViewModel indexForSection:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -1220,9 +1651,7 @@
 - (void)tableViewControllerDidDisappear:(SCTableViewController *)tableViewController 
 					 cancelButtonTapped:(BOOL)cancelTapped doneButtonTapped:(BOOL)doneTapped
 {
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:detailViewDidDisappearForSectionAtIndex:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDetailViewDidDisappearForSectionAtIndex])
 	{
 		NSUInteger index = [ownerTableViewModel indexForSection:self];
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
@@ -1286,17 +1715,14 @@
 	[self.ownerTableViewModel.modeledTableView selectRowAtIndexPath:newRowIndexPath animated:TRUE 
 													 scrollPosition:UITableViewScrollPositionNone];
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:itemAddedForSectionAtIndexPath:item:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityItemAddedForSectionAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 						   itemAddedForSectionAtIndexPath:newRowIndexPath
 													 item:newItem];
 	}
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didInsertRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidInsertRowAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel didInsertRowAtIndexPath:newRowIndexPath];
 	}
@@ -1309,9 +1735,7 @@
 	SCTextFieldCell *textFieldCell = (SCTextFieldCell *)[detailModel
 														 cellAtIndexPath:textFieldCellIndexPath];
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:itemEditedForSectionAtIndexPath:item:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityItemEditedForSectionAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 						  itemEditedForSectionAtIndexPath:textFieldCellIndexPath
@@ -1480,6 +1904,8 @@
 		
 		itemsSet = nil;
 		sortItemsSetAscending = TRUE;
+		itemsSetSortedItems = nil;
+		itemsSetSortKeys = nil;
 	}
 	
 	return self;
@@ -1589,6 +2015,8 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	[itemsPredicate release];
 	[itemsClassDefinitions release];
 	[itemsSet release];
+	[itemsSetSortedItems release];
+	[itemsSetSortKeys release];
 	
 	if(coreDataBound)
 	{
@@ -1661,12 +2089,11 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	
 	if(objectClassDef.descriptionPropertyName)
 	{
-#ifdef _COREDATADEFINES_H
-		if([object isKindOfClass:[NSManagedObject class]])
-			return [NSString stringWithFormat:@"%@", [(NSManagedObject *)object valueForKeyPath:objectClassDef.descriptionPropertyName]];
-#endif		
+		id value = [objectClassDef descriptionValueForObject:object];
+		if([value isKindOfClass:[NSString class]])
+			return value;
 		//else
-		return [NSString stringWithFormat:@"%@", [object valueForKey:objectClassDef.descriptionPropertyName]];
+		return [NSString stringWithFormat:@"%@", value];
 	}
 	
 	//else
@@ -1734,30 +2161,24 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 // override superclass method
 - (void)addNewItem:(NSObject *)newItem
 {
-	[items addObject:newItem];
-	
+	NSUInteger newItemIndex = items.count;
 	if(coreDataBound)
 	{
-		// Sort the items array (if key is sortable)
-		NSSortDescriptor *descriptor = [[NSSortDescriptor alloc] 
-										initWithKey:[self firstClassDefinition].keyPropertyName
-										ascending:self.sortItemsSetAscending];
+		// Items are already sorted, binary search for the new item's position (if key is sortable)
 		@try 
 		{
-			[items sortUsingDescriptors:[NSArray arrayWithObject:descriptor]];
+			newItemIndex = [SCHelper insertionIndexForObject:newItem inArray:items
+												 sortedByKey:[self firstClassDefinition].keyPropertyName
+												   ascending:self.sortItemsSetAscending];
 		}
 		@catch (NSException * e) 
 		{
 			// do nothing (do not sort)
 		}
-		@finally 
-		{
-			[descriptor release];
-		}
 	}
+	[items insertObject:newItem atIndex:newItemIndex];
 	
 	NSUInteger sectionIndex = [self.ownerTableViewModel indexForSection:self];
-	NSUInteger newItemIndex = [items indexOfObjectIdenticalTo:newItem];
 	
 	NSIndexPath *newRowIndexPath = [NSIndexPath indexPathForRow:newItemIndex inSection:sectionIndex];
 	NSArray *indexPaths = [NSArray arrayWithObject:newRowIndexPath];
@@ -1769,17 +2190,14 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	[self.ownerTableViewModel.modeledTableView selectRowAtIndexPath:newRowIndexPath animated:TRUE 
 													 scrollPosition:UITableViewScrollPositionNone];
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:itemAddedForSectionAtIndexPath:item:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityItemAddedForSectionAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 						   itemAddedForSectionAtIndexPath:newRowIndexPath
 													 item:newItem];
 	}
 	
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate respondsToSelector:@selector(tableViewModel:didInsertRowAtIndexPath:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityDidInsertRowAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel 
 								  didInsertRowAtIndexPath:newRowIndexPath];
@@ -1817,9 +2235,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 // override superclass method
 - (void)commitDetailModelChanges:(SCTableViewModel *)detailModel
 {
-	if([self.ownerTableViewModel.delegate conformsToProtocol:@protocol(SCTableViewModelDelegate)]
-	   && [self.ownerTableViewModel.delegate 
-		   respondsToSelector:@selector(tableViewModel:itemEditedForSectionAtIndexPath:item:)])
+	if([self.ownerTableViewModel delegateRespondsTo:SCDelegateCapabilityItemEditedForSectionAtIndexPath])
 	{
 		[self.ownerTableViewModel.delegate tableViewModel:self.ownerTableViewModel
 						  itemEditedForSectionAtIndexPath:selectedCellIndexPath
@@ -1931,6 +2347,21 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 
 -(void)setSortItemsSetAscending:(BOOL)ascending
 {
+	// If items still hold the last sort result, the opposite order is just its reverse
+	if(ascending!=sortItemsSetAscending && itemsSetSortKeys 
+	   && [itemsSetSortedItems count]==[self.itemsSet count] && [itemsSetSortedItems isEqualToArray:self.items])
+	{
+		sortItemsSetAscending = ascending;
+		
+		NSMutableArray *reversedArray = [NSMutableArray arrayWithArray:self.items];
+		[SCHelper reverseSortedArray:reversedArray withSortKeys:itemsSetSortKeys];
+		[itemsSetSortedItems release];
+		itemsSetSortedItems = [[NSArray alloc] initWithArray:reversedArray];
+		
+		self.items = reversedArray;
+		return;
+	}
+	
 	sortItemsSetAscending = ascending;
 	[self generateItemsArrayFromItemsSet];
 }
@@ -1965,18 +2396,25 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 
 - (void)generateItemsArrayFromItemsSet
 {
+	[itemsSetSortedItems release];
+	itemsSetSortedItems = nil;
+	[itemsSetSortKeys release];
+	itemsSetSortKeys = nil;
+	
 	if(!self.itemsSet)
 	{
 		self.items = nil;
 		return;
 	}
 	
-	NSMutableArray *sortedArray = [NSMutableArray arrayWithArray:[self.itemsSet allObjects]]; 
-	NSSortDescriptor *descriptor = [[NSSortDescriptor alloc] 
-									initWithKey:[self firstClassDefinition].keyPropertyName
-									ascending:self.sortItemsSetAscending];
-	[sortedArray sortUsingDescriptors:[NSArray arrayWithObject:descriptor]];
-	[descriptor release];
+	// Key values are extracted once and kept, so that toggling sortItemsSetAscending can reuse them
+	NSMutableArray *sortKeys = nil;
+	NSMutableArray *sortedArray = [SCHelper sortedArrayWithObjects:[self.itemsSet allObjects]
+															 byKey:[self firstClassDefinition].keyPropertyName
+														 ascending:self.sortItemsSetAscending
+														  sortKeys:&sortKeys];
+	itemsSetSortKeys = [sortKeys retain];
+	itemsSetSortedItems = [[NSArray alloc] initWithArray:sortedArray];
 	
 	self.items = sortedArray;
 }
@@ -2025,6 +2463,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 
 @interface SCSelectionSection ()
 
+- (BOOL)isItemIndexSelected:(NSUInteger)index;
 - (void)buildSelectedItemsIndexesFromString:(NSString *)string;
 - (NSString *)buildStringFromSelectedItemsIndexes;
 
@@ -2108,7 +2547,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 		allowMultipleSelection = FALSE;
 		allowNoSelection = FALSE;
 		autoDismissViewController = FALSE;
-		_selectedItemsIndexes = [[NSMutableSet alloc] init];
+		_selectedItemsIndexes = [[SCSelectionSet alloc] init];
 	}
 	
 	return self;
@@ -2160,7 +2599,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 		allowMultipleSelection = multipleSelection;
 		
 		if(self.boundObject && !self.boundValue)
-			self.boundValue = [NSMutableSet set];   //Empty set
+			self.boundValue = [SCSelectionSet set];   //Empty set
 	}
 	return self;
 }
@@ -2224,7 +2663,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 		allowMultipleSelection = multipleSelection;
 		
 		if(self.boundKey && !self.boundValue)
-			self.boundValue = [NSMutableSet set];   //Empty set
+			self.boundValue = [SCSelectionSet set];   //Empty set
 	}
 	return self;
 }
@@ -2236,6 +2675,15 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	[super dealloc];
 }
 
+- (BOOL)isItemIndexSelected:(NSUInteger)index
+{
+	NSMutableSet *indexes = self.selectedItemsIndexes;
+	if([indexes isKindOfClass:[SCSelectionSet class]])
+		return [(SCSelectionSet *)indexes containsIndex:index];
+	//else
+	return [indexes containsObject:[NSNumber numberWithInt:index]];
+}
+
 - (void)buildSelectedItemsIndexesFromString:(NSString *)string
 {
 	NSArray *selectionStrings = [string componentsSeparatedByString:@";"];
@@ -2252,7 +2700,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 - (NSString *)buildStringFromSelectedItemsIndexes
 {
 	NSMutableArray *selectionStrings = [NSMutableArray arrayWithCapacity:[self.selectedItemsIndexes count]];
-	for(NSNumber *index in self.selectedItemsIndexes)
+	for(NSNumber *index in [SCSelectionSet orderedObjectsOfSet:self.selectedItemsIndexes])
 	{
 		[selectionStrings addObject:[self.items objectAtIndex:[index intValue]]];
 	}
@@ -2265,7 +2713,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 {
 	SCTableViewCell *cell = [super cellAtIndex:index];
 	
-	if([self.selectedItemsIndexes containsObject:[NSNumber numberWithInt:index]])
+	if([self isItemIndexSelected:index])
 	{
 		cell.accessoryType = UITableViewCellAccessoryCheckmark;
 		cell.textLabel.textColor = [UIColor colorWithRed:50.0f/255 green:79.0f/255 blue:133.0f/255 alpha:1];
@@ -2308,7 +2756,7 @@ withEntityClassDefinition:(SCClassDefinition *)classDefinition
 	[lastSelectedRowIndexPath release];
 	lastSelectedRowIndexPath = [indexPath retain];
 	
-	if([self.selectedItemsIndexes containsObject:itemIndex])
+	if([self isItemIndexSelected:indexPath.row])
 	{
 		if(!self.allowNoSelection && self.selectedItemsIndexes.count==1)
 		{
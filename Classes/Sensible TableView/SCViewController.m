@@ -163,6 +163,8 @@
 {
 	[super viewWillDisappear:animated];
 	
+	[self.tableViewModel commitPendingChanges];
+	
 	if([self.delegate conformsToProtocol:@protocol(SCViewControllerDelegate)]
 	   && [self.delegate respondsToSelector:
 		   @selector(viewControllerWillDisappear:cancelButtonTapped:doneButtonTapped:)])
@@ -295,6 +297,11 @@
 
 - (void)doneButtonAction
 {
+	// The button might have been tapped before the last deferred changes were committed
+	[self.tableViewModel commitPendingChanges];
+	if(!self.tableViewModel.valuesAreValid)
+		return;
+	
 	[self dismissWithCancelValue:FALSE doneValue:TRUE];
 }
 
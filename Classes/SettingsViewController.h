@@ -7,6 +7,7 @@
 //
 
 #import <UIKit/UIKit.h>
+#import <CoreData/CoreData.h>
 #import "SCTableViewModel.h"
 @class MailComposerViewController;
 
@@ -15,9 +16,13 @@
 	
 	SCTableViewModel *tableModel;
 	MailComposerViewController *mailComposerViewController;
+	
+	NSArray *backupGenerations;
+	NSManagedObjectContext *managedObjectContext;
 }
 
 @property (nonatomic, retain) id delegate;
+@property (nonatomic, retain) NSManagedObjectContext *managedObjectContext;
 
 @end
 
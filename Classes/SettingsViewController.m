@@ -10,6 +10,8 @@
 #import "RootViewController.h"
 #import "MailComposerViewController.h"
 #import "ApplicationHelper.h"
+#import "IdeaSnapshot.h"
+#import "IdeaBackup.h"
 
 @interface SettingsViewController (PrivateMethods)
 - (void)dismiss;
@@ -19,6 +21,7 @@
 @implementation SettingsViewController
 
 @synthesize delegate;
+@synthesize managedObjectContext;
 
 #pragma mark -
 #pragma mark View lifecycle
@@ -95,6 +98,30 @@
 	feedbackCell.label.lineBreakMode = UILineBreakModeWordWrap;
 	[supportSection addCell:feedbackCell];
 	
+	// Backups, tapping one adds a copy of it to the board
+	
+	backupGenerations = [[[IdeaBackup defaultBackup] generations] retain];
+	
+	if ([backupGenerations count] > 0) {
+		SCTableViewSection *backupsSection = [SCTableViewSection sectionWithHeaderTitle:@"Restore Backup"];
+		[tableModel addSection:backupsSection];
+		
+		NSDateFormatter *dateFormatter = [[NSDateFormatter alloc] init];
+		[dateFormatter setDateStyle:NSDateFormatterMediumStyle];
+		[dateFormatter setTimeStyle:NSDateFormatterShortStyle];
+		
+		for (NSDictionary *generation in backupGenerations) {
+			NSString *date = [dateFormatter stringFromDate:[generation objectForKey:IdeaBackupDateKey]];
+			NSUInteger ideaCount = [[generation objectForKey:IdeaBackupIdeaCountKey] unsignedIntegerValue];
+			
+			SCLabelCell *backupCell = [SCLabelCell cellWithText:date];
+			backupCell.label.text = [NSString stringWithFormat:@"%d", ideaCount];
+			[backupsSection addCell:backupCell];
+		}
+		
+		[dateFormatter release];
+	}
+	
 }
 
 #pragma mark -
@@ -125,6 +152,19 @@
 		case 2:
 			[mailComposerViewController showPicker];
 			break;
+		case 3:
+		{
+			NSDictionary *generation = [backupGenerations objectAtIndex:indexPath.row];
+			
+			IdeaRestoreOperation *restoreOperation = [[IdeaRestoreOperation alloc] initWithBackup:[IdeaBackup defaultBackup]
+																					   generation:generation
+																			 managedObjectContext:self.managedObjectContext];
+			[[IdeaSnapshot readerQueue] addOperation:restoreOperation];
+			[restoreOperation release];
+			
+			[self dismiss];
+			break;
+		}
 	}
 }
 
@@ -148,6 +188,8 @@
 - (void)dealloc {
 	[delegate release];
 	[tableModel release];
+	[backupGenerations release];
+	[managedObjectContext release];
     [super dealloc];
 }
 
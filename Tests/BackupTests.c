@@ -0,0 +1,927 @@
+//
+//  BackupTests.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/28/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Tests of the chunk index behind IdeaBackup: counting and releasing chunks by hand, reading and
+// writing the index file, and backing up and pruning a random board the way IdeaBackup does, with
+// chunks as files named after a hash of their contents. Backups and prunes are killed after every
+// file they write or remove, and whatever the step, every generation left must restore whole and
+// no chunk may be counted less than it's named.
+
+#include "IdeaBackupIndex.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s (seed %u, step %d)\n", __FILE__, __LINE__, #condition, seed, step); \
+		exit(1); \
+	} \
+} while (0)
+
+static unsigned seed;
+static int step;
+
+static char directory[256];
+
+
+#pragma mark -
+#pragma mark Files
+
+static const char *PathNamed(const char *name)
+{
+	static char paths[8][512];
+	static int next;
+	char *path = paths[next++ % 8];
+	
+	snprintf(path, 512, "%s/%s", directory, name);
+	return path;
+}
+
+static const char *ChunkPath(const char *name)
+{
+	static char path[512];
+	
+	snprintf(path, sizeof(path), "%s/Chunks/%s", directory, name);
+	return path;
+}
+
+static void WriteString(const char *path, const char *contents)
+{
+	FILE *file = fopen(path, "w");
+	
+	CHECK(file != NULL);
+	CHECK(fputs(contents, file) >= 0);
+	fclose(file);
+}
+
+static int FileExists(const char *path)
+{
+	struct stat status;
+	
+	return lstat(path, &status) == 0;
+}
+
+static void RemoveAllFiles(void)
+{
+	char command[600];
+	
+	snprintf(command, sizeof(command), "rm -rf '%s'/*", directory);
+	CHECK(system(command) == 0);
+	CHECK(mkdir(PathNamed("Chunks"), 0755) == 0);
+	CHECK(mkdir(PathNamed("Generations"), 0755) == 0);
+}
+
+// Sorted, so that generations come oldest first
+static int CompareNames(const void *a, const void *b)
+{
+	return strcmp((const char *)a, (const char *)b);
+}
+
+static void ListDirectory(const char *path, IdeaBackupChunkName **names, size_t *count)
+{
+	DIR *dir = opendir(path);
+	struct dirent *entry;
+	size_t capacity = 0;
+	
+	CHECK(dir != NULL);
+	*names = NULL;
+	*count = 0;
+	
+	while ((entry = readdir(dir)) != NULL) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+		if (*count == capacity) {
+			capacity = capacity ? 2 * capacity : 64;
+			*names = realloc(*names, capacity * sizeof(IdeaBackupChunkName));
+			CHECK(*names != NULL);
+		}
+		CHECK(strlen(entry->d_name) <= IDEA_BACKUP_CHUNK_NAME_LENGTH);
+		strcpy((*names)[(*count)++], entry->d_name);
+	}
+	closedir(dir);
+	
+	if (*count > 0) {
+		qsort(*names, *count, sizeof(IdeaBackupChunkName), CompareNames);
+	}
+}
+
+
+#pragma mark -
+#pragma mark Chunks
+
+// Stands in for SHA-1: three FNV-1a hashes, of which the first 40 digits are used
+static void NameChunk(const char *contents, char *name)
+{
+	static const uint64_t bases[3] = { 14695981039346656037ULL, 1099511628211ULL, 0x9E3779B97F4A7C15ULL };
+	char digits[49];
+	
+	for (int i = 0; i < 3; i++) {
+		uint64_t hash = bases[i];
+		for (const char *c = contents; *c; c++) {
+			hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+		}
+		snprintf(digits + 16 * i, 17, "%016llx", (unsigned long long)hash);
+	}
+	
+	memcpy(name, digits, IDEA_BACKUP_CHUNK_NAME_LENGTH);
+	name[IDEA_BACKUP_CHUNK_NAME_LENGTH] = 0;
+}
+
+// Chunks hold the label of an idea on the first line and the names of its children's chunks on
+// the next ones. Returns 0 if the chunk is missing or its contents don't match its name.
+static int ReadChunk(const char *name, int *label, IdeaBackupChunkList *children)
+{
+	static char contents[1 << 16];
+	FILE *file = fopen(ChunkPath(name), "r");
+	
+	if (file == NULL) {
+		return 0;
+	}
+	
+	size_t length = fread(contents, 1, sizeof(contents) - 1, file);
+	contents[length] = 0;
+	fclose(file);
+	
+	char actualName[IDEA_BACKUP_CHUNK_NAME_LENGTH + 1];
+	NameChunk(contents, actualName);
+	if (strcmp(actualName, name) != 0) {
+		return 0;
+	}
+	
+	char *line = strtok(contents, "\n");
+	*label = atoi(line);
+	while ((line = strtok(NULL, "\n")) != NULL) {
+		CHECK(IdeaBackupChunkListAppend(children, line));
+	}
+	
+	return 1;
+}
+
+static int ReadChildChunks(void *info, const char *name, IdeaBackupChunkList *children)
+{
+	int label;
+	
+	(void)info;
+	return ReadChunk(name, &label, children);
+}
+
+
+#pragma mark -
+#pragma mark Board
+
+#define kMaxNodes 400
+#define kMaxChildren 5
+
+// Labels come from a small set, so that identical subtrees, siblings included, share chunks
+typedef struct {
+	int label;
+	int parent;
+	int alive;
+	int childCount;
+	int children[kMaxChildren];
+} Node;
+
+// Node 0 is the top level
+static Node nodes[kMaxNodes];
+
+static void BoardReset(void)
+{
+	memset(nodes, 0, sizeof(nodes));
+	nodes[0].label = -1;
+	nodes[0].parent = -1;
+	nodes[0].alive = 1;
+}
+
+static int RandomAliveNode(int includeTop)
+{
+	for (;;) {
+		int node = rand() % kMaxNodes;
+		if (nodes[node].alive && (includeTop || node != 0)) {
+			return node;
+		}
+	}
+}
+
+static void BoardRemoveSubtree(int node)
+{
+	for (int i = 0; i < nodes[node].childCount; i++) {
+		BoardRemoveSubtree(nodes[node].children[i]);
+	}
+	nodes[node].alive = 0;
+	nodes[node].childCount = 0;
+}
+
+// Adds, relabels and removes a few ideas
+static void BoardEdit(int edits)
+{
+	for (int e = 0; e < edits; e++) {
+		int kind = rand() % 4;
+		
+		if (kind <= 1) {
+			int parent = RandomAliveNode(1);
+			int node = 1;
+			while (node < kMaxNodes && nodes[node].alive) {
+				node++;
+			}
+			if (node < kMaxNodes && nodes[parent].childCount < kMaxChildren) {
+				memset(&nodes[node], 0, sizeof(Node));
+				nodes[node].label = rand() % 6;
+				nodes[node].parent = parent;
+				nodes[node].alive = 1;
+				nodes[parent].children[nodes[parent].childCount++] = node;
+			}
+		} else if (kind == 2 && nodes[0].childCount > 0) {
+			nodes[RandomAliveNode(0)].label = rand() % 6;
+		} else if (kind == 3 && nodes[0].childCount > 0) {
+			int node = RandomAliveNode(0);
+			Node *parent = &nodes[nodes[node].parent];
+			int i = 0;
+			while (parent->children[i] != node) {
+				i++;
+			}
+			memmove(&parent->children[i], &parent->children[i + 1], (size_t)(parent->childCount - i - 1) * sizeof(int));
+			parent->childCount--;
+			BoardRemoveSubtree(node);
+		}
+	}
+}
+
+static void AppendString(char **string, size_t *length, const char *append)
+{
+	size_t appendLength = strlen(append);
+	
+	*string = realloc(*string, *length + appendLength + 1);
+	CHECK(*string != NULL);
+	memcpy(*string + *length, append, appendLength + 1);
+	*length += appendLength;
+}
+
+static void DescribeNode(int node, char **description, size_t *length)
+{
+	char label[16];
+	
+	snprintf(label, sizeof(label), "%d(", nodes[node].label);
+	AppendString(description, length, label);
+	for (int i = 0; i < nodes[node].childCount; i++) {
+		DescribeNode(nodes[node].children[i], description, length);
+	}
+	AppendString(description, length, ")");
+}
+
+// What a generation has to restore to, as a malloc'd string
+static char *DescribeBoard(void)
+{
+	char *description = NULL;
+	size_t length = 0;
+	
+	AppendString(&description, &length, "");
+	DescribeNode(0, &description, &length);
+	return description;
+}
+
+// NULL if a chunk of the generation is missing or damaged
+static char *DescribeChunk(const char *name)
+{
+	IdeaBackupChunkList children;
+	int label;
+	char *description = NULL;
+	size_t length = 0;
+	
+	IdeaBackupChunkListInit(&children);
+	if (!ReadChunk(name, &label, &children)) {
+		IdeaBackupChunkListDestroy(&children);
+		return NULL;
+	}
+	
+	char labelString[16];
+	snprintf(labelString, sizeof(labelString), "%d(", label);
+	AppendString(&description, &length, labelString);
+	
+	for (size_t i = 0; i < children.count; i++) {
+		char *child = DescribeChunk(children.names[i]);
+		if (child == NULL) {
+			free(description);
+			IdeaBackupChunkListDestroy(&children);
+			return NULL;
+		}
+		AppendString(&description, &length, child);
+		free(child);
+	}
+	AppendString(&description, &length, ")");
+	
+	IdeaBackupChunkListDestroy(&children);
+	return description;
+}
+
+
+#pragma mark -
+#pragma mark Backing up
+
+#define kMaxGenerations 4096
+
+// What each generation was backed up from, by number
+static char *expected[kMaxGenerations];
+static int nextGeneration;
+
+// Files written or removed before the app is killed, -1 for never
+static int budget;
+static int operations;
+
+static int Proceed(void)
+{
+	if (budget == 0) {
+		return 0;
+	}
+	if (budget > 0) {
+		budget--;
+	}
+	operations++;
+	return 1;
+}
+
+static void ResetBackups(void)
+{
+	RemoveAllFiles();
+	BoardReset();
+	for (int i = 0; i < nextGeneration; i++) {
+		free(expected[i]);
+		expected[i] = NULL;
+	}
+	nextGeneration = 0;
+}
+
+static int ReadGenerationRoot(const char *file, char *root)
+{
+	char path[512];
+	
+	snprintf(path, sizeof(path), "%s/Generations/%s", directory, file);
+	FILE *generation = fopen(path, "r");
+	CHECK(generation != NULL);
+	int read = fscanf(generation, "%40s", root) == 1;
+	fclose(generation);
+	
+	return read;
+}
+
+// As IdeaBackup's readIndex:generations:error:
+static void ReadIndex(IdeaBackupIndex *index)
+{
+	if (IdeaBackupIndexRead(index, PathNamed("Chunks.index"))) {
+		return;
+	}
+	
+	IdeaBackupChunkName *files;
+	size_t count;
+	ListDirectory(PathNamed("Generations"), &files, &count);
+	
+	IdeaBackupChunkName *roots = malloc((count + 1) * sizeof(IdeaBackupChunkName));
+	const char **rootNames = malloc((count + 1) * sizeof(const char *));
+	CHECK(roots && rootNames);
+	
+	for (size_t i = 0; i < count; i++) {
+		CHECK(ReadGenerationRoot(files[i], roots[i]));
+		rootNames[i] = roots[i];
+	}
+	
+	CHECK(IdeaBackupIndexRebuild(index, rootNames, count, ReadChildChunks, NULL));
+	
+	free(files);
+	free(roots);
+	free(rootNames);
+}
+
+// As IdeaBackup's writeChunkOfIdeaWithID:inSnapshot:index:error:. Returns 0 if killed.
+static int WriteChunkOfNode(int node, IdeaBackupIndex *index, char *name)
+{
+	IdeaBackupChunkName childNames[kMaxChildren];
+	const char *childPointers[kMaxChildren];
+	char contents[16 + kMaxChildren * (IDEA_BACKUP_CHUNK_NAME_LENGTH + 1)];
+	int length = snprintf(contents, sizeof(contents), "%d\n", nodes[node].label);
+	
+	for (int i = 0; i < nodes[node].childCount; i++) {
+		if (!WriteChunkOfNode(nodes[node].children[i], index, childNames[i])) {
+			return 0;
+		}
+		childPointers[i] = childNames[i];
+		length += snprintf(contents + length, sizeof(contents) - (size_t)length, "%s\n", childNames[i]);
+	}
+	
+	NameChunk(contents, name);
+	
+	int added = IdeaBackupIndexAddChunk(index, name, childPointers, (size_t)nodes[node].childCount);
+	CHECK(added >= 0);
+	
+	if (added == 0 || FileExists(ChunkPath(name))) {
+		return 1;
+	}
+	
+	// Written whole or not at all, as NSAtomicWrite does
+	if (!Proceed()) {
+		return 0;
+	}
+	WriteString(ChunkPath(name), contents);
+	
+	return 1;
+}
+
+// As IdeaBackup's backUpSnapshot:error:. Returns 0 if killed.
+static int BackUp(void)
+{
+	IdeaBackupIndex index;
+	IdeaBackupChunkName root;
+	int finished = 0;
+	
+	IdeaBackupIndexInit(&index);
+	ReadIndex(&index);
+	
+	if (WriteChunkOfNode(0, &index, root)) {
+		CHECK(IdeaBackupIndexRetain(&index, root));
+		
+		if (Proceed()) {
+			CHECK(IdeaBackupIndexWrite(&index, PathNamed("Chunks.index")));
+			
+			if (Proceed()) {
+				char file[32];
+				snprintf(file, sizeof(file), "Generations/%06d", nextGeneration);
+				WriteString(PathNamed(file), root);
+				
+				CHECK(nextGeneration < kMaxGenerations);
+				expected[nextGeneration++] = DescribeBoard();
+				finished = 1;
+			}
+		}
+	}
+	
+	IdeaBackupIndexDestroy(&index);
+	return finished;
+}
+
+// As IdeaBackup's removeGenerationsBeyondCount:. Returns 0 if killed.
+static int Prune(size_t keep)
+{
+	IdeaBackupChunkName *files;
+	size_t count;
+	int finished = 0;
+	
+	ListDirectory(PathNamed("Generations"), &files, &count);
+	if (count <= keep) {
+		free(files);
+		return 1;
+	}
+	
+	IdeaBackupIndex index;
+	IdeaBackupChunkList removed;
+	
+	IdeaBackupIndexInit(&index);
+	IdeaBackupChunkListInit(&removed);
+	ReadIndex(&index);
+	
+	// Oldest first here, which makes no difference
+	size_t i = 0;
+	for (; i < count - keep; i++) {
+		IdeaBackupChunkName root;
+		char file[64];
+		
+		CHECK(ReadGenerationRoot(files[i], root));
+		if (!Proceed()) {
+			break;
+		}
+		snprintf(file, sizeof(file), "Generations/%s", files[i]);
+		CHECK(unlink(PathNamed(file)) == 0);
+		CHECK(IdeaBackupIndexRelease(&index, root, ReadChildChunks, NULL, &removed));
+	}
+	
+	if (i == count - keep && Proceed()) {
+		CHECK(IdeaBackupIndexWrite(&index, PathNamed("Chunks.index")));
+		
+		size_t r = 0;
+		for (; r < removed.count && Proceed(); r++) {
+			CHECK(unlink(ChunkPath(removed.names[r])) == 0);
+		}
+		finished = r == removed.count;
+	}
+	
+	IdeaBackupChunkListDestroy(&removed);
+	IdeaBackupIndexDestroy(&index);
+	free(files);
+	return finished;
+}
+
+// Every generation restores to what it was backed up from, every chunk it names is counted, and
+// no chunk is counted less than the chunks in the index and the generations name it. Unless the
+// backups were interrupted, counts are exact and there's no chunk the index doesn't have.
+static void CheckBackups(int exact)
+{
+	IdeaBackupChunkName *files;
+	size_t generationCount;
+	IdeaBackupChunkName *chunks;
+	size_t chunkCount;
+	IdeaBackupIndex index;
+	
+	ListDirectory(PathNamed("Generations"), &files, &generationCount);
+	ListDirectory(PathNamed("Chunks"), &chunks, &chunkCount);
+	IdeaBackupIndexInit(&index);
+	
+	if (!IdeaBackupIndexRead(&index, PathNamed("Chunks.index"))) {
+		CHECK(errno == ENOENT && generationCount == 0);
+	}
+	
+	long *references = calloc(chunkCount + 1, sizeof(long));
+	CHECK(references != NULL);
+	
+	for (size_t g = 0; g < generationCount; g++) {
+		IdeaBackupChunkName root;
+		CHECK(ReadGenerationRoot(files[g], root));
+		
+		char *description = DescribeChunk(root);
+		CHECK(description != NULL);
+		CHECK(strcmp(description, expected[atoi(files[g])]) == 0);
+		free(description);
+		
+		IdeaBackupChunkName *found = bsearch(root, chunks, chunkCount, sizeof(IdeaBackupChunkName), CompareNames);
+		CHECK(found != NULL);
+		references[found - chunks]++;
+	}
+	
+	size_t counted = 0;
+	for (size_t c = 0; c < chunkCount; c++) {
+		if (IdeaBackupIndexCount(&index, chunks[c]) == 0) {
+			CHECK(!exact);
+			continue;
+		}
+		counted++;
+		
+		IdeaBackupChunkList children;
+		int label;
+		IdeaBackupChunkListInit(&children);
+		CHECK(ReadChunk(chunks[c], &label, &children));
+		
+		for (size_t i = 0; i < children.count; i++) {
+			IdeaBackupChunkName *found = bsearch(children.names[i], chunks, chunkCount, sizeof(IdeaBackupChunkName), CompareNames);
+			CHECK(found != NULL);
+			CHECK(IdeaBackupIndexCount(&index, *found) > 0);
+			references[found - chunks]++;
+		}
+		IdeaBackupChunkListDestroy(&children);
+	}
+	
+	// Every chunk in the index is on disk
+	CHECK(counted == index.count);
+	
+	for (size_t c = 0; c < chunkCount; c++) {
+		long count = IdeaBackupIndexCount(&index, chunks[c]);
+		CHECK(count >= references[c]);
+		CHECK(!exact || count == references[c]);
+	}
+	
+	free(references);
+	free(files);
+	free(chunks);
+	IdeaBackupIndexDestroy(&index);
+}
+
+
+#pragma mark -
+#pragma mark Tests
+
+// The name made of a single hex digit, which stays the same for the whole test
+static const char *TestName(char digit)
+{
+	static char names[16][IDEA_BACKUP_CHUNK_NAME_LENGTH + 1];
+	char *name = names[digit <= '9' ? digit - '0' : digit - 'a' + 10];
+	
+	memset(name, digit, IDEA_BACKUP_CHUNK_NAME_LENGTH);
+	name[IDEA_BACKUP_CHUNK_NAME_LENGTH] = 0;
+	return name;
+}
+
+// Chunks a, b, c and d, where a names b twice and c, b names c and d names b
+static int ReadTestChildChunks(void *info, const char *name, IdeaBackupChunkList *children)
+{
+	(void)info;
+	
+	switch (name[0]) {
+		case 'a':
+			CHECK(IdeaBackupChunkListAppend(children, TestName('b')));
+			CHECK(IdeaBackupChunkListAppend(children, TestName('b')));
+			CHECK(IdeaBackupChunkListAppend(children, TestName('c')));
+			return 1;
+		case 'b':
+		case 'd':
+			CHECK(IdeaBackupChunkListAppend(children, TestName(name[0] == 'b' ? 'c' : 'b')));
+			return 1;
+		case 'c':
+			return 1;
+	}
+	
+	return 0;
+}
+
+static int ReadNoChildChunks(void *info, const char *name, IdeaBackupChunkList *children)
+{
+	(void)info;
+	(void)name;
+	(void)children;
+	return 1;
+}
+
+static void CheckTestCounts(const IdeaBackupIndex *index, long a, long b, long c, long d)
+{
+	CHECK(IdeaBackupIndexCount(index, TestName('a')) == a);
+	CHECK(IdeaBackupIndexCount(index, TestName('b')) == b);
+	CHECK(IdeaBackupIndexCount(index, TestName('c')) == c);
+	CHECK(IdeaBackupIndexCount(index, TestName('d')) == d);
+}
+
+// Generations with the roots a and d share b and c, which go with the last of them
+static void TestRetainRelease(void)
+{
+	IdeaBackupIndex index;
+	IdeaBackupIndex rebuilt;
+	IdeaBackupChunkList removed;
+	
+	step = -1;
+	IdeaBackupIndexInit(&index);
+	IdeaBackupIndexInit(&rebuilt);
+	IdeaBackupChunkListInit(&removed);
+	
+	const char *cChildren[1];
+	const char *bChildren[] = { TestName('c') };
+	const char *aChildren[] = { TestName('b'), TestName('b'), TestName('c') };
+	const char *dChildren[] = { TestName('b') };
+	
+	CHECK(IdeaBackupIndexAddChunk(&index, TestName('c'), cChildren, 0) == 1);
+	CHECK(IdeaBackupIndexAddChunk(&index, TestName('b'), bChildren, 1) == 1);
+	CHECK(IdeaBackupIndexAddChunk(&index, TestName('a'), aChildren, 3) == 1);
+	CHECK(IdeaBackupIndexRetain(&index, TestName('a')));
+	CheckTestCounts(&index, 1, 2, 2, 0);
+	
+	// Already there, with its children counted for it
+	CHECK(IdeaBackupIndexAddChunk(&index, TestName('b'), bChildren, 1) == 0);
+	CHECK(IdeaBackupIndexAddChunk(&index, TestName('d'), dChildren, 1) == 1);
+	CHECK(IdeaBackupIndexRetain(&index, TestName('d')));
+	CheckTestCounts(&index, 1, 3, 2, 1);
+	CHECK(index.count == 4);
+	
+	// Children that aren't in the index, and names that aren't chunk names
+	CHECK(IdeaBackupIndexAddChunk(&index, TestName('e'), (const char *[]){ TestName('f') }, 1) == -1);
+	CHECK(IdeaBackupIndexAddChunk(&index, "abc", cChildren, 0) == -1);
+	CHECK(!IdeaBackupIndexRetain(&index, TestName('e')));
+	CHECK(IdeaBackupIndexCount(&index, TestName('e')) == 0);
+	CHECK(index.count == 4);
+	
+	// Counting from scratch gives the same counts
+	const char *roots[] = { TestName('a'), TestName('d') };
+	CHECK(IdeaBackupIndexRebuild(&rebuilt, roots, 2, ReadTestChildChunks, NULL));
+	CheckTestCounts(&rebuilt, 1, 3, 2, 1);
+	CHECK(rebuilt.count == 4);
+	
+	// A chunk that can't be read is left out, and so are its children
+	const char *unreadableRoots[] = { TestName('e'), TestName('d') };
+	CHECK(IdeaBackupIndexRebuild(&rebuilt, unreadableRoots, 2, ReadTestChildChunks, NULL));
+	CheckTestCounts(&rebuilt, 0, 1, 1, 1);
+	CHECK(IdeaBackupIndexCount(&rebuilt, TestName('e')) == 0);
+	CHECK(rebuilt.count == 3);
+	
+	CHECK(IdeaBackupIndexRelease(&index, TestName('a'), ReadTestChildChunks, NULL, &removed));
+	CheckTestCounts(&index, 0, 1, 1, 1);
+	CHECK(removed.count == 1 && strcmp(removed.names[0], TestName('a')) == 0);
+	
+	// Nothing happens to chunks the index doesn't have
+	CHECK(IdeaBackupIndexRelease(&index, TestName('a'), ReadTestChildChunks, NULL, &removed));
+	CHECK(IdeaBackupIndexRelease(&index, TestName('e'), ReadTestChildChunks, NULL, &removed));
+	CHECK(removed.count == 1);
+	
+	CHECK(IdeaBackupIndexRelease(&index, TestName('d'), ReadTestChildChunks, NULL, &removed));
+	CheckTestCounts(&index, 0, 0, 0, 0);
+	CHECK(index.count == 0);
+	CHECK(removed.count == 4);
+	CHECK(strcmp(removed.names[1], TestName('d')) == 0);
+	CHECK(strcmp(removed.names[2], TestName('b')) == 0);
+	CHECK(strcmp(removed.names[3], TestName('c')) == 0);
+	
+	IdeaBackupChunkListDestroy(&removed);
+	IdeaBackupIndexDestroy(&rebuilt);
+	IdeaBackupIndexDestroy(&index);
+}
+
+// Thousands of chunks counted and released at random, which moves entries of the hash table
+// around, against counts kept alongside
+static void TestManyChunks(void)
+{
+	enum { kChunkCount = 5000 };
+	static IdeaBackupChunkName names[kChunkCount];
+	static long counts[kChunkCount];
+	IdeaBackupIndex index;
+	IdeaBackupChunkList removed;
+	
+	IdeaBackupIndexInit(&index);
+	IdeaBackupChunkListInit(&removed);
+	
+	for (int i = 0; i < kChunkCount; i++) {
+		char contents[16];
+		snprintf(contents, sizeof(contents), "%d", i);
+		NameChunk(contents, names[i]);
+		counts[i] = 0;
+	}
+	
+	for (step = 0; step < 100000; step++) {
+		int i = rand() % kChunkCount;
+		
+		if (counts[i] == 0) {
+			CHECK(IdeaBackupIndexAddChunk(&index, names[i], NULL, 0) == 1);
+			CHECK(IdeaBackupIndexRetain(&index, names[i]));
+			counts[i] = 1;
+		} else if (rand() % 2) {
+			CHECK(IdeaBackupIndexRetain(&index, names[i]));
+			counts[i]++;
+		} else {
+			removed.count = 0;
+			CHECK(IdeaBackupIndexRelease(&index, names[i], ReadNoChildChunks, NULL, &removed));
+			counts[i]--;
+			CHECK(removed.count == (counts[i] == 0));
+		}
+		
+		if (step % 10000 == 0) {
+			size_t count = 0;
+			for (int j = 0; j < kChunkCount; j++) {
+				CHECK(IdeaBackupIndexCount(&index, names[j]) == counts[j]);
+				count += counts[j] > 0;
+			}
+			CHECK(index.count == count);
+		}
+	}
+	
+	// What's written is read back the same
+	IdeaBackupIndex read;
+	IdeaBackupIndexInit(&read);
+	CHECK(IdeaBackupIndexWrite(&index, PathNamed("Chunks.index")));
+	CHECK(IdeaBackupIndexRead(&read, PathNamed("Chunks.index")));
+	CHECK(read.count == index.count);
+	for (int j = 0; j < kChunkCount; j++) {
+		CHECK(IdeaBackupIndexCount(&read, names[j]) == counts[j]);
+	}
+	CHECK(!FileExists(PathNamed("Chunks.index.new")));
+	
+	IdeaBackupIndexDestroy(&read);
+	IdeaBackupChunkListDestroy(&removed);
+	IdeaBackupIndexDestroy(&index);
+	RemoveAllFiles();
+}
+
+static void TestIndexFile(void)
+{
+	static const char *damaged[] = {
+		"",
+		"GreenBoardPro chunk index 2\n0\n",
+		"GreenBoardPro chunk index 1\n",
+		"GreenBoardPro chunk index 1\n2\n1111111111111111111111111111111111111111 1\n",
+		"GreenBoardPro chunk index 1\n1\n1111111111111111111111111111111111111111 0\n",
+		"GreenBoardPro chunk index 1\n1\n111111111111111111111111111111111111111 1\n",
+		"GreenBoardPro chunk index 1\n1\n111111111111111111111111111111111111111X 1\n",
+		"GreenBoardPro chunk index 1\n1\n1111111111111111111111111111111111111111 1\nextra\n",
+		"GreenBoardPro chunk index 1\n2\n1111111111111111111111111111111111111111 1\n1111111111111111111111111111111111111111 1\n",
+	};
+	IdeaBackupIndex index;
+	
+	step = -1;
+	IdeaBackupIndexInit(&index);
+	
+	CHECK(!IdeaBackupIndexRead(&index, PathNamed("Chunks.index")));
+	CHECK(errno == ENOENT);
+	CHECK(index.count == 0);
+	
+	WriteString(PathNamed("Chunks.index"), "GreenBoardPro chunk index 1\n1\n1111111111111111111111111111111111111111 3\n");
+	CHECK(IdeaBackupIndexRead(&index, PathNamed("Chunks.index")));
+	CHECK(index.count == 1);
+	CHECK(IdeaBackupIndexCount(&index, TestName('1')) == 3);
+	
+	for (step = 0; step < (int)(sizeof(damaged) / sizeof(damaged[0])); step++) {
+		WriteString(PathNamed("Chunks.index"), damaged[step]);
+		CHECK(!IdeaBackupIndexRead(&index, PathNamed("Chunks.index")));
+		CHECK(errno == EINVAL);
+		CHECK(index.count == 0);
+	}
+	
+	IdeaBackupIndexDestroy(&index);
+	RemoveAllFiles();
+}
+
+// Backups of a board that's edited in between, each followed by a prune, then every
+// generation removed, which has to leave no chunk behind
+static void TestBackups(int rounds)
+{
+	ResetBackups();
+	budget = -1;
+	
+	for (step = 0; step < rounds; step++) {
+		BoardEdit(1 + rand() % 30);
+		CHECK(BackUp());
+		CHECK(Prune(5));
+		CheckBackups(1);
+	}
+	
+	// Counted again from scratch, the counts are the same
+	CHECK(unlink(PathNamed("Chunks.index")) == 0);
+	BoardEdit(5);
+	CHECK(BackUp());
+	CheckBackups(1);
+	
+	WriteString(PathNamed("Chunks.index"), "GreenBoardPro chunk index 1\n1\n");
+	CHECK(Prune(3));
+	CheckBackups(1);
+	
+	CHECK(Prune(0));
+	CheckBackups(1);
+	
+	IdeaBackupChunkName *chunks;
+	size_t chunkCount;
+	ListDirectory(PathNamed("Chunks"), &chunks, &chunkCount);
+	CHECK(chunkCount == 0);
+	free(chunks);
+}
+
+// A backup and a prune killed after each of the files they write or remove. What's left is
+// consistent, and later backups and prunes go on from it.
+static void TestInterruptedBackup(int runs)
+{
+	for (int run = 0; run < runs; run++) {
+		// The number of files a backup and a prune of this board write and remove
+		srand(seed + (unsigned)run);
+		ResetBackups();
+		budget = -1;
+		for (int i = 0; i < 8; i++) {
+			BoardEdit(1 + rand() % 30);
+			CHECK(BackUp() && Prune(3));
+		}
+		unsigned editSeed = (unsigned)rand();
+		srand(editSeed);
+		BoardEdit(1 + rand() % 30);
+		operations = 0;
+		CHECK(BackUp() && Prune(3));
+		int operationCount = operations;
+		
+		for (step = 0; step <= operationCount; step++) {
+			srand(seed + (unsigned)run);
+			ResetBackups();
+			budget = -1;
+			for (int i = 0; i < 8; i++) {
+				BoardEdit(1 + rand() % 30);
+				CHECK(BackUp() && Prune(3));
+			}
+			srand(editSeed);
+			BoardEdit(1 + rand() % 30);
+			
+			budget = step;
+			int finished = BackUp() && Prune(3);
+			CHECK(finished == (step == operationCount));
+			CheckBackups(finished);
+			
+			budget = -1;
+			for (int i = 0; i < 6; i++) {
+				BoardEdit(1 + rand() % 30);
+				CHECK(BackUp() && Prune(3));
+				CheckBackups(finished);
+			}
+		}
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	seed = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 20110128;
+	srand(seed);
+	
+	snprintf(directory, sizeof(directory), "/tmp/BackupTests.XXXXXX");
+	CHECK(mkdtemp(directory) != NULL);
+	RemoveAllFiles();
+	
+	TestRetainRelease();
+	TestIndexFile();
+	TestManyChunks();
+	TestBackups(200);
+	TestInterruptedBackup(10);
+	
+	ResetBackups();
+	
+	char command[600];
+	snprintf(command, sizeof(command), "rm -rf '%s'", directory);
+	CHECK(system(command) == 0);
+	
+	printf("BackupTests passed\n");
+	return 0;
+}
@@ -0,0 +1,362 @@
+//
+//  CapabilityBenchmark.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/22/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Headless micro-benchmark of the delegate checks SCTableViewModel makes while a table scrolls.
+// There's no Objective-C runtime on the host, so the runtime's side of the checks is written out
+// in C after the objc4 paths they take:
+//
+//   message send          - lookup of the selector in the receiver class's method cache, filled
+//                           from the method lists up the superclass chain on a miss.
+//   conformsToProtocol:   - a message send, then for each class up the chain the runtime lock is
+//                           taken and the class's protocol list searched, comparing pointers and
+//                           then names, recursing into incorporated protocols.
+//   respondsToSelector:   - a message send, then a lookup of the asked selector in the cache,
+//                           which also remembers selectors the class doesn't implement.
+//
+// For every row, the checks made by cellForRowAtIndexPath:, willDisplayCell: and layoutSubviews
+// are replayed, once as the old conformsToProtocol:/respondsToSelector: pairs and once as the
+// delegateRespondsTo:/dataSourceRespondsTo: bitmask tests, over a 10,000 row model.
+//
+//   ./CapabilityBenchmark [passes]
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define kRowCount 10000
+#define kCacheSize 64  // power of two
+
+typedef const char *SEL;
+typedef int (*IMP)(void);
+
+typedef struct Protocol {
+	const char *name;
+	const struct Protocol **incorporated;
+} Protocol;
+
+typedef struct {
+	SEL name;
+	IMP imp;
+} Method;
+
+typedef struct CacheEntry {
+	SEL sel;
+	IMP imp;  // NULL for a selector the class doesn't implement
+} CacheEntry;
+
+typedef struct Class {
+	const char *name;
+	struct Class *superclass;
+	const Method *methods;
+	const Protocol **protocols;
+	CacheEntry cache[kCacheSize];
+} Class;
+
+static pthread_rwlock_t runtimeLock = PTHREAD_RWLOCK_INITIALIZER;
+
+static int Implementation(void) { return 1; }
+
+// Selectors are unique strings, compared by address as SELs are
+#define DEFINE_SEL(variable, name) static const char variable[] = name
+DEFINE_SEL(conformsToProtocolSel, "conformsToProtocol:");
+DEFINE_SEL(respondsToSelectorSel, "respondsToSelector:");
+DEFINE_SEL(isKindOfClassSel, "isKindOfClass:");
+DEFINE_SEL(descriptionSel, "description");
+DEFINE_SEL(nextResponderSel, "nextResponder");
+DEFINE_SEL(viewSel, "view");
+DEFINE_SEL(loadViewSel, "loadView");
+DEFINE_SEL(viewDidLoadSel, "viewDidLoad");
+DEFINE_SEL(viewWillAppearSel, "viewWillAppear:");
+DEFINE_SEL(tableViewSel, "tableView");
+DEFINE_SEL(numberOfRowsSel, "tableView:numberOfRowsInSection:");
+DEFINE_SEL(cellForRowSel, "tableView:cellForRowAtIndexPath:");
+DEFINE_SEL(deallocSel, "dealloc");
+DEFINE_SEL(delegateRespondsToSel, "delegateRespondsTo:");
+DEFINE_SEL(dataSourceRespondsToSel, "dataSourceRespondsTo:");
+DEFINE_SEL(willConfigureCellSel, "tableViewModel:willConfigureCell:forRowAtIndexPath:");
+DEFINE_SEL(willDisplayCellSel, "tableViewModel:willDisplayCell:forRowAtIndexPath:");
+DEFINE_SEL(didLayoutSubviewsSel, "tableViewModel:didLayoutSubviewsForCell:forRowAtIndexPath:");
+DEFINE_SEL(customCellSel, "tableViewModel:customCellForRowAtIndexPath:");
+
+static IMP LookUpMethod(const Class *cls, SEL sel)
+{
+	for (; cls; cls = cls->superclass)
+		for (const Method *method = cls->methods; method && method->name; method++)
+			if (method->name == sel)
+				return method->imp;
+	
+	return NULL;
+}
+
+static IMP CacheLookUp(Class *cls, SEL sel)
+{
+	size_t slot = ((uintptr_t)sel >> 3) & (kCacheSize - 1);
+	
+	for (;;) {
+		CacheEntry *entry = &cls->cache[slot];
+		if (entry->sel == sel)
+			return entry->imp;
+		if (!entry->sel) {
+			entry->sel = sel;
+			entry->imp = LookUpMethod(cls, sel);
+			return entry->imp;
+		}
+		slot = (slot + 1) & (kCacheSize - 1);
+	}
+}
+
+// The dispatch of a message, without the call itself
+static __attribute__((noinline)) IMP MessageSend(Class *receiver, SEL sel)
+{
+	if (!receiver)
+		return NULL;
+	
+	return CacheLookUp(receiver, sel);
+}
+
+static int ProtocolConformsToProtocol(const Protocol *protocol, const Protocol *other)
+{
+	if (protocol == other || strcmp(protocol->name, other->name) == 0)
+		return 1;
+	for (const Protocol **incorporated = protocol->incorporated; incorporated && *incorporated; incorporated++)
+		if (ProtocolConformsToProtocol(*incorporated, other))
+			return 1;
+	
+	return 0;
+}
+
+static __attribute__((noinline)) int ConformsToProtocol(Class *receiver, const Protocol *protocol)
+{
+	if (!MessageSend(receiver, conformsToProtocolSel))
+		return 0;
+	
+	for (const Class *cls = receiver; cls; cls = cls->superclass) {
+		int conforms = 0;
+		
+		pthread_rwlock_rdlock(&runtimeLock);
+		for (const Protocol **adopted = cls->protocols; adopted && *adopted; adopted++)
+			if (ProtocolConformsToProtocol(*adopted, protocol)) {
+				conforms = 1;
+				break;
+			}
+		pthread_rwlock_unlock(&runtimeLock);
+		
+		if (conforms)
+			return 1;
+	}
+	
+	return 0;
+}
+
+static __attribute__((noinline)) int RespondsToSelector(Class *receiver, SEL sel)
+{
+	if (!MessageSend(receiver, respondsToSelectorSel))
+		return 0;
+	
+	return CacheLookUp(receiver, sel) != NULL;
+}
+
+// The model, with the masks setDelegate: and setDataSource: work out
+typedef struct {
+	Class *isa;
+	Class *delegate;
+	Class *dataSource;
+	uint64_t delegateCapabilities;
+	uint32_t dataSourceCapabilities;
+} Model;
+
+enum { WillConfigureCell, WillDisplayCell, DidLayoutSubviews };
+enum { CustomCell };
+
+static __attribute__((noinline)) int DelegateRespondsTo(Model *model, int capability)
+{
+	MessageSend(model->isa, delegateRespondsToSel);
+	
+	return (model->delegateCapabilities & ((uint64_t)1 << capability)) != 0;
+}
+
+static __attribute__((noinline)) int DataSourceRespondsTo(Model *model, int capability)
+{
+	MessageSend(model->isa, dataSourceRespondsToSel);
+	
+	return (model->dataSourceCapabilities & ((uint32_t)1 << capability)) != 0;
+}
+
+static const Protocol NSObjectProtocol = { "NSObject", NULL };
+static const Protocol *incorporatesNSObject[] = { &NSObjectProtocol, NULL };
+static const Protocol NSCodingProtocol = { "NSCoding", NULL };
+static const Protocol UITableViewDelegateProtocol = { "UITableViewDelegate", incorporatesNSObject };
+static const Protocol UITableViewDataSourceProtocol = { "UITableViewDataSource", incorporatesNSObject };
+static const Protocol UIScrollViewDelegateProtocol = { "UIScrollViewDelegate", incorporatesNSObject };
+static const Protocol SCTableViewModelDelegateProtocol = { "SCTableViewModelDelegate", NULL };
+static const Protocol SCTableViewModelDataSourceProtocol = { "SCTableViewModelDataSource", NULL };
+
+static const Protocol *objectProtocols[] = { &NSObjectProtocol, NULL };
+static const Protocol *viewControllerProtocols[] = { &NSCodingProtocol, NULL };
+static const Protocol *tableViewControllerProtocols[] = {
+	&UITableViewDelegateProtocol, &UITableViewDataSourceProtocol, &UIScrollViewDelegateProtocol, NULL
+};
+static const Protocol *delegateProtocols[] = { &SCTableViewModelDelegateProtocol, NULL };
+
+static const Method objectMethods[] = {
+	{ conformsToProtocolSel, Implementation }, { respondsToSelectorSel, Implementation },
+	{ isKindOfClassSel, Implementation }, { descriptionSel, Implementation }, { NULL, NULL }
+};
+static const Method responderMethods[] = { { nextResponderSel, Implementation }, { NULL, NULL } };
+static const Method viewControllerMethods[] = {
+	{ viewSel, Implementation }, { loadViewSel, Implementation }, { viewDidLoadSel, Implementation },
+	{ viewWillAppearSel, Implementation }, { NULL, NULL }
+};
+static const Method tableViewControllerMethods[] = {
+	{ tableViewSel, Implementation }, { numberOfRowsSel, Implementation }, { cellForRowSel, Implementation }, { NULL, NULL }
+};
+static const Method controllerMethods[] = { { viewDidLoadSel, Implementation }, { deallocSel, Implementation }, { NULL, NULL } };
+static const Method callbackControllerMethods[] = {
+	{ viewDidLoadSel, Implementation }, { deallocSel, Implementation },
+	{ willConfigureCellSel, Implementation }, { willDisplayCellSel, Implementation }, { NULL, NULL }
+};
+static const Method modelMethods[] = {
+	{ delegateRespondsToSel, Implementation }, { dataSourceRespondsToSel, Implementation }, { NULL, NULL }
+};
+
+static Class NSObjectClass = { "NSObject", NULL, objectMethods, objectProtocols, {{0}} };
+static Class UIResponderClass = { "UIResponder", &NSObjectClass, responderMethods, NULL, {{0}} };
+static Class UIViewControllerClass = { "UIViewController", &UIResponderClass, viewControllerMethods, viewControllerProtocols, {{0}} };
+static Class UITableViewControllerClass = { "UITableViewController", &UIViewControllerClass, tableViewControllerMethods,
+	tableViewControllerProtocols, {{0}} };
+static Class SCTableViewModelClass = { "SCTableViewModel", &NSObjectClass, modelMethods, NULL, {{0}} };
+
+// SettingsViewController : UITableViewController <SCTableViewModelDelegate>
+static Class SettingsViewControllerClass = { "SettingsViewController", &UITableViewControllerClass, controllerMethods,
+	delegateProtocols, {{0}} };
+// The same, implementing willConfigureCell: and willDisplayCell:
+static Class CallbackViewControllerClass = { "CallbackViewController", &UITableViewControllerClass, callbackControllerMethods,
+	delegateProtocols, {{0}} };
+// A delegate that doesn't adopt the protocol, so every check walks the whole chain
+static Class PlainViewControllerClass = { "PlainViewController", &UITableViewControllerClass, controllerMethods, NULL, {{0}} };
+
+static volatile int sink;
+
+static void ScrollOld(Model *model)
+{
+	const Protocol *delegateProtocol = &SCTableViewModelDelegateProtocol;
+	const Protocol *dataSourceProtocol = &SCTableViewModelDataSourceProtocol;
+	
+	for (int row = 0; row < kRowCount; row++) {
+		int calls = 0;
+		
+		// SCArrayOfItemsSection cellAtIndex:
+		if (ConformsToProtocol(model->dataSource, dataSourceProtocol) && RespondsToSelector(model->dataSource, customCellSel))
+			calls++;
+		if (ConformsToProtocol(model->delegate, delegateProtocol) && RespondsToSelector(model->delegate, willConfigureCellSel))
+			calls++;
+		// cellForRowAtIndexPath:
+		if (ConformsToProtocol(model->delegate, delegateProtocol) && RespondsToSelector(model->delegate, willConfigureCellSel))
+			calls++;
+		// willDisplayCell:forRowAtIndexPath:
+		if (ConformsToProtocol(model->delegate, delegateProtocol) && RespondsToSelector(model->delegate, willDisplayCellSel))
+			calls++;
+		// SCTableViewCell layoutSubviews
+		if (ConformsToProtocol(model->delegate, delegateProtocol) && RespondsToSelector(model->delegate, didLayoutSubviewsSel))
+			calls++;
+		
+		sink += calls;
+	}
+}
+
+static void ScrollNew(Model *model)
+{
+	for (int row = 0; row < kRowCount; row++) {
+		int calls = 0;
+		
+		if (DataSourceRespondsTo(model, CustomCell))
+			calls++;
+		if (DelegateRespondsTo(model, WillConfigureCell))
+			calls++;
+		if (DelegateRespondsTo(model, WillConfigureCell))
+			calls++;
+		if (DelegateRespondsTo(model, WillDisplayCell))
+			calls++;
+		if (DelegateRespondsTo(model, DidLayoutSubviews))
+			calls++;
+		
+		sink += calls;
+	}
+}
+
+static double Now(void)
+{
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Best of the passes, in microseconds for the whole 10,000 rows
+static double TimeScroll(void (*scroll)(Model *), Model *model, int passes)
+{
+	double best = 0;
+	
+	for (int pass = 0; pass < passes; pass++) {
+		double start = Now();
+		scroll(model);
+		double elapsed = (Now() - start) * 1e6;
+		
+		if (pass == 0 || elapsed < best)
+			best = elapsed;
+	}
+	
+	return best;
+}
+
+static void Measure(const char *description, Model *model, int passes)
+{
+	// Checks made per row, with the results of the old and new paths compared over one pass
+	int before = sink;
+	ScrollOld(model);
+	int oldCalls = sink - before;
+	ScrollNew(model);
+	int newCalls = sink - before - oldCalls;
+	if (oldCalls != newCalls) {
+		fprintf(stderr, "%s: old checks called %d delegate methods, new checks %d\n", description, oldCalls, newCalls);
+		exit(1);
+	}
+	
+	double old = TimeScroll(ScrollOld, model, passes);
+	double new = TimeScroll(ScrollNew, model, passes);
+	
+	printf("%-48s %10.1f %10.1f %8.1f %8.1f %6.1fx\n", description, old, new,
+		   old * 1000 / kRowCount, new * 1000 / kRowCount, old / new);
+}
+
+int main(int argc, char *argv[])
+{
+	int passes = (argc > 1) ? atoi(argv[1]) : 50;
+	if (passes < 1)
+		passes = 1;
+	
+	uint64_t callbackCapabilities = ((uint64_t)1 << WillConfigureCell) | ((uint64_t)1 << WillDisplayCell);
+	Model settings = { &SCTableViewModelClass, &SettingsViewControllerClass, NULL, 0, 0 };
+	Model callback = { &SCTableViewModelClass, &CallbackViewControllerClass, NULL, callbackCapabilities, 0 };
+	Model both = { &SCTableViewModelClass, &CallbackViewControllerClass, &CallbackViewControllerClass, callbackCapabilities, 0 };
+	Model plain = { &SCTableViewModelClass, &PlainViewControllerClass, NULL, 0, 0 };
+	
+	printf("%d rows, 5 checks per row, best of %d passes\n", kRowCount, passes);
+	printf("%-48s %21s %17s\n", "", "whole scroll (us)", "per row (ns)");
+	printf("%-48s %10s %10s %8s %8s\n", "delegate", "before", "after", "before", "after");
+	Measure("conforms, implements no row callbacks", &settings, passes);
+	Measure("conforms, implements 2 row callbacks", &callback, passes);
+	Measure("as above, and the data source without protocol", &both, passes);
+	Measure("doesn't adopt the protocol", &plain, passes);
+	
+	return 0;
+}
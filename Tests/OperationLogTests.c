@@ -0,0 +1,278 @@
+//
+//  OperationLogTests.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/25/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Randomized tests of IdeaOperationLog's ring buffer and name deltas against plain reference
+// models: a list of operations with an undo cursor, and brute force prefix and suffix matching.
+
+#include "IdeaOperationCore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s (seed %u, step %d)\n", __FILE__, __LINE__, #condition, seed, step); \
+		exit(1); \
+	} \
+} while (0)
+
+static unsigned seed;
+static int step;
+
+
+#pragma mark -
+#pragma mark Ring buffer
+
+#define kMaxCapacity 16
+#define kNoOperation -1
+
+typedef struct {
+	int ids[kMaxCapacity];
+	size_t bytes[kMaxCapacity];
+	size_t count;
+	size_t undoCount;
+} ReferenceLog;
+
+// What IdeaOperationLog keeps in its operations array
+static int slots[kMaxCapacity];
+
+static void DropSlot(void *info, size_t slot)
+{
+	(void)info;
+	CHECK(slots[slot] != kNoOperation);
+	slots[slot] = kNoOperation;
+}
+
+static void ReferenceRemoveOldest(ReferenceLog *log)
+{
+	memmove(log->ids, log->ids + 1, (log->count - 1) * sizeof(int));
+	memmove(log->bytes, log->bytes + 1, (log->count - 1) * sizeof(size_t));
+	log->count--;
+	if (log->undoCount > 0) {
+		log->undoCount--;
+	}
+}
+
+static void ReferenceAdd(ReferenceLog *log, int identifier, size_t bytes, size_t capacity, size_t byteLimit)
+{
+	log->count = log->undoCount;
+	
+	if (log->count == capacity) {
+		ReferenceRemoveOldest(log);
+	}
+	
+	log->ids[log->count] = identifier;
+	log->bytes[log->count] = bytes;
+	log->count++;
+	log->undoCount = log->count;
+	
+	for (;;) {
+		size_t total = 0;
+		for (size_t i = 0; i < log->count; i++) {
+			total += log->bytes[i];
+		}
+		if (total <= byteLimit || log->count <= 1) {
+			break;
+		}
+		ReferenceRemoveOldest(log);
+	}
+}
+
+static void CheckRing(const OperationRing *ring, const ReferenceLog *log)
+{
+	CHECK(ring->count == log->count);
+	CHECK(ring->undoCount == log->undoCount);
+	CHECK(OperationRingCanUndo(ring) == (log->undoCount > 0));
+	CHECK(OperationRingCanRedo(ring) == (log->undoCount < log->count));
+	
+	size_t total = 0;
+	int live[kMaxCapacity] = { 0 };
+	
+	for (size_t i = 0; i < log->count; i++) {
+		size_t slot = OperationRingSlotAtIndex(ring, i);
+		CHECK(slot < ring->capacity);
+		CHECK(slots[slot] == log->ids[i]);
+		live[slot] = 1;
+		total += log->bytes[i];
+	}
+	CHECK(ring->byteCount == total);
+	
+	// Every operation that left the ring was dropped, and only those
+	for (size_t slot = 0; slot < ring->capacity; slot++) {
+		CHECK(live[slot] || slots[slot] == kNoOperation);
+	}
+	
+	if (log->undoCount > 0) {
+		CHECK(slots[OperationRingUndoSlot(ring)] == log->ids[log->undoCount - 1]);
+	}
+	if (log->undoCount < log->count) {
+		CHECK(slots[OperationRingRedoSlot(ring)] == log->ids[log->undoCount]);
+	}
+}
+
+static void TestRing(size_t capacity, size_t byteLimit, int steps)
+{
+	OperationRing ring;
+	ReferenceLog log;
+	int nextID = 0;
+	
+	memset(&log, 0, sizeof(log));
+	for (size_t slot = 0; slot < kMaxCapacity; slot++) {
+		slots[slot] = kNoOperation;
+	}
+	
+	CHECK(OperationRingInit(&ring, capacity, byteLimit, DropSlot, NULL));
+	
+	for (step = 0; step < steps; step++) {
+		int action = rand() % 10;
+		
+		if (action < 5) {
+			// Mostly small operations, now and then one bigger than the whole limit
+			size_t bytes = (rand() % 8 == 0) ? byteLimit + 1 + rand() % 10 : 1 + rand() % (byteLimit / 3 + 1);
+			int identifier = nextID++;
+			
+			size_t slot = OperationRingAdd(&ring, bytes);
+			CHECK(slot < capacity);
+			CHECK(slots[slot] == kNoOperation);
+			slots[slot] = identifier;
+			
+			ReferenceAdd(&log, identifier, bytes, capacity, byteLimit);
+		} else if (action < 7) {
+			if (OperationRingCanUndo(&ring)) {
+				OperationRingDidUndo(&ring);
+			}
+			if (log.undoCount > 0) {
+				log.undoCount--;
+			}
+		} else if (action < 9) {
+			if (OperationRingCanRedo(&ring)) {
+				OperationRingDidRedo(&ring);
+			}
+			if (log.undoCount < log.count) {
+				log.undoCount++;
+			}
+		} else if (rand() % 4 == 0) {
+			OperationRingRemoveAll(&ring);
+			log.count = 0;
+			log.undoCount = 0;
+		}
+		
+		CheckRing(&ring, &log);
+	}
+	
+	OperationRingRemoveAll(&ring);
+	for (size_t slot = 0; slot < capacity; slot++) {
+		CHECK(slots[slot] == kNoOperation);
+	}
+	OperationRingDestroy(&ring);
+}
+
+
+#pragma mark -
+#pragma mark Name delta
+
+#define kMaxNameLength 12
+
+static size_t RandomName(NameDeltaChar *name)
+{
+	size_t length = rand() % (kMaxNameLength + 1);
+	
+	// A small alphabet so that names share a lot, with the odd character outside the BMP's ASCII
+	for (size_t i = 0; i < length; i++) {
+		name[i] = (rand() % 16 == 0) ? 0xD83D : 'a' + rand() % 3;
+	}
+	
+	return length;
+}
+
+static void TestNameDelta(int steps)
+{
+	NameDeltaChar oldName[kMaxNameLength];
+	NameDeltaChar newName[kMaxNameLength];
+	NameDeltaChar result[2 * kMaxNameLength];
+	
+	for (step = 0; step < steps; step++) {
+		size_t oldLength = RandomName(oldName);
+		size_t newLength;
+		
+		// Half of the time an edit of the old name, the way names usually change
+		if (rand() % 2) {
+			newLength = RandomName(newName);
+		} else {
+			size_t at = oldLength ? rand() % (oldLength + 1) : 0;
+			size_t removed = (oldLength - at) ? rand() % (oldLength - at + 1) : 0;
+			size_t inserted = rand() % 4;
+			
+			newLength = 0;
+			for (size_t i = 0; i < at; i++) {
+				newName[newLength++] = oldName[i];
+			}
+			for (size_t i = 0; i < inserted && newLength < kMaxNameLength; i++) {
+				newName[newLength++] = 'a' + rand() % 3;
+			}
+			for (size_t i = at + removed; i < oldLength && newLength < kMaxNameLength; i++) {
+				newName[newLength++] = oldName[i];
+			}
+		}
+		
+		size_t prefix, suffix;
+		NameDeltaCompute(oldName, oldLength, newName, newLength, &prefix, &suffix);
+		
+		// Reference: longest common prefix, then longest common suffix of what's left
+		size_t shortest = oldLength < newLength ? oldLength : newLength;
+		size_t expectedPrefix = 0;
+		size_t expectedSuffix = 0;
+		while (expectedPrefix < shortest && oldName[expectedPrefix] == newName[expectedPrefix]) {
+			expectedPrefix++;
+		}
+		while (expectedPrefix + expectedSuffix < shortest &&
+			   oldName[oldLength - 1 - expectedSuffix] == newName[newLength - 1 - expectedSuffix]) {
+			expectedSuffix++;
+		}
+		CHECK(prefix == expectedPrefix);
+		CHECK(suffix == expectedSuffix);
+		
+		size_t removedLength = oldLength - prefix - suffix;
+		size_t insertedLength = newLength - prefix - suffix;
+		const NameDeltaChar *removedText = oldName + prefix;
+		const NameDeltaChar *insertedText = newName + prefix;
+		
+		// Redo turns the old name into the new one, undo the new one back
+		CHECK(NameDeltaApply(oldName, oldLength, prefix, removedLength, suffix, insertedText, insertedLength, result));
+		CHECK(memcmp(result, newName, newLength * sizeof(NameDeltaChar)) == 0);
+		CHECK(NameDeltaApply(newName, newLength, prefix, insertedLength, suffix, removedText, removedLength, result));
+		CHECK(memcmp(result, oldName, oldLength * sizeof(NameDeltaChar)) == 0);
+		
+		// A name of another length was changed some other way
+		if (newLength != oldLength) {
+			CHECK(!NameDeltaApply(newName, newLength, prefix, removedLength, suffix, insertedText, insertedLength, result));
+		}
+	}
+	
+	// Empty names
+	size_t prefix = 1, suffix = 1;
+	NameDeltaCompute(NULL, 0, NULL, 0, &prefix, &suffix);
+	CHECK(prefix == 0 && suffix == 0);
+	CHECK(NameDeltaApply(NULL, 0, 0, 0, 0, NULL, 0, result));
+}
+
+
+int main(int argc, char *argv[])
+{
+	seed = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 20110125;
+	
+	for (int run = 0; run < 50; run++, seed++) {
+		srand(seed);
+		TestRing(1 + rand() % kMaxCapacity, 1 + rand() % 200, 2000);
+		TestNameDelta(2000);
+	}
+	
+	printf("OperationLogTests passed\n");
+	return 0;
+}
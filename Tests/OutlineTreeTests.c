@@ -0,0 +1,282 @@
+//
+//  OutlineTreeTests.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/24/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Randomized tests of OutlineTree's rows: items of a random forest are expanded and collapsed at
+// random, and after every step the rows are compared with a reference list built by walking the
+// forest, which remembers which items are expanded the way the rows do while an ancestor is
+// collapsed. Items are checked to be retained once per row and released when the rows go away.
+
+#include "OutlineTreeCore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s (seed %u, step %d)\n", __FILE__, __LINE__, #condition, seed, step); \
+		exit(1); \
+	} \
+} while (0)
+
+static unsigned seed;
+static int step;
+
+#define kMaxItems 600
+#define kMaxChildren 6
+#define kMaxDepth 6
+
+typedef struct Item {
+	struct Item *children[kMaxChildren];
+	size_t childCount;
+	int expanded;
+	int retainCount;
+	int childrenAsked;
+} Item;
+
+typedef struct {
+	Item items[kMaxItems];
+	size_t itemCount;
+	Item *roots[kMaxItems];
+	size_t rootCount;
+} Forest;
+
+typedef struct {
+	const Item *item;
+	size_t depth;
+	int expanded;
+} ReferenceRow;
+
+static void RetainItem(void *info, const void *item)
+{
+	(void)info;
+	((Item *)item)->retainCount++;
+}
+
+static void ReleaseItem(void *info, const void *item)
+{
+	(void)info;
+	Item *theItem = (Item *)item;
+	
+	CHECK(theItem->retainCount > 0);
+	theItem->retainCount--;
+}
+
+static Item *ForestAddItem(Forest *forest, size_t depth)
+{
+	Item *item = &forest->items[forest->itemCount++];
+	
+	memset(item, 0, sizeof(Item));
+	if (depth < kMaxDepth) {
+		size_t childCount = (size_t)rand() % (kMaxChildren + 1);
+		if (rand() % 3 == 0) {
+			childCount = 0;  // plenty of leaves, and of items that expand to nothing
+		}
+		for (size_t i = 0; i < childCount && forest->itemCount < kMaxItems; i++) {
+			item->children[item->childCount++] = ForestAddItem(forest, depth + 1);
+		}
+	}
+	
+	return item;
+}
+
+static void ForestBuild(Forest *forest)
+{
+	forest->itemCount = 0;
+	forest->rootCount = 0;
+	
+	size_t rootCount = 1 + (size_t)rand() % 20;
+	for (size_t i = 0; i < rootCount && forest->itemCount < kMaxItems; i++) {
+		forest->roots[forest->rootCount++] = ForestAddItem(forest, 0);
+	}
+}
+
+static void AppendReferenceRows(const Item *item, size_t depth, ReferenceRow *rows, size_t *count)
+{
+	rows[*count].item = item;
+	rows[*count].depth = depth;
+	rows[*count].expanded = item->expanded;
+	(*count)++;
+	
+	if (item->expanded) {
+		for (size_t i = 0; i < item->childCount; i++) {
+			AppendReferenceRows(item->children[i], depth + 1, rows, count);
+		}
+	}
+}
+
+static size_t BuildReference(const Forest *forest, ReferenceRow *rows)
+{
+	size_t count = 0;
+	
+	for (size_t i = 0; i < forest->rootCount; i++) {
+		AppendReferenceRows(forest->roots[i], 0, rows, &count);
+	}
+	
+	return count;
+}
+
+static void CheckRows(const OutlineRows *rows, const Forest *forest)
+{
+	static ReferenceRow reference[kMaxItems];
+	size_t count = BuildReference(forest, reference);
+	
+	CHECK(OutlineRowsCount(rows) == count);
+	for (size_t i = 0; i < count; i++) {
+		CHECK(OutlineRowsItemAtIndex(rows, i) == reference[i].item);
+		CHECK(OutlineRowsDepthAtIndex(rows, i) == reference[i].depth);
+		CHECK(!OutlineRowsIsExpandedAtIndex(rows, i) == !reference[i].expanded);
+	}
+}
+
+// Items have a row, visible or hidden, from the first time their parent is expanded
+static void CheckRetainCounts(const Forest *forest)
+{
+	static int hasRow[kMaxItems];
+	
+	for (size_t i = 0; i < forest->itemCount; i++) {
+		hasRow[i] = 0;
+	}
+	for (size_t i = 0; i < forest->rootCount; i++) {
+		hasRow[forest->roots[i] - forest->items] = 1;
+	}
+	for (size_t i = 0; i < forest->itemCount; i++) {
+		const Item *item = &forest->items[i];
+		if (item->childrenAsked) {
+			for (size_t c = 0; c < item->childCount; c++) {
+				hasRow[item->children[c] - forest->items] = 1;
+			}
+		}
+	}
+	
+	for (size_t i = 0; i < forest->itemCount; i++) {
+		CHECK(forest->items[i].retainCount == hasRow[i]);
+	}
+}
+
+static size_t VisibleDescendantCount(const Item *item)
+{
+	size_t count = 0;
+	
+	for (size_t i = 0; i < item->childCount; i++) {
+		count += 1 + (item->children[i]->expanded ? VisibleDescendantCount(item->children[i]) : 0);
+	}
+	
+	return count;
+}
+
+static void TestRandomExpandCollapse(OutlineRows *rows, Forest *forest, int steps)
+{
+	ForestBuild(forest);
+	OutlineRowsRemoveAll(rows);
+	for (size_t i = 0; i < forest->rootCount; i++) {
+		CHECK(OutlineRowsAppendItem(rows, forest->roots[i]));
+	}
+	CheckRows(rows, forest);
+	
+	for (step = 0; step < steps; step++) {
+		size_t index = (size_t)rand() % OutlineRowsCount(rows);
+		Item *item = (Item *)OutlineRowsItemAtIndex(rows, index);
+		
+		// Mostly flip the item, sometimes ask for what it already is, which does nothing
+		int expand = item->expanded ? (rand() % 8 == 0) : (rand() % 8 != 0);
+		
+		if (expand) {
+			int needsChildren = OutlineRowsNeedsChildrenAtIndex(rows, index);
+			// Children are only needed the first time, or again if there were none
+			CHECK(!needsChildren == (item->expanded || (item->childrenAsked && item->childCount > 0)));
+			
+			const void *children[kMaxChildren];
+			size_t childCount = 0;
+			if (needsChildren) {
+				item->childrenAsked = 1;
+				for (size_t i = 0; i < item->childCount; i++) {
+					children[childCount++] = item->children[i];
+				}
+			}
+			
+			size_t expected = item->expanded ? 0 : VisibleDescendantCount(item);
+			CHECK(OutlineRowsExpandItemAtIndex(rows, index, children, childCount) == expected);
+			item->expanded = 1;
+		} else {
+			size_t expected = item->expanded ? VisibleDescendantCount(item) : 0;
+			CHECK(OutlineRowsCollapseItemAtIndex(rows, index) == expected);
+			item->expanded = 0;
+		}
+		
+		CheckRows(rows, forest);
+		CheckRetainCounts(forest);
+	}
+	
+	// Everything goes, hidden rows included
+	OutlineRowsRemoveAll(rows);
+	CHECK(OutlineRowsCount(rows) == 0);
+	for (size_t i = 0; i < forest->itemCount; i++) {
+		CHECK(forest->items[i].retainCount == 0);
+	}
+}
+
+// Collapsing the root of a deep, fully expanded subtree and expanding it again gives back the
+// same rows, with whatever was expanded below it still expanded
+static void TestCollapseKeepsDescendants(OutlineRows *rows)
+{
+	Item items[4] = {{{0}, 0, 0, 0, 0}};
+	
+	step = -1;
+	items[0].children[0] = &items[1];
+	items[0].childCount = 1;
+	items[1].children[0] = &items[2];
+	items[1].children[1] = &items[3];
+	items[1].childCount = 2;
+	
+	OutlineRowsRemoveAll(rows);
+	CHECK(OutlineRowsAppendItem(rows, &items[0]));
+	
+	const void *children0[] = { &items[1] };
+	const void *children1[] = { &items[2], &items[3] };
+	CHECK(OutlineRowsExpandItemAtIndex(rows, 0, children0, 1) == 1);
+	CHECK(OutlineRowsExpandItemAtIndex(rows, 1, children1, 2) == 2);
+	CHECK(OutlineRowsCount(rows) == 4);
+	
+	CHECK(OutlineRowsCollapseItemAtIndex(rows, 0) == 3);
+	CHECK(OutlineRowsCount(rows) == 1);
+	CHECK(!OutlineRowsNeedsChildrenAtIndex(rows, 0));
+	CHECK(OutlineRowsExpandItemAtIndex(rows, 0, NULL, 0) == 3);
+	CHECK(OutlineRowsItemAtIndex(rows, 3) == &items[3]);
+	CHECK(OutlineRowsDepthAtIndex(rows, 3) == 2);
+	CHECK(OutlineRowsIsExpandedAtIndex(rows, 1));
+	
+	// Already expanded or collapsed
+	CHECK(OutlineRowsExpandItemAtIndex(rows, 0, NULL, 0) == 0);
+	CHECK(OutlineRowsCollapseItemAtIndex(rows, 2) == 0);
+	
+	OutlineRowsRemoveAll(rows);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static Forest forest;
+	OutlineRows rows;
+	
+	seed = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 20110124;
+	
+	OutlineRowsInit(&rows, seed, RetainItem, ReleaseItem, NULL);
+	TestCollapseKeepsDescendants(&rows);
+	OutlineRowsDestroy(&rows);
+	
+	for (int run = 0; run < 200; run++, seed++) {
+		srand(seed);
+		OutlineRowsInit(&rows, seed, RetainItem, ReleaseItem, NULL);
+		TestRandomExpandCollapse(&rows, &forest, 300);
+		OutlineRowsDestroy(&rows);
+	}
+	
+	printf("OutlineTreeTests passed\n");
+	return 0;
+}
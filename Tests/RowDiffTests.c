@@ -0,0 +1,315 @@
+//
+//  RowDiffTests.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/20/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Randomized tests of RowDiff's matching: a list of rows is mutated at random, and the changes
+// computed between the old and new lists are applied to the old one the way a table view applies
+// a batch of updates, which has to give back the new list. Moves are checked to be minimal
+// against a brute force longest increasing subsequence.
+
+#include "RowDiffCore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s (seed %u, step %d)\n", __FILE__, __LINE__, #condition, seed, step); \
+		exit(1); \
+	} \
+} while (0)
+
+static unsigned seed;
+static int step;
+
+#define kMaxRows 300
+
+typedef struct {
+	uintptr_t identifier;
+	int value;
+} Row;
+
+typedef struct {
+	Row rows[kMaxRows];
+	size_t count;
+} RowList;
+
+static int ValuesDiffer(void *info, size_t oldIndex, size_t newIndex)
+{
+	const RowList *lists = info;
+	
+	return lists[0].rows[oldIndex].value != lists[1].rows[newIndex].value;
+}
+
+static void Mutate(const RowList *oldList, RowList *newList, uintptr_t *nextID, int allowDuplicates)
+{
+	*newList = *oldList;
+	
+	int mutations = rand() % 12;
+	
+	for (int m = 0; m < mutations; m++) {
+		int kind = rand() % 5;
+		size_t count = newList->count;
+		
+		if (kind == 0 && count > 0) {
+			size_t i = (size_t)rand() % count;
+			memmove(&newList->rows[i], &newList->rows[i + 1], (count - i - 1) * sizeof(Row));
+			newList->count--;
+		} else if (kind == 1 && count < kMaxRows) {
+			size_t i = (size_t)rand() % (count + 1);
+			memmove(&newList->rows[i + 1], &newList->rows[i], (count - i) * sizeof(Row));
+			newList->rows[i].identifier = (allowDuplicates && count > 0 && rand() % 4 == 0)
+										  ? newList->rows[rand() % count].identifier : (*nextID)++;
+			newList->rows[i].value = rand() % 4;
+			newList->count++;
+		} else if (kind == 2 && count > 1) {
+			size_t from = (size_t)rand() % count;
+			size_t to = (size_t)rand() % count;
+			Row row = newList->rows[from];
+			
+			memmove(&newList->rows[from], &newList->rows[from + 1], (count - from - 1) * sizeof(Row));
+			memmove(&newList->rows[to + 1], &newList->rows[to], (count - 1 - to) * sizeof(Row));
+			newList->rows[to] = row;
+		} else if (kind == 3 && count > 0) {
+			newList->rows[rand() % count].value = rand() % 4;
+		} else if (kind == 4 && count > 1 && rand() % 10 == 0) {
+			// Everything shuffled
+			for (size_t i = count - 1; i > 0; i--) {
+				size_t j = (size_t)rand() % (i + 1);
+				Row row = newList->rows[i];
+				newList->rows[i] = newList->rows[j];
+				newList->rows[j] = row;
+			}
+		}
+	}
+}
+
+// Pairs as RowDiffCompute documents them, then the longest increasing subsequence by brute force
+static size_t ReferenceStayingCount(const RowList *oldList, const RowList *newList)
+{
+	size_t pairNew[kMaxRows];
+	char matched[kMaxRows] = { 0 };
+	size_t pairs = 0;
+	
+	for (size_t i = 0; i < oldList->count; i++) {
+		size_t last = (size_t)-1;
+		
+		for (size_t j = 0; j < newList->count; j++) {
+			if (newList->rows[j].identifier == oldList->rows[i].identifier) {
+				last = j;
+			}
+		}
+		
+		if (last != (size_t)-1 && !matched[last]) {
+			matched[last] = 1;
+			pairNew[pairs++] = last;
+		}
+	}
+	
+	size_t lengths[kMaxRows];
+	size_t longest = 0;
+	
+	for (size_t p = 0; p < pairs; p++) {
+		lengths[p] = 1;
+		for (size_t q = 0; q < p; q++) {
+			if (pairNew[q] < pairNew[p] && lengths[q] + 1 > lengths[p]) {
+				lengths[p] = lengths[q] + 1;
+			}
+		}
+		if (lengths[p] > longest) {
+			longest = lengths[p];
+		}
+	}
+	
+	return longest;
+}
+
+static int Contains(const size_t *indexes, size_t count, size_t index)
+{
+	for (size_t k = 0; k < count; k++) {
+		if (indexes[k] == index) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Applies the batch as UITableView does: deletes, reloads and move sources against the old
+// rows, inserts and move destinations against the new ones, the rest keeping their order
+static void CheckChanges(const RowList *lists, const RowDiffChanges *changes)
+{
+	const RowList *oldList = &lists[0];
+	const RowList *newList = &lists[1];
+	char deletedOrMoved[kMaxRows] = { 0 };
+	char filled[kMaxRows] = { 0 };
+	size_t sourceOfRow[kMaxRows];
+	Row result[kMaxRows];
+	
+	for (size_t k = 0; k < changes->deletedCount; k++) {
+		CHECK(changes->deleted[k] < oldList->count && !deletedOrMoved[changes->deleted[k]]);
+		deletedOrMoved[changes->deleted[k]] = 1;
+	}
+	for (size_t k = 0; k < changes->movedCount; k++) {
+		CHECK(changes->movedFrom[k] < oldList->count && !deletedOrMoved[changes->movedFrom[k]]);
+		deletedOrMoved[changes->movedFrom[k]] = 1;
+	}
+	for (size_t k = 0; k < changes->updatedCount; k++) {
+		CHECK(changes->updated[k] < oldList->count && !deletedOrMoved[changes->updated[k]]);
+		CHECK(!Contains(changes->updated, k, changes->updated[k]));
+	}
+	
+	for (size_t k = 0; k < changes->insertedCount; k++) {
+		size_t j = changes->inserted[k];
+		
+		CHECK(j < newList->count && !filled[j]);
+		filled[j] = 1;
+		result[j] = newList->rows[j];
+		sourceOfRow[j] = (size_t)-1;
+	}
+	for (size_t k = 0; k < changes->movedCount; k++) {
+		size_t j = changes->movedTo[k];
+		
+		CHECK(j < newList->count && !filled[j]);
+		filled[j] = 1;
+		result[j] = oldList->rows[changes->movedFrom[k]];
+		sourceOfRow[j] = changes->movedFrom[k];
+	}
+	
+	CHECK(oldList->count - changes->deletedCount - changes->movedCount ==
+		  newList->count - changes->insertedCount - changes->movedCount);
+	
+	size_t j = 0;
+	for (size_t i = 0; i < oldList->count; i++) {
+		if (deletedOrMoved[i]) {
+			continue;
+		}
+		while (filled[j]) {
+			j++;
+		}
+		filled[j] = 1;
+		result[j] = oldList->rows[i];
+		sourceOfRow[j] = i;
+	}
+	
+	// Reloaded rows take the new contents at wherever they ended up
+	for (j = 0; j < newList->count; j++) {
+		if (sourceOfRow[j] != (size_t)-1 && Contains(changes->updated, changes->updatedCount, sourceOfRow[j])) {
+			CHECK(result[j].value != newList->rows[j].value);
+			result[j].value = newList->rows[j].value;
+		}
+	}
+	
+	for (j = 0; j < newList->count; j++) {
+		CHECK(result[j].identifier == newList->rows[j].identifier);
+		CHECK(result[j].value == newList->rows[j].value);
+	}
+	
+	// Only the rows outside of the longest run that kept its order were moved
+	CHECK(oldList->count - changes->deletedCount - changes->movedCount == ReferenceStayingCount(oldList, newList));
+}
+
+static int ListsAreEqual(const RowList *list1, const RowList *list2)
+{
+	if (list1->count != list2->count) {
+		return 0;
+	}
+	
+	for (size_t i = 0; i < list1->count; i++) {
+		if (list1->rows[i].identifier != list2->rows[i].identifier || list1->rows[i].value != list2->rows[i].value) {
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+static void TestRandomEdits(int steps, int allowDuplicates)
+{
+	RowList lists[2];
+	uintptr_t nextID = 1;
+	
+	lists[0].count = (size_t)rand() % 40;
+	for (size_t i = 0; i < lists[0].count; i++) {
+		lists[0].rows[i].identifier = nextID++;
+		lists[0].rows[i].value = rand() % 4;
+	}
+	
+	for (step = 0; step < steps; step++) {
+		RowDiffChanges changes;
+		
+		Mutate(&lists[0], &lists[1], &nextID, allowDuplicates);
+		
+		CHECK(RowDiffCompute(NULL, 0, NULL, 0, ValuesDiffer, lists, &changes));
+		CHECK(changes.deletedCount + changes.insertedCount + changes.updatedCount + changes.movedCount == 0);
+		RowDiffChangesFree(&changes);
+		
+		uintptr_t oldIds[kMaxRows];
+		uintptr_t newIds[kMaxRows];
+		
+		for (size_t i = 0; i < lists[0].count; i++) {
+			oldIds[i] = lists[0].rows[i].identifier;
+		}
+		for (size_t i = 0; i < lists[1].count; i++) {
+			newIds[i] = lists[1].rows[i].identifier;
+		}
+		
+		CHECK(RowDiffCompute(oldIds, lists[0].count, newIds, lists[1].count, ValuesDiffer, lists, &changes));
+		CheckChanges(lists, &changes);
+		
+		// Nothing changed, nothing to do, as long as ids are unique: a repeated id only pairs once
+		if (!allowDuplicates && ListsAreEqual(&lists[0], &lists[1])) {
+			CHECK(changes.deletedCount + changes.insertedCount + changes.updatedCount + changes.movedCount == 0);
+		}
+		
+		RowDiffChangesFree(&changes);
+		
+		lists[0] = lists[1];
+	}
+	
+	step = 0;
+}
+
+static void TestKnownMoves(void)
+{
+	// 1 2 3 4 5 to 2 3 4 5 1: one move, not four
+	RowList lists[2] = { { { { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 5, 0 } }, 5 },
+						 { { { 2, 0 }, { 3, 0 }, { 4, 0 }, { 5, 0 }, { 1, 0 } }, 5 } };
+	uintptr_t oldIds[] = { 1, 2, 3, 4, 5 };
+	uintptr_t newIds[] = { 2, 3, 4, 5, 1 };
+	RowDiffChanges changes;
+	
+	CHECK(RowDiffCompute(oldIds, 5, newIds, 5, ValuesDiffer, lists, &changes));
+	CHECK(changes.movedCount == 1 && changes.movedFrom[0] == 0 && changes.movedTo[0] == 4);
+	CHECK(changes.deletedCount == 0 && changes.insertedCount == 0 && changes.updatedCount == 0);
+	RowDiffChangesFree(&changes);
+	
+	// The same move with new contents is a delete and an insert
+	lists[1].rows[4].value = 1;
+	CHECK(RowDiffCompute(oldIds, 5, newIds, 5, ValuesDiffer, lists, &changes));
+	CHECK(changes.movedCount == 0);
+	CHECK(changes.deletedCount == 1 && changes.deleted[0] == 0);
+	CHECK(changes.insertedCount == 1 && changes.inserted[0] == 4);
+	CheckChanges(lists, &changes);
+	RowDiffChangesFree(&changes);
+}
+
+
+int main(int argc, char *argv[])
+{
+	seed = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 20110120;
+	
+	TestKnownMoves();
+	
+	for (int run = 0; run < 200; run++, seed++) {
+		srand(seed);
+		TestRandomEdits(200, run % 2);
+	}
+	
+	printf("RowDiffTests passed\n");
+	return 0;
+}
@@ -0,0 +1,266 @@
+//
+//  SectionGroupingBenchmark.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/20/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Host-side harness for the grouping pass of SCTableViewModel's generateSections. Both versions
+// of the pass are written out in C with strings standing in for header titles:
+//
+//   scan  - the old pass: sectionWithHeaderTitle:'s linear scan over the sections built so far
+//           for every item, and addSection:'s sort of all sections for every new section.
+//   map   - the current pass: the previous item's section first, then a hash map keyed by header
+//           title, and a single sort of the sections at the end.
+//
+// Both are checked to build the same sections, then timed over items in random order and over
+// items already grouped by title, for a range of item and section counts.
+//
+//   ./SectionGroupingBenchmark [seed]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static unsigned seed;
+
+typedef struct {
+	const char *headerTitle;
+	size_t *items;
+	size_t itemCount;
+	size_t itemCapacity;
+} Section;
+
+typedef struct {
+	Section *sections;
+	size_t count;
+} SectionList;
+
+static void SectionAddItem(Section *section, size_t item)
+{
+	if (section->itemCount == section->itemCapacity) {
+		section->itemCapacity = section->itemCapacity ? section->itemCapacity * 2 : 8;
+		section->items = realloc(section->items, section->itemCapacity * sizeof(size_t));
+		if (!section->items)
+			abort();
+	}
+	section->items[section->itemCount++] = item;
+}
+
+static size_t SectionListAdd(SectionList *list, const char *headerTitle)
+{
+	Section *section = &list->sections[list->count];
+	
+	memset(section, 0, sizeof(Section));
+	section->headerTitle = headerTitle;
+	
+	return list->count++;
+}
+
+static void SectionListFree(SectionList *list)
+{
+	for (size_t i = 0; i < list->count; i++)
+		free(list->sections[i].items);
+	free(list->sections);
+}
+
+static int CompareSections(const void *a, const void *b)
+{
+	return strcmp(((const Section *)a)->headerTitle, ((const Section *)b)->headerTitle);
+}
+
+// The old pass. Sections move while being sorted, so the scan has to come first for every item.
+static SectionList GroupByScan(const char **titles, size_t count, size_t sectionCapacity)
+{
+	SectionList list = { calloc(sectionCapacity, sizeof(Section)), 0 };
+	
+	for (size_t i = 0; i < count; i++) {
+		Section *section = NULL;
+		for (size_t s = 0; s < list.count; s++)
+			if (strcmp(list.sections[s].headerTitle, titles[i]) == 0) {
+				section = &list.sections[s];
+				break;
+			}
+		
+		if (!section) {
+			SectionListAdd(&list, titles[i]);
+			qsort(list.sections, list.count, sizeof(Section), CompareSections);
+			for (size_t s = 0; s < list.count; s++)
+				if (list.sections[s].headerTitle == titles[i])
+					section = &list.sections[s];
+		}
+		SectionAddItem(section, i);
+	}
+	
+	return list;
+}
+
+static uint32_t HashTitle(const char *title)
+{
+	uint32_t hash = 2166136261u;
+	
+	for (; *title; title++)
+		hash = (hash ^ (unsigned char)*title) * 16777619u;
+	
+	return hash;
+}
+
+// The current pass. The map holds section indexes, which stay put until the final sort.
+static SectionList GroupByMap(const char **titles, size_t count, size_t sectionCapacity)
+{
+	SectionList list = { calloc(sectionCapacity, sizeof(Section)), 0 };
+	size_t mapSize = 16;
+	
+	while (mapSize < sectionCapacity * 2)
+		mapSize *= 2;
+	size_t *map = malloc(mapSize * sizeof(size_t));
+	memset(map, 0xff, mapSize * sizeof(size_t));
+	
+	size_t lastSection = SIZE_MAX;
+	const char *lastTitle = NULL;
+	
+	for (size_t i = 0; i < count; i++) {
+		size_t section = SIZE_MAX;
+		
+		if (lastSection != SIZE_MAX && (titles[i] == lastTitle || strcmp(titles[i], lastTitle) == 0)) {
+			section = lastSection;
+		} else {
+			size_t slot = HashTitle(titles[i]) & (mapSize - 1);
+			
+			while (map[slot] != SIZE_MAX) {
+				if (strcmp(list.sections[map[slot]].headerTitle, titles[i]) == 0) {
+					section = map[slot];
+					break;
+				}
+				slot = (slot + 1) & (mapSize - 1);
+			}
+			if (section == SIZE_MAX) {
+				section = SectionListAdd(&list, titles[i]);
+				map[slot] = section;
+			}
+		}
+		SectionAddItem(&list.sections[section], i);
+		
+		lastSection = section;
+		lastTitle = titles[i];
+	}
+	free(map);
+	
+	qsort(list.sections, list.count, sizeof(Section), CompareSections);
+	
+	return list;
+}
+
+static int SectionListsAreEqual(const SectionList *a, const SectionList *b)
+{
+	if (a->count != b->count)
+		return 0;
+	
+	for (size_t s = 0; s < a->count; s++) {
+		const Section *x = &a->sections[s];
+		const Section *y = &b->sections[s];
+		
+		if (strcmp(x->headerTitle, y->headerTitle) != 0 || x->itemCount != y->itemCount)
+			return 0;
+		if (memcmp(x->items, y->items, x->itemCount * sizeof(size_t)) != 0)
+			return 0;
+	}
+	
+	return 1;
+}
+
+static double Now(void)
+{
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Best of a few runs, in milliseconds
+static double TimePass(SectionList (*pass)(const char **, size_t, size_t), const char **titles, size_t count, size_t sectionCount)
+{
+	double best = 0;
+	
+	for (int run = 0; run < 3; run++) {
+		double start = Now();
+		SectionList list = pass(titles, count, sectionCount);
+		double elapsed = (Now() - start) * 1000;
+		
+		SectionListFree(&list);
+		if (run == 0 || elapsed < best)
+			best = elapsed;
+	}
+	
+	return best;
+}
+
+static int CompareTitles(const void *a, const void *b)
+{
+	return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+static void Measure(size_t count, size_t sectionCount)
+{
+	// Titles are distinct strings per item, as a data source returning new strings would give
+	char (*storage)[32] = malloc(count * sizeof(*storage));
+	const char **titles = malloc(count * sizeof(char *));
+	
+	for (size_t i = 0; i < count; i++) {
+		size_t section = (i < sectionCount) ? i : (size_t)rand() % sectionCount;
+		snprintf(storage[i], sizeof(storage[i]), "Group %05zu", section);
+		titles[i] = storage[i];
+	}
+	for (size_t i = count - 1; i > 0; i--) {
+		size_t j = (size_t)rand() % (i + 1);
+		const char *title = titles[i];
+		titles[i] = titles[j];
+		titles[j] = title;
+	}
+	
+	SectionList expected = GroupByScan(titles, count, sectionCount);
+	SectionList actual = GroupByMap(titles, count, sectionCount);
+	if (!SectionListsAreEqual(&expected, &actual)) {
+		fprintf(stderr, "grouping differs for %zu items in %zu sections (seed %u)\n", count, sectionCount, seed);
+		exit(1);
+	}
+	SectionListFree(&expected);
+	SectionListFree(&actual);
+	
+	double scanShuffled = TimePass(GroupByScan, titles, count, sectionCount);
+	double mapShuffled = TimePass(GroupByMap, titles, count, sectionCount);
+	
+	qsort(titles, count, sizeof(char *), CompareTitles);
+	double scanGrouped = TimePass(GroupByScan, titles, count, sectionCount);
+	double mapGrouped = TimePass(GroupByMap, titles, count, sectionCount);
+	
+	printf("%8zu %8zu   %10.2f %10.2f %8.1f   %10.2f %10.2f %8.1f\n", count, sectionCount,
+		   scanShuffled, mapShuffled, mapShuffled * 1e6 / count, scanGrouped, mapGrouped, mapGrouped * 1e6 / count);
+	
+	free(titles);
+	free(storage);
+}
+
+int main(int argc, char *argv[])
+{
+	seed = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : (unsigned)time(NULL);
+	srand(seed);
+	
+	printf("seed %u, best of 3 runs\n", seed);
+	printf("                      random order (ms, ns/item)            grouped order (ms, ns/item)\n");
+	printf("   items sections         scan        map  map/item         scan        map  map/item\n");
+	
+	static const size_t sectionCounts[] = { 100, 300, 1000 };
+	for (size_t s = 0; s < sizeof(sectionCounts) / sizeof(sectionCounts[0]); s++)
+		Measure(50000, sectionCounts[s]);
+	
+	static const size_t itemCounts[] = { 12500, 25000, 50000, 100000, 200000 };
+	for (size_t n = 0; n < sizeof(itemCounts) / sizeof(itemCounts[0]); n++)
+		Measure(itemCounts[n], 300);
+	
+	return 0;
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+#
+#  StoreCompactionBenchmark.py
+#  GreenBoardPro
+#
+#  Created by Oscar Del Ben on 1/27/11.
+#  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+#
+# Host-side benchmark of compacting the store (see IdeaStoreMeasurementOperation): builds a store
+# with Core Data's layout for the Idea entity, deletes big subtrees the way a user clearing out a
+# board would, then measures the file and what a launch reads from it before and after VACUUM and
+# ANALYZE.
+#
+# Reads are measured in bytes the process asked the file system for (rchar in /proc/self/io),
+# which doesn't depend on what the OS happens to have cached, next to wall clock time.
+#
+#   python3 StoreCompactionBenchmark.py [idea count] [seed]
+
+import os
+import random
+import sqlite3
+import struct
+import sys
+import tempfile
+import time
+
+# Same thresholds as IdeaStore.m
+VACUUM_MINIMUM_FREE_BYTES = 256 * 1024
+VACUUM_MINIMUM_FREE_FRACTION = 0.25
+
+SCHEMA = """
+CREATE TABLE ZIDEA (Z_PK INTEGER PRIMARY KEY, Z_ENT INTEGER, Z_OPT INTEGER, ZPARENT INTEGER,
+                    ZTIMESTAMP TIMESTAMP, ZNAME VARCHAR);
+CREATE INDEX ZIDEA_ZPARENT_INDEX ON ZIDEA (ZPARENT);
+"""
+
+
+def free_bytes(path):
+    """Same header parsing as +[IdeaStore freeBytesInStoreAtURL:fileSize:]."""
+    size = os.path.getsize(path)
+    with open(path, 'rb') as f:
+        header = f.read(100)
+    if len(header) < 100 or header[:16] != b'SQLite format 3\0':
+        return 0, size
+    page_size = struct.unpack('>H', header[16:18])[0]
+    if page_size == 1:
+        page_size = 65536
+    free_pages = struct.unpack('>I', header[36:40])[0]
+    return min(free_pages * page_size, size), size
+
+
+def needs_compaction(path, idea_count, bytes_per_idea):
+    """Same decision as +[IdeaStore storeAtURL:needsCompactionWithIdeaCount:], also returning the
+    decision from the free pages in the header alone."""
+    free, size = free_bytes(path)
+    header_only = free >= VACUUM_MINIMUM_FREE_BYTES and free >= size * VACUUM_MINIMUM_FREE_FRACTION
+    if size < VACUUM_MINIMUM_FREE_BYTES:
+        return False, header_only
+    if bytes_per_idea > 0:
+        free = max(free, size - bytes_per_idea * idea_count)
+    return free >= VACUUM_MINIMUM_FREE_BYTES and free >= size * VACUUM_MINIMUM_FREE_FRACTION, header_only
+
+
+def idea_count(path):
+    db = sqlite3.connect(path)
+    count = db.execute('SELECT COUNT(*) FROM ZIDEA').fetchone()[0]
+    db.close()
+    return count
+
+
+def vacuum(path):
+    db = sqlite3.connect(path)
+    db.execute('VACUUM')
+    db.execute('ANALYZE')
+    db.close()
+    free, size = free_bytes(path)
+    return float(size - free) / idea_count(path)
+
+
+def read_bytes():
+    with open('/proc/self/io') as f:
+        for line in f:
+            if line.startswith('rchar:'):
+                return int(line.split()[1])
+    return 0
+
+
+def build(path, count, rng, refill):
+    db = sqlite3.connect(path)
+    db.execute('PRAGMA page_size = 4096')
+    db.executescript(SCHEMA)
+    stamp = 0.0
+    ideas = []
+    for pk in range(1, count + 1):
+        # A few dozen top level ideas, everything else anywhere under them
+        parent = rng.choice(ideas) if pk > 40 else None
+        stamp += 1.0
+        name = 'Idea %d %s' % (pk, 'x' * rng.randint(0, 60))
+        db.execute('INSERT INTO ZIDEA VALUES (?, 1, 1, ?, ?, ?)', (pk, parent, stamp, name))
+        ideas.append(pk)
+    db.commit()
+    db.close()
+
+    # The board as it was right after the last compaction
+    bytes_per_idea = vacuum(path)
+
+    # Clear out half of the top level. When refilling, ideas keep being added under what's left
+    # afterwards: they reuse the freed pages, so the file has few free pages left but the rows of
+    # a level end up scattered across it.
+    db = sqlite3.connect(path)
+    survivors = list(range(1, 41))
+    for victim in rng.sample(survivors, 20):
+        survivors.remove(victim)
+        db.execute("""WITH RECURSIVE subtree(pk) AS (SELECT ? UNION ALL
+                      SELECT Z_PK FROM ZIDEA JOIN subtree ON ZPARENT = pk)
+                      DELETE FROM ZIDEA WHERE Z_PK IN subtree""", (victim,))
+        db.commit()
+    for pk in range(count + 1, count + (count // 10 if refill else 0) + 1):
+        stamp += 1.0
+        db.execute('INSERT INTO ZIDEA VALUES (?, 1, 1, ?, ?, ?)', (pk, rng.choice(survivors), stamp, 'New idea %d' % pk))
+    db.commit()
+    db.close()
+    return bytes_per_idea
+
+
+def launch_read(path):
+    """What a launch reads: the top level, then every level breadth first the way the level
+    prefetcher and the backup's snapshot walk it, on a fresh connection."""
+    before = read_bytes()
+    start = time.perf_counter()
+    db = sqlite3.connect(path)
+    db.execute('PRAGMA cache_size = 100')  # about what Core Data's connection keeps on a device
+    levels = [None]
+    rows = 0
+    while levels:
+        parent = levels.pop(0)
+        if parent is None:
+            result = db.execute('SELECT Z_PK, ZNAME FROM ZIDEA WHERE ZPARENT IS NULL ORDER BY ZTIMESTAMP').fetchall()
+        else:
+            result = db.execute('SELECT Z_PK, ZNAME FROM ZIDEA WHERE ZPARENT = ? ORDER BY ZTIMESTAMP', (parent,)).fetchall()
+        rows += len(result)
+        levels.extend(pk for pk, _ in result)
+    db.close()
+    return rows, time.perf_counter() - start, read_bytes() - before
+
+
+def measure(label, path, bytes_per_idea, repeats=5):
+    free, size = free_bytes(path)
+    results = [launch_read(path) for _ in range(repeats)]
+    rows = results[0][0]
+    seconds = sorted(r[1] for r in results)[repeats // 2]
+    read = results[-1][2]
+    needs, header_only = needs_compaction(path, idea_count(path), bytes_per_idea)
+    print('%-7s %9d bytes, %8d in free pages, compaction %-3s (%-3s from free pages alone), '
+          '%6d ideas read in %7.1f ms, %10d bytes read'
+          % (label, size, free, 'yes' if needs else 'no', 'yes' if header_only else 'no', rows, seconds * 1000, read))
+    return size, seconds, read
+
+
+def run(label, count, seed, refill):
+    print(label)
+    directory = tempfile.mkdtemp()
+    path = os.path.join(directory, 'Ideas.sqlite')
+
+    bytes_per_idea = build(path, count, random.Random(seed), refill)
+    size_before, seconds_before, read_before = measure('before', path, bytes_per_idea)
+
+    bytes_per_idea = vacuum(path)
+    size_after, seconds_after, read_after = measure('after', path, bytes_per_idea)
+
+    print('file %.0f%% smaller, launch read %.0f%% faster with %.0f%% fewer bytes read\n'
+          % (100.0 * (size_before - size_after) / size_before,
+             100.0 * (seconds_before - seconds_after) / seconds_before,
+             100.0 * (read_before - read_after) / read_before))
+
+    os.remove(path)
+    os.rmdir(directory)
+
+
+def main():
+    count = int(sys.argv[1]) if len(sys.argv) > 1 else 20000
+    seed = int(sys.argv[2]) if len(sys.argv) > 2 else 20110127
+
+    run('Half of the board deleted', count, seed, False)
+    run('Half of the board deleted, then refilled by 10%', count, seed, True)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,908 @@
+//
+//  StoreTests.c
+//  GreenBoardPro
+//
+//  Created by Oscar Del Ben on 1/27/11.
+//  Copyright 2011 Dibi Store di Del Ben Oscar. All rights reserved.
+//
+
+// Tests of what IdeaStore does to the store behind Core Data's back: reading the free pages from
+// the header, swapping files in and out with their journals, and salvaging ideas from damaged
+// SQLite files. The damaged files are real stores with the table Core Data keeps ideas in, with
+// bits flipped, cut short, or with pages torn half way through a write.
+
+#include "IdeaStoreFile.h"
+#include "IdeaSalvageStore.h"
+
+#include <math.h>
+#include <sqlite3.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s (seed %u, step %d)\n", __FILE__, __LINE__, #condition, seed, step); \
+		exit(1); \
+	} \
+} while (0)
+
+static unsigned seed;
+static int step;
+
+static char directory[256];
+
+
+#pragma mark -
+#pragma mark Files
+
+static const char *PathNamed(const char *name)
+{
+	static char paths[8][512];
+	static int next;
+	char *path = paths[next++ % 8];
+	
+	snprintf(path, 512, "%s/%s", directory, name);
+	return path;
+}
+
+static void WriteFile(const char *path, const void *bytes, size_t length)
+{
+	FILE *file = fopen(path, "wb");
+	
+	CHECK(file != NULL);
+	CHECK(fwrite(bytes, 1, length, file) == length);
+	fclose(file);
+}
+
+static void WriteString(const char *path, const char *contents)
+{
+	WriteFile(path, contents, strlen(contents));
+}
+
+// Returns a malloc'd copy of the file, NULL if there's none
+static unsigned char *ReadFile(const char *path, size_t *length)
+{
+	FILE *file = fopen(path, "rb");
+	
+	if (file == NULL) {
+		return NULL;
+	}
+	
+	fseek(file, 0, SEEK_END);
+	*length = (size_t)ftell(file);
+	fseek(file, 0, SEEK_SET);
+	
+	unsigned char *bytes = malloc(*length + 1);
+	CHECK(bytes != NULL);
+	CHECK(fread(bytes, 1, *length, file) == *length);
+	bytes[*length] = 0;
+	fclose(file);
+	
+	return bytes;
+}
+
+static int FileHasContents(const char *path, const char *contents)
+{
+	size_t length;
+	unsigned char *bytes = ReadFile(path, &length);
+	int matches = bytes && length == strlen(contents) && memcmp(bytes, contents, length) == 0;
+	
+	free(bytes);
+	return matches;
+}
+
+static int FileExists(const char *path)
+{
+	struct stat status;
+	
+	return lstat(path, &status) == 0;
+}
+
+static void RemoveAllFiles(void)
+{
+	char command[600];
+	
+	snprintf(command, sizeof(command), "rm -f '%s'/*", directory);
+	CHECK(system(command) == 0);
+}
+
+
+#pragma mark -
+#pragma mark Stores
+
+static void Execute(sqlite3 *db, const char *sql)
+{
+	char *message = NULL;
+	
+	if (sqlite3_exec(db, sql, NULL, NULL, &message) != SQLITE_OK) {
+		fprintf(stderr, "%s: %s\n", sql, message);
+		CHECK(0);
+	}
+}
+
+static long long QueryInteger(sqlite3 *db, const char *sql)
+{
+	sqlite3_stmt *statement;
+	
+	CHECK(sqlite3_prepare_v2(db, sql, -1, &statement, NULL) == SQLITE_OK);
+	CHECK(sqlite3_step(statement) == SQLITE_ROW);
+	long long value = sqlite3_column_int64(statement, 0);
+	sqlite3_finalize(statement);
+	
+	return value;
+}
+
+// The table Core Data keeps ideas in, parents first so that keys look like the app's
+static sqlite3 *CreateStore(const char *path, int pageSize)
+{
+	sqlite3 *db;
+	char sql[64];
+	
+	unlink(path);
+	CHECK(sqlite3_open(path, &db) == SQLITE_OK);
+	
+	snprintf(sql, sizeof(sql), "PRAGMA page_size = %d", pageSize);
+	Execute(db, sql);
+	Execute(db, "CREATE TABLE ZIDEA (Z_PK INTEGER PRIMARY KEY, Z_ENT INTEGER, Z_OPT INTEGER, "
+				"ZPARENT INTEGER, ZTIMESTAMP TIMESTAMP, ZNAME VARCHAR)");
+	Execute(db, "CREATE INDEX ZIDEA_ZPARENT_INDEX ON ZIDEA (ZPARENT)");
+	
+	return db;
+}
+
+#define kMaxIdeas 4000
+
+typedef struct {
+	long long parentKey;
+	double timeStamp;
+	char name[96];
+} StoredIdea;
+
+// Ideas of the last store filled, by key
+static StoredIdea stored[kMaxIdeas + 1];
+static int storedCount;
+
+static void FillStore(sqlite3 *db, int count)
+{
+	sqlite3_stmt *statement;
+	
+	CHECK(count <= kMaxIdeas);
+	CHECK(sqlite3_prepare_v2(db, "INSERT INTO ZIDEA (Z_PK, Z_ENT, Z_OPT, ZPARENT, ZTIMESTAMP, ZNAME) VALUES (?, 1, 1, ?, ?, ?)",
+							 -1, &statement, NULL) == SQLITE_OK);
+	
+	Execute(db, "BEGIN");
+	
+	for (int key = 1; key <= count; key++) {
+		StoredIdea *idea = &stored[key];
+		
+		// Mostly shallow and wide, like a board
+		idea->parentKey = (key == 1 || rand() % 8 == 0) ? 0 : 1 + rand() % (key - 1);
+		idea->timeStamp = (rand() % 20 == 0) ? NAN : (double)(rand() % 1000);
+		snprintf(idea->name, sizeof(idea->name), "Idea %d %.*s", key, rand() % 60,
+				 "the quick brown fox jumps over the lazy dog and keeps on running far away");
+		
+		sqlite3_bind_int64(statement, 1, key);
+		if (idea->parentKey) {
+			sqlite3_bind_int64(statement, 2, idea->parentKey);
+		} else {
+			sqlite3_bind_null(statement, 2);
+		}
+		if (isnan(idea->timeStamp)) {
+			sqlite3_bind_null(statement, 3);
+		} else {
+			sqlite3_bind_double(statement, 3, idea->timeStamp);
+		}
+		sqlite3_bind_text(statement, 4, idea->name, -1, SQLITE_STATIC);
+		
+		CHECK(sqlite3_step(statement) == SQLITE_DONE);
+		sqlite3_reset(statement);
+	}
+	
+	Execute(db, "COMMIT");
+	sqlite3_finalize(statement);
+	
+	storedCount = count;
+}
+
+
+#pragma mark -
+#pragma mark Header
+
+static void TestFreeBytes(void)
+{
+	const char *path = PathNamed("Ideas.sqlite");
+	unsigned long long freeBytes;
+	unsigned long long fileSize;
+	struct stat status;
+	
+	// Deleting leaves free pages, which the header counts
+	for (int pageSizeIndex = 0; pageSizeIndex < 3; pageSizeIndex++) {
+		int pageSize = (int[]){ 1024, 4096, 65536 }[pageSizeIndex];
+		sqlite3 *db = CreateStore(path, pageSize);
+		
+		FillStore(db, 3000);
+		Execute(db, "DELETE FROM ZIDEA WHERE Z_PK % 3 != 0 OR Z_PK > 2000");
+		
+		long long freePages = QueryInteger(db, "PRAGMA freelist_count");
+		CHECK(QueryInteger(db, "PRAGMA page_size") == pageSize);
+		CHECK(freePages > 0);
+		sqlite3_close(db);
+		
+		CHECK(IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+		CHECK(stat(path, &status) == 0);
+		CHECK(fileSize == (unsigned long long)status.st_size);
+		CHECK(freeBytes == (unsigned long long)freePages * pageSize);
+	}
+	
+	// A header claiming more free pages than there are is clamped to the file
+	size_t length;
+	unsigned char *bytes = ReadFile(path, &length);
+	CHECK(bytes != NULL);
+	memset(bytes + 36, 0xff, 4);
+	WriteFile(path, bytes, length);
+	CHECK(IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+	CHECK(freeBytes == fileSize && fileSize == length);
+	
+	// Anything that isn't an SQLite header reads as no free pages at all
+	bytes[3] ^= 0x04;
+	WriteFile(path, bytes, length);
+	CHECK(!IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+	CHECK(freeBytes == 0 && fileSize == length);
+	
+	bytes[3] ^= 0x04;
+	WriteFile(path, bytes, 99);
+	CHECK(!IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+	CHECK(freeBytes == 0 && fileSize == 99);
+	
+	WriteFile(path, bytes, 0);
+	CHECK(!IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+	CHECK(freeBytes == 0 && fileSize == 0);
+	
+	WriteString(path, "This is not a database, but it is long enough to hold a header of one hundred bytes or more. Really.");
+	CHECK(!IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+	CHECK(freeBytes == 0);
+	
+	unlink(path);
+	CHECK(!IdeaStoreFileReadFreeBytes(path, &freeBytes, &fileSize));
+	CHECK(freeBytes == 0 && fileSize == 0);
+	
+	free(bytes);
+	RemoveAllFiles();
+}
+
+
+#pragma mark -
+#pragma mark Swapping
+
+static void TestReplace(void)
+{
+	// The journal goes along, the destination's own is dropped
+	WriteString(PathNamed("Ideas-recovered.sqlite"), "recovered");
+	WriteString(PathNamed("Ideas-recovered.sqlite-journal"), "recovered journal");
+	WriteString(PathNamed("Ideas.sqlite"), "damaged");
+	WriteString(PathNamed("Ideas.sqlite-journal"), "damaged journal");
+	
+	CHECK(IdeaStoreFileReplace(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "recovered"));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite-journal"), "recovered journal"));
+	CHECK(!FileExists(PathNamed("Ideas-recovered.sqlite")));
+	CHECK(!FileExists(PathNamed("Ideas-recovered.sqlite-journal")));
+	
+	// A stale journal isn't kept with a store that has none
+	WriteString(PathNamed("Ideas-recovered.sqlite"), "second");
+	CHECK(IdeaStoreFileReplace(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "second"));
+	CHECK(!FileExists(PathNamed("Ideas.sqlite-journal")));
+	
+	// Nothing to move, nothing touched
+	WriteString(PathNamed("Ideas.sqlite-journal"), "hot journal");
+	CHECK(!IdeaStoreFileReplace(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "second"));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite-journal"), "hot journal"));
+	
+	RemoveAllFiles();
+}
+
+static void TestSetAside(void)
+{
+	char prefix[512];
+	char result[512];
+	
+	snprintf(prefix, sizeof(prefix), "%s/Ideas-damaged", directory);
+	
+	WriteString(PathNamed("Ideas.sqlite"), "first");
+	WriteString(PathNamed("Ideas.sqlite-journal"), "first journal");
+	CHECK(IdeaStoreFileSetAside(PathNamed("Ideas.sqlite"), prefix, "sqlite", 1000, result, sizeof(result)));
+	CHECK(strcmp(result, PathNamed("Ideas-damaged-1000.sqlite")) == 0);
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000.sqlite"), "first"));
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000.sqlite-journal"), "first journal"));
+	CHECK(!FileExists(PathNamed("Ideas.sqlite")));
+	CHECK(!FileExists(PathNamed("Ideas.sqlite-journal")));
+	
+	// A second damaged store in the same second doesn't replace the first
+	WriteString(PathNamed("Ideas.sqlite"), "second");
+	CHECK(IdeaStoreFileSetAside(PathNamed("Ideas.sqlite"), prefix, "sqlite", 1000, result, sizeof(result)));
+	CHECK(strcmp(result, PathNamed("Ideas-damaged-1000-2.sqlite")) == 0);
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000.sqlite"), "first"));
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000.sqlite-journal"), "first journal"));
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000-2.sqlite"), "second"));
+	CHECK(!FileExists(PathNamed("Ideas-damaged-1000-2.sqlite-journal")));
+	
+	// Nor does it take a stray journal left under a free name
+	WriteString(PathNamed("Ideas-damaged-1000-3.sqlite"), "taken");
+	WriteString(PathNamed("Ideas-damaged-1000-4.sqlite-journal"), "stray journal");
+	WriteString(PathNamed("Ideas.sqlite"), "third");
+	CHECK(IdeaStoreFileSetAside(PathNamed("Ideas.sqlite"), prefix, "sqlite", 1000, result, sizeof(result)));
+	CHECK(strcmp(result, PathNamed("Ideas-damaged-1000-4.sqlite")) == 0);
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000-3.sqlite"), "taken"));
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-1000-4.sqlite"), "third"));
+	CHECK(!FileExists(PathNamed("Ideas-damaged-1000-4.sqlite-journal")));
+	
+	// No store, nothing set aside
+	CHECK(!IdeaStoreFileSetAside(PathNamed("Ideas.sqlite"), prefix, "sqlite", 1000, result, sizeof(result)));
+	CHECK(!FileExists(PathNamed("Ideas-damaged-1000-5.sqlite")));
+	
+	// A name that doesn't fit fails rather than being cut short
+	WriteString(PathNamed("Ideas.sqlite"), "fourth");
+	CHECK(!IdeaStoreFileSetAside(PathNamed("Ideas.sqlite"), prefix, "sqlite", 1000, result, strlen(prefix) + 4));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "fourth"));
+	
+	RemoveAllFiles();
+}
+
+// The steps of IdeaStoreRecoveryOperation once the copy is written, in order
+enum {
+	kRecoveryWroteCopy,
+	kRecoveryFinishedCopy,
+	kRecoverySetAside,
+	kRecoveryReplaced,
+	kRecoveryStepCount
+};
+
+static void RunRecovery(int lastStep, time_t time, char *damagedPath, size_t damagedPathSize)
+{
+	char prefix[512];
+	
+	snprintf(prefix, sizeof(prefix), "%s/Ideas-damaged", directory);
+	
+	IdeaStoreFileRemove(PathNamed("Ideas-recovering.sqlite"));
+	WriteString(PathNamed("Ideas-recovering.sqlite"), "recovered");
+	if (lastStep == kRecoveryWroteCopy) {
+		return;
+	}
+	
+	CHECK(IdeaStoreFileReplace(PathNamed("Ideas-recovered.sqlite"), PathNamed("Ideas-recovering.sqlite")));
+	if (lastStep == kRecoveryFinishedCopy) {
+		return;
+	}
+	
+	CHECK(IdeaStoreFileSetAside(PathNamed("Ideas.sqlite"), prefix, "sqlite", time, damagedPath, damagedPathSize));
+	if (lastStep == kRecoverySetAside) {
+		return;
+	}
+	
+	CHECK(IdeaStoreFileReplace(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+}
+
+// Whatever step the app is killed after, the next launch finds either the damaged store, to be
+// recovered again, or the recovered one, and the damaged store is kept throughout
+static void TestInterruptedSwap(void)
+{
+	char damagedPath[512];
+	
+	for (int lastStep = 0; lastStep < kRecoveryStepCount; lastStep++) {
+		WriteString(PathNamed("Ideas.sqlite"), "damaged");
+		WriteString(PathNamed("Ideas.sqlite-journal"), "damaged journal");
+		
+		RunRecovery(lastStep, 2000, damagedPath, sizeof(damagedPath));
+		
+		int finished = IdeaStoreFileFinishInterruptedSwap(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite"));
+		
+		CHECK(finished == (lastStep == kRecoverySetAside));
+		
+		if (lastStep < kRecoverySetAside) {
+			CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "damaged"));
+			CHECK(FileHasContents(PathNamed("Ideas.sqlite-journal"), "damaged journal"));
+			
+			// Recovered again from the start, which replaces the leftover copies
+			RunRecovery(kRecoveryReplaced, 2000, damagedPath, sizeof(damagedPath));
+		}
+		
+		CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "recovered"));
+		CHECK(!FileExists(PathNamed("Ideas.sqlite-journal")));
+		CHECK(!FileExists(PathNamed("Ideas-recovering.sqlite")));
+		CHECK(!FileExists(PathNamed("Ideas-recovered.sqlite")));
+		CHECK(FileHasContents(PathNamed("Ideas-damaged-2000.sqlite"), "damaged"));
+		CHECK(FileHasContents(PathNamed("Ideas-damaged-2000.sqlite-journal"), "damaged journal"));
+		
+		// Nothing left to finish with a store in place
+		CHECK(!IdeaStoreFileFinishInterruptedSwap(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+		
+		RemoveAllFiles();
+	}
+	
+	// Killed between linking the damaged store to its new name and removing the old one: the
+	// damaged store is opened and recovered again, and both names are kept
+	WriteString(PathNamed("Ideas.sqlite"), "damaged");
+	CHECK(link(PathNamed("Ideas.sqlite"), PathNamed("Ideas-damaged-2000.sqlite")) == 0);
+	CHECK(!IdeaStoreFileFinishInterruptedSwap(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+	RunRecovery(kRecoveryReplaced, 2000, damagedPath, sizeof(damagedPath));
+	CHECK(strcmp(damagedPath, PathNamed("Ideas-damaged-2000-2.sqlite")) == 0);
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-2000.sqlite"), "damaged"));
+	CHECK(FileHasContents(PathNamed("Ideas-damaged-2000-2.sqlite"), "damaged"));
+	CHECK(FileHasContents(PathNamed("Ideas.sqlite"), "recovered"));
+	
+	// No store and nothing recovered, as on first launch
+	RemoveAllFiles();
+	CHECK(!IdeaStoreFileFinishInterruptedSwap(PathNamed("Ideas.sqlite"), PathNamed("Ideas-recovered.sqlite")));
+	CHECK(!FileExists(PathNamed("Ideas.sqlite")));
+}
+
+
+#pragma mark -
+#pragma mark Salvage
+
+typedef struct {
+	long long key;
+	long long parentKey;	// of the row as read
+	double timeStamp;
+	const char *name;
+	int parentIndex;		// index of the parent's copy, -1 for the top level
+} Copy;
+
+typedef struct {
+	sqlite3 *db;
+	
+	// Rows read by the full read, and whether it succeeded
+	int readAllSucceeded;
+	size_t distinctKeysRead;
+	
+	// For mock sources, instead of a store
+	const IdeaSalvageRow *rows;
+	size_t rowCount;
+	int failReadAll;
+	long long failingParentKey;
+	long long failingCopyKey;
+	
+	Copy *copies;
+	size_t copyCount;
+	size_t copyCapacity;
+} TestSource;
+
+static int ReadAllRows(void *info, IdeaSalvageRowList *rows)
+{
+	TestSource *source = info;
+	
+	if (source->db == NULL) {
+		if (source->failReadAll) {
+			return 0;
+		}
+		for (size_t i = 0; i < source->rowCount; i++) {
+			const IdeaSalvageRow *row = &source->rows[i];
+			CHECK(IdeaSalvageRowListAppend(rows, row->key, row->parentKey, row->timeStamp, row->name));
+		}
+		source->readAllSucceeded = 1;
+		return 1;
+	}
+	
+	source->readAllSucceeded = IdeaSalvageStoreReadAllRows(source->db, rows);
+	
+	// A damaged table can hand out the same key twice, or keys no store would have
+	for (size_t i = 0; source->readAllSucceeded && i < rows->count; i++) {
+		size_t j = 0;
+		while (j < i && rows->rows[j].key != rows->rows[i].key) {
+			j++;
+		}
+		source->distinctKeysRead += (j == i && rows->rows[i].key > 0);
+	}
+	
+	return source->readAllSucceeded;
+}
+
+static int ReadChildRows(void *info, long long parentKey, IdeaSalvageRowList *rows)
+{
+	TestSource *source = info;
+	
+	if (source->db == NULL) {
+		if (parentKey == source->failingParentKey) {
+			return 0;
+		}
+		for (size_t i = 0; i < source->rowCount; i++) {
+			const IdeaSalvageRow *row = &source->rows[i];
+			if (row->parentKey == parentKey) {
+				CHECK(IdeaSalvageRowListAppend(rows, row->key, row->parentKey, row->timeStamp, row->name));
+			}
+		}
+		return 1;
+	}
+	
+	return IdeaSalvageStoreReadChildRows(source->db, parentKey, rows);
+}
+
+// Copies are kept as indexes plus one, so that none is NULL
+static void *CopyRow(void *info, const IdeaSalvageRow *row, void *parentCopy)
+{
+	TestSource *source = info;
+	
+	if (row->key == source->failingCopyKey) {
+		return NULL;
+	}
+	
+	if (source->copyCount == source->copyCapacity) {
+		source->copyCapacity = source->copyCapacity ? 2 * source->copyCapacity : 256;
+		source->copies = realloc(source->copies, source->copyCapacity * sizeof(Copy));
+		CHECK(source->copies != NULL);
+	}
+	
+	int parentIndex = parentCopy ? (int)((intptr_t)parentCopy - 1) : -1;
+	CHECK(parentIndex < (int)source->copyCount);
+	
+	Copy *copy = &source->copies[source->copyCount];
+	copy->key = row->key;
+	copy->parentKey = row->parentKey;
+	copy->timeStamp = row->timeStamp;
+	copy->name = row->name ? strdup(row->name) : NULL;
+	copy->parentIndex = parentIndex;
+	
+	source->copyCount++;
+	return (void *)(intptr_t)source->copyCount;
+}
+
+static size_t RunSalvage(TestSource *source, size_t *lostLevelCount)
+{
+	IdeaSalvageSource salvageSource = { source, ReadAllRows, ReadChildRows, CopyRow };
+	
+	source->copyCount = 0;
+	source->readAllSucceeded = 0;
+	source->distinctKeysRead = 0;
+	
+	size_t copied = IdeaSalvage(&salvageSource, lostLevelCount);
+	CHECK(copied == source->copyCount);
+	
+	return copied;
+}
+
+static void FreeCopies(TestSource *source)
+{
+	for (size_t i = 0; i < source->copyCount; i++) {
+		free((char *)source->copies[i].name);
+	}
+	free(source->copies);
+	source->copies = NULL;
+	source->copyCount = 0;
+	source->copyCapacity = 0;
+}
+
+static int CompareTimeStamps(double timeStamp1, double timeStamp2)
+{
+	if (isnan(timeStamp1) || isnan(timeStamp2)) {
+		return isnan(timeStamp2) - isnan(timeStamp1);
+	}
+	return (timeStamp1 > timeStamp2) - (timeStamp1 < timeStamp2);
+}
+
+// What holds however damaged the store is: no idea is copied twice, every copy is attached to a
+// copy made before it, and siblings come in time stamp order. Read all at once, ideas are attached
+// to the parent their row names; read level by level, to the one whose children they were read
+// as, which a damaged index can disagree with.
+static void CheckCopies(const TestSource *source)
+{
+	long long maxKey = 0;
+	
+	for (size_t i = 0; i < source->copyCount; i++) {
+		CHECK(source->copies[i].key > 0);
+		if (source->copies[i].key > maxKey) {
+			maxKey = source->copies[i].key;
+		}
+	}
+	
+	char *seen = calloc((size_t)maxKey + 1, 1);
+	int *lastChild = malloc((source->copyCount + 1) * sizeof(int));
+	CHECK(seen != NULL && lastChild != NULL);
+	
+	for (size_t i = 0; i <= source->copyCount; i++) {
+		lastChild[i] = -1;
+	}
+	
+	for (size_t i = 0; i < source->copyCount; i++) {
+		const Copy *copy = &source->copies[i];
+		
+		CHECK(!seen[copy->key]);
+		seen[copy->key] = 1;
+		
+		CHECK(copy->parentIndex < (int)i);
+		if (copy->parentIndex >= 0 && source->readAllSucceeded) {
+			CHECK(source->copies[copy->parentIndex].key == copy->parentKey);
+		}
+		
+		// Top level ideas come from several places once parents go missing, the rest are in order
+		if (copy->parentIndex >= 0) {
+			int previous = lastChild[copy->parentIndex + 1];
+			if (previous >= 0) {
+				const Copy *sibling = &source->copies[previous];
+				int order = CompareTimeStamps(sibling->timeStamp, copy->timeStamp);
+				CHECK(order < 0 || (order == 0 && sibling->key < copy->key));
+			}
+			lastChild[copy->parentIndex + 1] = (int)i;
+		}
+	}
+	
+	free(seen);
+	free(lastChild);
+}
+
+// An intact store is copied whole, the same tree in the same order
+static void CheckCompleteCopy(const TestSource *source)
+{
+	CHECK(source->copyCount == (size_t)storedCount);
+	
+	for (size_t i = 0; i < source->copyCount; i++) {
+		const Copy *copy = &source->copies[i];
+		const StoredIdea *idea = &stored[copy->key];
+		
+		CHECK(copy->parentKey == idea->parentKey);
+		CHECK(copy->parentIndex >= 0 || idea->parentKey == 0);
+		CHECK(CompareTimeStamps(copy->timeStamp, idea->timeStamp) == 0);
+		CHECK(copy->name && strcmp(copy->name, idea->name) == 0);
+	}
+	
+	CheckCopies(source);
+}
+
+static void TestSalvageIntactStore(void)
+{
+	const char *path = PathNamed("Ideas.sqlite");
+	sqlite3 *db = CreateStore(path, 1024);
+	
+	FillStore(db, 2000);
+	
+	TestSource source;
+	memset(&source, 0, sizeof(source));
+	source.db = db;
+	
+	size_t lostLevelCount;
+	RunSalvage(&source, &lostLevelCount);
+	CHECK(lostLevelCount == 0);
+	CHECK(source.readAllSucceeded);
+	CheckCompleteCopy(&source);
+	FreeCopies(&source);
+	
+	sqlite3_close(db);
+	RemoveAllFiles();
+}
+
+enum {
+	kDamageBitFlips,
+	kDamageTruncation,
+	kDamageTornWrite,
+	kDamageKindCount
+};
+
+static void Damage(unsigned char *bytes, size_t *length, const unsigned char *oldBytes, size_t oldLength, int kind)
+{
+	const size_t pageSize = 1024;
+	size_t pageCount = *length / pageSize;
+	
+	switch (kind) {
+		case kDamageBitFlips: {
+			int flips = 1 + rand() % 16;
+			for (int i = 0; i < flips; i++) {
+				size_t offset = (size_t)rand() % *length;
+				bytes[offset] ^= (unsigned char)(1 << (rand() % 8));
+			}
+			break;
+		}
+		
+		case kDamageTruncation:
+			*length = (size_t)rand() % *length;
+			break;
+		
+		case kDamageTornWrite: {
+			// Pages written only half way when power was lost: the rest is the page as it was
+			// before the write, or zeros if the page was new
+			int pages = 1 + rand() % 4;
+			for (int i = 0; i < pages; i++) {
+				size_t page = (size_t)rand() % pageCount;
+				size_t offset = page * pageSize + pageSize / 2 * (size_t)(rand() % 2);
+				size_t end = offset + pageSize / 2;
+				
+				for (; offset < end; offset++) {
+					bytes[offset] = offset < oldLength ? oldBytes[offset] : 0;
+				}
+			}
+			break;
+		}
+	}
+}
+
+static void TestSalvageDamagedStores(int runs)
+{
+	const char *intactPath = PathNamed("Ideas-intact.sqlite");
+	const char *oldPath = PathNamed("Ideas-old.sqlite");
+	const char *path = PathNamed("Ideas.sqlite");
+	
+	// An older state of the store, for torn writes to leave parts of
+	sqlite3 *db = CreateStore(intactPath, 1024);
+	FillStore(db, 3000);
+	Execute(db, "UPDATE ZIDEA SET ZNAME = ZNAME || ' (old)', ZPARENT = NULL WHERE Z_PK % 7 = 0");
+	sqlite3_close(db);
+	rename(intactPath, oldPath);
+	
+	db = CreateStore(intactPath, 1024);
+	FillStore(db, 3000);
+	sqlite3_close(db);
+	
+	size_t intactLength;
+	size_t oldLength;
+	unsigned char *intact = ReadFile(intactPath, &intactLength);
+	unsigned char *old = ReadFile(oldPath, &oldLength);
+	unsigned char *bytes = malloc(intactLength);
+	CHECK(intact && old && bytes);
+	
+	int opened = 0;
+	int complete = 0;
+	int byLevel = 0;
+	
+	for (step = 0; step < runs; step++) {
+		int kind = step % kDamageKindCount;
+		size_t length = intactLength;
+		
+		memcpy(bytes, intact, intactLength);
+		Damage(bytes, &length, old, oldLength, kind);
+		WriteFile(path, bytes, length);
+		
+		if ((db = IdeaSalvageStoreOpen(path)) == NULL) {
+			continue;
+		}
+		opened++;
+		
+		TestSource source;
+		memset(&source, 0, sizeof(source));
+		source.db = db;
+		
+		size_t lostLevelCount;
+		RunSalvage(&source, &lostLevelCount);
+		CheckCopies(&source);
+		
+		if (source.readAllSucceeded) {
+			// Every idea that was read is copied, whatever its parent says
+			CHECK(lostLevelCount == 0);
+			CHECK(source.copyCount == source.distinctKeysRead);
+			complete++;
+		} else {
+			CHECK(source.copyCount <= (size_t)storedCount);
+			byLevel++;
+		}
+		
+		FreeCopies(&source);
+		sqlite3_close(db);
+	}
+	
+	// The runs should have exercised both ways of reading
+	CHECK(opened > runs / 2);
+	CHECK(complete > 0 && byLevel > 0);
+	
+	free(intact);
+	free(old);
+	free(bytes);
+	RemoveAllFiles();
+	step = 0;
+}
+
+static void TestSalvageMockStores(void)
+{
+	// 1 and 2 at the top, 3 and 4 under 1 with 4 first, 5 under 3, 6 under 2; 7 and 8 are each
+	// other's parent, 9's parent is gone
+	IdeaSalvageRow rows[] = {
+		{ 3, 1, 20, "three" },
+		{ 5, 3, 10, "five" },
+		{ 1, 0, 10, "one" },
+		{ 6, 2, NAN, "six" },
+		{ 2, 0, 5, "two" },
+		{ 4, 1, 15, "four" },
+		{ 8, 7, 2, "eight" },
+		{ 7, 8, 1, "seven" },
+		{ 9, 42, 3, NULL },
+	};
+	
+	TestSource source;
+	size_t lostLevelCount;
+	
+	memset(&source, 0, sizeof(source));
+	source.rows = rows;
+	source.rowCount = sizeof(rows) / sizeof(rows[0]);
+	source.failingParentKey = -1;
+	source.failingCopyKey = -1;
+	
+	// All at once, a subtree at a time: orphans at the top after it, then the cycle broken at
+	// its first idea
+	CHECK(RunSalvage(&source, &lostLevelCount) == 9);
+	CHECK(lostLevelCount == 0);
+	CheckCopies(&source);
+	
+	long long expectedKeys[] = { 2, 6, 1, 4, 3, 5, 9, 8, 7 };
+	for (size_t i = 0; i < 9; i++) {
+		CHECK(source.copies[i].key == expectedKeys[i]);
+	}
+	CHECK(source.copies[6].parentIndex == -1 && source.copies[6].name == NULL);
+	CHECK(source.copies[7].parentIndex == -1);
+	CHECK(source.copies[8].parentIndex == 7);
+	FreeCopies(&source);
+	
+	// A copy that fails takes its subtree with it, and nothing else
+	source.failingCopyKey = 3;
+	CHECK(RunSalvage(&source, &lostLevelCount) == 7);
+	CheckCopies(&source);
+	for (size_t i = 0; i < source.copyCount; i++) {
+		CHECK(source.copies[i].key != 3 && source.copies[i].key != 5);
+	}
+	FreeCopies(&source);
+	source.failingCopyKey = -1;
+	
+	// Level by level, a level that can't be read only loses what's under it, and ideas that
+	// aren't reachable from the top can't be found at all
+	source.failReadAll = 1;
+	source.failingParentKey = 3;
+	CHECK(RunSalvage(&source, &lostLevelCount) == 5);
+	CHECK(lostLevelCount == 1);
+	CheckCopies(&source);
+	
+	long long expectedLevelKeys[] = { 2, 1, 6, 4, 3 };
+	for (size_t i = 0; i < 5; i++) {
+		CHECK(source.copies[i].key == expectedLevelKeys[i]);
+	}
+	FreeCopies(&source);
+	
+	// The top level itself
+	source.failingParentKey = 0;
+	CHECK(RunSalvage(&source, &lostLevelCount) == 0);
+	CHECK(lostLevelCount == 1);
+	FreeCopies(&source);
+	
+	// An idea found under two parents, or under itself, is copied once
+	IdeaSalvageRow looping[] = {
+		{ 1, 0, 1, "one" },
+		{ 2, 1, 1, "two" },
+		{ 2, 2, 1, "two again" },
+		{ 1, 2, 1, "one again" },
+	};
+	source.rows = looping;
+	source.rowCount = sizeof(looping) / sizeof(looping[0]);
+	source.failingParentKey = -1;
+	CHECK(RunSalvage(&source, &lostLevelCount) == 2);
+	CHECK(lostLevelCount == 0);
+	CheckCopies(&source);
+	FreeCopies(&source);
+	
+	source.failReadAll = 0;
+	CHECK(RunSalvage(&source, &lostLevelCount) == 2);
+	CheckCopies(&source);
+	FreeCopies(&source);
+}
+
+
+int main(int argc, char *argv[])
+{
+	seed = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 20110127;
+	srand(seed);
+	
+	snprintf(directory, sizeof(directory), "/tmp/StoreTests.XXXXXX");
+	CHECK(mkdtemp(directory) != NULL);
+	
+	TestFreeBytes();
+	TestReplace();
+	TestSetAside();
+	TestInterruptedSwap();
+	TestSalvageMockStores();
+	TestSalvageIntactStore();
+	TestSalvageDamagedStores(300);
+	
+	rmdir(directory);
+	
+	printf("StoreTests passed\n");
+	return 0;
+}